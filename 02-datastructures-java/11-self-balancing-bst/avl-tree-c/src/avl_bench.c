@@ -0,0 +1,1110 @@
+/*
+ * avl_bench: timing driver for the AVL operations.
+ *
+ *   gcc -O2 avl_bench.c avl_tree.c avl_compact.c avl_setops.c avl_interval.c avl_persist.c avl_threaded.c avl_concurrent.c -std=c11 -Wall -Wextra -pedantic -pthread -o avl_bench
+ *   ./avl_bench [n ...]            (default: 1000000 10000000)
+ *   ./avl_bench --compact [n ...]  (default: 10000000)
+ *   ./avl_bench --setops [n ...]   (default: 1000000)
+ *   ./avl_bench --build [n ...]    (default: 1000000 10000000)
+ *   ./avl_bench --interval [n ...] (default: 1000000)
+ *   ./avl_bench --persist [n ...]  (default: 100000 1000000)
+ *   ./avl_bench --threaded [n ...] (default: 1000000 10000000)
+ *   ./avl_bench --concurrent [n ...] (default: 1000000)
+ *   ./avl_bench --concurrent-check   (exit status 1 on any wrong result)
+ *
+ * Inserts n distinct keys in random order, searches all of them and
+ * deletes them in another random order; by default once with the
+ * iterative operations and once with the recursive reference versions,
+ * with --compact with the pointer tree against the 12-byte arena tree
+ * (grown by doubling, and presized to n). Each run is a child process,
+ * so none inherits another's freed heap; the variants alternate for
+ * ROUNDS rounds and the best time counts. Memory is the heap growth
+ * over the inserts (glibc), i.e. including malloc headers and slack.
+ *
+ * --setops merges a tree of n keys with one of m = n and m = n / 1000
+ * keys (half of them shared) and times union / intersection /
+ * difference as m single-key operations against the join-based
+ * versions on 1..MAX_THREADS threads.
+ *
+ * --build times building a tree of n keys by insertAVL (in sorted and
+ * in random order) against avl_build_sorted and avl_build_stream.
+ *
+ * --interval loads n random intervals into the interval tree and times
+ * QUERIES stabbing and overlap queries against a linear scan.
+ *
+ * --persist keeps a version per update of an n-key tree: PERSIST_VERSIONS
+ * path-copying versions against COPY_VERSIONS full copies of the pointer
+ * tree (copy-on-snapshot), then releases them all.
+ *
+ * --threaded times full in-order scans and SCAN_RANGES range scans of
+ * SCAN_LENGTH keys: threaded tree (next) against struct Node with an
+ * explicit-stack iterator and with recursion.
+ *
+ * --concurrent fills a tree with n random keys of [0, 2n), then runs
+ * CONCURRENT_OPS random operations split over 1..MAX_THREADS threads,
+ * 90% and 50% searches (the rest half inserts, half deletes): the
+ * concurrent tree against the avl_tree.h operations behind one mutex.
+ *
+ * --concurrent-check runs the concurrent tree on 1..MAX_THREADS threads
+ * and compares the result of every operation with a reference set
+ * (see check_concurrent).
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#include "avl_tree.h"
+#include "avl_compact.h"
+#include "avl_setops.h"
+#include "avl_interval.h"
+#include "avl_persist.h"
+#include "avl_threaded.h"
+#include "avl_concurrent.h"
+
+#define ROUNDS 3
+#define MAX_THREADS 8
+#define QUERIES 1000
+#define MAX_LENGTH 1000   /* --interval: lengths uniform in [0, MAX_LENGTH) */
+#define PERSIST_VERSIONS 100000
+#define COPY_VERSIONS 100
+#define SCAN_RANGES 100000
+#define SCAN_LENGTH 100
+#define CONCURRENT_OPS 2000000
+#define CHECK_KEYS 50000   /* --concurrent-check: keys per class */
+#define CHECK_OPS 400000   /* --concurrent-check: operations per thread and phase */
+#define HOT_KEYS 64        /* --concurrent-check: keys every thread updates */
+
+typedef struct {
+    double insert_ns, search_ns, delete_ns;  /* Per operation */
+    double bytes_per_key;                    /* Heap growth over the inserts */
+    int valid;                               /* Invariant holds after inserts */
+} Timing;
+
+typedef struct Variant {
+    const char *name;
+    Timing (*run)(const struct Variant *, const int *, const int *, size_t);
+    struct Node *(*insert)(struct Node *, int);
+    struct Node *(*remove)(struct Node *, int);
+    int (*search)(struct Node *, int);
+    size_t presize;                          /* Compact only: capacity_hint = n */
+} Variant;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* heap_bytes: bytes the allocator has handed out (0 if unknown) */
+static double heap_bytes(void) {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    struct mallinfo2 mi = mallinfo2();
+    return (double)mi.uordblks + (double)mi.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+/* shuffle: Fisher-Yates with a 64-bit LCG (rand() is too short for 10M) */
+static void shuffle(int *a, size_t n, unsigned long long *state) {
+    for (size_t i = n - 1; i > 0; i--) {
+        *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+        size_t j = (size_t)((*state >> 33) % (i + 1));
+        int tmp = a[i];
+        a[i] = a[j];
+        a[j] = tmp;
+    }
+}
+
+static Timing run_pointer(const Variant *v, const int *ins, const int *del, size_t n) {
+    Timing t;
+    struct Node *root = NULL;
+
+    double heap = heap_bytes();
+    double start = now_ns();
+    for (size_t i = 0; i < n; i++) root = v->insert(root, ins[i]);
+    t.insert_ns = (now_ns() - start) / n;
+    heap = heap_bytes() - heap;
+    t.bytes_per_key = heap > 0 ? heap / n : (double)sizeof(struct Node);
+
+    t.valid = check_avl_invariant(root);
+
+    volatile long found = 0;
+    start = now_ns();
+    for (size_t i = 0; i < n; i++) found += v->search(root, del[i]);
+    t.search_ns = (now_ns() - start) / n;
+    if (found != (long)n) t.valid = 0;
+
+    start = now_ns();
+    for (size_t i = 0; i < n; i++) root = v->remove(root, del[i]);
+    t.delete_ns = (now_ns() - start) / n;
+    if (root != NULL) t.valid = 0;
+
+    return t;
+}
+
+static Timing run_compact(const Variant *v, const int *ins, const int *del, size_t n) {
+    Timing t;
+    double heap = heap_bytes();
+    struct CompactAVL *tree = compact_create(v->presize ? n : 0);
+    if (tree == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+
+    int added = 1;
+    double start = now_ns();
+    for (size_t i = 0; i < n; i++) added &= compact_insert(tree, ins[i]) == 1;
+    t.insert_ns = (now_ns() - start) / n;
+    heap = heap_bytes() - heap;
+    t.bytes_per_key = heap > 0 ? heap / n : (double)compact_memory(tree) / n;
+
+    t.valid = added && check_compact_invariant(tree);
+
+    volatile long found = 0;
+    start = now_ns();
+    for (size_t i = 0; i < n; i++) found += compact_search(tree, del[i]);
+    t.search_ns = (now_ns() - start) / n;
+    if (found != (long)n) t.valid = 0;
+
+    start = now_ns();
+    for (size_t i = 0; i < n; i++) compact_delete(tree, del[i]);
+    t.delete_ns = (now_ns() - start) / n;
+    if (tree->size != 0) t.valid = 0;
+
+    compact_destroy(tree);
+    return t;
+}
+
+/* run_isolated: v->run in a fresh child process */
+static Timing run_isolated(const Variant *v, const int *ins, const int *del, size_t n) {
+    Timing t = { 0, 0, 0, 0, 0 };
+    int fds[2];
+    if (pipe(fds) != 0) return v->run(v, ins, del, n);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        t = v->run(v, ins, del, n);
+        ssize_t written = write(fds[1], &t, sizeof(t));
+        _exit(written == (ssize_t)sizeof(t) ? 0 : 1);
+    }
+    close(fds[1]);
+    if (pid < 0 || read(fds[0], &t, sizeof(t)) != (ssize_t)sizeof(t)) {
+        t.valid = 0;
+    }
+    close(fds[0]);
+    if (pid > 0) waitpid(pid, NULL, 0);
+    return t;
+}
+
+static void bench(size_t n, const Variant *variants, int count) {
+    int *ins = (int *)malloc(n * sizeof(int));
+    int *del = (int *)malloc(n * sizeof(int));
+    if (ins == NULL || del == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    for (size_t i = 0; i < n; i++) ins[i] = del[i] = (int)i;
+    unsigned long long state = 42;
+    shuffle(ins, n, &state);
+    shuffle(del, n, &state);
+
+    Timing timing[4];
+
+    printf("n = %zu (best of %d)\n", n, ROUNDS);
+    for (int round = 0; round < ROUNDS; round++) {
+        for (int i = 0; i < count; i++) {
+            Timing t = run_isolated(&variants[i], ins, del, n);
+            if (round == 0) {
+                timing[i] = t;
+                continue;
+            }
+            if (t.insert_ns < timing[i].insert_ns) timing[i].insert_ns = t.insert_ns;
+            if (t.search_ns < timing[i].search_ns) timing[i].search_ns = t.search_ns;
+            if (t.delete_ns < timing[i].delete_ns) timing[i].delete_ns = t.delete_ns;
+            timing[i].valid &= t.valid;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        printf("  %-10s insert %7.1f ns  search %7.1f ns  delete %7.1f ns  %5.1f B/key  %s\n",
+               variants[i].name, timing[i].insert_ns, timing[i].search_ns,
+               timing[i].delete_ns, timing[i].bytes_per_key,
+               timing[i].valid ? "(valid)" : "(INVALID)");
+    }
+    for (int i = 1; i < count; i++) {
+        printf("  speedup    insert %6.2fx   search %6.2fx   delete %6.2fx  (%s vs %s)\n",
+               timing[0].insert_ns / timing[i].insert_ns,
+               timing[0].search_ns / timing[i].search_ns,
+               timing[0].delete_ns / timing[i].delete_ns,
+               variants[i].name, variants[0].name);
+    }
+
+    free(ins);
+    free(del);
+}
+
+/* ---------- Set Operations ---------- */
+
+enum { SET_UNION, SET_INTERSECT, SET_DIFFERENCE };
+
+static size_t count_nodes(struct Node *n) {
+    return n ? 1 + count_nodes(n->left) + count_nodes(n->right) : 0;
+}
+
+static struct Node *build(const int *keys, size_t n) {
+    struct Node *root = NULL;
+    for (size_t i = 0; i < n; i++) root = insertAVL(root, keys[i]);
+    return root;
+}
+
+/* set_loop: the same operation as m single-key calls on a */
+static struct Node *set_loop(int op, struct Node *a, const int *b, size_t m) {
+    struct Node *c = NULL;
+    switch (op) {
+    case SET_UNION:
+        for (size_t i = 0; i < m; i++) a = insertAVL(a, b[i]);
+        return a;
+    case SET_INTERSECT:
+        for (size_t i = 0; i < m; i++) {
+            if (searchBST(a, b[i])) c = insertAVL(c, b[i]);
+        }
+        freeTree(a);
+        return c;
+    default:
+        for (size_t i = 0; i < m; i++) a = deleteAVL(a, b[i]);
+        return a;
+    }
+}
+
+static struct Node *set_join(int op, struct Node *a, struct Node *b, int threads) {
+    switch (op) {
+    case SET_UNION:     return avl_union(a, b, threads);
+    case SET_INTERSECT: return avl_intersect(a, b, threads);
+    default:            return avl_difference(a, b, threads);
+    }
+}
+
+/* time_set_op: ms for one run (threads 0 = single-key loop), -1 if wrong */
+static double time_set_op(int op, const int *a, size_t n, const int *b, size_t m,
+                          int threads, size_t expected) {
+    struct Node *ta = build(a, n);
+    struct Node *tb = threads ? build(b, m) : NULL;
+
+    double start = now_ns();
+    struct Node *result = threads ? set_join(op, ta, tb, threads)
+                                  : set_loop(op, ta, b, m);
+    double ms = (now_ns() - start) / 1e6;
+
+    int ok = check_avl_invariant(result) && count_nodes(result) == expected;
+    freeTree(result);
+    return ok ? ms : -1;
+}
+
+static void bench_setops(size_t n, size_t m) {
+    static const char *names[] = { "union", "intersect", "difference" };
+    size_t range = 2 * n;
+    int *pool = (int *)malloc(range * sizeof(int));
+    int *a = (int *)malloc(n * sizeof(int));
+    int *b = (int *)malloc(m * sizeof(int));
+    char *in_a = (char *)calloc(range, 1);
+    if (pool == NULL || a == NULL || b == NULL || in_a == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+
+    /* a: n random keys of [0, 2n); b: m/2 keys of a plus m/2 others */
+    unsigned long long state = 42;
+    for (size_t i = 0; i < range; i++) pool[i] = (int)i;
+    shuffle(pool, range, &state);
+    for (size_t i = 0; i < n; i++) {
+        a[i] = pool[i];
+        in_a[a[i]] = 1;
+    }
+    for (size_t i = 0; i < m; i++) b[i] = pool[(i % 2) ? n + i / 2 : i / 2];
+    shuffle(b, m, &state);
+
+    size_t shared = 0;
+    for (size_t i = 0; i < m; i++) shared += in_a[b[i]];
+    size_t expected[3] = { n + m - shared, shared, n - shared };
+
+    printf("n = %zu, m = %zu (ms, best of %d)\n", n, m, ROUNDS);
+    printf("  %-10s %10s", "", "m x 1-key");
+    for (int th = 1; th <= MAX_THREADS; th *= 2) printf("   join %dT", th);
+    printf("\n");
+
+    for (int op = SET_UNION; op <= SET_DIFFERENCE; op++) {
+        double best[MAX_THREADS + 1];
+        for (int i = 0; i <= MAX_THREADS; i++) best[i] = -1;
+        for (int round = 0; round < ROUNDS; round++) {
+            for (int th = 0; th <= MAX_THREADS; th = th ? th * 2 : 1) {
+                double ms = time_set_op(op, a, n, b, m, th, expected[op]);
+                if (ms < 0) {
+                    best[th] = -2;  /* Wrong result: stays INVALID */
+                } else if (best[th] != -2 && (best[th] < 0 || ms < best[th])) {
+                    best[th] = ms;
+                }
+            }
+        }
+        printf("  %-10s", names[op]);
+        for (int th = 0; th <= MAX_THREADS; th = th ? th * 2 : 1) {
+            if (best[th] == -2) printf(" %9s", "INVALID");
+            else printf(" %9.1f", best[th]);
+        }
+        printf("\n");
+    }
+
+    free(in_a);
+    free(b);
+    free(a);
+    free(pool);
+}
+
+/* ---------- Bulk Construction ---------- */
+
+typedef struct {
+    const int *keys;
+    size_t next, n;
+} KeyStream;
+
+static int next_key(void *ctx, int *key) {
+    KeyStream *ks = (KeyStream *)ctx;
+    if (ks->next == ks->n) return 0;
+    *key = ks->keys[ks->next++];
+    return 1;
+}
+
+/* time_build: ms to build from keys (method 0-3), -1 if the tree is wrong */
+static double time_build(int method, const int *sorted, const int *shuffled, size_t n) {
+    struct Node *root = NULL;
+    KeyStream ks = { sorted, 0, n };
+
+    double start = now_ns();
+    switch (method) {
+    case 0:
+        for (size_t i = 0; i < n; i++) root = insertAVL(root, sorted[i]);
+        break;
+    case 1:
+        for (size_t i = 0; i < n; i++) root = insertAVL(root, shuffled[i]);
+        break;
+    case 2:
+        root = avl_build_sorted(sorted, n);
+        break;
+    default:
+        root = avl_build_stream(next_key, &ks);
+        break;
+    }
+    double ms = (now_ns() - start) / 1e6;
+
+    int ok = check_avl_invariant(root) && count_nodes(root) == n;
+    freeTree(root);
+    return ok ? ms : -1;
+}
+
+/* time_build_isolated: time_build in a fresh child, like run_isolated */
+static double time_build_isolated(int method, const int *sorted, const int *shuffled,
+                                  size_t n) {
+    double ms = -1;
+    int fds[2];
+    if (pipe(fds) != 0) return time_build(method, sorted, shuffled, n);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        ms = time_build(method, sorted, shuffled, n);
+        ssize_t written = write(fds[1], &ms, sizeof(ms));
+        _exit(written == (ssize_t)sizeof(ms) ? 0 : 1);
+    }
+    close(fds[1]);
+    if (pid < 0 || read(fds[0], &ms, sizeof(ms)) != (ssize_t)sizeof(ms)) {
+        ms = -1;
+    }
+    close(fds[0]);
+    if (pid > 0) waitpid(pid, NULL, 0);
+    return ms;
+}
+
+static void bench_build(size_t n) {
+    static const char *names[] = {
+        "insertAVL (sorted keys)", "insertAVL (random order)",
+        "avl_build_sorted", "avl_build_stream",
+    };
+    int *sorted = (int *)malloc(n * sizeof(int));
+    int *shuffled = (int *)malloc(n * sizeof(int));
+    if (sorted == NULL || shuffled == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    for (size_t i = 0; i < n; i++) sorted[i] = shuffled[i] = (int)i;
+    unsigned long long state = 42;
+    shuffle(shuffled, n, &state);
+
+    double best[4] = { -1, -1, -1, -1 };
+    for (int round = 0; round < ROUNDS; round++) {
+        for (int m = 0; m < 4; m++) {
+            double ms = time_build_isolated(m, sorted, shuffled, n);
+            if (ms < 0 || best[m] == -2) best[m] = -2;
+            else if (best[m] < 0 || ms < best[m]) best[m] = ms;
+        }
+    }
+
+    printf("n = %zu (best of %d)\n", n, ROUNDS);
+    for (int m = 0; m < 4; m++) {
+        if (best[m] == -2) {
+            printf("  %-26s INVALID\n", names[m]);
+        } else {
+            printf("  %-26s %9.1f ms  %6.1f ns/key\n", names[m], best[m], best[m] * 1e6 / n);
+        }
+    }
+
+    free(shuffled);
+    free(sorted);
+}
+
+/* ---------- Interval Queries ---------- */
+
+static size_t scan_overlap(const struct Interval *all, size_t n, int lo, int hi) {
+    size_t count = 0;
+    for (size_t i = 0; i < n; i++) count += all[i].start <= hi && all[i].end >= lo;
+    return count;
+}
+
+static unsigned long long next_random(unsigned long long *state) {
+    *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return *state >> 33;
+}
+
+static void bench_interval(size_t n) {
+    /* Starts spread over 100 n points: a point is covered ~5 times */
+    int range = (int)(n * 100);
+    struct Interval *all = (struct Interval *)malloc(n * sizeof(struct Interval));
+    struct Interval *out = (struct Interval *)malloc(n * sizeof(struct Interval));
+    int *points = (int *)malloc(QUERIES * sizeof(int));
+    if (all == NULL || out == NULL || points == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+
+    /* Start i lies in [100 i, 100 i + 100): all distinct, inserted shuffled */
+    unsigned long long state = 42;
+    for (size_t i = 0; i < n; i++) {
+        all[i].start = (int)(i * 100 + next_random(&state) % 100);
+        all[i].end = all[i].start + (int)(next_random(&state) % MAX_LENGTH);
+    }
+    for (size_t i = n - 1; i > 0; i--) {
+        size_t j = (size_t)(next_random(&state) % (i + 1));
+        struct Interval tmp = all[i];
+        all[i] = all[j];
+        all[j] = tmp;
+    }
+
+    struct IntervalNode *root = NULL;
+    double start = now_ns();
+    for (size_t i = 0; i < n; i++) root = avl_interval_insert(root, all[i].start, all[i].end);
+    double build_ms = (now_ns() - start) / 1e6;
+    for (int q = 0; q < QUERIES; q++) points[q] = (int)(next_random(&state) % (unsigned)range);
+
+    int valid = check_interval_invariant(root);
+    printf("n = %zu intervals (tree built in %.1f ms)\n", n, build_ms);
+
+    for (int width = 0; width <= MAX_LENGTH; width += MAX_LENGTH) {
+        size_t tree_hits = 0, scan_hits = 0;
+
+        start = now_ns();
+        for (int q = 0; q < QUERIES; q++) {
+            tree_hits += width == 0
+                ? avl_interval_stab(root, points[q], out, n)
+                : avl_interval_overlap(root, points[q], points[q] + width, out, n);
+        }
+        double tree_us = (now_ns() - start) / 1e3 / QUERIES;
+
+        start = now_ns();
+        for (int q = 0; q < QUERIES; q++) {
+            scan_hits += scan_overlap(all, n, points[q], points[q] + width);
+        }
+        double scan_us = (now_ns() - start) / 1e3 / QUERIES;
+
+        printf("  %-22s k = %5.1f  tree %8.2f us  scan %9.1f us  speedup %7.0fx  %s\n",
+               width == 0 ? "stab p" : "overlap [p, p+1000]",
+               (double)tree_hits / QUERIES, tree_us, scan_us, scan_us / tree_us,
+               valid && tree_hits == scan_hits ? "(valid)" : "(INVALID)");
+    }
+
+    avl_interval_free(root);
+    free(points);
+    free(out);
+    free(all);
+}
+
+/* ---------- Versioned Trees ---------- */
+
+static struct Node *copy_tree(const struct Node *n) {
+    if (n == NULL) return NULL;
+    struct Node *c = (struct Node *)malloc(sizeof(struct Node));
+    if (c == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    *c = *n;
+    c->left = copy_tree(n->left);
+    c->right = copy_tree(n->right);
+    return c;
+}
+
+/* sole_owner: every node has refs == 1, i.e. no version shares it */
+static int sole_owner(const struct PersistNode *n) {
+    if (n == NULL) return 1;
+    return n->refs == 1 && sole_owner(n->left) && sole_owner(n->right);
+}
+
+static void bench_persist(size_t n) {
+    int *keys = (int *)malloc(2 * n * sizeof(int));
+    struct PersistNode **versions =
+        (struct PersistNode **)malloc(PERSIST_VERSIONS * sizeof(struct PersistNode *));
+    struct Node **copies = (struct Node **)malloc(COPY_VERSIONS * sizeof(struct Node *));
+    if (keys == NULL || versions == NULL || copies == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    for (size_t i = 0; i < 2 * n; i++) keys[i] = (int)i;
+    unsigned long long state = 42;
+    shuffle(keys, 2 * n, &state);
+
+    /* Version 0: n random keys of [0, 2n) */
+    struct PersistNode *base = NULL;
+    struct Node *base_copy = NULL;
+    for (size_t i = 0; i < n; i++) {
+        struct PersistNode *next = avl_persist_insert(base, keys[i]);
+        avl_persist_release(base);
+        base = next;
+        base_copy = insertAVL(base_copy, keys[i]);
+    }
+    printf("n = %zu (version 0 holds n keys; one version per update)\n", n);
+
+    /* Path copying: version i + 1 = version i plus an insert (even i) or delete */
+    unsigned long long ops = 7;
+    int valid = 1;
+    double heap = heap_bytes();
+    double start = now_ns();
+    struct PersistNode *prev = base;
+    for (size_t i = 0; i < PERSIST_VERSIONS; i++) {
+        int key = (int)(next_random(&ops) % (2 * n));
+        prev = versions[i] = (i % 2 == 0) ? avl_persist_insert(prev, key)
+                                          : avl_persist_delete(prev, key);
+    }
+    double ns = (now_ns() - start) / PERSIST_VERSIONS;
+    double bytes = (heap_bytes() - heap) / PERSIST_VERSIONS;
+    valid &= check_persist_invariant(versions[PERSIST_VERSIONS - 1]);
+    valid &= check_persist_invariant(base);
+
+    /* Released versions must hand back every reference they took */
+    for (size_t i = 0; i < PERSIST_VERSIONS; i++) avl_persist_release(versions[i]);
+    int reclaimed = sole_owner(base);
+    printf("  %-10s %7d versions  %10.1f ns/version  %10.0f versions/s  %10.1f B/version  %s\n",
+           "path copy", PERSIST_VERSIONS, ns, 1e9 / ns, bytes,
+           valid ? (reclaimed ? "(valid, all reclaimed)" : "(valid, NOT reclaimed)")
+                 : "(INVALID)");
+    avl_persist_release(base);
+
+    /* Copy-on-snapshot: copy the whole tree, then update the copy */
+    ops = 7;
+    heap = heap_bytes();
+    start = now_ns();
+    const struct Node *last = base_copy;
+    for (size_t i = 0; i < COPY_VERSIONS; i++) {
+        int key = (int)(next_random(&ops) % (2 * n));
+        struct Node *copy = copy_tree(last);
+        copy = (i % 2 == 0) ? insertAVL(copy, key) : deleteAVL(copy, key);
+        last = copies[i] = copy;
+    }
+    ns = (now_ns() - start) / COPY_VERSIONS;
+    bytes = (heap_bytes() - heap) / COPY_VERSIONS;
+    valid = check_avl_invariant(copies[COPY_VERSIONS - 1]);
+    printf("  %-10s %7d versions  %10.1f ns/version  %10.0f versions/s  %10.1f B/version  %s\n",
+           "full copy", COPY_VERSIONS, ns, 1e9 / ns, bytes, valid ? "(valid)" : "(INVALID)");
+
+    for (size_t i = 0; i < COPY_VERSIONS; i++) freeTree(copies[i]);
+    freeTree(base_copy);
+    free(copies);
+    free(versions);
+    free(keys);
+}
+
+/* ---------- In-Order Scans ---------- */
+
+/* StackIter: in-order iterator over struct Node with an explicit stack */
+typedef struct {
+    struct Node *stack[64];  /* Enough for any AVL tree of < 2^31 keys */
+    int depth;
+} StackIter;
+
+/* stack_seek: position at the first key >= key */
+static void stack_seek(StackIter *it, struct Node *root, int key) {
+    it->depth = 0;
+    while (root != NULL) {
+        if (root->key >= key) {
+            it->stack[it->depth++] = root;
+            root = root->left;
+        } else {
+            root = root->right;
+        }
+    }
+}
+
+static struct Node *stack_next(StackIter *it) {
+    if (it->depth == 0) return NULL;
+    struct Node *n = it->stack[--it->depth];
+    for (struct Node *c = n->right; c != NULL; c = c->left) it->stack[it->depth++] = c;
+    return n;
+}
+
+static long sum_recursive(const struct Node *n) {
+    return n ? sum_recursive(n->left) + n->key + sum_recursive(n->right) : 0;
+}
+
+static void bench_threaded(size_t n) {
+    int *keys = (int *)malloc(n * sizeof(int));
+    int *starts = (int *)malloc(SCAN_RANGES * sizeof(int));
+    if (keys == NULL || starts == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    for (size_t i = 0; i < n; i++) keys[i] = (int)i;
+    unsigned long long state = 42;
+    shuffle(keys, n, &state);
+    for (int q = 0; q < SCAN_RANGES; q++) starts[q] = (int)(next_random(&state) % n);
+
+    /* Interleaved inserts give both trees the same allocation pattern */
+    struct Node *plain = NULL;
+    struct ThreadedNode *threaded = NULL;
+    for (size_t i = 0; i < n; i++) {
+        plain = insertAVL(plain, keys[i]);
+        threaded = avl_threaded_insert(threaded, keys[i]);
+    }
+    int valid = check_threaded_invariant(threaded);
+    long expect = (long)n * (long)(n - 1) / 2;
+
+    double full[3] = { 0, 0, 0 }, range[2] = { 0, 0 };
+    long range_sum[2] = { 0, 0 };
+    for (int round = 0; round < ROUNDS; round++) {
+        double start = now_ns();
+        long sum = 0;
+        for (const struct ThreadedNode *t = avl_threaded_first(threaded); t != NULL;
+             t = avl_threaded_next(t)) {
+            sum += t->key;
+        }
+        double ns = (now_ns() - start) / n;
+        if (round == 0 || ns < full[0]) full[0] = ns;
+        valid &= sum == expect;
+
+        StackIter it;
+        start = now_ns();
+        sum = 0;
+        stack_seek(&it, plain, 0);
+        for (struct Node *p = stack_next(&it); p != NULL; p = stack_next(&it)) sum += p->key;
+        ns = (now_ns() - start) / n;
+        if (round == 0 || ns < full[1]) full[1] = ns;
+        valid &= sum == expect;
+
+        start = now_ns();
+        sum = sum_recursive(plain);
+        ns = (now_ns() - start) / n;
+        if (round == 0 || ns < full[2]) full[2] = ns;
+        valid &= sum == expect;
+
+        start = now_ns();
+        sum = 0;
+        for (int q = 0; q < SCAN_RANGES; q++) {
+            const struct ThreadedNode *t = avl_threaded_lower_bound(threaded, starts[q]);
+            for (int i = 0; i < SCAN_LENGTH && t != NULL; i++, t = avl_threaded_next(t)) {
+                sum += t->key;
+            }
+        }
+        ns = (now_ns() - start) / SCAN_RANGES;
+        if (round == 0 || ns < range[0]) range[0] = ns;
+        range_sum[0] = sum;
+
+        start = now_ns();
+        sum = 0;
+        for (int q = 0; q < SCAN_RANGES; q++) {
+            stack_seek(&it, plain, starts[q]);
+            struct Node *p = stack_next(&it);
+            for (int i = 0; i < SCAN_LENGTH && p != NULL; i++, p = stack_next(&it)) {
+                sum += p->key;
+            }
+        }
+        ns = (now_ns() - start) / SCAN_RANGES;
+        if (round == 0 || ns < range[1]) range[1] = ns;
+        range_sum[1] = sum;
+    }
+    valid &= range_sum[0] == range_sum[1];
+
+    printf("n = %zu (best of %d) %s\n", n, ROUNDS, valid ? "(valid)" : "(INVALID)");
+    printf("  full scan    threaded %6.1f ns/key   stack %6.1f ns/key   recursive %6.1f ns/key\n",
+           full[0], full[1], full[2]);
+    printf("  range scan   threaded %6.0f ns/range stack %6.0f ns/range (%d keys each)\n",
+           range[0], range[1], SCAN_LENGTH);
+
+    avl_threaded_free(threaded);
+    freeTree(plain);
+    free(starts);
+    free(keys);
+}
+
+/* ---------- Concurrent Operations ---------- */
+
+typedef struct {
+    struct ConcurrentAVL *concurrent;  /* Exactly one of the two is set */
+    struct LockedAVL *locked;
+    int read_percent;
+    size_t ops, range;
+    unsigned long long seed;
+} Worker;
+
+static void *run_worker(void *arg) {
+    Worker *w = (Worker *)arg;
+    unsigned long long state = w->seed;
+    for (size_t i = 0; i < w->ops; i++) {
+        int key = (int)(next_random(&state) % w->range);
+        int roll = (int)(next_random(&state) % 100);
+        if (roll < w->read_percent) {
+            if (w->concurrent) avl_concurrent_search(w->concurrent, key);
+            else avl_locked_search(w->locked, key);
+        } else if (roll % 2 == 0) {
+            if (w->concurrent) avl_concurrent_insert(w->concurrent, key);
+            else avl_locked_insert(w->locked, key);
+        } else {
+            if (w->concurrent) avl_concurrent_delete(w->concurrent, key);
+            else avl_locked_delete(w->locked, key);
+        }
+    }
+    return NULL;
+}
+
+/* time_workers: Mops/s of CONCURRENT_OPS operations on `threads` threads, or -1 if invalid */
+static double time_workers(int concurrent, const int *keys, size_t n, int threads,
+                           int read_percent) {
+    struct ConcurrentAVL *ctree = NULL;
+    struct LockedAVL ltree;
+    if (concurrent) {
+        ctree = avl_concurrent_create();
+        for (size_t i = 0; i < n; i++) avl_concurrent_insert(ctree, keys[i]);
+    } else {
+        avl_locked_init(&ltree);
+        for (size_t i = 0; i < n; i++) avl_locked_insert(&ltree, keys[i]);
+    }
+
+    Worker workers[MAX_THREADS];
+    pthread_t ids[MAX_THREADS];
+    for (int t = 0; t < threads; t++) {
+        workers[t] = (Worker){ ctree, concurrent ? NULL : &ltree, read_percent,
+                               CONCURRENT_OPS / (size_t)threads, 2 * n,
+                               1000003ULL * (unsigned long long)(t + 1) };
+    }
+    double start = now_ns();
+    int started = 0;
+    for (; started < threads; started++) {
+        if (pthread_create(&ids[started], NULL, run_worker, &workers[started]) != 0) break;
+    }
+    for (int t = 0; t < started; t++) pthread_join(ids[t], NULL);
+    double seconds = (now_ns() - start) / 1e9;
+
+    int ok = started == threads;
+    if (concurrent) {
+        ok = ok && check_concurrent_invariant(ctree);
+        avl_concurrent_free(ctree);
+    } else {
+        ok = ok && check_avl_invariant(ltree.root);
+        avl_locked_destroy(&ltree);
+    }
+    return ok ? CONCURRENT_OPS / seconds / 1e6 : -1;
+}
+
+static void bench_concurrent(size_t n) {
+    static const int read_percents[] = { 90, 50 };
+    size_t range = 2 * n;
+    int *pool = (int *)malloc(range * sizeof(int));
+    if (pool == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    unsigned long long state = 42;
+    for (size_t i = 0; i < range; i++) pool[i] = (int)i;
+    shuffle(pool, range, &state);
+
+    printf("n = %zu, %d ops (Mops/s, best of %d)\n", n, CONCURRENT_OPS, ROUNDS);
+    printf("  %-22s", "");
+    for (int th = 1; th <= MAX_THREADS; th *= 2) printf("      %dT", th);
+    printf("\n");
+
+    for (int w = 0; w < 2; w++) {
+        for (int concurrent = 1; concurrent >= 0; concurrent--) {
+            double best[MAX_THREADS + 1] = { 0 };
+            for (int round = 0; round < ROUNDS; round++) {
+                for (int th = 1; th <= MAX_THREADS; th *= 2) {
+                    double mops = time_workers(concurrent, pool, n, th, read_percents[w]);
+                    if (mops < 0) best[th] = -1;  /* Stays INVALID */
+                    else if (best[th] >= 0 && mops > best[th]) best[th] = mops;
+                }
+            }
+            printf("  %d/%d %-16s", read_percents[w], 100 - read_percents[w],
+                   concurrent ? "concurrent" : "global lock");
+            for (int th = 1; th <= MAX_THREADS; th *= 2) {
+                if (best[th] < 0) printf(" %7s", "INVALID");
+                else printf(" %7.2f", best[th]);
+            }
+            printf("\n");
+        }
+    }
+    free(pool);
+}
+
+/* ---------- Concurrent Result Check ---------- */
+
+typedef struct {
+    struct ConcurrentAVL *tree;
+    int id, threads;
+    unsigned long long seed;
+    unsigned char *owned;      /* Reference set: 2 slots per key group of 4 */
+    long net[HOT_KEYS];        /* Hot phase: successful inserts - deletes */
+    long mismatches;
+} Checker;
+
+/* owned_by: thread that may update key k (classes 0 and 1 only) */
+static int owned_by(int k, int threads) {
+    return (k / 4) % threads;
+}
+
+/*
+ * run_exact_check: keys of [0, 4 * CHECK_KEYS) by k % 4 -
+ *   0, 1: only owned_by(k) updates them, so its reference set predicts
+ *         every result; other threads just search them
+ *   2:    never inserted - search and delete must return 0
+ *   3:    inserted up front, never deleted - search 1, insert 0
+ */
+static void *run_exact_check(void *arg) {
+    Checker *c = (Checker *)arg;
+    unsigned long long state = c->seed;
+    for (size_t i = 0; i < CHECK_OPS; i++) {
+        int k = (int)(next_random(&state) % (4 * CHECK_KEYS));
+        int op = (int)(next_random(&state) % 3);
+        int cls = k % 4, got, want;
+        if (cls < 2 && owned_by(k, c->threads) != c->id) {
+            avl_concurrent_search(c->tree, k);
+            continue;
+        }
+        if (cls < 2) {
+            unsigned char *ref = &c->owned[(k / 4) * 2 + cls];
+            if (op == 0) {
+                got = avl_concurrent_insert(c->tree, k);
+                want = !*ref;
+                *ref = 1;
+            } else if (op == 1) {
+                got = avl_concurrent_delete(c->tree, k);
+                want = *ref;
+                *ref = 0;
+            } else {
+                got = avl_concurrent_search(c->tree, k);
+                want = *ref;
+            }
+        } else if (cls == 2) {
+            got = op == 1 ? avl_concurrent_delete(c->tree, k) : avl_concurrent_search(c->tree, k);
+            want = 0;
+        } else {
+            got = op == 0 ? avl_concurrent_insert(c->tree, k) : avl_concurrent_search(c->tree, k);
+            want = op == 0 ? 0 : 1;
+        }
+        if (got != want) c->mismatches++;
+    }
+    return NULL;
+}
+
+/* run_hot_check: every thread updates the same HOT_KEYS keys (-1 .. -HOT_KEYS) */
+static void *run_hot_check(void *arg) {
+    Checker *c = (Checker *)arg;
+    unsigned long long state = c->seed;
+    for (size_t i = 0; i < CHECK_OPS; i++) {
+        int h = (int)(next_random(&state) % HOT_KEYS);
+        int op = (int)(next_random(&state) % 3);
+        if (op == 0) c->net[h] += avl_concurrent_insert(c->tree, -1 - h);
+        else if (op == 1) c->net[h] -= avl_concurrent_delete(c->tree, -1 - h);
+        else avl_concurrent_search(c->tree, -1 - h);
+    }
+    return NULL;
+}
+
+/* run_checkers: start one thread per checker and join them; 0 if any failed to start */
+static int run_checkers(Checker *checkers, int threads, void *(*fn)(void *)) {
+    pthread_t ids[MAX_THREADS];
+    int started = 0;
+    for (; started < threads; started++) {
+        if (pthread_create(&ids[started], NULL, fn, &checkers[started]) != 0) break;
+    }
+    for (int t = 0; t < started; t++) pthread_join(ids[t], NULL);
+    return started == threads;
+}
+
+/*
+ * check_concurrent: the two phases above on `threads` threads, then a
+ * quiescent comparison: owned keys against their reference sets, and
+ * each hot key's presence against the sum of its net updates (linearizable
+ * results can only add up to 0 or 1). Returns the number of mismatches.
+ */
+static long check_concurrent(int threads) {
+    struct ConcurrentAVL *tree = avl_concurrent_create();
+    Checker checkers[MAX_THREADS];
+    for (int k = 3; k < 4 * CHECK_KEYS; k += 4) avl_concurrent_insert(tree, k);
+    for (int t = 0; t < threads; t++) {
+        checkers[t] = (Checker){ tree, t, threads, 7919ULL * (unsigned long long)(t + 1),
+                                 calloc(2 * CHECK_KEYS, 1), { 0 }, 0 };
+        if (checkers[t].owned == NULL) {
+            fprintf(stderr, "Memory allocation failed\n");
+            exit(1);
+        }
+    }
+
+    long bad = 0;
+    if (!run_checkers(checkers, threads, run_exact_check)) bad++;
+    long expected_size = CHECK_KEYS;
+    for (int k = 0; k < 4 * CHECK_KEYS; k++) {
+        int cls = k % 4, want;
+        if (cls < 2) want = checkers[owned_by(k, threads)].owned[(k / 4) * 2 + cls];
+        else want = cls == 3;
+        if (cls < 2) expected_size += want;
+        if (avl_concurrent_search(tree, k) != want) bad++;
+    }
+    if (!run_checkers(checkers, threads, run_hot_check)) bad++;
+    for (int h = 0; h < HOT_KEYS; h++) {
+        long net = 0;
+        for (int t = 0; t < threads; t++) net += checkers[t].net[h];
+        if (net != avl_concurrent_search(tree, -1 - h)) bad++;
+        expected_size += net;
+    }
+    if (!check_concurrent_invariant(tree)) bad++;
+    if ((long)avl_concurrent_size(tree) != expected_size) bad++;
+
+    for (int t = 0; t < threads; t++) {
+        bad += checkers[t].mismatches;
+        free(checkers[t].owned);
+    }
+    avl_concurrent_free(tree);
+    return bad;
+}
+
+int main(int argc, char *argv[]) {
+    static const Variant recursion[] = {
+        { "recursive", run_pointer, insertAVL_rec, deleteAVL_rec, searchBST_rec, 0 },
+        { "iterative", run_pointer, insertAVL, deleteAVL, searchBST, 0 },
+    };
+    static const Variant layout[] = {
+        { "pointer", run_pointer, insertAVL, deleteAVL, searchBST, 0 },
+        { "compact", run_compact, NULL, NULL, NULL, 0 },
+        { "presized", run_compact, NULL, NULL, NULL, 1 },
+    };
+
+    if (argc > 1 && strcmp(argv[1], "--setops") == 0) {
+        if (argc == 2) {
+            bench_setops(1000000, 1000000);
+            bench_setops(1000000, 1000);
+        }
+        for (int i = 2; i < argc; i++) {
+            long n = atol(argv[i]);
+            if (n <= 0) continue;
+            bench_setops((size_t)n, (size_t)n);
+            if (n >= 1000) bench_setops((size_t)n, (size_t)n / 1000);
+        }
+        return 0;
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--concurrent-check") == 0) {
+        long total = 0;
+        for (int th = 1; th <= MAX_THREADS; th *= 2) {
+            long bad = check_concurrent(th);
+            printf("%dT: %d ops checked, %ld mismatches\n", th, 2 * CHECK_OPS * th, bad);
+            total += bad;
+        }
+        return total == 0 ? 0 : 1;
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--concurrent") == 0) {
+        if (argc == 2) bench_concurrent(1000000);
+        for (int i = 2; i < argc; i++) {
+            long n = atol(argv[i]);
+            if (n > 0) bench_concurrent((size_t)n);
+        }
+        return 0;
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--threaded") == 0) {
+        if (argc == 2) {
+            bench_threaded(1000000);
+            bench_threaded(10000000);
+        }
+        for (int i = 2; i < argc; i++) {
+            long n = atol(argv[i]);
+            if (n > 0) bench_threaded((size_t)n);
+        }
+        return 0;
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--persist") == 0) {
+        if (argc == 2) {
+            bench_persist(100000);
+            bench_persist(1000000);
+        }
+        for (int i = 2; i < argc; i++) {
+            long n = atol(argv[i]);
+            if (n > 0) bench_persist((size_t)n);
+        }
+        return 0;
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--interval") == 0) {
+        if (argc == 2) bench_interval(1000000);
+        for (int i = 2; i < argc; i++) {
+            long n = atol(argv[i]);
+            if (n > 0 && n <= 20000000) bench_interval((size_t)n);  /* 100 n fits an int */
+        }
+        return 0;
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--build") == 0) {
+        if (argc == 2) {
+            bench_build(1000000);
+            bench_build(10000000);
+        }
+        for (int i = 2; i < argc; i++) {
+            long n = atol(argv[i]);
+            if (n > 0) bench_build((size_t)n);
+        }
+        return 0;
+    }
+
+    const Variant *variants = recursion;
+    int count = 2;
+    int first = 1;
+    if (argc > 1 && strcmp(argv[1], "--compact") == 0) {
+        variants = layout;
+        count = 3;
+        first = 2;
+    }
+
+    if (argc <= first) {
+        if (variants == recursion) bench(1000000, variants, count);
+        bench(10000000, variants, count);
+        return 0;
+    }
+    for (int i = first; i < argc; i++) {
+        long n = atol(argv[i]);
+        if (n > 0) bench((size_t)n, variants, count);
+    }
+    return 0;
+}
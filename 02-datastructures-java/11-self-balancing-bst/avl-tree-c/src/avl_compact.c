@@ -0,0 +1,284 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "avl_compact.h"
+
+#define NIL 0u
+#define INDEX_MASK 0x7fffffffu
+#define HEAVY_BIT  0x80000000u
+#define MAX_NODES  INDEX_MASK      /* Largest index that fits in 31 bits */
+#define MAX_PATH   64              /* AVL height < 1.44 log2(2^31) < 46 */
+#define MIN_CAPACITY 16
+
+enum { LEFT = 0, RIGHT = 1 };
+
+_Static_assert(sizeof(struct CompactNode) == 12, "compact nodes are 12 bytes");
+
+/* ---------- Internal Helpers (Static) ---------- */
+
+static struct CompactNode *at(const struct CompactAVL *t, uint32_t i) {
+    return &t->nodes[i];
+}
+
+static uint32_t child(const struct CompactNode *n, int dir) {
+    return n->link[dir] & INDEX_MASK;
+}
+
+/* set_child: replace an index, keeping that field's heavy bit */
+static void set_child(struct CompactNode *n, int dir, uint32_t c) {
+    n->link[dir] = (n->link[dir] & HEAVY_BIT) | c;
+}
+
+static int get_bf(const struct CompactNode *n) {
+    return (int)(n->link[LEFT] >> 31) - (int)(n->link[RIGHT] >> 31);
+}
+
+static void set_bf(struct CompactNode *n, int bf) {
+    n->link[LEFT] = (n->link[LEFT] & INDEX_MASK) | (bf > 0 ? HEAVY_BIT : 0);
+    n->link[RIGHT] = (n->link[RIGHT] & INDEX_MASK) | (bf < 0 ? HEAVY_BIT : 0);
+}
+
+/* alloc_node: reuse a freed slot or take the next one, growing by 2x */
+static uint32_t alloc_node(struct CompactAVL *t, int key) {
+    uint32_t i = t->free_list;
+    if (i != NIL) {
+        t->free_list = at(t, i)->link[LEFT];
+    } else {
+        if (t->used == t->capacity) {
+            if (t->capacity > MAX_NODES) return NIL;
+            uint32_t capacity = t->capacity <= MAX_NODES / 2 ? t->capacity * 2 : MAX_NODES + 1;
+            struct CompactNode *grown = (struct CompactNode *)realloc(
+                t->nodes, (size_t)capacity * sizeof(struct CompactNode));
+            if (grown == NULL) return NIL;
+            t->nodes = grown;
+            t->capacity = capacity;
+        }
+        i = t->used++;
+    }
+    struct CompactNode *n = at(t, i);
+    n->key = key;
+    n->link[LEFT] = NIL;
+    n->link[RIGHT] = NIL;
+    return i;
+}
+
+static void free_node(struct CompactAVL *t, uint32_t i) {
+    at(t, i)->link[LEFT] = t->free_list;
+    t->free_list = i;
+}
+
+/* rotate: single rotation lifting child(p, dir) above p; returns it */
+static uint32_t rotate(struct CompactAVL *t, uint32_t p, int dir) {
+    struct CompactNode *pn = at(t, p);
+    uint32_t c = child(pn, dir);
+    struct CompactNode *cn = at(t, c);
+    set_child(pn, dir, child(cn, !dir));
+    set_child(cn, !dir, p);
+    return c;
+}
+
+/*
+ * fix_heavy: p has bf = +2 (dir LEFT) or -2 (dir RIGHT). Rotate and set
+ * the balance bits from the pre-rotation ones (no heights needed).
+ * *shrunk tells whether the subtree is now one level lower than before
+ * the imbalance (always after an insert; after a delete unless the
+ * heavy child was balanced).
+ */
+static uint32_t fix_heavy(struct CompactAVL *t, uint32_t p, int dir, int *shrunk) {
+    int sign = (dir == LEFT) ? 1 : -1;
+    uint32_t c = child(at(t, p), dir);
+    int cbf = get_bf(at(t, c)) * sign;  /* +1: same side, -1: zig-zag */
+
+    if (cbf >= 0) {
+        uint32_t top = rotate(t, p, dir);
+        if (cbf == 0) {  /* Only after a delete */
+            set_bf(at(t, p), sign);
+            set_bf(at(t, c), -sign);
+            *shrunk = 0;
+        } else {
+            set_bf(at(t, p), 0);
+            set_bf(at(t, c), 0);
+            *shrunk = 1;
+        }
+        return top;
+    }
+
+    uint32_t g = child(at(t, c), !dir);
+    int gbf = get_bf(at(t, g)) * sign;
+    set_child(at(t, p), dir, rotate(t, c, !dir));
+    uint32_t top = rotate(t, p, dir);
+    set_bf(at(t, p), gbf > 0 ? -sign : 0);
+    set_bf(at(t, c), gbf < 0 ? sign : 0);
+    set_bf(at(t, g), 0);
+    *shrunk = 1;
+    return top;
+}
+
+/* relink: point the parent of path[depth] (or the root) at node */
+static void relink(struct CompactAVL *t, const uint32_t *path, const int *dirs,
+                   int depth, uint32_t node) {
+    if (depth == 0) {
+        t->root = node;
+    } else {
+        set_child(at(t, path[depth - 1]), dirs[depth - 1], node);
+    }
+}
+
+/* ---------- Public Operations Implementation ---------- */
+
+struct CompactAVL *compact_create(size_t capacity_hint) {
+    struct CompactAVL *t = (struct CompactAVL *)calloc(1, sizeof(struct CompactAVL));
+    if (t == NULL) return NULL;
+
+    uint32_t capacity = MIN_CAPACITY;
+    if (capacity_hint >= MIN_CAPACITY) {
+        capacity = capacity_hint < MAX_NODES ? (uint32_t)capacity_hint + 1 : MAX_NODES + 1;
+    }
+    t->nodes = (struct CompactNode *)malloc((size_t)capacity * sizeof(struct CompactNode));
+    if (t->nodes == NULL) {
+        free(t);
+        return NULL;
+    }
+    t->capacity = capacity;
+    t->used = 1;  /* Slot 0 is NIL */
+    return t;
+}
+
+void compact_destroy(struct CompactAVL *tree) {
+    if (tree == NULL) return;
+    free(tree->nodes);
+    free(tree);
+}
+
+int compact_search(const struct CompactAVL *tree, int key) {
+    uint32_t link = tree->root;
+    while ((link & INDEX_MASK) != NIL) {
+        const struct CompactNode *n = at(tree, link & INDEX_MASK);
+        if (key == n->key) return 1;
+        /* Load both links, then select: compiles to cmov, like searchBST */
+        link = n->link[key > n->key];
+    }
+    return 0;
+}
+
+int compact_insert(struct CompactAVL *tree, int key) {
+    uint32_t path[MAX_PATH];
+    int dirs[MAX_PATH];
+    int depth = 0;
+
+    for (uint32_t i = tree->root; i != NIL; depth++) {
+        struct CompactNode *n = at(tree, i);
+        if (key == n->key) return 0;
+        path[depth] = i;
+        dirs[depth] = key < n->key ? LEFT : RIGHT;
+        i = child(n, dirs[depth]);
+    }
+
+    uint32_t fresh = alloc_node(tree, key);  /* May move the arena */
+    if (fresh == NIL) return -1;
+    relink(tree, path, dirs, depth, fresh);
+    tree->size++;
+
+    /* The subtree under path[d] grew on side dirs[d] */
+    while (depth > 0) {
+        uint32_t p = path[--depth];
+        int bf = get_bf(at(tree, p)) + (dirs[depth] == LEFT ? 1 : -1);
+        if (bf == 0) {
+            set_bf(at(tree, p), 0);
+            break;               /* Height unchanged */
+        }
+        if (bf == 1 || bf == -1) {
+            set_bf(at(tree, p), bf);
+            continue;            /* Grew by one: keep going */
+        }
+        int shrunk;
+        relink(tree, path, dirs, depth, fix_heavy(tree, p, dirs[depth], &shrunk));
+        break;                   /* Rotation restores the old height */
+    }
+    return 1;
+}
+
+int compact_delete(struct CompactAVL *tree, int key) {
+    uint32_t path[MAX_PATH];
+    int dirs[MAX_PATH];
+    int depth = 0;
+
+    uint32_t i = tree->root;
+    while (i != NIL && at(tree, i)->key != key) {
+        path[depth] = i;
+        dirs[depth] = key < at(tree, i)->key ? LEFT : RIGHT;
+        i = child(at(tree, i), dirs[depth++]);
+    }
+    if (i == NIL) return 0;
+
+    struct CompactNode *target = at(tree, i);
+    if (child(target, LEFT) != NIL && child(target, RIGHT) != NIL) {
+        /* Take the successor's key, then unlink the successor instead */
+        path[depth] = i;
+        dirs[depth++] = RIGHT;
+        uint32_t s = child(target, RIGHT);
+        while (child(at(tree, s), LEFT) != NIL) {
+            path[depth] = s;
+            dirs[depth++] = LEFT;
+            s = child(at(tree, s), LEFT);
+        }
+        target->key = at(tree, s)->key;
+        i = s;
+    }
+
+    struct CompactNode *gone = at(tree, i);
+    uint32_t only = child(gone, LEFT) != NIL ? child(gone, LEFT) : child(gone, RIGHT);
+    relink(tree, path, dirs, depth, only);
+    free_node(tree, i);
+    tree->size--;
+
+    /* The subtree under path[d] shrank on side dirs[d] */
+    while (depth > 0) {
+        uint32_t p = path[--depth];
+        int bf = get_bf(at(tree, p)) - (dirs[depth] == LEFT ? 1 : -1);
+        if (bf == 1 || bf == -1) {
+            set_bf(at(tree, p), bf);
+            break;               /* Was balanced: height unchanged */
+        }
+        if (bf == 0) {
+            set_bf(at(tree, p), 0);
+            continue;            /* Shrank by one: keep going */
+        }
+        int shrunk;
+        int heavy = bf > 0 ? LEFT : RIGHT;
+        relink(tree, path, dirs, depth, fix_heavy(tree, p, heavy, &shrunk));
+        if (!shrunk) break;
+    }
+    return 1;
+}
+
+size_t compact_memory(const struct CompactAVL *tree) {
+    return (size_t)tree->capacity * sizeof(struct CompactNode);
+}
+
+/* ---------- Invariant Checkers Implementation ---------- */
+
+/* check_subtree: returns height (-1 for NIL), or -2 on a violation */
+static int check_subtree(const struct CompactAVL *t, uint32_t i,
+                         const int *lo, const int *hi) {
+    if (i == NIL) return -1;
+    const struct CompactNode *n = at(t, i);
+    if ((lo && n->key <= *lo) || (hi && n->key >= *hi)) {
+        fprintf(stderr, "Error: BST property violated at key %d\n", n->key);
+        return -2;
+    }
+
+    int hl = check_subtree(t, child(n, LEFT), lo, &n->key);
+    int hr = check_subtree(t, child(n, RIGHT), &n->key, hi);
+    if (hl == -2 || hr == -2) return -2;
+
+    if (hl - hr != get_bf(n)) {
+        fprintf(stderr, "Error: Node %d has balance bits %+d, but real BF is %d\n",
+                n->key, get_bf(n), hl - hr);
+        return -2;
+    }
+    return 1 + (hl > hr ? hl : hr);
+}
+
+int check_compact_invariant(const struct CompactAVL *tree) {
+    return check_subtree(tree, tree->root, NULL, NULL) != -2;
+}
@@ -0,0 +1,50 @@
+#ifndef AVL_COMPACT_H
+#define AVL_COMPACT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Compact AVL tree: 12-byte nodes in one growable arena.
+ *
+ * Children are 31-bit indices into the arena (0 = none) and the top
+ * bit of each child field encodes the balance factor, so no height is
+ * stored:
+ *
+ *   link[0] = [left-heavy  bit | left index ]
+ *   link[1] = [right-heavy bit | right index]
+ *
+ * bf = left-heavy - right-heavy, in {-1, 0, +1} (same sign as
+ * getBalanceFactor in avl_tree.c). Freed slots are reused; the arena
+ * doubles when full, or can be presized with capacity_hint.
+ */
+
+struct CompactNode {
+    int32_t key;
+    uint32_t link[2];  /* [0] left, [1] right */
+};
+
+struct CompactAVL {
+    struct CompactNode *nodes;  /* nodes[0] is unused (index 0 = NIL) */
+    uint32_t capacity;          /* Slots allocated, including slot 0 */
+    uint32_t used;              /* Slots ever handed out, including slot 0 */
+    uint32_t free_list;         /* Freed slots chained through link[0] */
+    uint32_t root;
+    size_t size;                /* Keys in the tree */
+};
+
+/* ---------- Public Operations (API) ---------- */
+
+struct CompactAVL *compact_create(size_t capacity_hint);
+void compact_destroy(struct CompactAVL *tree);
+
+int compact_insert(struct CompactAVL *tree, int key);  /* 1 added, 0 present, -1 full */
+int compact_delete(struct CompactAVL *tree, int key);  /* 1 removed, 0 absent */
+int compact_search(const struct CompactAVL *tree, int key);
+
+size_t compact_memory(const struct CompactAVL *tree);  /* Arena bytes */
+
+/* Invariant Checker: BST order and balance bits against real heights */
+int check_compact_invariant(const struct CompactAVL *tree);
+
+#endif /* AVL_COMPACT_H */
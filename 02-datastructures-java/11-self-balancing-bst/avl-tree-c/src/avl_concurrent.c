@@ -0,0 +1,752 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+#include "avl_concurrent.h"
+
+#define NIL_HEIGHT (-1)
+#define SPINS_BEFORE_YIELD 100
+#ifndef PENDING_STACK
+#define PENDING_STACK 64  /* Initial stack of subtrees still to re-check (grows) */
+#endif
+
+/* Version word: low bits flag the node, the rest counts finished changes */
+#define UNLINKED ((uint64_t)1)
+#define CHANGING ((uint64_t)2)
+#define VERSION_STEP ((uint64_t)4)
+
+/* node_condition results; anything >= 0 is a corrected height */
+#define NOTHING_REQUIRED (-4)
+#define REBALANCE_REQUIRED (-3)
+#define UNLINK_REQUIRED (-2)
+
+/* Result of an attempt whose validation failed: redo it from the parent */
+#define RETRY (-1)
+
+/*
+ * Naming follows the paper: a function ending in _nl expects the caller
+ * to hold the lock of every node passed to it (except the last child
+ * pointers it only reads). Nodes are locked parent before child.
+ */
+
+/* ---------- Internal Helpers (Static) ---------- */
+
+static struct ConcNode *newNode(int key, struct ConcNode *parent) {
+    struct ConcNode *node = (struct ConcNode *)malloc(sizeof(struct ConcNode));
+    if (node == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    atomic_init(&node->left, NULL);
+    atomic_init(&node->right, NULL);
+    atomic_init(&node->parent, parent);
+    atomic_init(&node->version, 0);
+    atomic_init(&node->height, 0);
+    atomic_init(&node->present, 1);
+    node->key = key;
+    node->retired = NULL;
+    pthread_mutex_init(&node->lock, NULL);
+    return node;
+}
+
+static void destroy_node(struct ConcNode *n) {
+    pthread_mutex_destroy(&n->lock);
+    free(n);
+}
+
+static void lock(struct ConcNode *n) {
+    pthread_mutex_lock(&n->lock);
+}
+
+static void unlock(struct ConcNode *n) {
+    pthread_mutex_unlock(&n->lock);
+}
+
+/* compare: direction from n towards key: -1 left, 0 here, 1 right */
+static int compare(int key, const struct ConcNode *n) {
+    return (key > n->key) - (key < n->key);
+}
+
+static struct ConcNode *left(struct ConcNode *n) {
+    return atomic_load(&n->left);
+}
+
+static struct ConcNode *right(struct ConcNode *n) {
+    return atomic_load(&n->right);
+}
+
+/*
+ * child: both links are loaded (same cache line) and one is selected.
+ * The compiler will not turn a conditional atomic load into a cmov, and
+ * the mispredicted branch made searches ~2.5x slower.
+ */
+static struct ConcNode *child(struct ConcNode *n, int dir) {
+    struct ConcNode *l = left(n), *r = right(n);
+    return dir < 0 ? l : r;
+}
+
+static void set_child(struct ConcNode *n, int dir, struct ConcNode *c) {
+    atomic_store(dir < 0 ? &n->left : &n->right, c);
+    if (c != NULL) atomic_store(&c->parent, n);
+}
+
+/* replace_child: point the link of parent that held old at c */
+static void replace_child(struct ConcNode *parent, struct ConcNode *old, struct ConcNode *c) {
+    set_child(parent, left(parent) == old ? -1 : 1, c);
+}
+
+static int getHeight(struct ConcNode *n) {
+    return n ? atomic_load_explicit(&n->height, memory_order_relaxed) : NIL_HEIGHT;
+}
+
+static void setHeight(struct ConcNode *n, int height) {
+    atomic_store_explicit(&n->height, height, memory_order_relaxed);
+}
+
+static int max(int a, int b) {
+    return (a > b) ? a : b;
+}
+
+static int is_present(struct ConcNode *n) {
+    return atomic_load(&n->present);
+}
+
+static uint64_t version(struct ConcNode *n) {
+    return atomic_load(&n->version);
+}
+
+static int is_unlinked(uint64_t v) {
+    return (v & UNLINKED) != 0;
+}
+
+static int changing_or_unlinked(uint64_t v) {
+    return (v & (CHANGING | UNLINKED)) != 0;
+}
+
+/* begin_change / end_change: bracket a rotation that moves n down (lock held) */
+static void begin_change(struct ConcNode *n) {
+    atomic_store(&n->version, version(n) | CHANGING);
+}
+
+static void end_change(struct ConcNode *n) {
+    atomic_store(&n->version, (version(n) & ~CHANGING) + VERSION_STEP);
+}
+
+/* wait_until_change_completed: spin (then yield) while a rotation is under way */
+static void wait_until_change_completed(struct ConcNode *n, uint64_t v) {
+    if (!(v & CHANGING)) return;
+    for (int spins = 0; version(n) == v; spins++) {
+        if (spins >= SPINS_BEFORE_YIELD) sched_yield();
+    }
+}
+
+static void retire(struct ConcurrentAVL *tree, struct ConcNode *n) {
+    struct ConcNode *head = atomic_load(&tree->retired);
+    do {
+        n->retired = head;
+    } while (!atomic_compare_exchange_weak(&tree->retired, &head, n));
+}
+
+/* ---------- Relaxed Rebalancing ---------- */
+
+/*
+ * node_condition: what n needs, judged from unlocked reads: unlinking
+ * (a routing node with < 2 children), a rotation, a new height (>= 0),
+ * or nothing.
+ */
+static int node_condition(struct ConcNode *n) {
+    struct ConcNode *l = left(n), *r = right(n);
+    if ((l == NULL || r == NULL) && !is_present(n)) return UNLINK_REQUIRED;
+
+    int hl = getHeight(l), hr = getHeight(r);
+    int height = 1 + max(hl, hr);
+    if (hl - hr < -1 || hl - hr > 1) return REBALANCE_REQUIRED;
+    return height != getHeight(n) ? height : NOTHING_REQUIRED;
+}
+
+/* fix_height_nl: repair n's height if that is all it needs; returns the next node to look at */
+static struct ConcNode *fix_height_nl(struct ConcNode *n) {
+    int c = node_condition(n);
+    switch (c) {
+    case REBALANCE_REQUIRED:
+    case UNLINK_REQUIRED:
+        return n;
+    case NOTHING_REQUIRED:
+        return NULL;
+    default:
+        setHeight(n, c);
+        return atomic_load(&n->parent);
+    }
+}
+
+/* attempt_unlink_nl: splice out n (< 2 children) from below parent; 0 if n changed */
+static int attempt_unlink_nl(struct ConcurrentAVL *tree, struct ConcNode *parent,
+                             struct ConcNode *n) {
+    if (left(parent) != n && right(parent) != n) return 0;
+    struct ConcNode *l = left(n), *r = right(n);
+    if (l != NULL && r != NULL) return 0;
+
+    atomic_store(&n->present, 0);
+    replace_child(parent, n, l ? l : r);
+    atomic_store(&n->version, version(n) | UNLINKED);
+    retire(tree, n);
+    return 1;
+}
+
+/*
+ * Rotations. Only the node that moves down loses keys from its subtree,
+ * so only it is marked as changing: a search inside it waits or
+ * retries, a search anywhere else stays valid. Afterwards each returns
+ * the node that still needs work (heights of the moved nodes are exact,
+ * but a grandchild read without its lock may have changed meanwhile).
+ */
+static struct ConcNode *rotate_right_nl(struct ConcNode *parent, struct ConcNode *n,
+                                        struct ConcNode *l, int hr, int hll,
+                                        struct ConcNode *lr, int hlr) {
+    begin_change(n);
+    set_child(n, -1, lr);
+    set_child(l, 1, n);
+    replace_child(parent, n, l);
+    int hn = 1 + max(hlr, hr);
+    setHeight(n, hn);
+    setHeight(l, 1 + max(hll, hn));
+    end_change(n);
+
+    if (hlr - hr < -1 || hlr - hr > 1) return n;
+    if ((lr == NULL || hr == NIL_HEIGHT) && !is_present(n)) return n;
+    if (hll - hn < -1 || hll - hn > 1) return l;
+    if (hll == NIL_HEIGHT && !is_present(l)) return l;
+    return fix_height_nl(parent);
+}
+
+static struct ConcNode *rotate_left_nl(struct ConcNode *parent, struct ConcNode *n,
+                                       struct ConcNode *r, int hl, int hrr,
+                                       struct ConcNode *rl, int hrl) {
+    begin_change(n);
+    set_child(n, 1, rl);
+    set_child(r, -1, n);
+    replace_child(parent, n, r);
+    int hn = 1 + max(hl, hrl);
+    setHeight(n, hn);
+    setHeight(r, 1 + max(hn, hrr));
+    end_change(n);
+
+    if (hrl - hl < -1 || hrl - hl > 1) return n;
+    if ((rl == NULL || hl == NIL_HEIGHT) && !is_present(n)) return n;
+    if (hrr - hn < -1 || hrr - hn > 1) return r;
+    if (hrr == NIL_HEIGHT && !is_present(r)) return r;
+    return fix_height_nl(parent);
+}
+
+/* rotate_right_over_left_nl: double rotation, lr becomes the subtree root */
+static struct ConcNode *rotate_right_over_left_nl(struct ConcNode *parent, struct ConcNode *n,
+                                                  struct ConcNode *l, int hr, int hll,
+                                                  struct ConcNode *lr, int hlrl) {
+    struct ConcNode *lrl = left(lr), *lrr = right(lr);
+    int hlrr = getHeight(lrr);
+
+    begin_change(n);
+    begin_change(l);
+    set_child(n, -1, lrr);
+    set_child(l, 1, lrl);
+    set_child(lr, -1, l);
+    set_child(lr, 1, n);
+    replace_child(parent, n, lr);
+    int hn = 1 + max(hlrr, hr);
+    int hl = 1 + max(hll, hlrl);
+    setHeight(n, hn);
+    setHeight(l, hl);
+    setHeight(lr, 1 + max(hl, hn));
+    end_change(n);
+    end_change(l);
+
+    if (hlrr - hr < -1 || hlrr - hr > 1) return n;
+    if ((lrr == NULL || hr == NIL_HEIGHT) && !is_present(n)) return n;
+    if (hl - hn < -1 || hl - hn > 1) return lr;
+    return fix_height_nl(parent);
+}
+
+static struct ConcNode *rotate_left_over_right_nl(struct ConcNode *parent, struct ConcNode *n,
+                                                  struct ConcNode *r, int hl, int hrr,
+                                                  struct ConcNode *rl, int hrlr) {
+    struct ConcNode *rll = left(rl), *rlr = right(rl);
+    int hrll = getHeight(rll);
+
+    begin_change(n);
+    begin_change(r);
+    set_child(n, 1, rll);
+    set_child(r, -1, rlr);
+    set_child(rl, 1, r);
+    set_child(rl, -1, n);
+    replace_child(parent, n, rl);
+    int hn = 1 + max(hl, hrll);
+    int hr = 1 + max(hrlr, hrr);
+    setHeight(n, hn);
+    setHeight(r, hr);
+    setHeight(rl, 1 + max(hn, hr));
+    end_change(n);
+    end_change(r);
+
+    if (hrll - hl < -1 || hrll - hl > 1) return n;
+    if ((rll == NULL || hl == NIL_HEIGHT) && !is_present(n)) return n;
+    if (hr - hn < -1 || hr - hn > 1) return rl;
+    return fix_height_nl(parent);
+}
+
+/* rebalance_to_right_nl: n's left side is too high (parent and n locked) */
+static struct ConcNode *rebalance_to_right_nl(struct ConcNode *parent, struct ConcNode *n,
+                                              struct ConcNode *l, int hr) {
+    struct ConcNode *result;
+    lock(l);
+    if (getHeight(l) - hr <= 1) {
+        unlock(l);
+        return n;  /* Changed meanwhile: look at n again */
+    }
+    struct ConcNode *lr = right(l);
+    int hll = getHeight(left(l));
+    int hlr = getHeight(lr);
+    if (hll >= hlr) {
+        result = rotate_right_nl(parent, n, l, hr, hll, lr, hlr);
+        unlock(l);
+        return result;
+    }
+
+    lock(lr);
+    hlr = getHeight(lr);
+    if (hll >= hlr) {
+        result = rotate_right_nl(parent, n, l, hr, hll, lr, hlr);
+        unlock(lr);
+        unlock(l);
+        return result;
+    }
+    int hlrl = getHeight(left(lr));
+    int bf = hll - hlrl;
+    if (bf >= -1 && bf <= 1 && !((hll == NIL_HEIGHT || hlrl == NIL_HEIGHT) && !is_present(l))) {
+        result = rotate_right_over_left_nl(parent, n, l, hr, hll, lr, hlrl);
+        unlock(lr);
+        unlock(l);
+        return result;
+    }
+
+    /*
+     * The double rotation would leave l unbalanced or an unlinkable
+     * routing node. Do its first half only: everything that still needs
+     * work is then on the path from l up through lr and n.
+     */
+    result = rotate_left_nl(n, l, lr, hll, getHeight(right(lr)), left(lr), hlrl);
+    unlock(lr);
+    unlock(l);
+    return result;
+}
+
+/* rebalance_to_left_nl: n's right side is too high (parent and n locked) */
+static struct ConcNode *rebalance_to_left_nl(struct ConcNode *parent, struct ConcNode *n,
+                                             struct ConcNode *r, int hl) {
+    struct ConcNode *result;
+    lock(r);
+    if (getHeight(r) - hl <= 1) {
+        unlock(r);
+        return n;
+    }
+    struct ConcNode *rl = left(r);
+    int hrl = getHeight(rl);
+    int hrr = getHeight(right(r));
+    if (hrr >= hrl) {
+        result = rotate_left_nl(parent, n, r, hl, hrr, rl, hrl);
+        unlock(r);
+        return result;
+    }
+
+    lock(rl);
+    hrl = getHeight(rl);
+    if (hrr >= hrl) {
+        result = rotate_left_nl(parent, n, r, hl, hrr, rl, hrl);
+        unlock(rl);
+        unlock(r);
+        return result;
+    }
+    int hrlr = getHeight(right(rl));
+    int bf = hrr - hrlr;
+    if (bf >= -1 && bf <= 1 && !((hrr == NIL_HEIGHT || hrlr == NIL_HEIGHT) && !is_present(r))) {
+        result = rotate_left_over_right_nl(parent, n, r, hl, hrr, rl, hrlr);
+        unlock(rl);
+        unlock(r);
+        return result;
+    }
+
+    result = rotate_right_nl(n, r, rl, hrr, getHeight(left(rl)), right(rl), hrlr);
+    unlock(rl);
+    unlock(r);
+    return result;
+}
+
+/* rebalance_nl: unlink, rotate or re-height n (parent and n locked) */
+static struct ConcNode *rebalance_nl(struct ConcurrentAVL *tree, struct ConcNode *parent,
+                                     struct ConcNode *n) {
+    struct ConcNode *l = left(n), *r = right(n);
+    if ((l == NULL || r == NULL) && !is_present(n)) {
+        return attempt_unlink_nl(tree, parent, n) ? fix_height_nl(parent) : n;
+    }
+
+    int hl = getHeight(l), hr = getHeight(r);
+    if (hl - hr > 1) return rebalance_to_right_nl(parent, n, l, hr);
+    if (hl - hr < -1) return rebalance_to_left_nl(parent, n, r, hl);
+    if (getHeight(n) != 1 + max(hl, hr)) {
+        setHeight(n, 1 + max(hl, hr));
+        return fix_height_nl(parent);
+    }
+    return NULL;
+}
+
+/* grow_pending: double the re-check stack, moving it to the heap the first time */
+static struct ConcNode **grow_pending(struct ConcNode **pending, struct ConcNode **on_stack,
+                                      int *cap) {
+    size_t bytes = 2 * (size_t)*cap * sizeof(struct ConcNode *);
+    struct ConcNode **grown = pending == on_stack ? malloc(bytes) : realloc(pending, bytes);
+    if (grown == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    if (pending == on_stack) {
+        for (int i = 0; i < *cap; i++) grown[i] = on_stack[i];
+    }
+    *cap *= 2;
+    return grown;
+}
+
+/*
+ * fix_height_and_rebalance: walk up from a damaged node, locking at
+ * most the node, its parent and two nodes below at a time, until a
+ * node needs nothing. Stops at the holder (no parent). A rotation can
+ * hand back a node below the rotated subtree (e.g. a routing node it
+ * left with one child); the subtree's parent is then stacked, because
+ * the walk from below may stop before it gets there. Dropping an entry
+ * could leave the tree unbalanced, so the stack grows when full.
+ */
+static void fix_height_and_rebalance(struct ConcurrentAVL *tree, struct ConcNode *node) {
+    struct ConcNode *on_stack[PENDING_STACK];
+    struct ConcNode **pending = on_stack;
+    int depth = 0, cap = PENDING_STACK;
+
+    for (;;) {
+        if (node == NULL || atomic_load(&node->parent) == NULL ||
+            is_unlinked(version(node))) {
+            if (depth == 0) break;
+            node = pending[--depth];
+            continue;
+        }
+        int c = node_condition(node);
+        if (c == NOTHING_REQUIRED) {
+            node = NULL;
+            continue;
+        }
+
+        if (c != UNLINK_REQUIRED && c != REBALANCE_REQUIRED) {
+            struct ConcNode *n = node;
+            lock(n);
+            node = fix_height_nl(n);
+            unlock(n);
+        } else {
+            struct ConcNode *parent = atomic_load(&node->parent);
+            lock(parent);
+            if (!is_unlinked(version(parent)) && atomic_load(&node->parent) == parent) {
+                struct ConcNode *n = node;
+                lock(n);
+                node = rebalance_nl(tree, parent, n);
+                unlock(n);
+                if (node != NULL && node != parent && node != atomic_load(&parent->parent)) {
+                    if (depth == cap) pending = grow_pending(pending, on_stack, &cap);
+                    pending[depth++] = parent;
+                }
+            }
+            unlock(parent);
+        }
+    }
+    if (pending != on_stack) free(pending);
+}
+
+/* ---------- Updates ---------- */
+
+/* attempt_revive: insert key into its routing node n */
+static int attempt_revive(struct ConcNode *n) {
+    if (is_present(n)) return 0;
+    lock(n);
+    if (is_unlinked(version(n))) {
+        unlock(n);
+        return RETRY;
+    }
+    int added = !is_present(n);
+    atomic_store(&n->present, 1);
+    unlock(n);
+    return added;
+}
+
+/*
+ * attempt_remove: delete n's key. With < 2 children n is unlinked
+ * under the locks of parent and n; otherwise it only becomes a routing
+ * node and a later unlink or rotation removes it.
+ */
+static int attempt_remove(struct ConcurrentAVL *tree, struct ConcNode *parent,
+                          struct ConcNode *n) {
+    if (!is_present(n)) return 0;
+
+    if (left(n) == NULL || right(n) == NULL) {
+        lock(parent);
+        if (is_unlinked(version(parent)) || atomic_load(&n->parent) != parent) {
+            unlock(parent);
+            return RETRY;
+        }
+        lock(n);
+        if (!is_present(n)) {
+            unlock(n);
+            unlock(parent);
+            return 0;
+        }
+        if (!attempt_unlink_nl(tree, parent, n)) {
+            unlock(n);
+            unlock(parent);
+            return RETRY;
+        }
+        unlock(n);
+        struct ConcNode *damaged = fix_height_nl(parent);
+        unlock(parent);
+        fix_height_and_rebalance(tree, damaged);
+        return 1;
+    }
+
+    lock(n);
+    if (is_unlinked(version(n)) || left(n) == NULL || right(n) == NULL) {
+        unlock(n);
+        return RETRY;  /* Lost a child: take the unlinking path */
+    }
+    int removed = is_present(n);
+    atomic_store(&n->present, 0);
+    unlock(n);
+    return removed;
+}
+
+/*
+ * attempt_update: insert (insert != 0) or delete key below node,
+ * entered at version node_v, in direction dir. Every child read is
+ * validated against node_v; if node changed, RETRY sends the attempt
+ * back to node's parent. A new leaf is linked under node's lock;
+ * the rebalancing runs after that lock is released.
+ */
+static int attempt_update(struct ConcurrentAVL *tree, int key, int insert,
+                          struct ConcNode *node, int dir, uint64_t node_v) {
+    for (;;) {
+        struct ConcNode *c = child(node, dir);
+        if (version(node) != node_v) return RETRY;
+
+        if (c == NULL) {
+            if (!insert) return 0;
+            lock(node);
+            if (version(node) != node_v) {
+                unlock(node);
+                return RETRY;
+            }
+            if (child(node, dir) != NULL) {
+                unlock(node);
+                continue;  /* Someone else linked a child here first */
+            }
+            set_child(node, dir, newNode(key, node));
+            struct ConcNode *damaged = fix_height_nl(node);
+            unlock(node);
+            fix_height_and_rebalance(tree, damaged);
+            return 1;
+        }
+
+        int c_dir = compare(key, c);
+        if (c_dir == 0) {
+            int result = insert ? attempt_revive(c) : attempt_remove(tree, node, c);
+            if (result != RETRY) return result;
+            continue;
+        }
+
+        uint64_t c_v = version(c);
+        if (changing_or_unlinked(c_v)) {
+            wait_until_change_completed(c, c_v);
+        } else if (c == child(node, dir)) {
+            if (version(node) != node_v) return RETRY;
+            int result = attempt_update(tree, key, insert, c, c_dir, c_v);
+            if (result != RETRY) return result;
+        }
+    }
+}
+
+/* ---------- Public API Implementation ---------- */
+
+struct ConcurrentAVL *avl_concurrent_create(void) {
+    struct ConcurrentAVL *tree = (struct ConcurrentAVL *)malloc(sizeof(struct ConcurrentAVL));
+    if (tree == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    struct ConcNode *holder = &tree->holder;
+    atomic_init(&holder->left, NULL);
+    atomic_init(&holder->right, NULL);
+    atomic_init(&holder->parent, NULL);
+    atomic_init(&holder->version, 0);
+    atomic_init(&holder->height, 0);
+    atomic_init(&holder->present, 1);
+    holder->key = 0;
+    holder->retired = NULL;
+    pthread_mutex_init(&holder->lock, NULL);
+    atomic_init(&tree->retired, NULL);
+    return tree;
+}
+
+/*
+ * Hand-over-hand without locks: a child read from node counts only if
+ * node's version is still node_v afterwards, and c's version is read
+ * while c is still that child. Unlike attempt_update, a failed check
+ * restarts from the root instead of backing up one level: the loop
+ * beat the recursive version by ~1.4x, and restarts are rare.
+ */
+int avl_concurrent_search(struct ConcurrentAVL *tree, int key) {
+    for (;;) {
+        struct ConcNode *node = &tree->holder;
+        uint64_t node_v = version(node);
+        int dir = 1;
+        for (;;) {
+            struct ConcNode *c = child(node, dir);
+            if (c == NULL) {
+                if (version(node) == node_v) return 0;
+                break;
+            }
+            int c_dir = compare(key, c);
+            if (c_dir == 0) return is_present(c);
+
+            uint64_t c_v = version(c);
+            if (changing_or_unlinked(c_v)) {
+                wait_until_change_completed(c, c_v);
+            } else if (c == child(node, dir) && version(node) == node_v) {
+                node = c;
+                node_v = c_v;
+                dir = c_dir;
+                continue;
+            }
+            if (version(node) != node_v) break;  /* Else re-read the child */
+        }
+    }
+}
+
+/* The holder never changes version, so these loops never repeat */
+int avl_concurrent_insert(struct ConcurrentAVL *tree, int key) {
+    int added;
+    do {
+        added = attempt_update(tree, key, 1, &tree->holder, 1, version(&tree->holder));
+    } while (added == RETRY);
+    return added;
+}
+
+int avl_concurrent_delete(struct ConcurrentAVL *tree, int key) {
+    int removed;
+    do {
+        removed = attempt_update(tree, key, 0, &tree->holder, 1, version(&tree->holder));
+    } while (removed == RETRY);
+    return removed;
+}
+
+void avl_concurrent_reclaim(struct ConcurrentAVL *tree) {
+    struct ConcNode *n = atomic_exchange(&tree->retired, NULL);
+    while (n != NULL) {
+        struct ConcNode *next = n->retired;
+        destroy_node(n);
+        n = next;
+    }
+}
+
+static void free_subtree(struct ConcNode *n) {
+    if (n == NULL) return;
+    free_subtree(left(n));
+    free_subtree(right(n));
+    destroy_node(n);
+}
+
+void avl_concurrent_free(struct ConcurrentAVL *tree) {
+    if (tree == NULL) return;
+    avl_concurrent_reclaim(tree);
+    free_subtree(right(&tree->holder));
+    pthread_mutex_destroy(&tree->holder.lock);
+    free(tree);
+}
+
+static size_t count_present(struct ConcNode *n) {
+    if (n == NULL) return 0;
+    return count_present(left(n)) + (size_t)is_present(n) + count_present(right(n));
+}
+
+size_t avl_concurrent_size(struct ConcurrentAVL *tree) {
+    return count_present(right(&tree->holder));
+}
+
+/* ---------- Invariant Checkers Implementation ---------- */
+
+/* check_subtree: returns height (NIL_HEIGHT for NULL), or -2 on a violation */
+static int check_subtree(struct ConcNode *n, struct ConcNode *parent,
+                         const int *lo, const int *hi) {
+    if (n == NULL) return NIL_HEIGHT;
+    if ((lo && n->key <= *lo) || (hi && n->key >= *hi)) {
+        fprintf(stderr, "Error: BST property violated at key %d\n", n->key);
+        return -2;
+    }
+    if (atomic_load(&n->parent) != parent || version(n) & (CHANGING | UNLINKED)) {
+        fprintf(stderr, "Error: Node %d has a wrong parent link or version\n", n->key);
+        return -2;
+    }
+    if ((left(n) == NULL || right(n) == NULL) && !is_present(n)) {
+        fprintf(stderr, "Error: Routing node %d has fewer than two children\n", n->key);
+        return -2;
+    }
+
+    int hl = check_subtree(left(n), n, lo, &n->key);
+    int hr = check_subtree(right(n), n, &n->key, hi);
+    if (hl == -2 || hr == -2) return -2;
+    if (getHeight(n) != 1 + max(hl, hr)) {
+        fprintf(stderr, "Error: Node %d has stored height %d, but real height is %d\n",
+                n->key, getHeight(n), 1 + max(hl, hr));
+        return -2;
+    }
+    if (hl - hr < -1 || hl - hr > 1) {
+        fprintf(stderr, "Error: Node %d is unbalanced (BF = %d)\n", n->key, hl - hr);
+        return -2;
+    }
+    return getHeight(n);
+}
+
+int check_concurrent_invariant(struct ConcurrentAVL *tree) {
+    return check_subtree(right(&tree->holder), &tree->holder, NULL, NULL) != -2;
+}
+
+/* ---------- Global-Lock Wrapper ---------- */
+
+void avl_locked_init(struct LockedAVL *tree) {
+    pthread_mutex_init(&tree->lock, NULL);
+    tree->root = NULL;
+}
+
+void avl_locked_insert(struct LockedAVL *tree, int key) {
+    pthread_mutex_lock(&tree->lock);
+    tree->root = insertAVL(tree->root, key);
+    pthread_mutex_unlock(&tree->lock);
+}
+
+void avl_locked_delete(struct LockedAVL *tree, int key) {
+    pthread_mutex_lock(&tree->lock);
+    tree->root = deleteAVL(tree->root, key);
+    pthread_mutex_unlock(&tree->lock);
+}
+
+int avl_locked_search(struct LockedAVL *tree, int key) {
+    pthread_mutex_lock(&tree->lock);
+    int found = searchBST(tree->root, key);
+    pthread_mutex_unlock(&tree->lock);
+    return found;
+}
+
+void avl_locked_destroy(struct LockedAVL *tree) {
+    freeTree(tree->root);
+    tree->root = NULL;
+    pthread_mutex_destroy(&tree->lock);
+}
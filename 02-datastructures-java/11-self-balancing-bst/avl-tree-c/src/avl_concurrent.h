@@ -0,0 +1,82 @@
+#ifndef AVL_CONCURRENT_H
+#define AVL_CONCURRENT_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include "avl_tree.h"
+
+/*
+ * Concurrent AVL set after Bronson, Casper, Chafi and Olukotun, "A
+ * Practical Concurrent Binary Search Tree" (PPoPP 2010).
+ *
+ * - Every node has a version word and a mutex. A rotation marks the
+ *   node that moves down as changing, and bumps its version when done.
+ * - Searches take no locks. They read a child, then check that the
+ *   parent's version did not change (hand-over-hand validation), and
+ *   start over if it did. The only wait is for a rotation already in
+ *   progress at the node they are about to enter.
+ * - Writers lock only the nodes they link or unlink (parent before
+ *   child). Heights are repaired, and rotations done, afterwards and
+ *   bottom-up by fix_height_and_rebalance, a few nodes at a time
+ *   (relaxed balance: between operations the tree may be briefly out
+ *   of balance; once all operations finish it is a valid AVL tree).
+ * - Deleting a key with two children only clears `present`: the node
+ *   stays as a routing node. It is unlinked later, once a rotation or
+ *   delete leaves it with at most one child.
+ *
+ * Unlinked nodes may still be read by searches in flight, so they go on
+ * a retire list and are freed by avl_concurrent_reclaim /
+ * avl_concurrent_free, which need a point where no operation runs.
+ */
+
+struct ConcNode {
+    /* Read on every search step: kept within the first 32 bytes */
+    _Atomic(struct ConcNode *) left;
+    _Atomic(struct ConcNode *) right;
+    _Atomic uint64_t version;    /* CHANGING / UNLINKED bits + change count */
+    int key;
+    _Atomic int present;         /* 0: routing node (key deleted) */
+    /* Used by updates only */
+    _Atomic(struct ConcNode *) parent;
+    _Atomic int height;
+    struct ConcNode *retired;    /* Next on the retire list */
+    pthread_mutex_t lock;
+};
+
+struct ConcurrentAVL {
+    struct ConcNode holder;      /* Sentinel: holder.right is the root */
+    _Atomic(struct ConcNode *) retired;
+};
+
+/* ---------- Public Operations (API) ---------- */
+
+/* Safe to call from any number of threads at once */
+struct ConcurrentAVL *avl_concurrent_create(void);
+int avl_concurrent_insert(struct ConcurrentAVL *tree, int key);  /* 1 if added */
+int avl_concurrent_delete(struct ConcurrentAVL *tree, int key);  /* 1 if removed */
+int avl_concurrent_search(struct ConcurrentAVL *tree, int key);
+
+/* Only while no other operation runs */
+void avl_concurrent_reclaim(struct ConcurrentAVL *tree);
+void avl_concurrent_free(struct ConcurrentAVL *tree);
+size_t avl_concurrent_size(struct ConcurrentAVL *tree);
+
+/* Invariant Checker: order, parent links, heights, balance, no unlinkable routing node */
+int check_concurrent_invariant(struct ConcurrentAVL *tree);
+
+/* ---------- Global-Lock Wrapper ---------- */
+
+/* The single-threaded avl_tree.h operations behind one mutex */
+struct LockedAVL {
+    pthread_mutex_t lock;
+    struct Node *root;
+};
+
+void avl_locked_init(struct LockedAVL *tree);
+void avl_locked_insert(struct LockedAVL *tree, int key);
+void avl_locked_delete(struct LockedAVL *tree, int key);
+int avl_locked_search(struct LockedAVL *tree, int key);
+void avl_locked_destroy(struct LockedAVL *tree);
+
+#endif /* AVL_CONCURRENT_H */
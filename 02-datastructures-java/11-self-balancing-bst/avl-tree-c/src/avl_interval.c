@@ -0,0 +1,217 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "avl_interval.h"
+
+#define NIL_HEIGHT (-1)
+
+/* ---------- Internal Helpers (Static) ---------- */
+
+static struct IntervalNode *newNode(int start, int end) {
+    struct IntervalNode *node = (struct IntervalNode *)malloc(sizeof(struct IntervalNode));
+    if (node == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    node->left = NULL;
+    node->right = NULL;
+    node->start = start;
+    node->end = end;
+    node->max_end = end;
+    node->height = 0;
+    return node;
+}
+
+static int getHeight(const struct IntervalNode *n) {
+    return n ? n->height : NIL_HEIGHT;
+}
+
+static int max(int a, int b) {
+    return (a > b) ? a : b;
+}
+
+/* update: recompute height and max_end from the children */
+static void update(struct IntervalNode *n) {
+    n->height = 1 + max(getHeight(n->left), getHeight(n->right));
+    n->max_end = n->end;
+    if (n->left != NULL) n->max_end = max(n->max_end, n->left->max_end);
+    if (n->right != NULL) n->max_end = max(n->max_end, n->right->max_end);
+}
+
+static int getBalanceFactor(const struct IntervalNode *n) {
+    return n ? getHeight(n->left) - getHeight(n->right) : 0;
+}
+
+/* compare: order by start, then by end */
+static int compare(int start, int end, const struct IntervalNode *n) {
+    if (start != n->start) return (start < n->start) ? -1 : 1;
+    return (end > n->end) - (end < n->end);
+}
+
+static struct IntervalNode *rotate_left(struct IntervalNode *x) {
+    struct IntervalNode *y = x->right;
+    x->right = y->left;
+    y->left = x;
+    update(x);
+    update(y);
+    return y;
+}
+
+static struct IntervalNode *rotate_right(struct IntervalNode *y) {
+    struct IntervalNode *x = y->left;
+    y->left = x->right;
+    x->right = y;
+    update(y);
+    update(x);
+    return x;
+}
+
+/* rebalance: as in avl_tree.c, with max_end refreshed by update */
+static struct IntervalNode *rebalance(struct IntervalNode *node) {
+    update(node);
+    int bf = getBalanceFactor(node);
+
+    if (bf > 1) {
+        if (getBalanceFactor(node->left) < 0) node->left = rotate_left(node->left);
+        return rotate_right(node);
+    }
+    if (bf < -1) {
+        if (getBalanceFactor(node->right) > 0) node->right = rotate_right(node->right);
+        return rotate_left(node);
+    }
+    return node;
+}
+
+/* remove_min: unlink the leftmost node into *min, rebalancing on return */
+static struct IntervalNode *remove_min(struct IntervalNode *node, struct IntervalNode **min) {
+    if (node->left == NULL) {
+        *min = node;
+        return node->right;
+    }
+    node->left = remove_min(node->left, min);
+    return rebalance(node);
+}
+
+typedef struct {
+    int lo, hi;
+    struct Interval *out;
+    size_t cap, count;
+} Query;
+
+/*
+ * collect: in-order walk of the subtrees that can overlap [lo, hi].
+ * A subtree with max_end < lo holds nothing; once start > hi, neither
+ * the node nor its right subtree (starts >= start) can match.
+ */
+static void collect(const struct IntervalNode *n, Query *q) {
+    while (n != NULL && n->max_end >= q->lo) {
+        collect(n->left, q);
+        if (n->start > q->hi) return;
+        if (n->end >= q->lo) {
+            if (q->count < q->cap) {
+                q->out[q->count].start = n->start;
+                q->out[q->count].end = n->end;
+            }
+            q->count++;
+        }
+        n = n->right;  /* Tail call */
+    }
+}
+
+/* ---------- Public Operations Implementation ---------- */
+
+struct IntervalNode *avl_interval_insert(struct IntervalNode *root, int start, int end) {
+    if (start > end) return root;
+    if (root == NULL) return newNode(start, end);
+
+    int c = compare(start, end, root);
+    if (c < 0) root->left = avl_interval_insert(root->left, start, end);
+    else if (c > 0) root->right = avl_interval_insert(root->right, start, end);
+    else return root;  // duplicates ignored
+    return rebalance(root);
+}
+
+struct IntervalNode *avl_interval_delete(struct IntervalNode *root, int start, int end) {
+    if (root == NULL) return NULL;
+
+    int c = compare(start, end, root);
+    if (c < 0) {
+        root->left = avl_interval_delete(root->left, start, end);
+    } else if (c > 0) {
+        root->right = avl_interval_delete(root->right, start, end);
+    } else {
+        struct IntervalNode *left = root->left;
+        struct IntervalNode *right = root->right;
+        free(root);
+        if (right == NULL) return left;
+
+        /* The successor takes the deleted node's place */
+        struct IntervalNode *successor = NULL;
+        right = remove_min(right, &successor);
+        successor->left = left;
+        successor->right = right;
+        root = successor;
+    }
+    return rebalance(root);
+}
+
+void avl_interval_free(struct IntervalNode *root) {
+    if (root == NULL) return;
+    avl_interval_free(root->left);
+    avl_interval_free(root->right);
+    free(root);
+}
+
+size_t avl_interval_overlap(const struct IntervalNode *root, int lo, int hi,
+                            struct Interval *out, size_t cap) {
+    Query q = { lo, hi, out, cap, 0 };
+    if (lo <= hi) collect(root, &q);
+    return q.count;
+}
+
+size_t avl_interval_stab(const struct IntervalNode *root, int point,
+                         struct Interval *out, size_t cap) {
+    return avl_interval_overlap(root, point, point, out, cap);
+}
+
+/* ---------- Invariant Checkers Implementation ---------- */
+
+/* check_subtree: returns height (NIL_HEIGHT for NULL), or -2 on a violation */
+static int check_subtree(const struct IntervalNode *n, const struct IntervalNode *lo,
+                         const struct IntervalNode *hi) {
+    if (n == NULL) return NIL_HEIGHT;
+
+    if ((lo && compare(n->start, n->end, lo) <= 0) ||
+        (hi && compare(n->start, n->end, hi) >= 0)) {
+        fprintf(stderr, "Error: Interval [%d, %d] is out of order\n", n->start, n->end);
+        return -2;
+    }
+
+    int hl = check_subtree(n->left, lo, n);
+    int hr = check_subtree(n->right, n, hi);
+    if (hl == -2 || hr == -2) return -2;
+
+    int ok = 1;
+    if (n->height != 1 + max(hl, hr)) {
+        fprintf(stderr, "Error: Interval [%d, %d] has stored height %d, but real height is %d\n",
+                n->start, n->end, n->height, 1 + max(hl, hr));
+        ok = 0;
+    }
+    if (hl - hr < -1 || hl - hr > 1) {
+        fprintf(stderr, "Error: Interval [%d, %d] is unbalanced (BF = %d)\n",
+                n->start, n->end, hl - hr);
+        ok = 0;
+    }
+    int max_end = n->end;
+    if (n->left) max_end = max(max_end, n->left->max_end);
+    if (n->right) max_end = max(max_end, n->right->max_end);
+    if (n->max_end != max_end) {
+        fprintf(stderr, "Error: Interval [%d, %d] has max_end %d, but real max_end is %d\n",
+                n->start, n->end, n->max_end, max_end);
+        ok = 0;
+    }
+    return ok ? 1 + max(hl, hr) : -2;
+}
+
+int check_interval_invariant(const struct IntervalNode *root) {
+    return check_subtree(root, NULL, NULL) != -2;
+}
@@ -0,0 +1,50 @@
+#ifndef AVL_INTERVAL_H
+#define AVL_INTERVAL_H
+
+#include <stddef.h>
+
+/*
+ * Interval tree: an AVL tree of closed intervals [start, end] ordered
+ * by (start, end), where each node also keeps the largest end in its
+ * subtree. rotate_left/rotate_right/rebalance in avl_interval.c refresh
+ * max_end together with height, so queries can skip any subtree whose
+ * max_end lies left of the query.
+ */
+
+struct Interval {
+    int start;
+    int end;
+};
+
+struct IntervalNode {
+    struct IntervalNode *left;
+    struct IntervalNode *right;
+    int start;
+    int end;
+    int max_end;  /* Largest end in this subtree */
+    int height;
+};
+
+/* ---------- Public Operations (API) ---------- */
+
+/* Identical (start, end) pairs are stored once; start > end is ignored */
+struct IntervalNode *avl_interval_insert(struct IntervalNode *root, int start, int end);
+struct IntervalNode *avl_interval_delete(struct IntervalNode *root, int start, int end);
+void avl_interval_free(struct IntervalNode *root);
+
+/*
+ * Queries: store up to cap matches in out (in start order) and return
+ * how many intervals match in total. Only subtrees whose max_end can
+ * reach the query are entered: O((k + 1) log n) for k matches in the
+ * worst case (each may sit on its own path), O(log n + k) only when
+ * the matches are clustered.
+ */
+size_t avl_interval_stab(const struct IntervalNode *root, int point,
+                         struct Interval *out, size_t cap);
+size_t avl_interval_overlap(const struct IntervalNode *root, int lo, int hi,
+                            struct Interval *out, size_t cap);
+
+/* Invariant Checker: order, AVL heights/balance and max_end */
+int check_interval_invariant(const struct IntervalNode *root);
+
+#endif /* AVL_INTERVAL_H */
@@ -0,0 +1,185 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "avl_persist.h"
+
+#define NIL_HEIGHT (-1)
+
+/* ---------- Internal Helpers (Static) ---------- */
+
+static int getHeight(const struct PersistNode *n) {
+    return n ? n->height : NIL_HEIGHT;
+}
+
+static int max(int a, int b) {
+    return (a > b) ? a : b;
+}
+
+/* mk: new node owning one reference to each of left and right */
+static struct PersistNode *mk(int key, struct PersistNode *left, struct PersistNode *right) {
+    struct PersistNode *node = (struct PersistNode *)malloc(sizeof(struct PersistNode));
+    if (node == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    node->left = left;
+    node->right = right;
+    node->key = key;
+    node->height = 1 + max(getHeight(left), getHeight(right));
+    node->refs = 1;
+    return node;
+}
+
+/*
+ * take: consume one reference to n, returning owned references to its
+ * children. A node only this path points at (refs == 1, e.g. one built
+ * a moment ago) hands its children over and is freed; a shared node
+ * stays and its children gain a reference.
+ */
+static void take(struct PersistNode *n, struct PersistNode **left, struct PersistNode **right) {
+    *left = n->left;
+    *right = n->right;
+    if (n->refs == 1) {
+        free(n);
+        return;
+    }
+    n->refs--;
+    avl_persist_retain(*left);
+    avl_persist_retain(*right);
+}
+
+/*
+ * balance: mk(key, l, r), rotating if the heights differ by two. The
+ * rotated nodes are rebuilt with mk, so shared subtrees are never
+ * relinked (cf. rebalance in avl_tree.c).
+ */
+static struct PersistNode *balance(int key, struct PersistNode *l, struct PersistNode *r) {
+    struct PersistNode *a, *b, *c, *d;
+
+    if (getHeight(l) > getHeight(r) + 1) {
+        int lk = l->key;
+        take(l, &a, &b);
+        if (getHeight(a) >= getHeight(b)) {  // LL
+            return mk(lk, a, mk(key, b, r));
+        }
+        int bk = b->key;  // LR
+        take(b, &c, &d);
+        return mk(bk, mk(lk, a, c), mk(key, d, r));
+    }
+
+    if (getHeight(r) > getHeight(l) + 1) {
+        int rk = r->key;
+        take(r, &a, &b);
+        if (getHeight(b) >= getHeight(a)) {  // RR
+            return mk(rk, mk(key, l, a), b);
+        }
+        int ak = a->key;  // RL
+        take(a, &c, &d);
+        return mk(ak, mk(key, l, c), mk(rk, d, b));
+    }
+
+    return mk(key, l, r);
+}
+
+/* insert_path: key is absent; copy the search path, returning a new handle */
+static struct PersistNode *insert_path(struct PersistNode *n, int key) {
+    if (n == NULL) return mk(key, NULL, NULL);
+    if (key < n->key) {
+        return balance(n->key, insert_path(n->left, key), avl_persist_retain(n->right));
+    }
+    return balance(n->key, avl_persist_retain(n->left), insert_path(n->right, key));
+}
+
+/* delete_min: new handle to n without its smallest key, stored in *min */
+static struct PersistNode *delete_min(struct PersistNode *n, int *min) {
+    if (n->left == NULL) {
+        *min = n->key;
+        return avl_persist_retain(n->right);
+    }
+    struct PersistNode *left = delete_min(n->left, min);
+    return balance(n->key, left, avl_persist_retain(n->right));
+}
+
+/* delete_path: key is present; copy the search path, returning a new handle */
+static struct PersistNode *delete_path(struct PersistNode *n, int key) {
+    if (key < n->key) {
+        return balance(n->key, delete_path(n->left, key), avl_persist_retain(n->right));
+    }
+    if (key > n->key) {
+        return balance(n->key, avl_persist_retain(n->left), delete_path(n->right, key));
+    }
+    if (n->left == NULL) return avl_persist_retain(n->right);
+    if (n->right == NULL) return avl_persist_retain(n->left);
+
+    int successor = 0;
+    struct PersistNode *right = delete_min(n->right, &successor);
+    return balance(successor, avl_persist_retain(n->left), right);
+}
+
+/* ---------- Public Operations Implementation ---------- */
+
+int avl_persist_search(const struct PersistNode *root, int key) {
+    while (root != NULL) {
+        if (key == root->key) return 1;
+        root = (key < root->key) ? root->left : root->right;
+    }
+    return 0;
+}
+
+struct PersistNode *avl_persist_insert(struct PersistNode *root, int key) {
+    if (avl_persist_search(root, key)) return avl_persist_retain(root);  // duplicates ignored
+    return insert_path(root, key);
+}
+
+struct PersistNode *avl_persist_delete(struct PersistNode *root, int key) {
+    if (!avl_persist_search(root, key)) return avl_persist_retain(root);
+    return delete_path(root, key);
+}
+
+struct PersistNode *avl_persist_retain(struct PersistNode *root) {
+    if (root != NULL) root->refs++;
+    return root;
+}
+
+void avl_persist_release(struct PersistNode *root) {
+    /* Loop on the right child, recurse on the left: depth O(height) */
+    while (root != NULL && --root->refs == 0) {
+        struct PersistNode *right = root->right;
+        avl_persist_release(root->left);
+        free(root);
+        root = right;
+    }
+}
+
+/* ---------- Invariant Checkers Implementation ---------- */
+
+/* check_subtree: returns height (NIL_HEIGHT for NULL), or -2 on a violation */
+static int check_subtree(const struct PersistNode *n, const int *lo, const int *hi) {
+    if (n == NULL) return NIL_HEIGHT;
+    if ((lo && n->key <= *lo) || (hi && n->key >= *hi)) {
+        fprintf(stderr, "Error: BST property violated at key %d\n", n->key);
+        return -2;
+    }
+    if (n->refs < 1) {
+        fprintf(stderr, "Error: Node %d is reachable with refs = %d\n", n->key, n->refs);
+        return -2;
+    }
+
+    int hl = check_subtree(n->left, lo, &n->key);
+    int hr = check_subtree(n->right, &n->key, hi);
+    if (hl == -2 || hr == -2) return -2;
+
+    if (n->height != 1 + max(hl, hr)) {
+        fprintf(stderr, "Error: Node %d has stored height %d, but real height is %d\n",
+                n->key, n->height, 1 + max(hl, hr));
+        return -2;
+    }
+    if (hl - hr < -1 || hl - hr > 1) {
+        fprintf(stderr, "Error: Node %d is unbalanced (BF = %d)\n", n->key, hl - hr);
+        return -2;
+    }
+    return n->height;
+}
+
+int check_persist_invariant(const struct PersistNode *root) {
+    return check_subtree(root, NULL, NULL) != -2;
+}
@@ -0,0 +1,41 @@
+#ifndef AVL_PERSIST_H
+#define AVL_PERSIST_H
+
+#include <stddef.h>
+
+/*
+ * Persistent AVL tree: insert and delete leave their input version
+ * untouched and return a new root that shares every subtree off the
+ * changed path, so a version costs O(log n) new nodes. Rebalancing
+ * builds rotated copies instead of relinking shared nodes.
+ *
+ * Each node counts the parents and version handles that point at it.
+ * Every root returned below is a handle the caller owns and must drop
+ * with avl_persist_release; nodes nobody references are freed then.
+ * Reference counts are not atomic: share versions across threads
+ * read-only, or release them from one thread.
+ */
+
+struct PersistNode {
+    struct PersistNode *left;
+    struct PersistNode *right;
+    int key;
+    int height;
+    int refs;  /* Parents + handles pointing here */
+};
+
+/* ---------- Public Operations (API) ---------- */
+
+/* New version with key added / removed (a new handle to root if unchanged) */
+struct PersistNode *avl_persist_insert(struct PersistNode *root, int key);
+struct PersistNode *avl_persist_delete(struct PersistNode *root, int key);
+int avl_persist_search(const struct PersistNode *root, int key);
+
+/* Handles: retain adds one (returns root), release drops one */
+struct PersistNode *avl_persist_retain(struct PersistNode *root);
+void avl_persist_release(struct PersistNode *root);
+
+/* Invariant Checker: BST order, stored heights and balance */
+int check_persist_invariant(const struct PersistNode *root);
+
+#endif /* AVL_PERSIST_H */
@@ -0,0 +1,109 @@
+#include <stdlib.h>
+#include <pthread.h>
+#include "avl_setops.h"
+
+/* Subtrees lower than this are not worth a thread (~2^GRAIN_HEIGHT keys) */
+#define GRAIN_HEIGHT 12
+
+enum { OP_UNION, OP_INTERSECT, OP_DIFFERENCE };
+
+/* ---------- Internal Helpers (Static) ---------- */
+
+typedef struct {
+    int op;
+    struct Node *a, *b;
+    int threads;
+    struct Node *result;
+} SetTask;
+
+static struct Node *set_op(int op, struct Node *a, struct Node *b, int threads);
+
+static int height(struct Node *n) {
+    return n ? n->height : -1;
+}
+
+static void *set_worker(void *arg) {
+    SetTask *task = (SetTask *)arg;
+    task->result = set_op(task->op, task->a, task->b, task->threads);
+    return NULL;
+}
+
+/*
+ * set_halves: *out_l = op(al, bl), *out_r = op(ar, br). The left half
+ * gets its own thread when there are threads to spare and both sides
+ * are big enough; if the thread cannot be created it runs inline.
+ */
+static void set_halves(int op, struct Node *al, struct Node *bl,
+                       struct Node *ar, struct Node *br, int threads,
+                       struct Node **out_l, struct Node **out_r) {
+    if (threads > 1 && height(al) >= GRAIN_HEIGHT && height(bl) >= GRAIN_HEIGHT) {
+        SetTask task = { op, al, bl, threads / 2, NULL };
+        pthread_t id;
+        if (pthread_create(&id, NULL, set_worker, &task) == 0) {
+            *out_r = set_op(op, ar, br, threads - threads / 2);
+            pthread_join(id, NULL);
+            *out_l = task.result;
+            return;
+        }
+    }
+    *out_l = set_op(op, al, bl, threads);
+    *out_r = set_op(op, ar, br, threads);
+}
+
+/* set_op: split b (or a, for difference) around the other root, recurse, join */
+static struct Node *set_op(int op, struct Node *a, struct Node *b, int threads) {
+    struct Node *bl, *br, *l, *r;
+
+    switch (op) {
+    case OP_UNION: {
+        if (a == NULL) return b;
+        if (b == NULL) return a;
+        struct Node *dup = avl_split(b, a->key, &bl, &br);
+        free(dup);
+        set_halves(op, a->left, bl, a->right, br, threads, &l, &r);
+        return avl_join(l, a, r);
+    }
+    case OP_INTERSECT: {
+        if (a == NULL || b == NULL) {
+            freeTree(a);
+            freeTree(b);
+            return NULL;
+        }
+        struct Node *dup = avl_split(b, a->key, &bl, &br);
+        set_halves(op, a->left, bl, a->right, br, threads, &l, &r);
+        if (dup != NULL) {
+            free(dup);
+            return avl_join(l, a, r);
+        }
+        free(a);
+        return avl_concat(l, r);
+    }
+    default: {  /* OP_DIFFERENCE */
+        if (a == NULL || b == NULL) {
+            freeTree(b);
+            return a;
+        }
+        struct Node *al, *ar;
+        free(avl_split(a, b->key, &al, &ar));
+        bl = b->left;
+        br = b->right;
+        free(b);
+        set_halves(op, al, bl, ar, br, threads, &l, &r);
+        return avl_concat(l, r);
+    }
+    }
+}
+
+/* ---------- Public Operations Implementation ---------- */
+
+struct Node *avl_union(struct Node *a, struct Node *b, int threads) {
+    return set_op(OP_UNION, a, b, threads);
+}
+
+struct Node *avl_intersect(struct Node *a, struct Node *b, int threads) {
+    return set_op(OP_INTERSECT, a, b, threads);
+}
+
+struct Node *avl_difference(struct Node *a, struct Node *b, int threads) {
+    return set_op(OP_DIFFERENCE, a, b, threads);
+}
@@ -0,0 +1,19 @@
+#ifndef AVL_SETOPS_H
+#define AVL_SETOPS_H
+
+#include "avl_tree.h"
+
+/*
+ * Join-based set operations on AVL trees (avl_join / avl_split).
+ *
+ * Each one consumes both input trees and returns the result tree;
+ * nodes are reused or freed, never copied. Work is O(m log(n/m + 1))
+ * for trees of m <= n keys. The two halves of each step recurse in
+ * parallel while threads > 1 (threads <= 1 runs sequentially).
+ */
+
+struct Node *avl_union(struct Node *a, struct Node *b, int threads);
+struct Node *avl_intersect(struct Node *a, struct Node *b, int threads);
+struct Node *avl_difference(struct Node *a, struct Node *b, int threads);  /* a - b */
+
+#endif /* AVL_SETOPS_H */
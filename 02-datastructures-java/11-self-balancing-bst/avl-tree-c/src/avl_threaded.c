@@ -0,0 +1,310 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "avl_threaded.h"
+
+#define NIL_HEIGHT (-1)
+#define AVL_MAX_PATH 64  /* An AVL tree of < 2^31 keys is < 46 high */
+#define THREAD_BIT ((uintptr_t)1)
+
+/* ---------- Internal Helpers (Static) ---------- */
+
+static int is_thread(const struct ThreadedNode *link) {
+    return ((uintptr_t)link & THREAD_BIT) != 0;
+}
+
+static struct ThreadedNode *make_thread(const struct ThreadedNode *target) {
+    return (struct ThreadedNode *)((uintptr_t)target | THREAD_BIT);
+}
+
+/* thread_target: the node a thread points at (NULL past the ends) */
+static struct ThreadedNode *thread_target(const struct ThreadedNode *link) {
+    return (struct ThreadedNode *)((uintptr_t)link & ~THREAD_BIT);
+}
+
+/* child: the child behind a link, NULL if the link is a thread */
+static struct ThreadedNode *child(struct ThreadedNode *link) {
+    return is_thread(link) ? NULL : link;
+}
+
+static struct ThreadedNode *newNode(int key) {
+    struct ThreadedNode *node = (struct ThreadedNode *)malloc(sizeof(struct ThreadedNode));
+    if (node == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    node->key = key;
+    node->height = 0;
+    return node;
+}
+
+static int getHeight(struct ThreadedNode *link) {
+    struct ThreadedNode *n = child(link);
+    return n ? n->height : NIL_HEIGHT;
+}
+
+static int max(int a, int b) {
+    return (a > b) ? a : b;
+}
+
+static void updateHeight(struct ThreadedNode *n) {
+    n->height = 1 + max(getHeight(n->left), getHeight(n->right));
+}
+
+static int getBalanceFactor(struct ThreadedNode *n) {
+    return getHeight(n->left) - getHeight(n->right);
+}
+
+/* leftmost / rightmost: follow child links down one side */
+static struct ThreadedNode *leftmost(struct ThreadedNode *n) {
+    while (child(n->left)) n = n->left;
+    return n;
+}
+
+static struct ThreadedNode *rightmost(struct ThreadedNode *n) {
+    while (child(n->right)) n = n->right;
+    return n;
+}
+
+/*
+ * Rotations move one subtree between x and y. If that subtree is
+ * empty, the link it leaves behind must become a thread: x is y's
+ * predecessor (rotate_right) or successor (rotate_left). No other
+ * thread changes, since the in-order sequence does not.
+ */
+static struct ThreadedNode *rotate_left(struct ThreadedNode *x) {
+    struct ThreadedNode *y = x->right;
+    x->right = is_thread(y->left) ? make_thread(y) : y->left;
+    y->left = x;
+    updateHeight(x);
+    updateHeight(y);
+    return y;
+}
+
+static struct ThreadedNode *rotate_right(struct ThreadedNode *y) {
+    struct ThreadedNode *x = y->left;
+    y->left = is_thread(x->right) ? make_thread(x) : x->right;
+    x->right = y;
+    updateHeight(y);
+    updateHeight(x);
+    return x;
+}
+
+/* rebalance: same cases as avl_tree.c */
+static struct ThreadedNode *rebalance(struct ThreadedNode *node) {
+    updateHeight(node);
+    int bf = getBalanceFactor(node);
+
+    if (bf > 1) {
+        if (getBalanceFactor(node->left) < 0) node->left = rotate_left(node->left);
+        return rotate_right(node);
+    }
+    if (bf < -1) {
+        if (getBalanceFactor(node->right) > 0) node->right = rotate_right(node->right);
+        return rotate_left(node);
+    }
+    return node;
+}
+
+/* rebalance_path: rebalance links path[depth-1] .. path[0] bottom-up */
+static void rebalance_path(struct ThreadedNode **path[], int depth) {
+    while (depth > 0) {
+        struct ThreadedNode **link = path[--depth];
+        int old_height = (*link)->height;
+        *link = rebalance(*link);
+        if ((*link)->height == old_height) break;  // early stop
+    }
+}
+
+/*
+ * unlink_node: remove z (at most one child) from *link. Whoever had a
+ * thread to z inherits z's thread on that side: the predecessor's
+ * right thread (z has a left child), the successor's left thread (z
+ * has a right child), or the parent's link itself (z is a leaf).
+ */
+static void unlink_node(struct ThreadedNode **link, struct ThreadedNode *parent,
+                        struct ThreadedNode *z) {
+    if (child(z->left)) {
+        rightmost(z->left)->right = z->right;
+        *link = z->left;
+    } else if (child(z->right)) {
+        leftmost(z->right)->left = z->left;
+        *link = z->right;
+    } else if (parent == NULL) {
+        *link = NULL;
+    } else {
+        *link = (link == &parent->left) ? z->left : z->right;
+    }
+    free(z);
+}
+
+/* ---------- Public Operations Implementation ---------- */
+
+int avl_threaded_search(const struct ThreadedNode *root, int key) {
+    struct ThreadedNode *n = child((struct ThreadedNode *)root);
+    while (n != NULL) {
+        if (key == n->key) return 1;
+        n = child((key < n->key) ? n->left : n->right);
+    }
+    return 0;
+}
+
+struct ThreadedNode *avl_threaded_insert(struct ThreadedNode *root, int key) {
+    struct ThreadedNode **path[AVL_MAX_PATH];
+    struct ThreadedNode **link = &root;
+    int depth = 0;
+
+    while (child(*link) != NULL) {
+        if (key == (*link)->key) return root;  // duplicates ignored
+        path[depth++] = link;
+        link = (key < (*link)->key) ? &(*link)->left : &(*link)->right;
+    }
+
+    /* The new leaf takes over the thread its link held */
+    struct ThreadedNode *z = newNode(key);
+    if (depth == 0) {
+        z->left = make_thread(NULL);
+        z->right = make_thread(NULL);
+    } else {
+        struct ThreadedNode *p = *path[depth - 1];
+        if (link == &p->left) {
+            z->left = p->left;
+            z->right = make_thread(p);
+        } else {
+            z->right = p->right;
+            z->left = make_thread(p);
+        }
+    }
+    *link = z;
+    rebalance_path(path, depth);
+    return root;
+}
+
+struct ThreadedNode *avl_threaded_delete(struct ThreadedNode *root, int key) {
+    struct ThreadedNode **path[AVL_MAX_PATH];
+    struct ThreadedNode **link = &root;
+    int depth = 0;
+
+    while (child(*link) != NULL && (*link)->key != key) {
+        path[depth++] = link;
+        link = (key < (*link)->key) ? &(*link)->left : &(*link)->right;
+    }
+    if (child(*link) == NULL) return root;
+
+    struct ThreadedNode *target = *link;
+    if (child(target->left) && child(target->right)) {
+        /* Continue to the successor in the same descent, then unlink it */
+        path[depth++] = link;
+        link = &target->right;
+        while (child((*link)->left)) {
+            path[depth++] = link;
+            link = &(*link)->left;
+        }
+        target->key = (*link)->key;
+    }
+    unlink_node(link, depth ? *path[depth - 1] : NULL, *link);
+
+    rebalance_path(path, depth);
+    return root;
+}
+
+void avl_threaded_free(struct ThreadedNode *root) {
+    /* next() only touches nodes after n, so freeing in order is safe */
+    struct ThreadedNode *n = (struct ThreadedNode *)avl_threaded_first(root);
+    while (n != NULL) {
+        struct ThreadedNode *following = (struct ThreadedNode *)avl_threaded_next(n);
+        free(n);
+        n = following;
+    }
+}
+
+const struct ThreadedNode *avl_threaded_first(const struct ThreadedNode *root) {
+    return root ? leftmost((struct ThreadedNode *)root) : NULL;
+}
+
+const struct ThreadedNode *avl_threaded_last(const struct ThreadedNode *root) {
+    return root ? rightmost((struct ThreadedNode *)root) : NULL;
+}
+
+const struct ThreadedNode *avl_threaded_next(const struct ThreadedNode *node) {
+    struct ThreadedNode *r = node->right;
+    return is_thread(r) ? thread_target(r) : leftmost(r);
+}
+
+const struct ThreadedNode *avl_threaded_prev(const struct ThreadedNode *node) {
+    struct ThreadedNode *l = node->left;
+    return is_thread(l) ? thread_target(l) : rightmost(l);
+}
+
+/* avl_threaded_lower_bound: first node with key >= key, or NULL */
+const struct ThreadedNode *avl_threaded_lower_bound(const struct ThreadedNode *root, int key) {
+    struct ThreadedNode *n = child((struct ThreadedNode *)root);
+    const struct ThreadedNode *best = NULL;
+    while (n != NULL) {
+        if (n->key >= key) {
+            best = n;
+            n = child(n->left);
+        } else {
+            n = child(n->right);
+        }
+    }
+    return best;
+}
+
+/* ---------- Invariant Checkers Implementation ---------- */
+
+/*
+ * check_subtree: in-order walk over child links only. *prev is the
+ * previous node visited; each thread must name exactly the neighbour
+ * the walk finds. Returns height, or -2 on a violation.
+ */
+static int check_subtree(struct ThreadedNode *n, struct ThreadedNode **prev) {
+    int hl = NIL_HEIGHT, hr = NIL_HEIGHT;
+
+    if (child(n->left)) {
+        hl = check_subtree(n->left, prev);
+        if (hl == -2) return -2;
+    } else if (thread_target(n->left) != *prev) {
+        fprintf(stderr, "Error: Node %d has a wrong predecessor thread\n", n->key);
+        return -2;
+    }
+
+    if (*prev != NULL) {
+        if ((*prev)->key >= n->key) {
+            fprintf(stderr, "Error: BST property violated at key %d\n", n->key);
+            return -2;
+        }
+        if (is_thread((*prev)->right) && thread_target((*prev)->right) != n) {
+            fprintf(stderr, "Error: Node %d has a wrong successor thread\n", (*prev)->key);
+            return -2;
+        }
+    }
+    *prev = n;
+
+    if (child(n->right)) {
+        hr = check_subtree(n->right, prev);
+        if (hr == -2) return -2;
+    }
+
+    if (n->height != 1 + max(hl, hr)) {
+        fprintf(stderr, "Error: Node %d has stored height %d, but real height is %d\n",
+                n->key, n->height, 1 + max(hl, hr));
+        return -2;
+    }
+    if (hl - hr < -1 || hl - hr > 1) {
+        fprintf(stderr, "Error: Node %d is unbalanced (BF = %d)\n", n->key, hl - hr);
+        return -2;
+    }
+    return n->height;
+}
+
+int check_threaded_invariant(const struct ThreadedNode *root) {
+    if (root == NULL) return 1;
+    struct ThreadedNode *prev = NULL;
+    if (check_subtree((struct ThreadedNode *)root, &prev) == -2) return 0;
+    if (!is_thread(prev->right) || thread_target(prev->right) != NULL) {
+        fprintf(stderr, "Error: Last node %d does not end with a NULL thread\n", prev->key);
+        return 0;
+    }
+    return 1;
+}
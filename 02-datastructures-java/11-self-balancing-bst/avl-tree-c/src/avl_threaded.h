@@ -0,0 +1,42 @@
+#ifndef AVL_THREADED_H
+#define AVL_THREADED_H
+
+#include <stddef.h>
+
+/*
+ * Threaded AVL tree: a missing left/right child is replaced by a
+ * thread to the in-order predecessor/successor (NULL past either end).
+ * Bit 0 of the link tells a thread from a child (nodes are at least
+ * 2-byte aligned), so the node stays as small as struct Node.
+ * Iteration needs no stack and no parent pointers: next/prev are O(1)
+ * amortized.
+ *
+ * Links are tagged: never follow node->left/right directly, only
+ * through the functions below.
+ */
+
+struct ThreadedNode {
+    struct ThreadedNode *left;   /* Child, or tagged thread to predecessor */
+    struct ThreadedNode *right;  /* Child, or tagged thread to successor */
+    int key;
+    int height;
+};
+
+/* ---------- Public Operations (API) ---------- */
+
+struct ThreadedNode *avl_threaded_insert(struct ThreadedNode *root, int key);
+struct ThreadedNode *avl_threaded_delete(struct ThreadedNode *root, int key);
+int avl_threaded_search(const struct ThreadedNode *root, int key);
+void avl_threaded_free(struct ThreadedNode *root);
+
+/* Iteration (NULL past either end) */
+const struct ThreadedNode *avl_threaded_first(const struct ThreadedNode *root);
+const struct ThreadedNode *avl_threaded_last(const struct ThreadedNode *root);
+const struct ThreadedNode *avl_threaded_next(const struct ThreadedNode *node);
+const struct ThreadedNode *avl_threaded_prev(const struct ThreadedNode *node);
+const struct ThreadedNode *avl_threaded_lower_bound(const struct ThreadedNode *root, int key);
+
+/* Invariant Checker: order, heights, balance, and every thread target */
+int check_threaded_invariant(const struct ThreadedNode *root);
+
+#endif /* AVL_THREADED_H */
@@ -0,0 +1,155 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "avl_trace.h"
+
+_Static_assert(sizeof(AvlTraceEvent) == 24, "trace records are 24 bytes");
+
+/* Per-thread ring; only its thread writes events and head */
+typedef struct Ring {
+    struct Ring *next;        /* Registry of all rings, newest first */
+    uint64_t thread;          /* Small id in creation order */
+    size_t mask;              /* Capacity - 1 (capacity is a power of 2) */
+    _Atomic uint64_t head;    /* Records ever written */
+    AvlTraceEvent events[];
+} Ring;
+
+atomic_bool avl_trace_enabled = false;
+
+static _Atomic(Ring *) registry = NULL;
+static atomic_size_t ring_events = AVL_TRACE_DEFAULT_EVENTS;
+static atomic_uint_fast64_t next_thread = 0;
+static _Thread_local Ring *local_ring = NULL;
+static _Thread_local uint8_t local_op = AVL_OP_NONE;
+
+/* ---------- Internal Helpers (Static) ---------- */
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/* ring_create: allocate this thread's ring and publish it (lock-free push) */
+static Ring *ring_create(void) {
+    size_t capacity = atomic_load(&ring_events);
+    Ring *ring = (Ring *)malloc(sizeof(Ring) + capacity * sizeof(AvlTraceEvent));
+    if (ring == NULL) return NULL;
+
+    ring->thread = atomic_fetch_add(&next_thread, 1);
+    ring->mask = capacity - 1;
+    atomic_init(&ring->head, 0);
+
+    Ring *first = atomic_load(&registry);
+    do {
+        ring->next = first;
+    } while (!atomic_compare_exchange_weak(&registry, &first, ring));
+    return ring;
+}
+
+static int write_all(FILE *f, const void *buf, size_t len) {
+    return fwrite(buf, 1, len, f) == len ? 0 : -1;
+}
+
+/* ---------- Public Operations Implementation ---------- */
+
+/*
+ * avl_trace_start: begin recording. events_per_thread is rounded up to
+ * a power of two (0 = default) and applies to rings created from now on.
+ */
+int avl_trace_start(size_t events_per_thread) {
+    size_t capacity = 1;
+    if (events_per_thread == 0) events_per_thread = AVL_TRACE_DEFAULT_EVENTS;
+    while (capacity < events_per_thread) capacity <<= 1;
+    atomic_store(&ring_events, capacity);
+    atomic_store(&avl_trace_enabled, true);
+    return 0;
+}
+
+void avl_trace_stop(void) {
+    atomic_store(&avl_trace_enabled, false);
+}
+
+void avl_trace_set_op(uint8_t op) {
+    local_op = op;
+}
+
+/* avl_trace_record: stamp and append one event to the calling thread's ring */
+void avl_trace_record(AvlTraceEvent *event) {
+    Ring *ring = local_ring;
+    if (ring == NULL) {
+        ring = local_ring = ring_create();
+        if (ring == NULL) return;  // out of memory: drop the event
+    }
+
+    event->ts_ns = now_ns();
+    event->op = local_op;
+
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    ring->events[head & ring->mask] = *event;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+/*
+ * avl_trace_dump: write all rings to path. Threads may keep tracing;
+ * records they overwrite during the copy are left out.
+ * Returns 0 on success, -1 on error.
+ */
+int avl_trace_dump(const char *path) {
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) return -1;
+
+    uint32_t rings = 0;
+    for (Ring *r = atomic_load(&registry); r != NULL; r = r->next) rings++;
+    uint32_t header[4] = { AVL_TRACE_MAGIC, AVL_TRACE_VERSION,
+                           (uint32_t)sizeof(AvlTraceEvent), rings };
+    int rc = write_all(f, header, sizeof(header));
+
+    Ring *r = atomic_load(&registry);
+    for (uint32_t i = 0; i < rings && rc == 0; i++, r = r->next) {
+        size_t capacity = r->mask + 1;
+        AvlTraceEvent *copy = (AvlTraceEvent *)malloc(capacity * sizeof(AvlTraceEvent));
+        if (copy == NULL) {
+            rc = -1;
+            break;
+        }
+
+        uint64_t end = atomic_load_explicit(&r->head, memory_order_acquire);
+        uint64_t begin = end > capacity ? end - capacity : 0;
+        for (uint64_t s = begin; s < end; s++) {
+            copy[s - begin] = r->events[s & r->mask];
+        }
+
+        /*
+         * Record w (end <= w <= later, the last one maybe half written)
+         * reuses the slot of copied record w - capacity: drop those.
+         */
+        uint64_t later = atomic_load_explicit(&r->head, memory_order_acquire);
+        uint64_t skip = later + 1 > begin + capacity ? later + 1 - begin - capacity : 0;
+        if (skip > end - begin) skip = end - begin;
+
+        uint64_t meta[3] = { r->thread, end, end - begin - skip };
+        rc = write_all(f, meta, sizeof(meta));
+        if (rc == 0) {
+            rc = write_all(f, copy + skip, (size_t)meta[2] * sizeof(AvlTraceEvent));
+        }
+        free(copy);
+    }
+
+    if (fclose(f) != 0) rc = -1;
+    return rc;
+}
+
+/* avl_trace_free: release all rings; other tracing threads must have exited */
+void avl_trace_free(void) {
+    avl_trace_stop();
+    Ring *r = atomic_exchange(&registry, NULL);
+    while (r != NULL) {
+        Ring *next = r->next;
+        free(r);
+        r = next;
+    }
+    local_ring = NULL;
+}
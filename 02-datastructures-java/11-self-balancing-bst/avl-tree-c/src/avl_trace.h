@@ -0,0 +1,72 @@
+#ifndef AVL_TRACE_H
+#define AVL_TRACE_H
+
+/*
+ * Binary rebalance tracing for avl_tree.c (built with -DTRACE_ROTATIONS=1).
+ *
+ * Each thread appends fixed-size records to its own ring buffer; the
+ * writer never locks and never blocks, and old records are overwritten
+ * once the ring is full. avl_trace_dump() writes every ring to a file
+ * that avl_trace_decode turns back into readable lines.
+ *
+ * While tracing is stopped, a hook costs one relaxed load and a branch.
+ */
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define AVL_TRACE_MAGIC   0x544c5641u  /* "AVLT" little-endian */
+#define AVL_TRACE_VERSION 1u
+#define AVL_TRACE_DEFAULT_EVENTS 65536
+
+/* Event types */
+enum { AVL_EV_STATE, AVL_EV_TRIGGER, AVL_EV_ROTATION };
+
+/* Public operation that caused the event */
+enum { AVL_OP_NONE, AVL_OP_INSERT, AVL_OP_DELETE };
+
+/* detail: phase (state), side (trigger) or rotation kind */
+enum { AVL_PHASE_BEFORE, AVL_PHASE_AFTER_CHILD_ROT, AVL_PHASE_AFTER_ROOT_ROT,
+       AVL_PHASE_AFTER_NO_ROT };
+enum { AVL_TRIGGER_LEFT_HEAVY, AVL_TRIGGER_RIGHT_HEAVY };
+enum { AVL_ROT_LR_PRE, AVL_ROT_LL, AVL_ROT_RL_PRE, AVL_ROT_RR };
+
+/* One record: 24 bytes, native endianness */
+typedef struct AvlTraceEvent {
+    uint64_t ts_ns;   /* CLOCK_MONOTONIC */
+    int32_t key;      /* Node (state/trigger) or pivot (rotation) */
+    int32_t other;    /* Height (state) or new root key (rotation) */
+    uint8_t type;
+    uint8_t op;
+    uint8_t detail;
+    int8_t bf;
+    int16_t hl;       /* Child heights (state); -1 for an empty side */
+    int16_t hr;
+} AvlTraceEvent;
+
+#define AVL_TRACE_NO_KEY (-999)  /* key/other of a missing node */
+
+/*
+ * File format:
+ *   header: magic, version, record size, ring count (4 x uint32)
+ *   rings:  {thread, written, count} (3 x uint64), then count records,
+ *           oldest first; written - count records were overwritten
+ */
+
+extern atomic_bool avl_trace_enabled;
+
+static inline bool avl_trace_active(void) {
+    return __builtin_expect(
+        atomic_load_explicit(&avl_trace_enabled, memory_order_relaxed), 0);
+}
+
+int avl_trace_start(size_t events_per_thread);
+void avl_trace_stop(void);
+void avl_trace_set_op(uint8_t op);
+void avl_trace_record(AvlTraceEvent *event);
+int avl_trace_dump(const char *path);
+void avl_trace_free(void);
+
+#endif /* AVL_TRACE_H */
@@ -0,0 +1,111 @@
+/*
+ * avl_trace_decode: print a trace written by avl_trace_dump.
+ *
+ *   gcc avl_trace_decode.c -std=c11 -Wall -Wextra -pedantic -o avl_trace_decode
+ *   ./avl_trace_decode avl_trace.bin
+ *
+ * One line per record, in the format the old printf tracing used,
+ * prefixed with the thread, the time since that thread's first record
+ * and the operation (insert/delete) that triggered it.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "avl_trace.h"
+
+static const char *op_name(uint8_t op) {
+    switch (op) {
+    case AVL_OP_INSERT: return "ins";
+    case AVL_OP_DELETE: return "del";
+    default:            return "-";
+    }
+}
+
+static const char *phase_name(uint8_t phase) {
+    static const char *names[] = { "before", "after-child-rot",
+                                   "after-root-rot", "after-no-rot" };
+    return phase < 4 ? names[phase] : "?";
+}
+
+static const char *rotation_name(uint8_t kind) {
+    static const char *names[] = { "LR-pre", "LL", "RL-pre", "RR" };
+    return kind < 4 ? names[kind] : "?";
+}
+
+static void print_event(const AvlTraceEvent *ev) {
+    switch (ev->type) {
+    case AVL_EV_STATE:
+        if (ev->key == AVL_TRACE_NO_KEY) {
+            printf("[state:%s] <null>\n", phase_name(ev->detail));
+            break;
+        }
+        printf("[state:%s] node=%d h=%d hl=%d hr=%d bf=%+d L=%s R=%s\n",
+               phase_name(ev->detail), ev->key, ev->other, ev->hl, ev->hr,
+               ev->bf, ev->hl >= 0 ? "X" : ".", ev->hr >= 0 ? "X" : ".");
+        break;
+    case AVL_EV_TRIGGER:
+        printf("[rebalance trigger] %s at node %d (bf=%+d)\n",
+               ev->detail == AVL_TRIGGER_LEFT_HEAVY ? "left-heavy" : "right-heavy",
+               ev->key, ev->bf);
+        break;
+    case AVL_EV_ROTATION:
+        printf("[rotation] %-7s pivot=%d -> new_root=%d\n",
+               rotation_name(ev->detail), ev->key, ev->other);
+        break;
+    default:
+        printf("[unknown event type %u]\n", ev->type);
+        break;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s <trace file>\n", argv[0]);
+        return 1;
+    }
+
+    FILE *f = fopen(argv[1], "rb");
+    if (f == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    uint32_t header[4];
+    if (fread(header, sizeof(header), 1, f) != 1 || header[0] != AVL_TRACE_MAGIC ||
+        header[1] != AVL_TRACE_VERSION || header[2] != sizeof(AvlTraceEvent)) {
+        fprintf(stderr, "Error: %s is not a version %u AVL trace\n",
+                argv[1], AVL_TRACE_VERSION);
+        fclose(f);
+        return 1;
+    }
+
+    int rc = 0;
+    for (uint32_t ring = 0; ring < header[3]; ring++) {
+        uint64_t meta[3];  // thread, written, count
+        if (fread(meta, sizeof(meta), 1, f) != 1) {
+            fprintf(stderr, "Error: truncated ring header\n");
+            rc = 1;
+            break;
+        }
+        printf("=== thread %" PRIu64 ": %" PRIu64 " records (%" PRIu64 " overwritten)\n",
+               meta[0], meta[2], meta[1] - meta[2]);
+
+        uint64_t first_ts = 0;
+        for (uint64_t i = 0; i < meta[2]; i++) {
+            AvlTraceEvent ev;
+            if (fread(&ev, sizeof(ev), 1, f) != 1) {
+                fprintf(stderr, "Error: truncated ring\n");
+                fclose(f);
+                return 1;
+            }
+            if (i == 0) first_ts = ev.ts_ns;
+            printf("t%" PRIu64 " +%10.3f us %-3s ", meta[0],
+                   (ev.ts_ns - first_ts) / 1e3, op_name(ev.op));
+            print_event(&ev);
+        }
+    }
+
+    fclose(f);
+    return rc;
+}
@@ -3,7 +3,13 @@
 #include "avl_tree.h"
 
 #define NIL_HEIGHT (-1)
-#define TRACE_ROTATIONS 1
+#define AVL_MAX_PATH 64  /* Path stack depth for the iterative operations */
+#define BUILD_CHUNK 4096 /* Keys avl_build_stream buffers per subtree */
+
+/* Build with -DTRACE_ROTATIONS=1 (and avl_trace.c) to record rebalancing */
+#ifndef TRACE_ROTATIONS
+#define TRACE_ROTATIONS 0
+#endif
 
 /* ---------- Internal Helpers (Static) ---------- */
 
@@ -11,44 +17,55 @@ static int getHeight(struct Node *n);
 static void updateHeight(struct Node *n);
 
 #if TRACE_ROTATIONS
-static void log_trigger(const char *reason, struct Node *node, int bf) {
-    printf("[rebalance trigger] %s at node %d (bf=%+d)\n",
-           reason,
-           node ? node->key : -999,
-           bf);
+#include "avl_trace.h"
+
+static void record_trigger(int side, struct Node *node, int bf) {
+    AvlTraceEvent ev = { 0 };
+    ev.type = AVL_EV_TRIGGER;
+    ev.detail = (uint8_t)side;
+    ev.key = node ? node->key : AVL_TRACE_NO_KEY;
+    ev.bf = (int8_t)bf;
+    avl_trace_record(&ev);
 }
 
-static void log_rotation(const char *label, int pivot_key, int new_root_key) {
-    printf("[rotation] %-7s pivot=%d -> new_root=%d\n",
-           label,
-           pivot_key,
-           new_root_key);
+static void record_rotation(int kind, struct Node *pivot, struct Node *new_root) {
+    AvlTraceEvent ev = { 0 };
+    ev.type = AVL_EV_ROTATION;
+    ev.detail = (uint8_t)kind;
+    ev.key = pivot ? pivot->key : AVL_TRACE_NO_KEY;
+    ev.other = new_root ? new_root->key : AVL_TRACE_NO_KEY;
+    avl_trace_record(&ev);
 }
 
-static void log_state(const char *phase, struct Node *node) {
-    if (node == NULL) {
-        printf("[state:%s] <null>\n", phase);
-        return;
+static void record_state(int phase, struct Node *node) {
+    AvlTraceEvent ev = { 0 };
+    ev.type = AVL_EV_STATE;
+    ev.detail = (uint8_t)phase;
+    ev.key = AVL_TRACE_NO_KEY;
+    if (node != NULL) {
+        ev.key = node->key;
+        ev.other = node->height;
+        ev.hl = (int16_t)getHeight(node->left);
+        ev.hr = (int16_t)getHeight(node->right);
+        ev.bf = (int8_t)(ev.hl - ev.hr);
     }
-
-    int hl = getHeight(node->left);
-    int hr = getHeight(node->right);
-    int bf = hl - hr;
-
-    printf("[state:%s] node=%d h=%d hl=%d hr=%d bf=%+d L=%s R=%s\n",
-           phase,
-           node->key,
-           node->height,
-           hl,
-           hr,
-           bf,
-           node->left ? "X" : ".",
-           node->right ? "X" : ".");
+    avl_trace_record(&ev);
 }
+
+/* Hooks: one relaxed load and a branch while tracing is stopped */
+#define trace_op(op) \
+    do { if (avl_trace_active()) avl_trace_set_op(op); } while (0)
+#define trace_trigger(side, node, bf) \
+    do { if (avl_trace_active()) record_trigger(side, node, bf); } while (0)
+#define trace_rotation(kind, pivot, new_root) \
+    do { if (avl_trace_active()) record_rotation(kind, pivot, new_root); } while (0)
+#define trace_state(phase, node) \
+    do { if (avl_trace_active()) record_state(phase, node); } while (0)
 #else
-#define log_trigger(reason, node, bf) ((void)0)
-#define log_rotation(label, pivot, new_root) ((void)0)
-#define log_state(phase, node) ((void)0)
+#define trace_op(op) ((void)0)
+#define trace_trigger(side, node, bf) ((void)0)
+#define trace_rotation(kind, pivot, new_root) ((void)0)
+#define trace_state(phase, node) ((void)0)
 #endif
 
 static struct Node *newNode(int key) {
@@ -130,84 +147,137 @@ static struct Node *rebalance(struct Node *node) {
     if (node == NULL) return NULL;
 
     updateHeight(node);
-    log_state("before", node);
+    trace_state(AVL_PHASE_BEFORE, node);
     int bf = getBalanceFactor(node);
 
     if (bf > 1) {  // left subtree heavier than right
-        log_trigger("left-heavy", node, bf);
+        trace_trigger(AVL_TRIGGER_LEFT_HEAVY, node, bf);
         if (getBalanceFactor(node->left) < 0) {  // LR pattern
-            int pivot_key = node->left ? node->left->key : -999;
-            int new_root_key = (node->left && node->left->right)
-                                   ? node->left->right->key
-                                   : -999;
-            log_rotation("LR-pre", pivot_key, new_root_key);
+            trace_rotation(AVL_ROT_LR_PRE, node->left, node->left->right);
             node->left = rotate_left(node->left);
-            log_state("after-child-rot", node->left);
+            trace_state(AVL_PHASE_AFTER_CHILD_ROT, node->left);
         }
-        int pivot_key = node->key;
-        int new_root_key = node->left ? node->left->key : -999;
+        trace_rotation(AVL_ROT_LL, node, node->left);
         struct Node *new_root = rotate_right(node);
-        log_rotation("LL", pivot_key, new_root_key);
-        log_state("after-root-rot", new_root);
+        trace_state(AVL_PHASE_AFTER_ROOT_ROT, new_root);
         return new_root;
     }
 
     if (bf < -1) {  // right subtree heavier than left
-        log_trigger("right-heavy", node, bf);
+        trace_trigger(AVL_TRIGGER_RIGHT_HEAVY, node, bf);
         if (getBalanceFactor(node->right) > 0) {  // RL pattern
-            int pivot_key = node->right ? node->right->key : -999;
-            int new_root_key = (node->right && node->right->left)
-                                   ? node->right->left->key
-                                   : -999;
-            log_rotation("RL-pre", pivot_key, new_root_key);
+            trace_rotation(AVL_ROT_RL_PRE, node->right, node->right->left);
             node->right = rotate_right(node->right);
-            log_state("after-child-rot", node->right);
+            trace_state(AVL_PHASE_AFTER_CHILD_ROT, node->right);
         }
-        int pivot_key = node->key;
-        int new_root_key = node->right ? node->right->key : -999;
+        trace_rotation(AVL_ROT_RR, node, node->right);
         struct Node *new_root = rotate_left(node);
-        log_rotation("RR", pivot_key, new_root_key);
-        log_state("after-root-rot", new_root);
+        trace_state(AVL_PHASE_AFTER_ROOT_ROT, new_root);
         return new_root;
     }
 
-    log_state("after-no-rot", node);
+    trace_state(AVL_PHASE_AFTER_NO_ROT, node);
     return node;
 }
 
 /* ---------- Public Operations Implementation ---------- */
 
+/*
+ * Iterative versions. insertAVL/deleteAVL record the links they pass in
+ * a stack and rebalance bottom-up, stopping at the first subtree whose
+ * height did not change (nothing above it can change either).
+ * An AVL tree of n < 2^31 keys is at most 1.44 log2(n) < 46 high; on a
+ * deeper (non-AVL) tree they fall back to the recursive versions.
+ */
+
 int searchBST(struct Node *root, int key) {
-    if (root == NULL) return 0;
-    if (key == root->key) return 1;
-    return (key < root->key)
-        ? searchBST(root->left, key)
-        : searchBST(root->right, key);
+    while (root != NULL) {
+        if (key == root->key) return 1;
+        root = (key < root->key) ? root->left : root->right;
+    }
+    return 0;
 }
 
 struct Node *insertBST(struct Node *root, int key) {
-    if (root == NULL) {
-        return newNode(key);
-    }
-    if (key < root->key) {
-        root->left = insertBST(root->left, key);
-    } else if (key > root->key) {
-        root->right = insertBST(root->right, key);
-    } else {
-        return root;  // duplicate key: do nothing
+    struct Node **link = &root;
+    int depth = 0;
+    while (*link != NULL) {
+        if (key == (*link)->key) return root;  // duplicate key: do nothing
+        link = (key < (*link)->key) ? &(*link)->left : &(*link)->right;
+        depth++;
     }
+    *link = newNode(key);
 
-    updateHeight(root);
+    /* No stack (a plain BST can be arbitrarily deep): walk down again */
+    for (struct Node *n = root; n != *link; depth--) {
+        if (n->height < depth) n->height = depth;
+        n = (key < n->key) ? n->left : n->right;
+    }
     return root;
 }
 
-/* insertAVL: BST insert + rebalance on return */
+/* rebalance_path: rebalance links path[depth-1] .. path[0] bottom-up */
+static void rebalance_path(struct Node **path[], int depth) {
+    while (depth > 0) {
+        struct Node **link = path[--depth];
+        int old_height = (*link)->height;
+        *link = rebalance(*link);
+        if ((*link)->height == old_height) break;  // early stop
+    }
+}
+
 struct Node *insertAVL(struct Node *root, int key) {
-    if (root == NULL) return newNode(key);
-    if (key < root->key) root->left  = insertAVL(root->left, key);
-    else if (key > root->key) root->right = insertAVL(root->right, key);
-    else return root;  // duplicates ignored
-    return rebalance(root);
+    trace_op(AVL_OP_INSERT);
+    struct Node **path[AVL_MAX_PATH];
+    struct Node **link = &root;
+    int depth = 0;
+
+    while (*link != NULL) {
+        if (key == (*link)->key) return root;  // duplicates ignored
+        if (depth == AVL_MAX_PATH) return insertAVL_rec(root, key);
+        path[depth++] = link;
+        link = (key < (*link)->key) ? &(*link)->left : &(*link)->right;
+    }
+    *link = newNode(key);
+    rebalance_path(path, depth);
+    return root;
+}
+
+struct Node *deleteAVL(struct Node *root, int key) {
+    trace_op(AVL_OP_DELETE);
+    struct Node **path[AVL_MAX_PATH];
+    struct Node **link = &root;
+    int depth = 0;
+
+    while (*link != NULL && (*link)->key != key) {
+        if (depth == AVL_MAX_PATH) return deleteAVL_rec(root, key);
+        path[depth++] = link;
+        link = (key < (*link)->key) ? &(*link)->left : &(*link)->right;
+    }
+    if (*link == NULL) return root;
+
+    struct Node *target = *link;
+    if (target->left != NULL && target->right != NULL) {
+        /* Continue to the successor in the same descent, then unlink it */
+        struct Node **succ = &target->right;
+        if (depth == AVL_MAX_PATH) return deleteAVL_rec(root, key);
+        path[depth++] = link;
+        while ((*succ)->left != NULL) {
+            if (depth == AVL_MAX_PATH) return deleteAVL_rec(root, key);
+            path[depth++] = succ;
+            succ = &(*succ)->left;
+        }
+        struct Node *successor = *succ;
+        target->key = successor->key;
+        *succ = successor->right;
+        free(successor);
+    } else {
+        *link = (target->left != NULL) ? target->left : target->right;
+        free(target);
+    }
+
+    rebalance_path(path, depth);
+    return root;
 }
 
 struct Node *deleteBST(struct Node *root, int key) {
@@ -244,13 +314,50 @@ struct Node *deleteBST(struct Node *root, int key) {
     return root;
 }
 
-/* deleteAVL: BST delete + rebalance on return */
-struct Node *deleteAVL(struct Node *root, int key) {
+/* ---------- Recursive Reference Versions ---------- */
+
+int searchBST_rec(struct Node *root, int key) {
+    if (root == NULL) return 0;
+    if (key == root->key) return 1;
+    return (key < root->key)
+        ? searchBST_rec(root->left, key)
+        : searchBST_rec(root->right, key);
+}
+
+struct Node *insertBST_rec(struct Node *root, int key) {
+    if (root == NULL) {
+        return newNode(key);
+    }
+    if (key < root->key) {
+        root->left = insertBST_rec(root->left, key);
+    } else if (key > root->key) {
+        root->right = insertBST_rec(root->right, key);
+    } else {
+        return root;  // duplicate key: do nothing
+    }
+
+    updateHeight(root);
+    return root;
+}
+
+/* insertAVL_rec: BST insert + rebalance on return */
+struct Node *insertAVL_rec(struct Node *root, int key) {
+    trace_op(AVL_OP_INSERT);
+    if (root == NULL) return newNode(key);
+    if (key < root->key) root->left  = insertAVL_rec(root->left, key);
+    else if (key > root->key) root->right = insertAVL_rec(root->right, key);
+    else return root;  // duplicates ignored
+    return rebalance(root);
+}
+
+/* deleteAVL_rec: BST delete + rebalance on return */
+struct Node *deleteAVL_rec(struct Node *root, int key) {
+    trace_op(AVL_OP_DELETE);
     if (root == NULL) return NULL;
     if (key < root->key) {
-        root->left = deleteAVL(root->left, key);
+        root->left = deleteAVL_rec(root->left, key);
     } else if (key > root->key) {
-        root->right = deleteAVL(root->right, key);
+        root->right = deleteAVL_rec(root->right, key);
     } else {
         if (root->left == NULL && root->right == NULL) {
             free(root);
@@ -265,7 +372,7 @@ struct Node *deleteAVL(struct Node *root, int key) {
 
         struct Node *successor = minValueNode(root->right);
         root->key = successor->key;
-        root->right = deleteAVL(root->right, successor->key);
+        root->right = deleteAVL_rec(root->right, successor->key);
     }
     return rebalance(root);
 }
@@ -279,6 +386,163 @@ void freeTree(struct Node *root) {
     free(root);
 }
 
+/* ---------- Join-Based Operations ---------- */
+
+/*
+ * avl_join links left, mid and right in O(|h(left) - h(right)| + 1):
+ * it walks down the spine of the taller tree to a subtree whose height
+ * is within one of the shorter tree, hangs mid there and rotates back
+ * up (Blelloch, Ferizovic and Sun, "Just Join for Parallel Ordered
+ * Sets"). avl_split and avl_concat are built on it; all three reuse the
+ * given nodes and allocate nothing.
+ */
+
+/* join_right: left is taller by more than one */
+static struct Node *join_right(struct Node *l, struct Node *k, struct Node *r) {
+    struct Node *c = l->right;
+    if (getHeight(c) <= getHeight(r) + 1) {
+        k->left = c;
+        k->right = r;
+        updateHeight(k);
+        if (getHeight(k) <= getHeight(l->left) + 1) {
+            l->right = k;
+            updateHeight(l);
+            return l;
+        }
+        l->right = rotate_right(k);
+        updateHeight(l);
+        return rotate_left(l);
+    }
+    l->right = join_right(c, k, r);
+    updateHeight(l);
+    if (getHeight(l->right) <= getHeight(l->left) + 1) return l;
+    return rotate_left(l);
+}
+
+/* join_left: mirror image of join_right (right is taller) */
+static struct Node *join_left(struct Node *l, struct Node *k, struct Node *r) {
+    struct Node *c = r->left;
+    if (getHeight(c) <= getHeight(l) + 1) {
+        k->left = l;
+        k->right = c;
+        updateHeight(k);
+        if (getHeight(k) <= getHeight(r->right) + 1) {
+            r->left = k;
+            updateHeight(r);
+            return r;
+        }
+        r->left = rotate_left(k);
+        updateHeight(r);
+        return rotate_right(r);
+    }
+    r->left = join_left(l, k, c);
+    updateHeight(r);
+    if (getHeight(r->left) <= getHeight(r->right) + 1) return r;
+    return rotate_right(r);
+}
+
+struct Node *avl_join(struct Node *left, struct Node *mid, struct Node *right) {
+    if (getHeight(left) > getHeight(right) + 1) return join_right(left, mid, right);
+    if (getHeight(right) > getHeight(left) + 1) return join_left(left, mid, right);
+    mid->left = left;
+    mid->right = right;
+    updateHeight(mid);
+    return mid;
+}
+
+/* split_last: detach the largest node into *last, return the rest */
+static struct Node *split_last(struct Node *root, struct Node **last) {
+    if (root->right == NULL) {
+        *last = root;
+        return root->left;
+    }
+    struct Node *rest = split_last(root->right, last);
+    return avl_join(root->left, root, rest);
+}
+
+struct Node *avl_concat(struct Node *left, struct Node *right) {
+    if (left == NULL) return right;
+    struct Node *last = NULL;
+    struct Node *rest = split_last(left, &last);
+    return avl_join(rest, last, right);
+}
+
+/*
+ * avl_split: keys < key go to *left, keys > key to *right. Returns the
+ * node holding key, detached (no children, height 0), or NULL.
+ */
+struct Node *avl_split(struct Node *root, int key,
+                       struct Node **left, struct Node **right) {
+    if (root == NULL) {
+        *left = NULL;
+        *right = NULL;
+        return NULL;
+    }
+
+    struct Node *l = root->left;
+    struct Node *r = root->right;
+    struct Node *found = NULL;
+
+    if (key < root->key) {
+        found = avl_split(l, key, left, &l);
+        *right = avl_join(l, root, r);
+    } else if (key > root->key) {
+        found = avl_split(r, key, &r, right);
+        *left = avl_join(l, root, r);
+    } else {
+        *left = l;
+        *right = r;
+        root->left = NULL;
+        root->right = NULL;
+        root->height = 0;
+        found = root;
+    }
+    return found;
+}
+
+/* ---------- Bulk Construction ---------- */
+
+/*
+ * build_range: the middle key becomes the root, the halves its
+ * subtrees. Subtree sizes differ by at most one, so the result is
+ * balanced with no rotations, and every node is visited once: O(n).
+ */
+static struct Node *build_range(const int *keys, size_t n) {
+    if (n == 0) return NULL;
+    size_t mid = n / 2;
+    struct Node *node = newNode(keys[mid]);
+    node->left = build_range(keys, mid);
+    node->right = build_range(keys + mid + 1, n - mid - 1);
+    updateHeight(node);
+    return node;
+}
+
+struct Node *avl_build_sorted(const int *keys, size_t n) {
+    return build_range(keys, n);
+}
+
+/*
+ * avl_build_stream: next() stores the following key and returns 1, or
+ * returns 0 at the end. Keys are read BUILD_CHUNK at a time; each chunk
+ * becomes a balanced subtree that avl_join appends to the right spine
+ * (O(log n) per chunk), so the total stays O(n) and only one chunk is
+ * ever buffered.
+ */
+struct Node *avl_build_stream(int (*next)(void *ctx, int *key), void *ctx) {
+    int buf[BUILD_CHUNK];
+    struct Node *root = NULL;
+    size_t n = BUILD_CHUNK;
+
+    while (n == BUILD_CHUNK) {
+        n = 0;
+        while (n < BUILD_CHUNK && next(ctx, &buf[n])) n++;
+        if (n == 0) break;
+        struct Node *mid = newNode(buf[0]);
+        root = avl_join(root, mid, build_range(buf + 1, n - 1));
+    }
+    return root;
+}
+
 /* ---------- Traversal & Debug Implementation ---------- */
 
 void print_inorder(struct Node *root) {
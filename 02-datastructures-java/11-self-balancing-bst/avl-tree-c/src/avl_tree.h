@@ -1,6 +1,7 @@
 #ifndef AVL_TREE_H
 #define AVL_TREE_H
 
+#include <stddef.h>
 #include <stdio.h>
 
 /* Node structure */
@@ -21,6 +22,22 @@ struct Node *deleteAVL(struct Node *root, int key);
 int searchBST(struct Node *root, int key);
 void freeTree(struct Node *root);
 
+/* Recursive Reference Versions (same results; kept for comparison) */
+struct Node *insertBST_rec(struct Node *root, int key);
+struct Node *insertAVL_rec(struct Node *root, int key);
+struct Node *deleteAVL_rec(struct Node *root, int key);
+int searchBST_rec(struct Node *root, int key);
+
+/* Bulk Construction (keys strictly increasing) */
+struct Node *avl_build_sorted(const int *keys, size_t n);
+struct Node *avl_build_stream(int (*next)(void *ctx, int *key), void *ctx);
+
+/* Join-Based Operations (all keys in left < mid->key < all keys in right) */
+struct Node *avl_join(struct Node *left, struct Node *mid, struct Node *right);
+struct Node *avl_concat(struct Node *left, struct Node *right);
+struct Node *avl_split(struct Node *root, int key,
+                       struct Node **left, struct Node **right);
+
 /* Debugging & Visualization */
 void print_inorder(struct Node *root);
 void print_tree_debug(struct Node *n, int depth);
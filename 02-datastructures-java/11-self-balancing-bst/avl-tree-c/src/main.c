@@ -4,6 +4,29 @@
 
 #define SAMPLE_INSERTS 10
 
+/* Same switch as avl_tree.c: -DTRACE_ROTATIONS=1 records rebalancing */
+#ifndef TRACE_ROTATIONS
+#define TRACE_ROTATIONS 0
+#endif
+
+#if TRACE_ROTATIONS
+#include "avl_trace.h"
+#define TRACE_FILE "avl_trace.bin"
+#endif
+
+/* finish_trace: write the rotation trace (if built in) before exiting */
+static void finish_trace(void) {
+#if TRACE_ROTATIONS
+    if (avl_trace_dump(TRACE_FILE) == 0) {
+        printf("Rotation trace written to %s (decode with avl_trace_decode)\n",
+               TRACE_FILE);
+    } else {
+        fprintf(stderr, "Could not write %s\n", TRACE_FILE);
+    }
+    avl_trace_free();
+#endif
+}
+
 static void wait_for_enter(const char *prompt) {
     int ch = 0;
     printf("%s", prompt);
@@ -19,10 +42,30 @@ int random_key(int max_value) {
     return rand() % max_value;
 }
 
+static int compare_ints(const void *a, const void *b) {
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+/* sorted_unique_keys: sort keys into out, drop duplicates, return count */
+static int sorted_unique_keys(const int *keys, int n, int *out) {
+    int count = 0;
+    for (int i = 0; i < n; i++) out[i] = keys[i];
+    qsort(out, (size_t)n, sizeof(int), compare_ints);
+    for (int i = 0; i < n; i++) {
+        if (count == 0 || out[i] != out[count - 1]) out[count++] = out[i];
+    }
+    return count;
+}
+
 int main(void) {
     struct Node *root = NULL;
     int keys[SAMPLE_INSERTS];
 
+#if TRACE_ROTATIONS
+    avl_trace_start(0);
+#endif
+
     printf("--- Generating Random Tree (unbalanced BST inserts) ---\n");
     for (int i = 0; i < SAMPLE_INSERTS; i++) {
         int key = random_key(1000);
@@ -71,6 +114,23 @@ int main(void) {
     print_inorder(avl_root);
     printf("\n\n");
 
+    printf("--- Building From Sorted Keys (avl_build_sorted, no rotations) ---\n");
+    int sorted[SAMPLE_INSERTS];
+    int unique = sorted_unique_keys(keys, SAMPLE_INSERTS, sorted);
+    struct Node *built = avl_build_sorted(sorted, (size_t)unique);
+
+    printf("\n[Visual Dashboard After Bulk Build]\n");
+    print_tree_debug(built, 0);
+    printf("--------------------------------------------------\n");
+
+    printf("\n[Automated Verification After Bulk Build]\n");
+    if (check_avl_invariant(built)) {
+        printf("RESULT: PASS (Valid AVL Tree)\n\n");
+    } else {
+        printf("RESULT: FAIL (Unexpected imbalance)\n\n");
+    }
+    freeTree(built);
+
     freeTree(root);
     root = avl_root;
 
@@ -80,6 +140,7 @@ int main(void) {
     if (scanf("%d", &target) != 1) {
         fprintf(stderr, "Invalid input\n");
         freeTree(root);
+        finish_trace();
         return 1;
     }
 
@@ -103,5 +164,6 @@ int main(void) {
     }
 
     freeTree(root);
+    finish_trace();
     return 0;
 }
@@ -0,0 +1,964 @@
+/* ============================================================
+ * AVL map / set with std::map-compatible interface (C++20)
+ * ============================================================
+ * The balancing is the one in ../avl-tree-c/src/avl_tree.c: every
+ * node stores its height (leaf 0, empty -1), rebalance() recomputes it
+ * and dispatches LL/LR/RL/RR rotations, and after an insert or erase
+ * the path is fixed bottom-up, stopping at the first subtree whose
+ * height did not change.
+ *
+ * What the container needs on top of that:
+ *
+ * - Parent pointers, so iterators can step in O(1) amortized and
+ *   fixups walk up without a path stack. The header node's left child
+ *   is the root; end() is the header.
+ * - Nodes are relinked, never copied: erase moves the successor node
+ *   into the erased node's place, so iterators and references to all
+ *   other elements stay valid (as for std::map).
+ * - emplace_hint attaches next to the hint when the key fits there,
+ *   skipping the descent; sorted input with end() as hint costs O(1)
+ *   amortized per element.
+ * - extract / insert(node_type&&) move nodes between containers with
+ *   the same allocator without reallocating them.
+ * - Nodes come from Alloc rebound to the node type, and the value is
+ *   built with uses-allocator construction (so pmr strings share the
+ *   container's resource). Assignment and swap follow the allocator's
+ *   propagate_on_container_* traits; when allocators differ and do not
+ *   propagate, elements are moved or copied one by one.
+ *
+ * [x] avl::map       - unique keys, pair<const K, V> elements
+ * [x] avl::set       - unique keys, immutable elements
+ * [x] check_invariant - parent links, order, heights, balance, size
+ * ============================================================ */
+
+#ifndef AVL_MAP_HPP
+#define AVL_MAP_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace avl {
+
+namespace detail {
+
+/* ================================================================
+ * NODE LINKS AND REBALANCING (value-independent)
+ * ================================================================ */
+
+struct NodeBase {
+    NodeBase *parent = nullptr;
+    NodeBase *left = nullptr;
+    NodeBase *right = nullptr;
+    int height = 0;  /* -1 marks the header */
+};
+
+inline int height(const NodeBase *n) { return n ? n->height : -1; }
+
+inline void update_height(NodeBase *n) {
+    n->height = 1 + std::max(height(n->left), height(n->right));
+}
+
+inline int balance_factor(const NodeBase *n) {
+    return height(n->left) - height(n->right);
+}
+
+inline NodeBase *minimum(NodeBase *n) {
+    while (n->left) n = n->left;
+    return n;
+}
+
+inline NodeBase *maximum(NodeBase *n) {
+    while (n->right) n = n->right;
+    return n;
+}
+
+/* next - In-order successor; the maximum is followed by the header */
+inline NodeBase *next(NodeBase *n) {
+    if (n->right) return minimum(n->right);
+    NodeBase *p = n->parent;
+    while (p->right == n) {  /* header->right is null: stops there */
+        n = p;
+        p = p->parent;
+    }
+    return p;
+}
+
+/* prev - In-order predecessor; the header (end) steps to the maximum */
+inline NodeBase *prev(NodeBase *n) {
+    if (n->height < 0) return maximum(n->left);
+    if (n->left) return maximum(n->left);
+    NodeBase *p = n->parent;
+    while (p->left == n) {
+        n = p;
+        p = p->parent;
+    }
+    return p;
+}
+
+/* replace - Point x's parent (or the header) at y instead of x */
+inline void replace(NodeBase *x, NodeBase *y) {
+    NodeBase *p = x->parent;
+    if (y) y->parent = p;
+    if (p->left == x) {
+        p->left = y;
+    } else {
+        p->right = y;
+    }
+}
+
+inline NodeBase *rotate_left(NodeBase *x) {
+    NodeBase *y = x->right;
+    x->right = y->left;
+    if (y->left) y->left->parent = x;
+    replace(x, y);
+    y->left = x;
+    x->parent = y;
+    update_height(x);
+    update_height(y);
+    return y;
+}
+
+inline NodeBase *rotate_right(NodeBase *y) {
+    NodeBase *x = y->left;
+    y->left = x->right;
+    if (x->right) x->right->parent = y;
+    replace(y, x);
+    x->right = y;
+    y->parent = x;
+    update_height(y);
+    update_height(x);
+    return x;
+}
+
+/* rebalance - Same cases as rebalance() in avl_tree.c; returns the subtree root */
+inline NodeBase *rebalance(NodeBase *n) {
+    update_height(n);
+    int bf = balance_factor(n);
+    if (bf > 1) {
+        if (balance_factor(n->left) < 0) rotate_left(n->left);  /* LR */
+        return rotate_right(n);
+    }
+    if (bf < -1) {
+        if (balance_factor(n->right) > 0) rotate_right(n->right);  /* RL */
+        return rotate_left(n);
+    }
+    return n;
+}
+
+/* fixup - Rebalance from n up to the root; stop once a height is unchanged */
+inline void fixup(NodeBase *n, NodeBase *header) {
+    while (n != header) {
+        int old_height = n->height;
+        n = rebalance(n);
+        if (n->height == old_height) return;
+        n = n->parent;
+    }
+}
+
+/* ================================================================
+ * KEY EXTRACTION
+ * ================================================================ */
+
+template <class K, class V>
+struct MapTraits {
+    using key_type = K;
+    using value_type = std::pair<const K, V>;
+    static constexpr bool kMutable = true;
+    static const K &key(const value_type &v) { return v.first; }
+};
+
+template <class K>
+struct SetTraits {
+    using key_type = K;
+    using value_type = K;
+    static constexpr bool kMutable = false;
+    static const K &key(const value_type &v) { return v; }
+};
+
+/* ================================================================
+ * TREE (shared by map and set)
+ * ================================================================ */
+
+template <class Traits, class Compare, class Alloc>
+class Tree {
+public:
+    using key_type = typename Traits::key_type;
+    using value_type = typename Traits::value_type;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using key_compare = Compare;
+    using allocator_type = Alloc;
+    using reference = value_type &;
+    using const_reference = const value_type &;
+
+private:
+    /* The allocator comes first so value gets uses-allocator construction */
+    struct Node : NodeBase {
+        template <class A, class... Args>
+        explicit Node(const A &alloc, Args &&...args)
+            : value(std::make_obj_using_allocator<value_type>(alloc,
+                                                              std::forward<Args>(args)...)) {}
+
+        value_type value;
+    };
+
+    using NodeAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Node>;
+    using NodeTraits = std::allocator_traits<NodeAlloc>;
+
+    static Node *as_node(NodeBase *n) { return static_cast<Node *>(n); }
+    static const key_type &key_of(const NodeBase *n) {
+        return Traits::key(static_cast<const Node *>(n)->value);
+    }
+
+    template <bool Const>
+    class Iter {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = typename Traits::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<Const, const value_type *, value_type *>;
+        using reference = std::conditional_t<Const, const value_type &, value_type &>;
+
+        Iter() = default;
+        explicit Iter(NodeBase *n) : node_(n) {}
+        template <bool C = Const, class = std::enable_if_t<C>>
+        Iter(const Iter<false> &other) : node_(other.node_) {}
+
+        reference operator*() const { return as_node(node_)->value; }
+        pointer operator->() const { return std::addressof(as_node(node_)->value); }
+
+        Iter &operator++() { node_ = next(node_); return *this; }
+        Iter operator++(int) { Iter old = *this; node_ = next(node_); return old; }
+        Iter &operator--() { node_ = prev(node_); return *this; }
+        Iter operator--(int) { Iter old = *this; node_ = prev(node_); return old; }
+
+        friend bool operator==(const Iter &a, const Iter &b) { return a.node_ == b.node_; }
+
+    private:
+        friend class Tree;
+        template <bool> friend class Iter;
+        NodeBase *node_ = nullptr;
+    };
+
+public:
+    using const_iterator = Iter<true>;
+    using iterator = std::conditional_t<Traits::kMutable, Iter<false>, const_iterator>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    /*
+     * NodeHandle - Owns one extracted node (std::map::node_type)
+     *
+     * key()/mapped() exist for maps, value() for sets; each is only
+     * instantiated when used.
+     */
+    class NodeHandle {
+    public:
+        using allocator_type = Alloc;
+
+        NodeHandle() = default;
+        NodeHandle(NodeHandle &&other) noexcept
+            : node_(std::exchange(other.node_, nullptr)), alloc_(std::move(other.alloc_)) {
+            other.alloc_.reset();
+        }
+        NodeHandle &operator=(NodeHandle &&other) noexcept {
+            if (this != &other) {
+                reset();
+                node_ = std::exchange(other.node_, nullptr);
+                /* Re-construct: allocators need not be assignable (pmr) */
+                alloc_.reset();
+                if (other.alloc_) alloc_.emplace(std::move(*other.alloc_));
+                other.alloc_.reset();
+            }
+            return *this;
+        }
+        ~NodeHandle() { reset(); }
+
+        bool empty() const noexcept { return node_ == nullptr; }
+        explicit operator bool() const noexcept { return node_ != nullptr; }
+        allocator_type get_allocator() const { return allocator_type(*alloc_); }
+
+        auto &key() const { return const_cast<key_type &>(node_->value.first); }
+        auto &mapped() const { return node_->value.second; }
+        auto &value() const { return node_->value; }
+
+    private:
+        friend class Tree;
+        NodeHandle(Node *node, const NodeAlloc &alloc) : node_(node), alloc_(alloc) {}
+
+        void reset() {
+            if (node_) {
+                NodeTraits::destroy(*alloc_, node_);
+                NodeTraits::deallocate(*alloc_, node_, 1);
+                node_ = nullptr;
+            }
+        }
+
+        Node *node_ = nullptr;
+        std::optional<NodeAlloc> alloc_;
+    };
+
+    using node_type = NodeHandle;
+
+    struct insert_return_type {
+        iterator position;
+        bool inserted;
+        node_type node;
+    };
+
+    /* ---------- Construction ---------- */
+
+    Tree() : Tree(Compare()) {}
+    explicit Tree(const Compare &comp, const Alloc &alloc = Alloc())
+        : comp_(comp), alloc_(alloc) {
+        reset_header();
+    }
+    explicit Tree(const Alloc &alloc) : Tree(Compare(), alloc) {}
+
+    template <class InputIt>
+    Tree(InputIt first, InputIt last, const Compare &comp = Compare(),
+         const Alloc &alloc = Alloc())
+        : Tree(comp, alloc) {
+        insert(first, last);
+    }
+
+    Tree(std::initializer_list<value_type> init, const Compare &comp = Compare(),
+         const Alloc &alloc = Alloc())
+        : Tree(init.begin(), init.end(), comp, alloc) {}
+
+    Tree(const Tree &other)
+        : comp_(other.comp_),
+          alloc_(NodeTraits::select_on_container_copy_construction(other.alloc_)) {
+        reset_header();
+        copy_from(other);
+    }
+
+    Tree(const Tree &other, const Alloc &alloc) : comp_(other.comp_), alloc_(alloc) {
+        reset_header();
+        copy_from(other);
+    }
+
+    Tree(Tree &&other) noexcept
+        : comp_(std::move(other.comp_)), alloc_(std::move(other.alloc_)) {
+        reset_header();
+        take_from(other);
+    }
+
+    /* Nodes are adopted only if alloc can free them; else moved one by one */
+    Tree(Tree &&other, const Alloc &alloc) : comp_(other.comp_), alloc_(alloc) {
+        reset_header();
+        move_from(other);
+    }
+
+    /*
+     * Copy into a temporary that already uses the allocator this tree
+     * ends up with, then swap the contents: strong guarantee.
+     */
+    Tree &operator=(const Tree &other) {
+        if (this != &other) {
+            constexpr bool kPropagate = NodeTraits::propagate_on_container_copy_assignment::value;
+            Tree copy(other, kPropagate ? Alloc(other.alloc_) : Alloc(alloc_));
+            if constexpr (kPropagate) {
+                clear();  /* Old nodes go back to the old allocator */
+                alloc_ = other.alloc_;
+            }
+            comp_ = other.comp_;
+            swap_contents(copy);
+        }
+        return *this;
+    }
+
+    Tree &operator=(Tree &&other) noexcept(
+        NodeTraits::propagate_on_container_move_assignment::value ||
+        NodeTraits::is_always_equal::value) {
+        if (this != &other) {
+            clear();
+            comp_ = std::move(other.comp_);
+            if constexpr (NodeTraits::propagate_on_container_move_assignment::value) {
+                alloc_ = std::move(other.alloc_);
+                take_from(other);
+            } else {
+                move_from(other);
+            }
+        }
+        return *this;
+    }
+
+    Tree &operator=(std::initializer_list<value_type> init) {
+        clear();
+        insert(init.begin(), init.end());
+        return *this;
+    }
+
+    ~Tree() { clear(); }
+
+    allocator_type get_allocator() const { return allocator_type(alloc_); }
+    key_compare key_comp() const { return comp_; }
+
+    /* ---------- Iterators and Capacity ---------- */
+
+    iterator begin() noexcept { return iterator(leftmost_); }
+    const_iterator begin() const noexcept { return const_iterator(leftmost_); }
+    const_iterator cbegin() const noexcept { return begin(); }
+    iterator end() noexcept { return iterator(header()); }
+    const_iterator end() const noexcept { return const_iterator(header()); }
+    const_iterator cend() const noexcept { return end(); }
+    reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+    const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+    reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+    const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+
+    bool empty() const noexcept { return size_ == 0; }
+    size_type size() const noexcept { return size_; }
+    size_type max_size() const noexcept { return NodeTraits::max_size(alloc_); }
+
+    /* ---------- Modifiers ---------- */
+
+    void clear() noexcept {
+        destroy_subtree(root());
+        reset_header();
+    }
+
+    std::pair<iterator, bool> insert(const value_type &value) {
+        return insert_unique(Traits::key(value), value);
+    }
+
+    std::pair<iterator, bool> insert(value_type &&value) {
+        return insert_unique(Traits::key(value), std::move(value));
+    }
+
+    iterator insert(const_iterator hint, const value_type &value) {
+        return emplace_hint(hint, value);
+    }
+
+    iterator insert(const_iterator hint, value_type &&value) {
+        return emplace_hint(hint, std::move(value));
+    }
+
+    /* Sorted ranges take the O(1) end() hint path */
+    template <class InputIt>
+    void insert(InputIt first, InputIt last) {
+        for (; first != last; ++first) emplace_hint(cend(), *first);
+    }
+
+    void insert(std::initializer_list<value_type> init) { insert(init.begin(), init.end()); }
+
+    insert_return_type insert(node_type &&nh) {
+        if (nh.empty()) return {end(), false, node_type()};
+        assert(*nh.alloc_ == alloc_);
+        Position pos = find_position(key_of(nh.node_));
+        if (pos.existing) return {iterator(pos.existing), false, std::move(nh)};
+        Node *node = std::exchange(nh.node_, nullptr);
+        nh.alloc_.reset();
+        attach(node, pos.parent, pos.left);
+        return {iterator(node), true, node_type()};
+    }
+
+    iterator insert(const_iterator hint, node_type &&nh) {
+        if (nh.empty()) return end();
+        assert(*nh.alloc_ == alloc_);
+        Position pos = hint_position(hint.node_, key_of(nh.node_));
+        if (pos.existing) return iterator(pos.existing);
+        Node *node = std::exchange(nh.node_, nullptr);
+        nh.alloc_.reset();
+        attach(node, pos.parent, pos.left);
+        return iterator(node);
+    }
+
+    template <class... Args>
+    std::pair<iterator, bool> emplace(Args &&...args) {
+        Node *node = create(std::forward<Args>(args)...);
+        Position pos = find_position(key_of(node));
+        if (pos.existing) {
+            destroy(node);
+            return {iterator(pos.existing), false};
+        }
+        attach(node, pos.parent, pos.left);
+        return {iterator(node), true};
+    }
+
+    template <class... Args>
+    iterator emplace_hint(const_iterator hint, Args &&...args) {
+        Node *node = create(std::forward<Args>(args)...);
+        Position pos = hint_position(hint.node_, key_of(node));
+        if (pos.existing) {
+            destroy(node);
+            return iterator(pos.existing);
+        }
+        attach(node, pos.parent, pos.left);
+        return iterator(node);
+    }
+
+    iterator erase(const_iterator pos) {
+        NodeBase *following = next(pos.node_);
+        destroy(as_node(unlink(pos.node_)));
+        return iterator(following);
+    }
+
+    template <class It = iterator,
+              class = std::enable_if_t<!std::is_same_v<It, const_iterator>>>
+    iterator erase(iterator pos) {
+        return erase(const_iterator(pos));
+    }
+
+    iterator erase(const_iterator first, const_iterator last) {
+        while (first != last) first = erase(first);
+        return iterator(last.node_);
+    }
+
+    size_type erase(const key_type &key) {
+        const_iterator it = find(key);
+        if (it == end()) return 0;
+        erase(it);
+        return 1;
+    }
+
+    node_type extract(const_iterator pos) {
+        return node_type(as_node(unlink(pos.node_)), alloc_);
+    }
+
+    node_type extract(const key_type &key) {
+        const_iterator it = find(key);
+        return it == end() ? node_type() : extract(it);
+    }
+
+    /* Without propagate_on_container_swap the allocators must be equal */
+    void swap(Tree &other) noexcept {
+        using std::swap;
+        swap(comp_, other.comp_);
+        if constexpr (NodeTraits::propagate_on_container_swap::value) {
+            swap(alloc_, other.alloc_);
+        } else {
+            assert(alloc_ == other.alloc_);
+        }
+        swap_contents(other);
+    }
+
+    /* ---------- Lookup ---------- */
+
+    size_type count(const key_type &key) const { return find(key) != end() ? 1 : 0; }
+    bool contains(const key_type &key) const { return find(key) != end(); }
+
+    iterator find(const key_type &key) { return iterator(find_node(key)); }
+    const_iterator find(const key_type &key) const { return const_iterator(find_node(key)); }
+
+    iterator lower_bound(const key_type &key) { return iterator(lower_node(key)); }
+    const_iterator lower_bound(const key_type &key) const { return const_iterator(lower_node(key)); }
+    iterator upper_bound(const key_type &key) { return iterator(upper_node(key)); }
+    const_iterator upper_bound(const key_type &key) const { return const_iterator(upper_node(key)); }
+
+    std::pair<iterator, iterator> equal_range(const key_type &key) {
+        return {lower_bound(key), upper_bound(key)};
+    }
+    std::pair<const_iterator, const_iterator> equal_range(const key_type &key) const {
+        return {lower_bound(key), upper_bound(key)};
+    }
+
+    /* ---------- Invariant Checker ---------- */
+
+    /* check_invariant - Links, order, stored heights, balance, size, extremes */
+    bool check_invariant() const {
+        size_type count = 0;
+        NodeBase *r = root();
+        if (r && r->parent != header()) return false;
+        if (check_subtree(r, nullptr, nullptr, count) == -2) return false;
+        if (count != size_) return false;
+        if (size_ == 0) return leftmost_ == header() && rightmost_ == header();
+        return leftmost_ == minimum(r) && rightmost_ == maximum(r);
+    }
+
+    friend bool operator==(const Tree &a, const Tree &b) {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+    }
+
+protected:
+    /* try_emplace for map: constructs the value only if key is absent */
+    template <class K, class... Args>
+    std::pair<iterator, bool> try_emplace_key(K &&key, Args &&...args) {
+        Position pos = find_position(key);
+        if (pos.existing) return {iterator(pos.existing), false};
+        Node *node = create(std::piecewise_construct,
+                            std::forward_as_tuple(std::forward<K>(key)),
+                            std::forward_as_tuple(std::forward<Args>(args)...));
+        attach(node, pos.parent, pos.left);
+        return {iterator(node), true};
+    }
+
+    template <class K, class... Args>
+    iterator try_emplace_hint(const_iterator hint, K &&key, Args &&...args) {
+        Position pos = hint_position(hint.node_, key);
+        if (pos.existing) return iterator(pos.existing);
+        Node *node = create(std::piecewise_construct,
+                            std::forward_as_tuple(std::forward<K>(key)),
+                            std::forward_as_tuple(std::forward<Args>(args)...));
+        attach(node, pos.parent, pos.left);
+        return iterator(node);
+    }
+
+private:
+    /* Where a key goes: under parent (on the left or right), or existing */
+    struct Position {
+        NodeBase *parent;
+        bool left;
+        NodeBase *existing;
+    };
+
+    NodeBase *header() const { return const_cast<NodeBase *>(&header_); }
+    NodeBase *root() const { return header_.left; }
+
+    void reset_header() {
+        header_.parent = nullptr;
+        header_.left = nullptr;
+        header_.right = nullptr;
+        header_.height = -1;
+        leftmost_ = rightmost_ = header();
+        size_ = 0;
+    }
+
+    /* set_root - Adopt a root and its bookkeeping (from swap/move) */
+    void set_root(NodeBase *r, NodeBase *left, NodeBase *right, size_type n, Tree &from) {
+        header_.left = r;
+        if (r) r->parent = header();
+        leftmost_ = (left == from.header()) ? header() : left;
+        rightmost_ = (right == from.header()) ? header() : right;
+        size_ = n;
+    }
+
+    void take_from(Tree &other) {
+        set_root(other.root(), other.leftmost_, other.rightmost_, other.size_, other);
+        other.reset_header();
+    }
+
+    /* swap_contents - Exchange roots and bookkeeping, not comparator or allocator */
+    void swap_contents(Tree &other) noexcept {
+        NodeBase *mine = root();
+        NodeBase *my_left = leftmost_, *my_right = rightmost_;
+        size_type my_size = size_;
+
+        set_root(other.root(), other.leftmost_, other.rightmost_, other.size_, other);
+        other.set_root(mine, my_left, my_right, my_size, *this);
+    }
+
+    /*
+     * move_from - Take other's elements into this (empty) tree
+     *
+     * Equal allocators: adopt the nodes. Otherwise move each value into
+     * a node of our own, in order, so every insert takes the end() hint.
+     */
+    void move_from(Tree &other) {
+        if (alloc_ == other.alloc_) {
+            take_from(other);
+            return;
+        }
+        for (NodeBase *n = other.leftmost_; n != other.header(); n = next(n)) {
+            emplace_hint(cend(), std::move(as_node(n)->value));
+        }
+        other.clear();
+    }
+
+    template <class... Args>
+    Node *create(Args &&...args) {
+        Node *node = NodeTraits::allocate(alloc_, 1);
+        try {
+            NodeTraits::construct(alloc_, node, alloc_, std::forward<Args>(args)...);
+        } catch (...) {
+            NodeTraits::deallocate(alloc_, node, 1);
+            throw;
+        }
+        return node;
+    }
+
+    void destroy(Node *node) {
+        NodeTraits::destroy(alloc_, node);
+        NodeTraits::deallocate(alloc_, node, 1);
+    }
+
+    /* destroy_subtree - Recurse left, loop right: stack depth O(height) */
+    void destroy_subtree(NodeBase *n) {
+        while (n) {
+            destroy_subtree(n->left);
+            NodeBase *right = n->right;
+            destroy(as_node(n));
+            n = right;
+        }
+    }
+
+    NodeBase *clone(const NodeBase *src, NodeBase *parent) {
+        Node *copy = create(static_cast<const Node *>(src)->value);
+        copy->parent = parent;
+        copy->left = copy->right = nullptr;
+        copy->height = src->height;
+        try {
+            if (src->left) copy->left = clone(src->left, copy);
+            if (src->right) copy->right = clone(src->right, copy);
+        } catch (...) {
+            destroy_subtree(copy);
+            throw;
+        }
+        return copy;
+    }
+
+    void copy_from(const Tree &other) {
+        if (other.root() == nullptr) return;
+        header_.left = clone(other.root(), header());
+        leftmost_ = minimum(root());
+        rightmost_ = maximum(root());
+        size_ = other.size_;
+    }
+
+    NodeBase *lower_node(const key_type &key) const {
+        NodeBase *n = root(), *result = header();
+        while (n) {
+            if (!comp_(key_of(n), key)) {
+                result = n;
+                n = n->left;
+            } else {
+                n = n->right;
+            }
+        }
+        return result;
+    }
+
+    NodeBase *upper_node(const key_type &key) const {
+        NodeBase *n = root(), *result = header();
+        while (n) {
+            if (comp_(key, key_of(n))) {
+                result = n;
+                n = n->left;
+            } else {
+                n = n->right;
+            }
+        }
+        return result;
+    }
+
+    NodeBase *find_node(const key_type &key) const {
+        NodeBase *n = lower_node(key);
+        return (n == header() || comp_(key, key_of(n))) ? header() : n;
+    }
+
+    /* find_position - Plain descent from the root */
+    template <class K>
+    Position find_position(const K &key) const {
+        NodeBase *parent = header(), *n = root();
+        bool left = true;
+        while (n) {
+            parent = n;
+            if (comp_(key, key_of(n))) {
+                left = true;
+                n = n->left;
+            } else if (comp_(key_of(n), key)) {
+                left = false;
+                n = n->right;
+            } else {
+                return {n, false, n};
+            }
+        }
+        return {parent, left, nullptr};
+    }
+
+    /*
+     * hint_position - Position just before hint if key belongs there
+     *
+     * key fits if prev(hint) < key < hint. Then either prev(hint) has
+     * no right child or hint has no left child (they are neighbours),
+     * so the node is attached without a descent. Otherwise fall back
+     * to find_position.
+     */
+    template <class K>
+    Position hint_position(NodeBase *hint, const K &key) const {
+        if (size_ == 0) return {header(), true, nullptr};
+
+        if (hint == header()) {
+            if (comp_(key_of(rightmost_), key)) return {rightmost_, false, nullptr};
+            return find_position(key);
+        }
+        if (comp_(key, key_of(hint))) {
+            if (hint == leftmost_) return {hint, true, nullptr};
+            NodeBase *before = prev(hint);
+            if (comp_(key_of(before), key)) {
+                if (before->right == nullptr) return {before, false, nullptr};
+                return {hint, true, nullptr};
+            }
+            return find_position(key);
+        }
+        if (!comp_(key_of(hint), key)) return {hint, false, hint};  /* Equal */
+        return find_position(key);
+    }
+
+    /* insert_unique - Construct from value only if key is absent */
+    template <class V>
+    std::pair<iterator, bool> insert_unique(const key_type &key, V &&value) {
+        Position pos = find_position(key);
+        if (pos.existing) return {iterator(pos.existing), false};
+        Node *node = create(std::forward<V>(value));
+        attach(node, pos.parent, pos.left);
+        return {iterator(node), true};
+    }
+
+    void attach(Node *node, NodeBase *parent, bool left) {
+        node->parent = parent;
+        node->left = node->right = nullptr;
+        node->height = 0;
+        if (parent == header()) {
+            header_.left = node;
+            leftmost_ = rightmost_ = node;
+        } else if (left) {
+            parent->left = node;
+            if (parent == leftmost_) leftmost_ = node;
+        } else {
+            parent->right = node;
+            if (parent == rightmost_) rightmost_ = node;
+        }
+        size_++;
+        fixup(parent, header());
+    }
+
+    /*
+     * unlink - Remove z from the tree without freeing it
+     *
+     * With two children, z's successor y (leftmost of z->right) is
+     * moved into z's place; no values are copied, so every other
+     * node keeps its address.
+     */
+    NodeBase *unlink(NodeBase *z) {
+        if (z == leftmost_) leftmost_ = (size_ == 1) ? header() : next(z);
+        if (z == rightmost_) rightmost_ = (size_ == 1) ? header() : prev(z);
+
+        NodeBase *start;
+        if (z->left == nullptr || z->right == nullptr) {
+            NodeBase *child = z->left ? z->left : z->right;
+            start = z->parent;
+            replace(z, child);
+        } else {
+            NodeBase *y = minimum(z->right);
+            if (y == z->right) {
+                start = y;
+            } else {
+                start = y->parent;
+                start->left = y->right;
+                if (y->right) y->right->parent = start;
+                y->right = z->right;
+                z->right->parent = y;
+            }
+            y->left = z->left;
+            z->left->parent = y;
+            y->height = z->height;
+            replace(z, y);
+        }
+
+        size_--;
+        fixup(start, header());
+        z->parent = z->left = z->right = nullptr;
+        return z;
+    }
+
+    /* check_subtree - Height of n, or -2 on any violation */
+    int check_subtree(const NodeBase *n, const NodeBase *lo, const NodeBase *hi,
+                      size_type &count) const {
+        if (n == nullptr) return -1;
+        count++;
+        if ((lo && !comp_(key_of(lo), key_of(n))) || (hi && !comp_(key_of(n), key_of(hi)))) {
+            return -2;
+        }
+        if ((n->left && n->left->parent != n) || (n->right && n->right->parent != n)) {
+            return -2;
+        }
+        int hl = check_subtree(n->left, lo, n, count);
+        int hr = check_subtree(n->right, n, hi, count);
+        if (hl == -2 || hr == -2) return -2;
+        if (n->height != 1 + std::max(hl, hr) || hl - hr < -1 || hl - hr > 1) return -2;
+        return n->height;
+    }
+
+    NodeBase header_;
+    NodeBase *leftmost_ = nullptr;
+    NodeBase *rightmost_ = nullptr;
+    size_type size_ = 0;
+    [[no_unique_address]] Compare comp_;
+    [[no_unique_address]] NodeAlloc alloc_;
+};
+
+} /* namespace detail */
+
+/* ================================================================
+ * PUBLIC CONTAINERS
+ * ================================================================ */
+
+template <class K, class V, class Compare = std::less<K>,
+          class Alloc = std::allocator<std::pair<const K, V>>>
+class map : public detail::Tree<detail::MapTraits<K, V>, Compare, Alloc> {
+    using Base = detail::Tree<detail::MapTraits<K, V>, Compare, Alloc>;
+
+public:
+    using mapped_type = V;
+    using typename Base::const_iterator;
+    using typename Base::iterator;
+    using typename Base::key_type;
+
+    using Base::Base;
+    map() = default;
+
+    template <class... Args>
+    std::pair<iterator, bool> try_emplace(const key_type &key, Args &&...args) {
+        return this->try_emplace_key(key, std::forward<Args>(args)...);
+    }
+    template <class... Args>
+    std::pair<iterator, bool> try_emplace(key_type &&key, Args &&...args) {
+        return this->try_emplace_key(std::move(key), std::forward<Args>(args)...);
+    }
+    template <class... Args>
+    iterator try_emplace(const_iterator hint, const key_type &key, Args &&...args) {
+        return this->try_emplace_hint(hint, key, std::forward<Args>(args)...);
+    }
+
+    template <class M>
+    std::pair<iterator, bool> insert_or_assign(const key_type &key, M &&obj) {
+        auto result = try_emplace(key, std::forward<M>(obj));
+        if (!result.second) result.first->second = std::forward<M>(obj);
+        return result;
+    }
+
+    V &operator[](const key_type &key) { return try_emplace(key).first->second; }
+    V &operator[](key_type &&key) { return try_emplace(std::move(key)).first->second; }
+
+    V &at(const key_type &key) {
+        auto it = this->find(key);
+        if (it == this->end()) throw std::out_of_range("avl::map::at");
+        return it->second;
+    }
+    const V &at(const key_type &key) const {
+        auto it = this->find(key);
+        if (it == this->end()) throw std::out_of_range("avl::map::at");
+        return it->second;
+    }
+};
+
+template <class K, class Compare = std::less<K>, class Alloc = std::allocator<K>>
+class set : public detail::Tree<detail::SetTraits<K>, Compare, Alloc> {
+    using Base = detail::Tree<detail::SetTraits<K>, Compare, Alloc>;
+
+public:
+    using Base::Base;
+    set() = default;
+};
+
+template <class K, class V, class C, class A>
+void swap(map<K, V, C, A> &a, map<K, V, C, A> &b) noexcept { a.swap(b); }
+
+template <class K, class C, class A>
+void swap(set<K, C, A> &a, set<K, C, A> &b) noexcept { a.swap(b); }
+
+} /* namespace avl */
+
+#endif /* AVL_MAP_HPP */
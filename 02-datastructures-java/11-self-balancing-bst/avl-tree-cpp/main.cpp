@@ -0,0 +1,470 @@
+/*
+ * avl::map / avl::set tests and benchmarks against std::map
+ *
+ * Compile: g++ -std=c++20 -O2 -Wall -Wextra -o avl_map_test main.cpp
+ * Usage:   ./avl_map_test [--bench [n]]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <memory_resource>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "avl_map.hpp"
+
+/* ================================================================
+ * TEST UTILITIES
+ * ================================================================ */
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST(name) printf("\n[TEST] %s\n", name)
+#define ASSERT(cond, msg) do { \
+    if (cond) { \
+        tests_passed++; \
+        printf("  PASS: %s\n", msg); \
+    } else { \
+        tests_failed++; \
+        printf("  FAIL: %s\n", msg); \
+    } \
+} while(0)
+
+/* Shuffle array using Fisher-Yates algorithm */
+static void shuffle(std::vector<int> &arr) {
+    for (int i = (int)arr.size() - 1; i > 0; i--) {
+        int j = rand() % (i + 1);
+        std::swap(arr[i], arr[j]);
+    }
+}
+
+/* CountingAllocator - std::allocator that tallies live allocations */
+static long live_allocations = 0;
+
+template <class T>
+struct CountingAllocator {
+    using value_type = T;
+
+    CountingAllocator() = default;
+    template <class U>
+    CountingAllocator(const CountingAllocator<U> &) {}
+
+    T *allocate(std::size_t n) {
+        live_allocations += (long)n;
+        return std::allocator<T>().allocate(n);
+    }
+    void deallocate(T *p, std::size_t n) {
+        live_allocations -= (long)n;
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    friend bool operator==(const CountingAllocator &, const CountingAllocator &) { return true; }
+};
+
+/* CountingResource - memory_resource that tallies live bytes */
+struct CountingResource : std::pmr::memory_resource {
+    long live = 0;
+
+    void *do_allocate(std::size_t bytes, std::size_t align) override {
+        live += (long)bytes;
+        return std::pmr::new_delete_resource()->allocate(bytes, align);
+    }
+    void do_deallocate(void *p, std::size_t bytes, std::size_t align) override {
+        live -= (long)bytes;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+    }
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+};
+
+/* same_as_std - Identical contents, both directions, and valid invariants */
+template <class AvlMap, class StdMap>
+static bool same_as_std(const AvlMap &a, const StdMap &s) {
+    if (!a.check_invariant() || a.size() != s.size()) return false;
+    if (!std::equal(a.begin(), a.end(), s.begin(), s.end())) return false;
+    return std::equal(a.rbegin(), a.rend(), s.rbegin(), s.rend());
+}
+
+/* ================================================================
+ * TESTS
+ * ================================================================ */
+
+static void test_basic_map(void) {
+    TEST("Basic Map Operations");
+
+    avl::map<int, std::string> m;
+    ASSERT(m.empty() && m.begin() == m.end() && m.check_invariant(), "empty map");
+
+    m[5] = "five";
+    m.insert({3, "three"});
+    m.emplace(8, "eight");
+    m.try_emplace(1, "one");
+    ASSERT(m.size() == 4 && m.at(3) == "three" && m[8] == "eight", "insert / emplace / []");
+
+    ASSERT(!m.insert({5, "again"}).second && m[5] == "five", "duplicate insert ignored");
+    m.insert_or_assign(5, "FIVE");
+    ASSERT(m[5] == "FIVE", "insert_or_assign overwrites");
+
+    bool threw = false;
+    try {
+        m.at(42);
+    } catch (const std::out_of_range &) {
+        threw = true;
+    }
+    ASSERT(threw, "at() throws for a missing key");
+
+    ASSERT(m.lower_bound(4)->first == 5 && m.upper_bound(5)->first == 8 &&
+           m.lower_bound(9) == m.end(), "lower_bound / upper_bound");
+    ASSERT(m.erase(3) == 1 && m.erase(3) == 0 && !m.contains(3), "erase by key");
+
+    auto it = m.find(5);
+    it = m.erase(it);
+    ASSERT(it->first == 8 && m.size() == 2 && m.check_invariant(), "erase returns the next element");
+}
+
+static void test_random_against_std(void) {
+    TEST("Random Operations Match std::map");
+
+    avl::map<int, int> a;
+    std::map<int, int> s;
+    bool ok = true;
+    for (int op = 0; op < 200000 && ok; op++) {
+        int key = rand() % 5000;
+        switch (rand() % 5) {
+        case 0:
+        case 1:
+            a.emplace(key, op);
+            s.emplace(key, op);
+            break;
+        case 2:
+            if (a.erase(key) != s.erase(key)) ok = false;
+            break;
+        case 3: {
+            auto hint = a.lower_bound(key);
+            a.emplace_hint(hint, key, op);
+            s.emplace_hint(s.lower_bound(key), key, op);
+            break;
+        }
+        default: {
+            auto lo = a.lower_bound(key);
+            auto hi = a.upper_bound(key + 20);
+            a.erase(lo, hi);
+            s.erase(s.lower_bound(key), s.upper_bound(key + 20));
+            break;
+        }
+        }
+        if (op % 1000 == 0 && !same_as_std(a, s)) ok = false;
+    }
+    ASSERT(ok && same_as_std(a, s), "200000 mixed operations");
+}
+
+static void test_hints(void) {
+    TEST("Hinted Insertion");
+
+    avl::set<int> sorted;
+    for (int k = 0; k < 10000; k++) sorted.emplace_hint(sorted.end(), k);
+    ASSERT(sorted.size() == 10000 && sorted.check_invariant(), "ascending keys, end() hint");
+
+    avl::set<int> reverse;
+    for (int k = 10000; k > 0; k--) reverse.emplace_hint(reverse.begin(), k);
+    ASSERT(reverse.size() == 10000 && reverse.check_invariant(), "descending keys, begin() hint");
+
+    avl::set<int> wrong;
+    std::set<int> expect;
+    for (int i = 0; i < 5000; i++) {
+        int k = rand() % 20000;
+        wrong.emplace_hint(wrong.begin(), k);  /* Usually a wrong hint */
+        expect.insert(k);
+    }
+    ASSERT(same_as_std(wrong, expect), "wrong hints fall back to a full descent");
+
+    auto it = sorted.emplace_hint(sorted.find(500), 500);
+    ASSERT(*it == 500 && sorted.size() == 10000, "hint at an equal key");
+}
+
+static void test_node_handles(void) {
+    TEST("Node Handles (extract / insert)");
+
+    avl::map<int, std::string> a{{1, "a"}, {2, "b"}, {3, "c"}};
+    avl::map<int, std::string> b;
+
+    const std::string *addr = &a.find(2)->second;
+    auto nh = a.extract(2);
+    ASSERT(!nh.empty() && nh.key() == 2 && nh.mapped() == "b" && a.size() == 2 &&
+           a.check_invariant(), "extract unlinks the node");
+
+    nh.key() = 20;
+    auto result = b.insert(std::move(nh));
+    ASSERT(result.inserted && result.position->first == 20 && nh.empty() &&
+           &result.position->second == addr, "insert reuses the same node (no reallocation)");
+
+    auto dup = a.extract(1);
+    b[1] = "existing";
+    auto failed = b.insert(std::move(dup));
+    ASSERT(!failed.inserted && !failed.node.empty() && failed.node.mapped() == "a",
+           "duplicate key hands the node back");
+
+    ASSERT(a.extract(42).empty(), "extract of a missing key is empty");
+
+    avl::set<int> s{1, 2, 3};
+    auto sn = s.extract(s.begin());
+    ASSERT(sn.value() == 1 && s.size() == 2 && s.check_invariant(), "set node handle");
+}
+
+static void test_allocator(void) {
+    TEST("Pluggable Allocator");
+
+    {
+        avl::map<int, int, std::less<int>, CountingAllocator<std::pair<const int, int>>> m;
+        for (int k = 0; k < 1000; k++) m[k] = k;
+        ASSERT(live_allocations == 1000, "one allocation per node");
+
+        auto copy = m;
+        ASSERT(live_allocations == 2000 && copy == m, "copy allocates its own nodes");
+
+        auto moved = std::move(copy);
+        ASSERT(live_allocations == 2000 && moved.check_invariant() && copy.empty(),
+               "move transfers nodes");
+
+        for (int k = 0; k < 1000; k += 2) m.erase(k);
+        ASSERT(live_allocations == 1500, "erase frees nodes");
+
+        auto nh = m.extract(1);
+        ASSERT(live_allocations == 1500, "extract keeps the node alive");
+    }
+    ASSERT(live_allocations == 0, "everything freed on destruction");
+}
+
+static void test_pmr(void) {
+    TEST("Polymorphic Allocators (std::pmr)");
+
+    using PmrMap = avl::map<int, std::pmr::string, std::less<int>,
+                            std::pmr::polymorphic_allocator<std::pair<const int, std::pmr::string>>>;
+    using PmrSet = avl::set<int, std::less<int>, std::pmr::polymorphic_allocator<int>>;
+    CountingResource r1, r2;
+
+    {
+        PmrMap a(&r1), b(&r2);
+        for (int k = 0; k < 500; k++) {
+            a.try_emplace(k, "a value too long for the small-string buffer");
+        }
+        ASSERT(a.check_invariant() && a.begin()->second.get_allocator().resource() == &r1,
+               "values use the container's resource");
+
+        /* polymorphic_allocator does not propagate: b keeps r2 */
+        long r2_before = r2.live;
+        b = a;
+        ASSERT(b == a && b.get_allocator().resource() == &r2 &&
+               b.begin()->second.get_allocator().resource() == &r2 && r2.live > r2_before,
+               "copy assignment keeps the target's resource");
+
+        PmrMap c(&r2);
+        c = std::move(a);
+        ASSERT(a.empty() && r1.live == 0 && c == b && c.check_invariant() &&
+               c.rbegin()->second.get_allocator().resource() == &r2,
+               "move assignment across resources moves element-wise");
+
+        long r2_live = r2.live;
+        PmrMap d(&r2);
+        d = std::move(c);
+        ASSERT(c.empty() && d == b && r2.live == r2_live,
+               "move assignment with equal resources adopts the nodes");
+
+        PmrMap e(std::move(d), std::pmr::polymorphic_allocator<int>(&r1));
+        ASSERT(d.empty() && e == b && e.get_allocator().resource() == &r1 &&
+               r2.live < r2_live, "allocator-extended move constructor");
+
+        PmrMap f(b);
+        ASSERT(f == b && f.get_allocator().resource() == std::pmr::get_default_resource(),
+               "copy constructor selects the default resource");
+
+        b.erase(b.begin(), b.find(250));
+        PmrMap g(&r2);
+        g.swap(b);
+        ASSERT(b.empty() && g.size() == 250 && g.begin()->first == 250 &&
+               g.check_invariant(), "swap with equal resources");
+    }
+    ASSERT(r1.live == 0 && r2.live == 0, "everything returned to its resource");
+
+    {
+        PmrSet s(&r1), t(&r1);
+        for (int k = 0; k < 100; k++) s.insert(k);
+        PmrSet::node_type nh;
+        nh = s.extract(7);
+        ASSERT(!nh.empty() && nh.value() == 7 && nh.get_allocator().resource() == &r1,
+               "node handle move assignment");
+        ASSERT(t.insert(std::move(nh)).inserted && t.contains(7) && !s.contains(7),
+               "node moves between sets sharing a resource");
+    }
+    ASSERT(r1.live == 0, "set nodes freed");
+}
+
+static void test_copy_move_swap(void) {
+    TEST("Copy, Move and Swap");
+
+    std::vector<int> keys(2000);
+    for (int i = 0; i < 2000; i++) keys[i] = i;
+    shuffle(keys);
+
+    avl::set<int> a(keys.begin(), keys.end());
+    avl::set<int> b = a;
+    ASSERT(a == b && b.check_invariant(), "copy");
+
+    b.erase(b.begin(), b.find(1000));
+    avl::set<int> c;
+    c = std::move(b);
+    ASSERT(c.size() == 1000 && *c.begin() == 1000 && c.check_invariant() && b.empty() &&
+           b.check_invariant(), "move assignment");
+
+    swap(a, c);
+    ASSERT(a.size() == 1000 && c.size() == 2000 && a.check_invariant() &&
+           c.check_invariant(), "swap");
+
+    avl::set<int> empty;
+    swap(empty, a);
+    ASSERT(a.empty() && a.begin() == a.end() && empty.size() == 1000 && a.check_invariant(),
+           "swap with an empty set");
+
+    int prev = -1;
+    bool ordered = true;
+    for (auto it = c.end(); it != c.begin();) {
+        --it;
+        if (prev != -1 && *it >= prev) ordered = false;
+        prev = *it;
+    }
+    ASSERT(ordered, "iteration backwards from end()");
+}
+
+static void run_tests(void) {
+    printf("===== AVL MAP TEST SUITE =====\n");
+
+    test_basic_map();
+    test_random_against_std();
+    test_hints();
+    test_node_handles();
+    test_allocator();
+    test_pmr();
+    test_copy_move_swap();
+
+    printf("\n===== TEST SUMMARY =====\n");
+    printf("Passed: %d\n", tests_passed);
+    printf("Failed: %d\n", tests_failed);
+}
+
+/* ================================================================
+ * BENCHMARK
+ * ================================================================ */
+
+static double get_time_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+struct Result {
+    double insert, find, iterate, erase, hinted;  /* ns per element */
+};
+
+/*
+ * run_suite - The same workload for any map type
+ *
+ * Random-order insert, find and erase; a full in-order scan; and
+ * hinted insertion of sorted keys at end().
+ */
+template <class Map>
+static Result run_suite(const std::vector<int> &keys, const std::vector<int> &probes,
+                        long &checksum) {
+    Result r;
+    double n = (double)keys.size();
+    Map m;
+
+    double start = get_time_ns();
+    for (int k : keys) m.emplace(k, k);
+    r.insert = (get_time_ns() - start) / n;
+
+    start = get_time_ns();
+    for (int k : probes) checksum += m.find(k)->second;
+    r.find = (get_time_ns() - start) / n;
+
+    start = get_time_ns();
+    for (const auto &kv : m) checksum += kv.second;
+    r.iterate = (get_time_ns() - start) / n;
+
+    start = get_time_ns();
+    for (int k : probes) m.erase(k);
+    r.erase = (get_time_ns() - start) / n;
+
+    Map sorted;
+    start = get_time_ns();
+    for (int k = 0; k < (int)keys.size(); k++) sorted.emplace_hint(sorted.end(), k, k);
+    r.hinted = (get_time_ns() - start) / n;
+    checksum += (long)sorted.size() + (long)m.size();
+    return r;
+}
+
+static void benchmark(int n) {
+    std::vector<int> keys(n), probes(n);
+    for (int i = 0; i < n; i++) keys[i] = probes[i] = i;
+    shuffle(keys);
+    shuffle(probes);
+
+    const int rounds = 3;
+    Result best_avl{}, best_std{};
+    long checksum = 0;
+    for (int round = 0; round < rounds; round++) {
+        Result a = run_suite<avl::map<int, int>>(keys, probes, checksum);
+        Result s = run_suite<std::map<int, int>>(keys, probes, checksum);
+        if (round == 0) {
+            best_avl = a;
+            best_std = s;
+            continue;
+        }
+        best_avl.insert = std::min(best_avl.insert, a.insert);
+        best_avl.find = std::min(best_avl.find, a.find);
+        best_avl.iterate = std::min(best_avl.iterate, a.iterate);
+        best_avl.erase = std::min(best_avl.erase, a.erase);
+        best_avl.hinted = std::min(best_avl.hinted, a.hinted);
+        best_std.insert = std::min(best_std.insert, s.insert);
+        best_std.find = std::min(best_std.find, s.find);
+        best_std.iterate = std::min(best_std.iterate, s.iterate);
+        best_std.erase = std::min(best_std.erase, s.erase);
+        best_std.hinted = std::min(best_std.hinted, s.hinted);
+    }
+
+    printf("  n=%d (ns per element, best of %d, checksum %ld)\n", n, rounds, checksum);
+    printf("    %-10s %10s %10s %10s\n", "", "avl::map", "std::map", "ratio");
+    const char *names[] = {"insert", "find", "iterate", "erase", "hinted"};
+    double avl_ns[] = {best_avl.insert, best_avl.find, best_avl.iterate, best_avl.erase,
+                       best_avl.hinted};
+    double std_ns[] = {best_std.insert, best_std.find, best_std.iterate, best_std.erase,
+                       best_std.hinted};
+    for (int i = 0; i < 5; i++) {
+        printf("    %-10s %10.1f %10.1f %9.2fx\n", names[i], avl_ns[i], std_ns[i],
+               std_ns[i] / avl_ns[i]);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    srand(12345);
+
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        printf("===== avl::map vs std::map =====\n");
+        if (argc > 2) {
+            benchmark(atoi(argv[2]));
+        } else {
+            benchmark(100000);
+            benchmark(1000000);
+        }
+        return 0;
+    }
+
+    run_tests();
+    return tests_failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,524 @@
+/*
+ * Range-Partitioned B-Tree Forest Implementation
+ *
+ * One BTree per key range, each driven by its own worker thread. See
+ * b-tree-forest.h for the routing and queueing model.
+ */
+
+#define _GNU_SOURCE
+#include "b-tree-forest.h"
+#include "b-tree.h"
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define SPIN_LIMIT 2000   /* Polls before an idle worker / waiting client sleeps */
+
+/* Completion of one btree_forest_execute call, shared by its requests */
+typedef struct {
+    atomic_int pending;    /* Shard requests not yet finished */
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool finished;
+} Completion;
+
+/* The part of a batch routed to one shard */
+typedef struct {
+    BTreeForestOp *ops;    /* Caller's batch */
+    const int *index;      /* Positions in ops for this shard, in batch order */
+    int count;
+    Completion *done;
+} ShardRequest;
+
+typedef struct {
+    atomic_size_t seq;     /* Vyukov sequence: pos = free, pos + 1 = full */
+    ShardRequest *req;
+} Cell;
+
+typedef struct Shard {
+    /* Producer side */
+    _Alignas(64) atomic_size_t tail;
+    /* Consumer side */
+    _Alignas(64) size_t head;
+    atomic_bool sleeping;
+    atomic_bool stop;
+    atomic_long keys;
+    atomic_long ops;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    BTree *tree;
+    pthread_t thread;
+    int cpu;
+    int sample[BTREE_FOREST_SAMPLE];
+    Cell cells[BTREE_FOREST_QUEUE];
+} Shard;
+
+struct BTreeForest {
+    int t;
+    int shards;
+    int lo[BTREE_FOREST_MAX_SHARDS];       /* lo[0] is INT_MIN */
+    Shard *shard[BTREE_FOREST_MAX_SHARDS];
+    int cpus;
+    int next_cpu;
+};
+
+/* ================================================================
+ * MPSC REQUEST QUEUE
+ *
+ * Bounded ring of cells with per-cell sequence numbers. Producers
+ * claim a slot by CAS on tail; the single consumer reads cells in
+ * order without any shared index.
+ * ================================================================ */
+
+static void queue_init(Shard *s) {
+    for (size_t i = 0; i < BTREE_FOREST_QUEUE; i++) {
+        atomic_init(&s->cells[i].seq, i);
+    }
+    atomic_init(&s->tail, 0);
+    s->head = 0;
+}
+
+/* queue_push - Returns false if the ring is full */
+static bool queue_push(Shard *s, ShardRequest *req) {
+    size_t pos = atomic_load_explicit(&s->tail, memory_order_relaxed);
+    for (;;) {
+        Cell *cell = &s->cells[pos & (BTREE_FOREST_QUEUE - 1)];
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+        if (dif == 0) {
+            if (atomic_compare_exchange_weak_explicit(&s->tail, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                cell->req = req;
+                atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+                return true;
+            }
+        } else if (dif < 0) {
+            return false;
+        } else {
+            pos = atomic_load_explicit(&s->tail, memory_order_relaxed);
+        }
+    }
+}
+
+static ShardRequest *queue_pop(Shard *s) {
+    Cell *cell = &s->cells[s->head & (BTREE_FOREST_QUEUE - 1)];
+    size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+    if (seq != s->head + 1) return NULL;
+    ShardRequest *req = cell->req;
+    atomic_store_explicit(&cell->seq, s->head + BTREE_FOREST_QUEUE,
+                          memory_order_release);
+    s->head++;
+    return req;
+}
+
+static bool queue_empty(Shard *s) {
+    Cell *cell = &s->cells[s->head & (BTREE_FOREST_QUEUE - 1)];
+    return atomic_load_explicit(&cell->seq, memory_order_acquire) != s->head + 1;
+}
+
+/*
+ * wake_worker - Called after a push
+ *
+ * Pairs with the worker's store to sleeping: either the worker sees
+ * the new cell before it sleeps, or we see sleeping and signal.
+ */
+static void wake_worker(Shard *s) {
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&s->sleeping, memory_order_relaxed)) {
+        pthread_mutex_lock(&s->lock);
+        pthread_cond_signal(&s->wake);
+        pthread_mutex_unlock(&s->lock);
+    }
+}
+
+/* ================================================================
+ * SHARD WORKER
+ * ================================================================ */
+
+static void complete(Completion *done) {
+    if (atomic_fetch_sub_explicit(&done->pending, 1, memory_order_acq_rel) == 1) {
+        pthread_mutex_lock(&done->lock);
+        done->finished = true;
+        pthread_cond_signal(&done->cond);
+        pthread_mutex_unlock(&done->lock);
+    }
+}
+
+/* run_request - Apply a request to the shard's tree, single-threaded */
+static void run_request(Shard *s, ShardRequest *req) {
+    long ops = atomic_load_explicit(&s->ops, memory_order_relaxed);
+    long keys = atomic_load_explicit(&s->keys, memory_order_relaxed);
+
+    for (int j = 0; j < req->count; j++) {
+        BTreeForestOp *op = &req->ops[req->index[j]];
+
+        switch (op->kind) {
+        case BTREE_FOREST_INSERT:
+            op->result = btree_insert_unique(s->tree, op->key);
+            keys += op->result;
+            break;
+        case BTREE_FOREST_DELETE:
+            op->result = btree_delete(s->tree, op->key);
+            keys -= op->result;
+            break;
+        default:
+            op->result = btree_search(s->tree->root, op->key, NULL) != NULL;
+            break;
+        }
+        s->sample[ops % BTREE_FOREST_SAMPLE] = op->key;
+        ops++;
+    }
+
+    atomic_store_explicit(&s->ops, ops, memory_order_relaxed);
+    atomic_store_explicit(&s->keys, keys, memory_order_relaxed);
+    complete(req->done);
+}
+
+static void *shard_worker(void *arg) {
+    Shard *s = (Shard *)arg;
+
+    for (;;) {
+        ShardRequest *req = NULL;
+        for (int spin = 0; spin < SPIN_LIMIT && !(req = queue_pop(s)); spin++) {
+            if (atomic_load_explicit(&s->stop, memory_order_acquire)) return NULL;
+        }
+        if (req) {
+            run_request(s, req);
+            continue;
+        }
+
+        /* Idle: sleep until a producer sees sleeping and signals */
+        pthread_mutex_lock(&s->lock);
+        atomic_store(&s->sleeping, true);
+        while (queue_empty(s) && !atomic_load(&s->stop)) {
+            pthread_cond_wait(&s->wake, &s->lock);
+        }
+        atomic_store(&s->sleeping, false);
+        pthread_mutex_unlock(&s->lock);
+        if (atomic_load(&s->stop) && queue_empty(s)) return NULL;
+    }
+}
+
+/* ================================================================
+ * SHARD LIFETIME
+ * ================================================================ */
+
+static Shard *shard_start(BTreeForest *forest, BTree *tree) {
+    size_t size = (sizeof(Shard) + 63) & ~(size_t)63;
+    Shard *s = (Shard *)aligned_alloc(64, size);
+    if (!s) return NULL;
+    memset(s, 0, sizeof(Shard));
+
+    queue_init(s);
+    atomic_init(&s->sleeping, false);
+    atomic_init(&s->stop, false);
+    atomic_init(&s->keys, btree_count(tree));
+    atomic_init(&s->ops, 0);
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->wake, NULL);
+    s->tree = tree;
+    s->cpu = forest->next_cpu++ % forest->cpus;
+
+    if (pthread_create(&s->thread, NULL, shard_worker, s) != 0) {
+        pthread_mutex_destroy(&s->lock);
+        pthread_cond_destroy(&s->wake);
+        free(s);
+        return NULL;
+    }
+
+#ifdef __linux__
+    /* Thread per core; best effort, the forest works unpinned too */
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(s->cpu, &set);
+    pthread_setaffinity_np(s->thread, sizeof(set), &set);
+#endif
+    return s;
+}
+
+/* shard_stop - Join the worker; the tree is returned to the caller */
+static BTree *shard_stop(Shard *s) {
+    atomic_store(&s->stop, true);
+    pthread_mutex_lock(&s->lock);
+    pthread_cond_signal(&s->wake);
+    pthread_mutex_unlock(&s->lock);
+    pthread_join(s->thread, NULL);
+
+    BTree *tree = s->tree;
+    pthread_mutex_destroy(&s->lock);
+    pthread_cond_destroy(&s->wake);
+    free(s);
+    return tree;
+}
+
+/*
+ * btree_forest_create - Start @shards workers over [min_key, max_key]
+ *
+ * Returns: the forest, or NULL on bad arguments or failure
+ */
+BTreeForest *btree_forest_create(int shards, int t, int min_key, int max_key) {
+    if (shards < 1 || shards > BTREE_FOREST_MAX_SHARDS || t < 2 ||
+        min_key > max_key) {
+        fprintf(stderr, "Error: forest needs 1..%d shards, t >= 2, min <= max\n",
+                BTREE_FOREST_MAX_SHARDS);
+        return NULL;
+    }
+
+    BTreeForest *forest = (BTreeForest *)calloc(1, sizeof(BTreeForest));
+    if (!forest) return NULL;
+    forest->t = t;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    forest->cpus = cpus > 0 ? (int)cpus : 1;
+
+    long long span = (long long)max_key - min_key + 1;
+    for (int i = 0; i < shards; i++) {
+        forest->lo[i] = i == 0 ? INT_MIN : (int)(min_key + span * i / shards);
+        BTree *tree = btree_create(t);
+        Shard *s = tree ? shard_start(forest, tree) : NULL;
+        if (!s) {
+            if (tree) btree_destroy(tree);
+            btree_forest_destroy(forest);
+            return NULL;
+        }
+        forest->shard[i] = s;
+        forest->shards++;
+    }
+    return forest;
+}
+
+void btree_forest_destroy(BTreeForest *forest) {
+    if (!forest) return;
+    for (int i = 0; i < forest->shards; i++) {
+        btree_destroy(shard_stop(forest->shard[i]));
+    }
+    free(forest);
+}
+
+/* ================================================================
+ * ROUTING
+ * ================================================================ */
+
+/* shard_of - Last shard whose lo <= key */
+static int shard_of(const BTreeForest *forest, int key) {
+    int lo = 0, hi = forest->shards - 1;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if (forest->lo[mid] <= key) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return lo;
+}
+
+/*
+ * btree_forest_execute - Run a batch of ops across the shards
+ *
+ * Safe to call from several threads at once. Blocks until every op in
+ * @ops has its result.
+ *
+ * Returns: 0 on success, -1 on allocation failure (nothing was run)
+ */
+int btree_forest_execute(BTreeForest *forest, BTreeForestOp *ops, int n) {
+    if (n <= 0) return 0;
+    int shards = forest->shards;
+    int *index = (int *)malloc(n * sizeof(int));
+    int *route = (int *)malloc(n * sizeof(int));
+    if (!index || !route) {
+        free(index);
+        free(route);
+        return -1;
+    }
+
+    /* Counting sort of op positions by shard, stable within a shard */
+    int start[BTREE_FOREST_MAX_SHARDS + 1] = {0};
+    for (int i = 0; i < n; i++) {
+        route[i] = shard_of(forest, ops[i].key);
+        start[route[i] + 1]++;
+    }
+    for (int s = 0; s < shards; s++) start[s + 1] += start[s];
+    int fill[BTREE_FOREST_MAX_SHARDS];
+    memcpy(fill, start, shards * sizeof(int));
+    for (int i = 0; i < n; i++) index[fill[route[i]]++] = i;
+
+    Completion done = { .lock = PTHREAD_MUTEX_INITIALIZER,
+                        .cond = PTHREAD_COND_INITIALIZER };
+    ShardRequest reqs[BTREE_FOREST_MAX_SHARDS];
+    int touched = 0;
+    for (int s = 0; s < shards; s++) touched += start[s + 1] > start[s];
+    atomic_init(&done.pending, touched);
+
+    for (int s = 0; s < shards; s++) {
+        if (start[s + 1] == start[s]) continue;
+        reqs[s] = (ShardRequest){ ops, index + start[s], start[s + 1] - start[s], &done };
+        while (!queue_push(forest->shard[s], &reqs[s])) sched_yield();
+        wake_worker(forest->shard[s]);
+    }
+
+    for (int spin = 0; spin < SPIN_LIMIT; spin++) {
+        if (atomic_load_explicit(&done.pending, memory_order_acquire) == 0) break;
+    }
+    pthread_mutex_lock(&done.lock);
+    while (!done.finished) pthread_cond_wait(&done.cond, &done.lock);
+    pthread_mutex_unlock(&done.lock);
+
+    pthread_mutex_destroy(&done.lock);
+    pthread_cond_destroy(&done.cond);
+    free(index);
+    free(route);
+    return 0;
+}
+
+/* ================================================================
+ * REBALANCING
+ * ================================================================ */
+
+static int compare_ints(const void *a, const void *b) {
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+/* collect_keys - Append the keys under @node to @out in order */
+static void collect_keys(const BTreeNode *node, int *out, long *len) {
+    for (int i = 0; i < node->n; i++) {
+        if (!node->is_leaf) collect_keys(node->children[i], out, len);
+        out[(*len)++] = node->keys[i];
+    }
+    if (!node->is_leaf) collect_keys(node->children[node->n], out, len);
+}
+
+/*
+ * btree_forest_rebalance - Split the busiest shard if it is overloaded
+ *
+ * @threshold: split when the busiest shard ran more than threshold x
+ *             the mean ops per shard (e.g. 1.5)
+ *
+ * The split key is the median of the shard's recently sampled keys,
+ * so load, not key count, is halved. Both halves are rebuilt with
+ * btree_build_parallel and the upper one gets a new worker. Op counts
+ * restart from zero on every shard.
+ *
+ * Returns: 1 if a shard was split, 0 if none needed (or could be:
+ *          one hot key cannot be split), -1 on failure
+ */
+int btree_forest_rebalance(BTreeForest *forest, double threshold) {
+    int shards = forest->shards;
+    if (shards >= BTREE_FOREST_MAX_SHARDS) return 0;
+
+    long total = 0, busiest = -1;
+    int hot = 0;
+    for (int s = 0; s < shards; s++) {
+        long ops = atomic_load(&forest->shard[s]->ops);
+        total += ops;
+        if (ops > busiest) {
+            busiest = ops;
+            hot = s;
+        }
+    }
+    if (total == 0 || busiest <= threshold * total / shards) return 0;
+
+    /* Median sampled key strictly above the shard's lower bound */
+    Shard *s = forest->shard[hot];
+    int samples = busiest < BTREE_FOREST_SAMPLE ? (int)busiest : BTREE_FOREST_SAMPLE;
+    int sorted[BTREE_FOREST_SAMPLE];
+    memcpy(sorted, s->sample, samples * sizeof(int));
+    qsort(sorted, samples, sizeof(int), compare_ints);
+    int m = samples / 2;
+    while (m < samples && sorted[m] <= forest->lo[hot]) m++;
+    if (m == samples) return 0;
+    int split = sorted[m];
+
+    long count = atomic_load(&s->keys);
+    int *keys = (int *)malloc((count > 0 ? count : 1) * sizeof(int));
+    if (!keys) return -1;
+    long len = 0;
+    collect_keys(s->tree->root, keys, &len);
+    long cut = 0;
+    while (cut < len && keys[cut] < split) cut++;
+
+    BTree *lower = btree_build_parallel(forest->t, keys, (int)cut, 1);
+    BTree *upper = btree_build_parallel(forest->t, keys + cut, (int)(len - cut), 1);
+    free(keys);
+    Shard *added = upper ? shard_start(forest, upper) : NULL;
+    if (!lower || !added) {
+        if (lower) btree_destroy(lower);
+        if (added) {
+            btree_destroy(shard_stop(added));
+        } else if (upper) {
+            btree_destroy(upper);
+        }
+        return -1;
+    }
+
+    /* The old worker is idle between batches: swap its tree in place */
+    btree_destroy(s->tree);
+    s->tree = lower;
+    atomic_store(&s->keys, cut);
+
+    memmove(&forest->shard[hot + 2], &forest->shard[hot + 1],
+            (shards - hot - 1) * sizeof(Shard *));
+    memmove(&forest->lo[hot + 2], &forest->lo[hot + 1],
+            (shards - hot - 1) * sizeof(int));
+    forest->shard[hot + 1] = added;
+    forest->lo[hot + 1] = split;
+    forest->shards++;
+
+    for (int i = 0; i < forest->shards; i++) {
+        atomic_store(&forest->shard[i]->ops, 0);
+    }
+    return 1;
+}
+
+/* ================================================================
+ * STATS / VALIDATION
+ * ================================================================ */
+
+void btree_forest_stats(BTreeForest *forest, BTreeForestStats *stats) {
+    memset(stats, 0, sizeof(*stats));
+    stats->shards = forest->shards;
+    long total = 0, busiest = 0;
+    for (int s = 0; s < forest->shards; s++) {
+        stats->lo[s] = forest->lo[s];
+        stats->keys[s] = atomic_load(&forest->shard[s]->keys);
+        stats->ops[s] = atomic_load(&forest->shard[s]->ops);
+        total += stats->ops[s];
+        if (stats->ops[s] > busiest) busiest = stats->ops[s];
+    }
+    stats->imbalance = total ? (double)busiest * forest->shards / total : 1.0;
+}
+
+/*
+ * btree_forest_validate - Every shard is a valid tree holding only keys
+ *                         of its range, and its key count is right
+ *
+ * Call between batches. Returns: 1 if valid, 0 otherwise
+ */
+int btree_forest_validate(BTreeForest *forest) {
+    for (int i = 0; i < forest->shards; i++) {
+        Shard *s = forest->shard[i];
+        if (!btree_validate(s->tree)) return 0;
+
+        long count = btree_count(s->tree);
+        if (count != atomic_load(&s->keys)) return 0;
+        if (count == 0) continue;
+
+        const BTreeNode *node = s->tree->root;
+        while (!node->is_leaf) node = node->children[0];
+        int min = node->keys[0];
+        node = s->tree->root;
+        while (!node->is_leaf) node = node->children[node->n];
+        int max = node->keys[node->n - 1];
+
+        if (min < forest->lo[i]) return 0;
+        if (i + 1 < forest->shards && max >= forest->lo[i + 1]) return 0;
+    }
+    return 1;
+}
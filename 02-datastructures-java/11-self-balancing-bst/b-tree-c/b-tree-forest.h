@@ -0,0 +1,79 @@
+/* ============================================================
+ * Range-Partitioned B-Tree Forest (thread per shard)
+ * ============================================================
+ * Instead of one tree behind a lock, the key space is cut into P
+ * ranges, each held by its own BTree and owned by one worker thread:
+ *
+ *   client batch -> route by key -> per-shard request queues
+ *                                     |        |        |
+ *                                  worker 0 worker 1 worker 2 ...
+ *                                  [min,b1)  [b1,b2)  [b2,max]
+ *
+ * - Only the owning worker touches a shard's tree, so it runs the
+ *   plain single-threaded btree_insert/btree_search/btree_delete
+ *   with no locks.
+ * - Each shard has a bounded lock-free MPSC queue (Vyukov's ring):
+ *   any number of client threads push, the worker pops. An idle
+ *   worker spins briefly, then sleeps until a push wakes it.
+ * - A batch is split into one request per shard it touches; ops on
+ *   the same key always reach the same shard in batch order, so a
+ *   batch behaves as if run sequentially. btree_forest_execute
+ *   returns when every shard has finished its part.
+ * - Set semantics: insert reports whether the key was added, delete
+ *   whether it was present.
+ * - Skew: each shard counts ops and samples recent keys. Rebalancing
+ *   splits the busiest shard at the median sampled key into two
+ *   shards (one more worker) when it carries threshold x the mean.
+ *
+ * [x] btree_forest_create / btree_forest_destroy
+ * [x] btree_forest_execute (batched insert / search / delete)
+ * [x] btree_forest_rebalance (split a hot shard)
+ * [x] btree_forest_stats / btree_forest_validate
+ * ============================================================ */
+
+#ifndef B_TREE_FOREST_H
+#define B_TREE_FOREST_H
+
+#include <stdbool.h>
+
+#define BTREE_FOREST_MAX_SHARDS 64
+#define BTREE_FOREST_QUEUE      256   /* Requests per shard queue (power of 2) */
+#define BTREE_FOREST_SAMPLE     256   /* Recent keys kept per shard for splits */
+
+typedef struct BTreeForest BTreeForest;  /* Layout is private */
+
+typedef enum {
+    BTREE_FOREST_INSERT,
+    BTREE_FOREST_SEARCH,
+    BTREE_FOREST_DELETE
+} BTreeForestOpKind;
+
+typedef struct BTreeForestOp {
+    int key;
+    BTreeForestOpKind kind;
+    bool result;   /* Out: added / found / removed */
+} BTreeForestOp;
+
+typedef struct BTreeForestStats {
+    int shards;
+    int lo[BTREE_FOREST_MAX_SHARDS];     /* Smallest key routed to each shard */
+    long keys[BTREE_FOREST_MAX_SHARDS];
+    long ops[BTREE_FOREST_MAX_SHARDS];   /* Since create or the last split */
+    double imbalance;                    /* Busiest shard's ops / mean ops */
+} BTreeForestStats;
+
+/*
+ * Shards split [min_key, max_key] into equal ranges; keys outside it
+ * go to the first or last shard.
+ */
+BTreeForest *btree_forest_create(int shards, int t, int min_key, int max_key);
+void btree_forest_destroy(BTreeForest *forest);
+
+int btree_forest_execute(BTreeForest *forest, BTreeForestOp *ops, int n);
+
+/* Not concurrent with btree_forest_execute: call between batches */
+int btree_forest_rebalance(BTreeForest *forest, double threshold);
+void btree_forest_stats(BTreeForest *forest, BTreeForestStats *stats);
+int btree_forest_validate(BTreeForest *forest);
+
+#endif /* B_TREE_FOREST_H */
@@ -0,0 +1,764 @@
+/*
+ * Gapped-Leaf B+-Tree Implementation
+ *
+ * This file implements a B+-tree whose leaves are small packed-memory
+ * arrays. See b-tree-gapped.h for the leaf layout and its invariants.
+ */
+
+#include "b-tree-gapped.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ================================================================
+ * OCCUPANCY BITMAP
+ *
+ * Bits past the last slot are kept set, so they never look like gaps.
+ * ================================================================ */
+
+static int bitmap_words(int slots) {
+    return (slots + 63) / 64;
+}
+
+static bool slot_used(const GBNode *leaf, int i) {
+    return (leaf->used[i >> 6] >> (i & 63)) & 1;
+}
+
+static void mark_used(GBNode *leaf, int i) {
+    leaf->used[i >> 6] |= 1ull << (i & 63);
+}
+
+static void mark_free(GBNode *leaf, int i) {
+    leaf->used[i >> 6] &= ~(1ull << (i & 63));
+}
+
+static void bitmap_clear(GBNode *leaf, int slots) {
+    int words = bitmap_words(slots);
+    memset(leaf->used, 0, words * sizeof(uint64_t));
+    if (slots & 63) leaf->used[words - 1] = ~0ull << (slots & 63);
+}
+
+/* next_gap - First unused slot >= from, or -1 */
+static int next_gap(const GBNode *leaf, int from, int slots) {
+    if (from >= slots) return -1;
+    for (int w = from >> 6; w < bitmap_words(slots); w++) {
+        uint64_t free_bits = ~leaf->used[w];
+        if (w == from >> 6) free_bits &= ~0ull << (from & 63);
+        if (free_bits) return w * 64 + __builtin_ctzll(free_bits);
+    }
+    return -1;
+}
+
+/* prev_gap - Last unused slot <= from, or -1 */
+static int prev_gap(const GBNode *leaf, int from) {
+    if (from < 0) return -1;
+    for (int w = from >> 6; w >= 0; w--) {
+        uint64_t free_bits = ~leaf->used[w];
+        if (w == from >> 6 && (from & 63) != 63) {
+            free_bits &= (2ull << (from & 63)) - 1;
+        }
+        if (free_bits) return w * 64 + 63 - __builtin_clzll(free_bits);
+    }
+    return -1;
+}
+
+/* ================================================================
+ * NODE CREATION / DESTRUCTION
+ * ================================================================ */
+
+/*
+ * create_node - Allocate an empty node
+ *
+ * Internal: keys[2t] and children[2t+1], one spare each so a child
+ * split can be absorbed before the node itself splits.
+ * Leaf: keys[slots] plus the occupancy bitmap.
+ */
+static GBNode *create_node(GBTree *tree, bool is_leaf) {
+    GBNode *node = (GBNode *)calloc(1, sizeof(GBNode));
+    if (!node) return NULL;
+
+    node->is_leaf = is_leaf;
+    if (is_leaf) {
+        node->keys = (int *)malloc(tree->slots * sizeof(int));
+        node->used = (uint64_t *)malloc(bitmap_words(tree->slots) * sizeof(uint64_t));
+        if (node->used) bitmap_clear(node, tree->slots);
+    } else {
+        node->keys = (int *)malloc(2 * tree->t * sizeof(int));
+        node->children = (GBNode **)calloc(2 * tree->t + 1, sizeof(GBNode *));
+    }
+
+    if (!node->keys || (is_leaf ? !node->used : !node->children)) {
+        free(node->keys);
+        free(node->used);
+        free(node->children);
+        free(node);
+        return NULL;
+    }
+    return node;
+}
+
+static void free_node(GBNode *node) {
+    free(node->keys);
+    free(node->used);
+    free(node->children);
+    free(node);
+}
+
+static void destroy_node(GBNode *node) {
+    if (!node) return;
+    if (!node->is_leaf) {
+        for (int i = 0; i <= node->n; i++) {
+            destroy_node(node->children[i]);
+        }
+    }
+    free_node(node);
+}
+
+/*
+ * gbtree_create - Create an empty gapped-leaf tree
+ *
+ * @t: minimum degree (must be >= 2); leaves get about 1.5 x (2t-1)
+ *     slots, so a full leaf is still a third gaps
+ */
+GBTree *gbtree_create(int t) {
+    if (t < 2) {
+        fprintf(stderr, "Error: Minimum degree must be at least 2\n");
+        return NULL;
+    }
+
+    GBTree *tree = (GBTree *)calloc(1, sizeof(GBTree));
+    if (!tree) return NULL;
+    tree->t = t;
+    tree->slots = ((3 * (2 * t - 1) + 1) / 2 + 7) & ~7;
+    tree->scratch = (int *)malloc(2 * t * sizeof(int));
+    tree->root = tree->scratch ? create_node(tree, true) : NULL;
+    if (!tree->root) {
+        free(tree->scratch);
+        free(tree);
+        return NULL;
+    }
+    return tree;
+}
+
+void gbtree_destroy(GBTree *tree) {
+    if (!tree) return;
+    destroy_node(tree->root);
+    free(tree->scratch);
+    free(tree);
+}
+
+/* ================================================================
+ * LEAF OPERATIONS
+ *
+ * Invariant: a gap holds the next real key to its right, or the last
+ * real key if there is none. slots[] is therefore non-decreasing and
+ * any value found in it is a real key.
+ * ================================================================ */
+
+/*
+ * lower_bound - First index in a[0..len) with a[i] >= key (or > key
+ *               when @inclusive)
+ *
+ * Branch-free halving down to one window of SEARCH_WINDOW entries,
+ * which is then counted in a straight loop (vectorizable, prefetch
+ * friendly). Gaps need no special care: slots[] is sorted.
+ */
+#define SEARCH_WINDOW 16
+
+static int lower_bound(const int *a, int len, int key, bool inclusive) {
+    const int *base = a;
+    while (len > SEARCH_WINDOW) {
+        int half = len / 2;
+        int v = base[half - 1];
+        base = (inclusive ? v <= key : v < key) ? base + half : base;
+        len -= half;
+    }
+    int c = 0;
+    for (int i = 0; i < len; i++) {
+        c += inclusive ? base[i] <= key : base[i] < key;
+    }
+    return (int)(base - a) + c;
+}
+
+/* slot_lower_bound - First slot with value >= key (slots if none) */
+static int slot_lower_bound(const GBNode *leaf, int slots, int key) {
+    return lower_bound(leaf->keys, slots, key, false);
+}
+
+/*
+ * leaf_find - Lower-bound slot of key in a leaf
+ *
+ * @found: set to true if key is present
+ */
+static int leaf_find(GBTree *tree, const GBNode *leaf, int key, bool *found) {
+    if (leaf->n == 0) {
+        *found = false;
+        return 0;
+    }
+    int p = slot_lower_bound(leaf, tree->slots, key);
+    *found = p < tree->slots && leaf->keys[p] == key;
+    return p;
+}
+
+/* leaf_collect - Copy the real keys, in order, to out[] */
+static int leaf_collect(GBTree *tree, const GBNode *leaf, int *out) {
+    int m = 0;
+    for (int s = 0; s < tree->slots; s++) {
+        if (slot_used(leaf, s)) out[m++] = leaf->keys[s];
+    }
+    return m;
+}
+
+/*
+ * leaf_spread - Lay out m sorted keys evenly over the leaf
+ *
+ * Key i goes to the middle of the i-th of m equal stretches, so both
+ * ends keep gaps. @keys must not alias the leaf.
+ */
+static void leaf_spread(GBTree *tree, GBNode *leaf, const int *keys, int m) {
+    int slots = tree->slots;
+
+    bitmap_clear(leaf, slots);
+    leaf->n = m;
+    if (m == 0) return;
+
+    for (int i = 0; i < m; i++) {
+        int s = (int)((2L * i + 1) * slots / (2L * m));
+        leaf->keys[s] = keys[i];
+        mark_used(leaf, s);
+    }
+
+    /* Gaps take the next real key; trailing gaps take the last one */
+    int next = keys[m - 1];
+    for (int s = slots - 1; s >= 0; s--) {
+        if (slot_used(leaf, s)) {
+            next = leaf->keys[s];
+        } else {
+            leaf->keys[s] = next;
+        }
+    }
+    tree->moves += m;
+}
+
+/*
+ * leaf_place - Store key in gap q and restore the gap invariant
+ *
+ * Gaps to the left of q now lead to key. If key is the new last real
+ * key, the trailing gaps copy it too.
+ */
+static void leaf_place(GBTree *tree, GBNode *leaf, int q, int key) {
+    int slots = tree->slots;
+
+    leaf->keys[q] = key;
+    mark_used(leaf, q);
+    leaf->n++;
+    tree->moves++;
+
+    for (int s = q - 1; s >= 0 && !slot_used(leaf, s); s--) {
+        leaf->keys[s] = key;
+    }
+    int s = q + 1;
+    while (s < slots && !slot_used(leaf, s)) s++;
+    if (s == slots) {
+        for (s = q + 1; s < slots; s++) leaf->keys[s] = key;
+    }
+}
+
+/*
+ * leaf_insert - Insert a key that is absent, into a leaf that has room
+ *
+ * @p: slot_lower_bound of key, if the caller has it; else -1
+ *
+ * 1. Key falls in a gap run: take the middle of the run, no shifting.
+ * 2. Key falls on a real key: shift toward the nearer gap. If that is
+ *    more than GBTREE_SHIFT_LIMIT slots away, re-spread the whole leaf
+ *    with the new key instead.
+ */
+static void leaf_insert(GBTree *tree, GBNode *leaf, int key, int p) {
+    int slots = tree->slots;
+
+    if (leaf->n == 0) {
+        leaf_spread(tree, leaf, &key, 1);
+        return;
+    }
+
+    if (p < 0) p = slot_lower_bound(leaf, slots, key);
+
+    /* Case 1: a gap run starts at p, or trailing gaps follow the last key */
+    int run_start = -1;
+    if (p < slots && !slot_used(leaf, p)) {
+        run_start = p;
+    } else if (p == slots && !slot_used(leaf, slots - 1)) {
+        run_start = slots - 1;
+        while (run_start > 0 && !slot_used(leaf, run_start - 1)) run_start--;
+    }
+    if (run_start >= 0) {
+        int run_end = run_start;
+        while (run_end + 1 < slots && !slot_used(leaf, run_end + 1)) run_end++;
+        leaf_place(tree, leaf, run_start + (run_end - run_start) / 2, key);
+        return;
+    }
+
+    /* Case 2: slots[p-1] and slots[p] are real; find the nearest gap */
+    int gr = next_gap(leaf, p, slots);
+    int gl = prev_gap(leaf, p - 1);
+    int dr = gr < 0 ? INT_MAX : gr - p;       /* Keys moved right */
+    int dl = gl < 0 ? INT_MAX : p - 1 - gl;   /* Keys moved left */
+
+    if (dr > GBTREE_SHIFT_LIMIT && dl > GBTREE_SHIFT_LIMIT) {
+        int m = leaf_collect(tree, leaf, tree->scratch);
+        int pos = m;
+        while (pos > 0 && tree->scratch[pos - 1] > key) {
+            tree->scratch[pos] = tree->scratch[pos - 1];
+            pos--;
+        }
+        tree->scratch[pos] = key;
+        leaf_spread(tree, leaf, tree->scratch, m + 1);
+        return;
+    }
+
+    int q;
+    if (dr <= dl) {
+        memmove(&leaf->keys[p + 1], &leaf->keys[p], dr * sizeof(int));
+        mark_used(leaf, gr);
+        q = p;
+        tree->moves += dr;
+    } else {
+        memmove(&leaf->keys[gl], &leaf->keys[gl + 1], dl * sizeof(int));
+        mark_used(leaf, gl);
+        q = p - 1;
+        tree->moves += dl;
+    }
+    /* q is marked used by the shift; leaf_place re-marks it harmlessly */
+    mark_free(leaf, q);
+    leaf_place(tree, leaf, q, key);
+}
+
+/*
+ * leaf_remove - Delete a key known to be in the leaf
+ *
+ * @p: slot_lower_bound of the key
+ *
+ * Its slot becomes a gap; the gap run it joins is rewritten to the
+ * next real key (or to the previous one if it was the last key).
+ */
+static void leaf_remove(GBTree *tree, GBNode *leaf, int p) {
+    int slots = tree->slots;
+
+    /* Gaps before a key copy it, so the real slot ends that run */
+    int i = p;
+    while (!slot_used(leaf, i)) i++;
+
+    mark_free(leaf, i);
+    leaf->n--;
+    if (leaf->n == 0) return;
+
+    int j = i + 1;
+    while (j < slots && !slot_used(leaf, j)) j++;
+    if (j < slots) {
+        for (int s = i; s >= 0 && !slot_used(leaf, s); s--) {
+            leaf->keys[s] = leaf->keys[j];
+        }
+    } else {
+        int k = i;
+        while (!slot_used(leaf, k)) k--;
+        for (int s = k + 1; s < slots; s++) leaf->keys[s] = leaf->keys[k];
+    }
+}
+
+/* Leftmost and rightmost slots always copy the first and last key */
+static int leaf_min(GBTree *tree, const GBNode *leaf) {
+    (void)tree;
+    return leaf->keys[0];
+}
+
+static int leaf_max(GBTree *tree, const GBNode *leaf) {
+    return leaf->keys[tree->slots - 1];
+}
+
+/* ================================================================
+ * INSERT / SEARCH
+ *
+ * Insert recurses to the leaf and splits on the way back up: a full
+ * leaf only needs splitting if the key turns out to be new.
+ * ================================================================ */
+
+/* child_index - Child whose range covers key: first separator > key */
+static int child_index(const GBNode *node, int key) {
+    return lower_bound(node->keys, node->n, key, true);
+}
+
+/*
+ * split_leaf - Split a full leaf while adding key
+ *
+ * The 2t keys are spread t / t; @sep is the right leaf's first key.
+ */
+static GBNode *split_leaf(GBTree *tree, GBNode *leaf, int key, int *sep) {
+    GBNode *right = create_node(tree, true);
+    if (!right) return NULL;
+
+    int *all = tree->scratch;
+    int m = leaf_collect(tree, leaf, all);
+    int pos = m;
+    while (pos > 0 && all[pos - 1] > key) {
+        all[pos] = all[pos - 1];
+        pos--;
+    }
+    all[pos] = key;
+    m++;
+
+    int half = m / 2;
+    leaf_spread(tree, right, all + half, m - half);
+    leaf_spread(tree, leaf, all, half);
+    *sep = all[half];
+    return right;
+}
+
+/*
+ * split_internal - Split an internal node that holds 2t separators
+ *
+ * Left keeps t separators, keys[t] moves up, right takes t-1.
+ */
+static GBNode *split_internal(GBTree *tree, GBNode *node, int *sep) {
+    int t = tree->t;
+    GBNode *right = create_node(tree, false);
+    if (!right) return NULL;
+
+    *sep = node->keys[t];
+    right->n = t - 1;
+    memcpy(right->keys, &node->keys[t + 1], (t - 1) * sizeof(int));
+    memcpy(right->children, &node->children[t + 1], t * sizeof(GBNode *));
+    node->n = t;
+    return right;
+}
+
+/*
+ * insert_rec - Insert below node
+ *
+ * @sep, @right: set when node split (right is NULL otherwise)
+ *
+ * Returns: 1 if added, 0 if already present, -1 on allocation failure
+ */
+static int insert_rec(GBTree *tree, GBNode *node, int key, int *sep,
+                      GBNode **right) {
+    *right = NULL;
+
+    if (node->is_leaf) {
+        bool found;
+        int p = leaf_find(tree, node, key, &found);
+        if (found) return 0;
+        if (node->n < 2 * tree->t - 1) {
+            leaf_insert(tree, node, key, p);
+            return 1;
+        }
+        *right = split_leaf(tree, node, key, sep);
+        return *right ? 1 : -1;
+    }
+
+    int i = child_index(node, key);
+    int child_sep;
+    GBNode *child_right;
+    int rc = insert_rec(tree, node->children[i], key, &child_sep, &child_right);
+    if (rc != 1 || !child_right) return rc;
+
+    /* Absorb the child's split at position i */
+    memmove(&node->keys[i + 1], &node->keys[i], (node->n - i) * sizeof(int));
+    memmove(&node->children[i + 2], &node->children[i + 1],
+            (node->n - i) * sizeof(GBNode *));
+    node->keys[i] = child_sep;
+    node->children[i + 1] = child_right;
+    node->n++;
+
+    if (node->n == 2 * tree->t) {
+        *right = split_internal(tree, node, sep);
+        if (!*right) return -1;
+    }
+    return 1;
+}
+
+/*
+ * gbtree_insert - Insert a key
+ *
+ * Returns: true if the key was added, false if present (or no memory)
+ */
+bool gbtree_insert(GBTree *tree, int key) {
+    if (!tree) return false;
+
+    int sep;
+    GBNode *right;
+    int rc = insert_rec(tree, tree->root, key, &sep, &right);
+    if (rc == 1 && right) {
+        /* Root split: the only place the tree grows taller */
+        GBNode *root = create_node(tree, false);
+        if (!root) return false;
+        root->keys[0] = sep;
+        root->children[0] = tree->root;
+        root->children[1] = right;
+        root->n = 1;
+        tree->root = root;
+    }
+    if (rc == 1) tree->count++;
+    return rc == 1;
+}
+
+bool gbtree_search(GBTree *tree, int key) {
+    if (!tree) return false;
+    GBNode *node = tree->root;
+    while (!node->is_leaf) {
+        node = node->children[child_index(node, key)];
+    }
+    bool found;
+    leaf_find(tree, node, key, &found);
+    return found;
+}
+
+/* ================================================================
+ * DELETE
+ *
+ * Deletion removes from the leaf and repairs underflow (fewer than t-1
+ * keys) on the way back up: borrow from a sibling with spare keys,
+ * otherwise merge with one.
+ * ================================================================ */
+
+static void borrow_from_left(GBTree *tree, GBNode *parent, int i) {
+    GBNode *child = parent->children[i];
+    GBNode *left = parent->children[i - 1];
+
+    if (child->is_leaf) {
+        int v = leaf_max(tree, left);
+        leaf_remove(tree, left, slot_lower_bound(left, tree->slots, v));
+        leaf_insert(tree, child, v, -1);
+        parent->keys[i - 1] = v;
+        return;
+    }
+
+    memmove(&child->keys[1], &child->keys[0], child->n * sizeof(int));
+    memmove(&child->children[1], &child->children[0],
+            (child->n + 1) * sizeof(GBNode *));
+    child->keys[0] = parent->keys[i - 1];
+    child->children[0] = left->children[left->n];
+    parent->keys[i - 1] = left->keys[left->n - 1];
+    child->n++;
+    left->n--;
+}
+
+static void borrow_from_right(GBTree *tree, GBNode *parent, int i) {
+    GBNode *child = parent->children[i];
+    GBNode *right = parent->children[i + 1];
+
+    if (child->is_leaf) {
+        int v = leaf_min(tree, right);
+        leaf_remove(tree, right, 0);
+        leaf_insert(tree, child, v, -1);
+        parent->keys[i] = leaf_min(tree, right);
+        return;
+    }
+
+    child->keys[child->n] = parent->keys[i];
+    child->children[child->n + 1] = right->children[0];
+    parent->keys[i] = right->keys[0];
+    memmove(&right->keys[0], &right->keys[1], (right->n - 1) * sizeof(int));
+    memmove(&right->children[0], &right->children[1],
+            right->n * sizeof(GBNode *));
+    child->n++;
+    right->n--;
+}
+
+/* merge - Fold children[j+1] into children[j] and drop separator j */
+static void merge(GBTree *tree, GBNode *parent, int j) {
+    GBNode *left = parent->children[j];
+    GBNode *right = parent->children[j + 1];
+
+    if (left->is_leaf) {
+        int m = leaf_collect(tree, left, tree->scratch);
+        m += leaf_collect(tree, right, tree->scratch + m);
+        leaf_spread(tree, left, tree->scratch, m);
+    } else {
+        left->keys[left->n] = parent->keys[j];
+        memcpy(&left->keys[left->n + 1], right->keys, right->n * sizeof(int));
+        memcpy(&left->children[left->n + 1], right->children,
+               (right->n + 1) * sizeof(GBNode *));
+        left->n += right->n + 1;
+    }
+    free_node(right);
+
+    memmove(&parent->keys[j], &parent->keys[j + 1],
+            (parent->n - j - 1) * sizeof(int));
+    memmove(&parent->children[j + 1], &parent->children[j + 2],
+            (parent->n - j - 1) * sizeof(GBNode *));
+    parent->n--;
+}
+
+static void rebalance(GBTree *tree, GBNode *parent, int i) {
+    int t = tree->t;
+    if (i > 0 && parent->children[i - 1]->n > t - 1) {
+        borrow_from_left(tree, parent, i);
+    } else if (i < parent->n && parent->children[i + 1]->n > t - 1) {
+        borrow_from_right(tree, parent, i);
+    } else {
+        merge(tree, parent, i > 0 ? i - 1 : i);
+    }
+}
+
+static bool delete_rec(GBTree *tree, GBNode *node, int key) {
+    if (node->is_leaf) {
+        bool found;
+        int p = leaf_find(tree, node, key, &found);
+        if (!found) return false;
+        leaf_remove(tree, node, p);
+        return true;
+    }
+
+    int i = child_index(node, key);
+    if (!delete_rec(tree, node->children[i], key)) return false;
+    if (node->children[i]->n < tree->t - 1) {
+        rebalance(tree, node, i);
+    }
+    return true;
+}
+
+/*
+ * gbtree_delete - Remove a key
+ *
+ * Returns: true if the key was present
+ */
+bool gbtree_delete(GBTree *tree, int key) {
+    if (!tree || !delete_rec(tree, tree->root, key)) return false;
+    tree->count--;
+
+    /* Root with no separators: its only child becomes the root */
+    if (!tree->root->is_leaf && tree->root->n == 0) {
+        GBNode *old_root = tree->root;
+        tree->root = old_root->children[0];
+        free_node(old_root);
+    }
+    return true;
+}
+
+/* ================================================================
+ * UTILITY FUNCTIONS
+ * ================================================================ */
+
+long gbtree_count(GBTree *tree) {
+    return tree ? tree->count : 0;
+}
+
+int gbtree_height(GBTree *tree) {
+    if (!tree) return 0;
+    int height = 1;
+    for (GBNode *node = tree->root; !node->is_leaf; node = node->children[0]) {
+        height++;
+    }
+    return height;
+}
+
+/*
+ * check_leaf - Occupancy count, key order and the gap invariant
+ */
+static bool check_leaf(GBTree *tree, const GBNode *leaf) {
+    int slots = tree->slots;
+    int real = 0;
+    for (int s = 0; s < slots; s++) {
+        if (slot_used(leaf, s)) real++;
+    }
+    if (real != leaf->n) {
+        fprintf(stderr, "Validation error: leaf n=%d but %d slots used\n",
+                leaf->n, real);
+        return false;
+    }
+    if (real == 0) return true;
+
+    int next = -1;  /* Slot of the next real key to the right */
+    int last = -1;
+    for (int s = slots - 1; s >= 0; s--) {
+        if (!slot_used(leaf, s)) continue;
+        if (last < 0) last = s;
+        if (next >= 0 && leaf->keys[s] >= leaf->keys[next]) {
+            fprintf(stderr, "Validation error: leaf keys not sorted at slot %d\n", s);
+            return false;
+        }
+        next = s;
+    }
+
+    next = last;
+    for (int s = slots - 1; s >= 0; s--) {
+        if (slot_used(leaf, s)) {
+            next = s;
+        } else if (leaf->keys[s] != leaf->keys[next]) {
+            fprintf(stderr, "Validation error: gap at slot %d holds %d, "
+                    "expected %d\n", s, leaf->keys[s], leaf->keys[next]);
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * validate_node - Check a subtree against bounds [lo, hi)
+ *
+ * Returns: leaf depth if valid, -1 if invalid
+ */
+static int validate_node(GBTree *tree, GBNode *node, const int *lo,
+                         const int *hi, bool is_root, int depth,
+                         int expected_depth, long *keys) {
+    int t = tree->t;
+    if (!is_root && (node->n < t - 1 || node->n > 2 * t - 1)) {
+        fprintf(stderr, "Validation error: node has %d keys (range [%d, %d])\n",
+                node->n, t - 1, 2 * t - 1);
+        return -1;
+    }
+
+    if (node->is_leaf) {
+        if (!check_leaf(tree, node)) return -1;
+        if (node->n > 0 && ((lo && leaf_min(tree, node) < *lo) ||
+                            (hi && leaf_max(tree, node) >= *hi))) {
+            fprintf(stderr, "Validation error: leaf key outside separators\n");
+            return -1;
+        }
+        if (expected_depth != -1 && depth != expected_depth) {
+            fprintf(stderr, "Validation error: leaf at depth %d, expected %d\n",
+                    depth, expected_depth);
+            return -1;
+        }
+        *keys += node->n;
+        return depth;
+    }
+
+    for (int i = 0; i < node->n; i++) {
+        if ((i > 0 && node->keys[i] <= node->keys[i - 1]) ||
+            (lo && node->keys[i] < *lo) || (hi && node->keys[i] >= *hi)) {
+            fprintf(stderr, "Validation error: bad separator at index %d\n", i);
+            return -1;
+        }
+    }
+
+    int leaf_depth = expected_depth;
+    for (int i = 0; i <= node->n; i++) {
+        const int *child_lo = i > 0 ? &node->keys[i - 1] : lo;
+        const int *child_hi = i < node->n ? &node->keys[i] : hi;
+        leaf_depth = validate_node(tree, node->children[i], child_lo, child_hi,
+                                   false, depth + 1, leaf_depth, keys);
+        if (leaf_depth == -1) return -1;
+    }
+    return leaf_depth;
+}
+
+/*
+ * gbtree_validate - Verify leaf layout, separators, fill and balance
+ *
+ * Returns: 1 if valid, 0 if invalid
+ */
+int gbtree_validate(GBTree *tree) {
+    if (!tree || !tree->root) return 0;
+    long keys = 0;
+    if (validate_node(tree, tree->root, NULL, NULL, true, 1, -1, &keys) == -1) {
+        return 0;
+    }
+    if (keys != tree->count) {
+        fprintf(stderr, "Validation error: %ld keys, count says %ld\n",
+                keys, tree->count);
+        return 0;
+    }
+    return 1;
+}
@@ -0,0 +1,63 @@
+/* ============================================================
+ * B+-Tree with Gapped (Packed-Memory-Array) Leaves
+ * ============================================================
+ * In b-tree.h every insert into a leaf shifts, on average, half of the
+ * node's keys (about t moves). Here a leaf keeps its keys spread over
+ * more slots than it needs, with evenly spaced gaps:
+ *
+ *   slots: [ 3  3  7  9  9 12 15 15 ... ]    used: [ . x x . x x . x ]
+ *            ^gap     ^gap     ^gap
+ *
+ *   - every gap holds a copy of the next real key to its right (or,
+ *     after the last key, of the last key), so slots[] is sorted and a
+ *     plain binary search skips gaps with no bitmap reads
+ *   - insert shifts keys only up to the nearest gap; if that gap is
+ *     more than GBTREE_SHIFT_LIMIT slots away, the whole leaf is
+ *     re-spread evenly first (local redistribution)
+ *   - delete just clears the slot's bit and rewrites its gap run
+ *
+ * Internal nodes are dense, as in b-tree.h. Keys live only in leaves;
+ * internal keys are separators (child i+1 holds keys >= keys[i]).
+ *
+ * [x] gbtree_create / gbtree_destroy
+ * [x] gbtree_insert / gbtree_search / gbtree_delete (set semantics)
+ * [x] gbtree_validate / gbtree_count / gbtree_height
+ * ============================================================ */
+
+#ifndef B_TREE_GAPPED_H
+#define B_TREE_GAPPED_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define GBTREE_SHIFT_LIMIT 8  /* Max slots moved before re-spreading a leaf */
+
+typedef struct GBNode {
+    int *keys;                 /* Internal: 2t separators; leaf: slots */
+    struct GBNode **children;  /* Internal only: 2t+1 (one spare) */
+    uint64_t *used;            /* Leaf only: occupancy bitmap */
+    int n;                     /* Real keys (leaf) or separators (internal) */
+    bool is_leaf;
+} GBNode;
+
+typedef struct GBTree {
+    GBNode *root;
+    int t;          /* Leaves and internal nodes hold [t-1, 2t-1] keys */
+    int slots;      /* Physical slots per leaf (about 1.5 x (2t-1)) */
+    long count;     /* Keys in the tree */
+    long moves;     /* Leaf slot writes caused by shifts and re-spreads */
+    int *scratch;   /* 2t keys: split, merge and re-spread buffer */
+} GBTree;
+
+GBTree *gbtree_create(int t);
+void gbtree_destroy(GBTree *tree);
+
+bool gbtree_insert(GBTree *tree, int key);
+bool gbtree_search(GBTree *tree, int key);
+bool gbtree_delete(GBTree *tree, int key);
+
+int gbtree_validate(GBTree *tree);
+long gbtree_count(GBTree *tree);
+int gbtree_height(GBTree *tree);
+
+#endif /* B_TREE_GAPPED_H */
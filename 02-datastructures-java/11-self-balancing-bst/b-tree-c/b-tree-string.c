@@ -0,0 +1,681 @@
+/*
+ * String-Key B+-Tree Implementation
+ *
+ * This file implements slotted-page nodes with per-page prefix
+ * compression and suffix-truncated separators.
+ * See b-tree-string.h for the page layout.
+ */
+
+#include "b-tree-string.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ================================================================
+ * PAGE LAYOUT (private)
+ * ================================================================ */
+
+typedef struct {
+    uint16_t count;        /* Number of slots */
+    uint16_t heap_start;   /* Lowest used heap offset (heap grows down) */
+    uint16_t prefix_off;   /* Page prefix location in the heap */
+    uint16_t prefix_len;
+    uint8_t is_leaf;
+    SBTreeNode *leftmost;  /* Internal: child for keys below slot 0 */
+} PageHeader;
+
+typedef struct {
+    uint32_t head;         /* First 4 suffix bytes, big-endian, 0-padded */
+    uint16_t off;          /* Heap offset of the entry */
+    uint16_t len;          /* Suffix length (bytes after the page prefix) */
+} Slot;
+
+struct SBTreeNode {
+    PageHeader h;
+    Slot slots[];
+};
+
+/*
+ * Heap entry: leaf      -> [suffix bytes]
+ *             internal  -> [child pointer][suffix bytes]
+ * An internal slot's child holds keys >= its separator.
+ */
+#define CHILD_BYTES sizeof(SBTreeNode *)
+
+/* A key gathered out of a page, with its full bytes materialized */
+typedef struct {
+    const unsigned char *key;
+    size_t len;
+    SBTreeNode *child;     /* Internal entries only */
+} Entry;
+
+/* Separator handed to the parent after a split */
+typedef struct {
+    SBTreeNode *right;     /* New right sibling, NULL if no split */
+    size_t sep_len;
+    unsigned char sep[SBTREE_MAX_KEY];
+} SplitResult;
+
+/* ================================================================
+ * SMALL HELPERS
+ * ================================================================ */
+
+static uint32_t pack_head(const unsigned char *s, size_t len) {
+    uint32_t head = 0;
+    for (size_t i = 0; i < 4; i++) {
+        head = (head << 8) | (i < len ? s[i] : 0);
+    }
+    return head;
+}
+
+static unsigned char *page_bytes(SBTreeNode *node) {
+    return (unsigned char *)node;
+}
+
+static const unsigned char *page_prefix(SBTreeNode *node) {
+    return page_bytes(node) + node->h.prefix_off;
+}
+
+static const unsigned char *slot_suffix(SBTreeNode *node, int i) {
+    return page_bytes(node) + node->slots[i].off +
+           (node->h.is_leaf ? 0 : CHILD_BYTES);
+}
+
+static SBTreeNode *slot_child(SBTreeNode *node, int i) {
+    SBTreeNode *child;
+    memcpy(&child, page_bytes(node) + node->slots[i].off, sizeof(child));
+    return child;
+}
+
+/* child_at - idx -1 means leftmost, otherwise the child of slot idx */
+static SBTreeNode *child_at(SBTreeNode *node, int idx) {
+    return idx < 0 ? node->h.leftmost : slot_child(node, idx);
+}
+
+static size_t free_space(SBTreeNode *node) {
+    return node->h.heap_start -
+           (sizeof(PageHeader) + node->h.count * sizeof(Slot));
+}
+
+static size_t lcp(const unsigned char *a, size_t al,
+                  const unsigned char *b, size_t bl) {
+    size_t n = al < bl ? al : bl;
+    size_t i = 0;
+    while (i < n && a[i] == b[i]) i++;
+    return i;
+}
+
+static int compare_bytes(const unsigned char *a, size_t al,
+                         const unsigned char *b, size_t bl) {
+    size_t n = al < bl ? al : bl;
+    int r = memcmp(a, b, n);
+    if (r != 0) return r;
+    return (al > bl) - (al < bl);
+}
+
+static SBTreeNode *page_alloc(SBTree *tree, bool is_leaf) {
+    SBTreeNode *node = (SBTreeNode *)malloc(tree->page_size);
+    if (!node) return NULL;
+    node->h.count = 0;
+    node->h.heap_start = (uint16_t)tree->page_size;
+    node->h.prefix_off = (uint16_t)tree->page_size;
+    node->h.prefix_len = 0;
+    node->h.is_leaf = is_leaf;
+    node->h.leftmost = NULL;
+    tree->pages++;
+    return node;
+}
+
+/* ================================================================
+ * IN-PAGE SEARCH
+ *
+ * The page prefix is compared once. A key that does not start with it
+ * lies entirely before or after the page, with no slot comparisons.
+ * Otherwise the binary search compares 4-byte heads first and only
+ * touches heap bytes when heads tie.
+ * ================================================================ */
+
+static int compare_slot(SBTreeNode *node, int i, const unsigned char *ks,
+                        size_t kl, uint32_t kh) {
+    const Slot *slot = &node->slots[i];
+    if (kh != slot->head) return kh < slot->head ? -1 : 1;
+
+    /* Heads tie: the first min(4, len) bytes are equal */
+    size_t sl = slot->len;
+    size_t n = kl < sl ? kl : sl;
+    if (n > 4) {
+        int r = memcmp(ks + 4, slot_suffix(node, i) + 4, n - 4);
+        if (r != 0) return r;
+    }
+    return (kl > sl) - (kl < sl);
+}
+
+/*
+ * node_lower_bound - Index of the first slot >= key
+ *
+ * @exact: set to true if that slot equals key
+ */
+static int node_lower_bound(SBTreeNode *node, const unsigned char *key,
+                            size_t len, bool *exact) {
+    *exact = false;
+
+    size_t plen = node->h.prefix_len;
+    if (plen > 0) {
+        size_t n = len < plen ? len : plen;
+        int r = memcmp(key, page_prefix(node), n);
+        if (r < 0 || (r == 0 && len < plen)) return 0;
+        if (r > 0) return node->h.count;
+    }
+
+    const unsigned char *ks = key + plen;
+    size_t kl = len - plen;
+    uint32_t kh = pack_head(ks, kl);
+
+    int lo = 0, hi = node->h.count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        int c = compare_slot(node, mid, ks, kl, kh);
+        if (c > 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+            if (c == 0) *exact = true;
+        }
+    }
+    return lo;
+}
+
+/* child_index - Slot whose child covers key (-1 for leftmost) */
+static int child_index(SBTreeNode *node, const unsigned char *key, size_t len) {
+    bool exact;
+    int lb = node_lower_bound(node, key, len, &exact);
+    return exact ? lb : lb - 1;
+}
+
+/* ================================================================
+ * PAGE REBUILD
+ *
+ * Slow path for inserts that do not fit the current prefix or free
+ * space: all entries are materialized as full keys, the prefix is
+ * recomputed as lcp(first, last), and the page is rewritten compactly.
+ * ================================================================ */
+
+/*
+ * gather_entries - Materialize a page's keys plus one new entry
+ *
+ * Returns: entry array (count + 1 long); *buf receives the key bytes
+ *          backing it. Both are malloc'd; NULL on failure.
+ */
+static Entry *gather_entries(SBTreeNode *node, int pos,
+                             const unsigned char *key, size_t len,
+                             SBTreeNode *child, unsigned char **buf) {
+    int count = node->h.count;
+    size_t plen = node->h.prefix_len;
+
+    size_t bytes = len;
+    for (int i = 0; i < count; i++) {
+        bytes += plen + node->slots[i].len;
+    }
+
+    Entry *entries = (Entry *)malloc((count + 1) * sizeof(Entry));
+    *buf = (unsigned char *)malloc(bytes ? bytes : 1);
+    if (!entries || !*buf) {
+        free(entries);
+        free(*buf);
+        return NULL;
+    }
+
+    unsigned char *out = *buf;
+    for (int i = 0, e = 0; e <= count; e++) {
+        if (e == pos) {
+            memcpy(out, key, len);
+            entries[e] = (Entry){ out, len, child };
+            out += len;
+            continue;
+        }
+        size_t sl = node->slots[i].len;
+        memcpy(out, page_prefix(node), plen);
+        memcpy(out + plen, slot_suffix(node, i), sl);
+        entries[e] = (Entry){ out, plen + sl,
+                              node->h.is_leaf ? NULL : slot_child(node, i) };
+        out += plen + sl;
+        i++;
+    }
+    return entries;
+}
+
+/* page_size_needed - Bytes to store entries [a, b) in one page */
+static size_t page_size_needed(const Entry *e, int a, int b, bool is_leaf) {
+    size_t plen = (b > a) ? lcp(e[a].key, e[a].len, e[b - 1].key, e[b - 1].len)
+                          : 0;
+    size_t total = sizeof(PageHeader) + plen;
+    for (int i = a; i < b; i++) {
+        total += sizeof(Slot) + (e[i].len - plen) + (is_leaf ? 0 : CHILD_BYTES);
+    }
+    return total;
+}
+
+/*
+ * build_page - Rewrite @node to hold entries [a, b)
+ *
+ * The caller has checked the entries fit (page_size_needed).
+ */
+static void build_page(SBTree *tree, SBTreeNode *node, const Entry *e,
+                       int a, int b, bool is_leaf, SBTreeNode *leftmost) {
+    size_t plen = (b > a) ? lcp(e[a].key, e[a].len, e[b - 1].key, e[b - 1].len)
+                          : 0;
+    size_t heap = tree->page_size - plen;
+
+    if (plen > 0) memcpy(page_bytes(node) + heap, e[a].key, plen);
+    node->h.prefix_off = (uint16_t)heap;
+    node->h.prefix_len = (uint16_t)plen;
+    node->h.is_leaf = is_leaf;
+    node->h.leftmost = leftmost;
+    node->h.count = (uint16_t)(b - a);
+
+    for (int i = a; i < b; i++) {
+        size_t sl = e[i].len - plen;
+        heap -= sl + (is_leaf ? 0 : CHILD_BYTES);
+        unsigned char *dst = page_bytes(node) + heap;
+        if (!is_leaf) {
+            memcpy(dst, &e[i].child, CHILD_BYTES);
+            dst += CHILD_BYTES;
+        }
+        memcpy(dst, e[i].key + plen, sl);
+
+        Slot *slot = &node->slots[i - a];
+        slot->head = pack_head(e[i].key + plen, sl);
+        slot->off = (uint16_t)heap;
+        slot->len = (uint16_t)sl;
+    }
+    node->h.heap_start = (uint16_t)heap;
+}
+
+/* ================================================================
+ * SPLIT
+ * ================================================================ */
+
+/*
+ * split_fits - Would splitting at @m leave both pages within size?
+ *
+ * Leaf: left [0, m), right [m, count).
+ * Internal: left [0, m), entry m promoted, right (m, count).
+ */
+static bool split_fits(SBTree *tree, const Entry *e, int count, int m,
+                       bool is_leaf) {
+    int right_start = is_leaf ? m : m + 1;
+    return page_size_needed(e, 0, m, is_leaf) <= tree->page_size &&
+           page_size_needed(e, right_start, count, is_leaf) <= tree->page_size;
+}
+
+/*
+ * choose_split - Byte-balanced split point that fits both halves
+ *
+ * Balance is measured in compressed bytes. If the balanced point does
+ * not fit (possible when a new key shortens a long shared prefix), the
+ * nearest feasible point is used. Splitting right around the new entry
+ * always fits, since each side is then a subset of the old page.
+ */
+static int choose_split(SBTree *tree, const Entry *e, int count, bool is_leaf) {
+    size_t plen = lcp(e[0].key, e[0].len, e[count - 1].key, e[count - 1].len);
+    size_t total = 0;
+    for (int i = 0; i < count; i++) total += sizeof(Slot) + e[i].len - plen;
+
+    int lo = is_leaf ? 1 : 0;
+    int hi = count - 1;  /* Leaf: m <= count-1; internal: m <= count-1 */
+    int m = lo;
+    size_t acc = 0;
+    for (int i = 0; i < count; i++) {
+        acc += sizeof(Slot) + e[i].len - plen;
+        if (acc * 2 >= total) {
+            m = i + (is_leaf ? 1 : 0);
+            break;
+        }
+    }
+    if (m < lo) m = lo;
+    if (m > hi) m = hi;
+
+    for (int d = 0; d <= hi - lo; d++) {
+        if (m - d >= lo && split_fits(tree, e, count, m - d, is_leaf)) return m - d;
+        if (m + d <= hi && split_fits(tree, e, count, m + d, is_leaf)) return m + d;
+    }
+    return -1;
+}
+
+/*
+ * node_insert_entry - Put (key, child) at slot @pos, splitting if needed
+ *
+ * Fast path: the key shares the page prefix and there is room -> write
+ * the suffix into the heap and shift slots. Otherwise rebuild; if the
+ * rebuilt page would overflow, split it into @node and a new right page
+ * and describe the separator in @split.
+ *
+ * Returns: 1 on success, -1 on allocation failure
+ */
+static int node_insert_entry(SBTree *tree, SBTreeNode *node, int pos,
+                             const unsigned char *key, size_t len,
+                             SBTreeNode *child, SplitResult *split) {
+    bool is_leaf = node->h.is_leaf;
+    size_t plen = node->h.prefix_len;
+    split->right = NULL;
+
+    if (len >= plen && memcmp(key, page_prefix(node), plen) == 0) {
+        size_t sl = len - plen;
+        size_t need = sl + (is_leaf ? 0 : CHILD_BYTES);
+        if (free_space(node) >= sizeof(Slot) + need) {
+            node->h.heap_start -= (uint16_t)need;
+            unsigned char *dst = page_bytes(node) + node->h.heap_start;
+            if (!is_leaf) {
+                memcpy(dst, &child, CHILD_BYTES);
+                dst += CHILD_BYTES;
+            }
+            memcpy(dst, key + plen, sl);
+
+            memmove(&node->slots[pos + 1], &node->slots[pos],
+                    (node->h.count - pos) * sizeof(Slot));
+            node->slots[pos].head = pack_head(key + plen, sl);
+            node->slots[pos].off = node->h.heap_start;
+            node->slots[pos].len = (uint16_t)sl;
+            node->h.count++;
+            return 1;
+        }
+    }
+
+    unsigned char *buf;
+    Entry *e = gather_entries(node, pos, key, len, child, &buf);
+    if (!e) return -1;
+    int count = node->h.count + 1;
+    SBTreeNode *leftmost = node->h.leftmost;
+
+    if (page_size_needed(e, 0, count, is_leaf) <= tree->page_size) {
+        build_page(tree, node, e, 0, count, is_leaf, leftmost);
+        free(e);
+        free(buf);
+        return 1;
+    }
+
+    int m = choose_split(tree, e, count, is_leaf);
+    SBTreeNode *right = (m >= 0) ? page_alloc(tree, is_leaf) : NULL;
+    if (!right) {
+        free(e);
+        free(buf);
+        return -1;
+    }
+
+    if (is_leaf) {
+        /* Suffix truncation: shortest prefix of right[0] above left[m-1] */
+        size_t common = lcp(e[m - 1].key, e[m - 1].len, e[m].key, e[m].len);
+        split->sep_len = common + 1;
+        memcpy(split->sep, e[m].key, split->sep_len);
+        build_page(tree, right, e, m, count, true, NULL);
+        build_page(tree, node, e, 0, m, true, NULL);
+    } else {
+        /* Entry m moves up; its child becomes the right page's leftmost */
+        split->sep_len = e[m].len;
+        memcpy(split->sep, e[m].key, e[m].len);
+        build_page(tree, right, e, m + 1, count, false, e[m].child);
+        build_page(tree, node, e, 0, m, false, leftmost);
+    }
+    split->right = right;
+
+    free(e);
+    free(buf);
+    return 1;
+}
+
+/* ================================================================
+ * PUBLIC: CREATE / DESTROY
+ * ================================================================ */
+
+/*
+ * sbtree_create - Create an empty string-key tree
+ *
+ * @page_size: bytes per node, in [SBTREE_MIN_PAGE, SBTREE_MAX_PAGE]
+ *
+ * Returns: new tree, or NULL on bad page size / allocation failure
+ */
+SBTree *sbtree_create(size_t page_size) {
+    if (page_size < SBTREE_MIN_PAGE || page_size > SBTREE_MAX_PAGE) {
+        fprintf(stderr, "Error: page size must be in [%d, %d]\n",
+                SBTREE_MIN_PAGE, SBTREE_MAX_PAGE);
+        return NULL;
+    }
+
+    SBTree *tree = (SBTree *)calloc(1, sizeof(SBTree));
+    if (!tree) return NULL;
+    tree->page_size = page_size;
+    tree->max_key_len = page_size / 8 - CHILD_BYTES - sizeof(Slot);
+    if (tree->max_key_len > SBTREE_MAX_KEY) tree->max_key_len = SBTREE_MAX_KEY;
+
+    tree->root = page_alloc(tree, true);
+    if (!tree->root) {
+        free(tree);
+        return NULL;
+    }
+    tree->height = 1;
+    return tree;
+}
+
+static void destroy_page(SBTreeNode *node) {
+    if (!node->h.is_leaf) {
+        destroy_page(node->h.leftmost);
+        for (int i = 0; i < node->h.count; i++) {
+            destroy_page(slot_child(node, i));
+        }
+    }
+    free(node);
+}
+
+void sbtree_destroy(SBTree *tree) {
+    if (!tree) return;
+    destroy_page(tree->root);
+    free(tree);
+}
+
+/* ================================================================
+ * INSERT / SEARCH
+ *
+ * Insert recurses to the leaf and splits on the way back up, since a
+ * variable-length key cannot tell in advance whether a page has room.
+ * ================================================================ */
+
+static int insert_rec(SBTree *tree, SBTreeNode *node, const unsigned char *key,
+                      size_t len, SplitResult *split) {
+    split->right = NULL;
+
+    if (node->h.is_leaf) {
+        bool exact;
+        int pos = node_lower_bound(node, key, len, &exact);
+        if (exact) return 0;  /* Duplicate */
+        return node_insert_entry(tree, node, pos, key, len, NULL, split);
+    }
+
+    int idx = child_index(node, key, len);
+    SplitResult *child_split = (SplitResult *)malloc(sizeof(SplitResult));
+    if (!child_split) return -1;
+
+    int rc = insert_rec(tree, child_at(node, idx), key, len, child_split);
+    if (rc == 1 && child_split->right) {
+        rc = node_insert_entry(tree, node, idx + 1, child_split->sep,
+                               child_split->sep_len, child_split->right, split);
+    }
+    free(child_split);
+    return rc;
+}
+
+/*
+ * sbtree_insert - Insert a byte-string key
+ *
+ * Returns: 1 if added, 0 if already present, -1 if the key exceeds
+ *          max_key_len or memory ran out
+ */
+int sbtree_insert(SBTree *tree, const char *key, size_t len) {
+    if (!tree || !key || len > tree->max_key_len) return -1;
+
+    SplitResult *split = (SplitResult *)malloc(sizeof(SplitResult));
+    if (!split) return -1;
+
+    int rc = insert_rec(tree, tree->root, (const unsigned char *)key, len, split);
+    if (rc == 1 && split->right) {
+        /* Root split: the only place the tree grows taller */
+        SBTreeNode *root = page_alloc(tree, false);
+        if (!root) {
+            free(split);
+            return -1;
+        }
+        Entry e = { split->sep, split->sep_len, split->right };
+        build_page(tree, root, &e, 0, 1, false, tree->root);
+        tree->root = root;
+        tree->height++;
+    }
+    if (rc == 1) tree->keys++;
+
+    free(split);
+    return rc;
+}
+
+/*
+ * sbtree_contains - Return true if key is present
+ */
+bool sbtree_contains(SBTree *tree, const char *key, size_t len) {
+    if (!tree) return false;
+    const unsigned char *k = (const unsigned char *)key;
+
+    SBTreeNode *node = tree->root;
+    while (!node->h.is_leaf) {
+        node = child_at(node, child_index(node, k, len));
+    }
+    bool exact;
+    node_lower_bound(node, k, len, &exact);
+    return exact;
+}
+
+/* ================================================================
+ * VALIDATION / STATISTICS
+ * ================================================================ */
+
+/*
+ * validate_page - Check one subtree against bounds [lo, hi)
+ *
+ * A NULL bound means unbounded. Checks per-page key order, slot heads,
+ * that separators stay within bounds, and equal leaf depth.
+ *
+ * Returns: leaf depth if valid, -1 if invalid
+ */
+static int validate_page(SBTree *tree, SBTreeNode *node,
+                         const unsigned char *lo, size_t lo_len,
+                         const unsigned char *hi, size_t hi_len, int depth,
+                         int expected_depth) {
+    int count = node->h.count;
+    size_t plen = node->h.prefix_len;
+    unsigned char *keys = (unsigned char *)malloc((size_t)count * (plen + SBTREE_MAX_KEY) + 1);
+    size_t *lens = (size_t *)malloc((count + 1) * sizeof(size_t));
+    int result = -1;
+    if (!keys || !lens) goto out;
+
+    if (node->h.heap_start < sizeof(PageHeader) + count * sizeof(Slot)) {
+        fprintf(stderr, "Validation error: slots overlap heap\n");
+        goto out;
+    }
+
+    for (int i = 0; i < count; i++) {
+        unsigned char *k = keys + (size_t)i * (plen + SBTREE_MAX_KEY);
+        memcpy(k, page_prefix(node), plen);
+        memcpy(k + plen, slot_suffix(node, i), node->slots[i].len);
+        lens[i] = plen + node->slots[i].len;
+
+        if (node->slots[i].head != pack_head(k + plen, node->slots[i].len)) {
+            fprintf(stderr, "Validation error: stale slot head at %d\n", i);
+            goto out;
+        }
+        if (i > 0 && compare_bytes(k - (plen + SBTREE_MAX_KEY), lens[i - 1],
+                                   k, lens[i]) >= 0) {
+            fprintf(stderr, "Validation error: keys not sorted at index %d\n", i);
+            goto out;
+        }
+        if ((lo && compare_bytes(k, lens[i], lo, lo_len) < 0) ||
+            (hi && compare_bytes(k, lens[i], hi, hi_len) >= 0)) {
+            fprintf(stderr, "Validation error: key out of separator range\n");
+            goto out;
+        }
+    }
+
+    if (node->h.is_leaf) {
+        if (expected_depth != -1 && depth != expected_depth) {
+            fprintf(stderr, "Validation error: leaf at depth %d, expected %d\n",
+                    depth, expected_depth);
+            goto out;
+        }
+        result = depth;
+        goto out;
+    }
+
+    if (!node->h.leftmost) {
+        fprintf(stderr, "Validation error: internal page without leftmost child\n");
+        goto out;
+    }
+    int leaf_depth = validate_page(tree, node->h.leftmost, lo, lo_len,
+                                   count ? keys : hi, count ? lens[0] : hi_len,
+                                   depth + 1, expected_depth);
+    for (int i = 0; i < count && leaf_depth != -1; i++) {
+        unsigned char *k = keys + (size_t)i * (plen + SBTREE_MAX_KEY);
+        const unsigned char *next = (i + 1 < count) ? k + plen + SBTREE_MAX_KEY : hi;
+        size_t next_len = (i + 1 < count) ? lens[i + 1] : hi_len;
+        leaf_depth = validate_page(tree, slot_child(node, i), k, lens[i],
+                                   next, next_len, depth + 1, leaf_depth);
+    }
+    result = leaf_depth;
+
+out:
+    free(keys);
+    free(lens);
+    return result;
+}
+
+/*
+ * sbtree_validate - Verify ordering, separators and balance
+ *
+ * Returns: 1 if valid, 0 if invalid
+ */
+int sbtree_validate(SBTree *tree) {
+    if (!tree || !tree->root) return 0;
+    int depth = validate_page(tree, tree->root, NULL, 0, NULL, 0, 1, -1);
+    if (depth != -1 && depth != tree->height) {
+        fprintf(stderr, "Validation error: height %d, leaves at %d\n",
+                tree->height, depth);
+        return 0;
+    }
+    return depth != -1;
+}
+
+static void stats_page(SBTree *tree, SBTreeNode *node, SBTreeStats *stats) {
+    size_t plen = node->h.prefix_len;
+
+    stats->pages++;
+    stats->used_bytes += tree->page_size - free_space(node);
+    if (node->h.count > 0) stats->prefix_saved += plen * (node->h.count - 1);
+
+    if (node->h.is_leaf) {
+        stats->leaf_pages++;
+        for (int i = 0; i < node->h.count; i++) {
+            stats->raw_key_bytes += plen + node->slots[i].len;
+        }
+        return;
+    }
+    stats_page(tree, node->h.leftmost, stats);
+    for (int i = 0; i < node->h.count; i++) {
+        stats_page(tree, slot_child(node, i), stats);
+    }
+}
+
+/*
+ * sbtree_stats - Page counts and byte usage of the whole tree
+ */
+void sbtree_stats(SBTree *tree, SBTreeStats *stats) {
+    memset(stats, 0, sizeof(*stats));
+    if (!tree) return;
+    stats_page(tree, tree->root, stats);
+    stats->keys = tree->keys;
+    stats->height = tree->height;
+}
@@ -0,0 +1,71 @@
+/* ============================================================
+ * String-Key B+-Tree with Slotted-Page Nodes
+ * ============================================================
+ * Variable-length byte-string keys (URLs, identifiers) stored in
+ * fixed-size pages. Unlike b-tree.h, keys live only in leaves, so
+ * internal separators are free to be shortened.
+ *
+ * Page layout:
+ *
+ *   [header][slot 0][slot 1] ...  -> free <-  ... [heap: key bytes]
+ *
+ *   - slot:   {head, offset, length} kept in key order; head is the
+ *             first 4 suffix bytes packed big-endian, so most
+ *             comparisons finish on one integer compare
+ *   - heap:   key suffixes (plus a child pointer in internal nodes),
+ *             growing down from the end of the page
+ *   - prefix: bytes shared by every key in the page are stored once;
+ *             slots only hold what follows them
+ *
+ * Splits choose the byte-balanced midpoint. A leaf split promotes the
+ * shortest separator that still divides the two halves (suffix
+ * truncation), e.g. "example.com/abc" | "example.com/b" -> "example.com/b".
+ *
+ * [x] sbtree_create / sbtree_destroy
+ * [x] sbtree_insert (set semantics: returns 1 added, 0 duplicate,
+ *     -1 key too long / out of memory)
+ * [x] sbtree_contains
+ * [x] sbtree_validate / sbtree_stats
+ * ============================================================ */
+
+#ifndef B_TREE_STRING_H
+#define B_TREE_STRING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define SBTREE_MIN_PAGE 1024
+#define SBTREE_MAX_PAGE 32768   /* Offsets are 16-bit */
+#define SBTREE_MAX_KEY  1024    /* Hard cap; also limited to page_size/8 */
+
+typedef struct SBTreeNode SBTreeNode;  /* One page; layout is private */
+
+typedef struct SBTree {
+    SBTreeNode *root;
+    size_t page_size;
+    size_t max_key_len;  /* Longer keys are rejected (keeps fan-out >= 4) */
+    long keys;
+    long pages;
+    int height;
+} SBTree;
+
+typedef struct SBTreeStats {
+    long keys;
+    long pages;
+    long leaf_pages;
+    int height;
+    size_t used_bytes;      /* Page bytes holding headers, slots and keys */
+    size_t raw_key_bytes;   /* Sum of key lengths as inserted */
+    size_t prefix_saved;    /* Key bytes elided by per-page prefixes */
+} SBTreeStats;
+
+SBTree *sbtree_create(size_t page_size);
+void sbtree_destroy(SBTree *tree);
+
+int sbtree_insert(SBTree *tree, const char *key, size_t len);
+bool sbtree_contains(SBTree *tree, const char *key, size_t len);
+
+int sbtree_validate(SBTree *tree);
+void sbtree_stats(SBTree *tree, SBTreeStats *stats);
+
+#endif /* B_TREE_STRING_H */
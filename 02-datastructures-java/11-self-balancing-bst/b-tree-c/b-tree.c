@@ -6,9 +6,20 @@
  */
 
 #include "b-tree.h"
+#include <errno.h>
 #include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 /* Enable/disable trace logging for debugging */
 #define TRACE_SPLIT 0
@@ -18,10 +29,13 @@
  * INTERNAL HELPER FUNCTIONS (Static)
  * ================================================================ */
 
-static BTreeNode *create_node(int t, bool is_leaf);
+static BTreeNode *create_node(int t, bool is_leaf, BTreeNode *near);
+static void free_node(BTreeNode *node);
 static void destroy_node(BTreeNode *node);
 static void split_child(BTreeNode *parent, int i, int t);
-static void insert_non_full(BTreeNode *node, int key, int t);
+static bool insert_non_full(BTreeNode *node, int key, int t, bool bstar,
+                            bool unique);
+static bool make_room(BTreeNode *parent, int i, int t);
 
 /* Result of fill() operation - indicates what action was taken */
 typedef enum {
@@ -32,17 +46,36 @@ typedef enum {
 
 /* Delete helper functions */
 static int find_key(BTreeNode *node, int key);
-static int get_predecessor(BTreeNode *node, int idx);
-static int get_successor(BTreeNode *node, int idx);
+static int get_predecessor(BTreeNode *node, int idx, int *count);
+static int get_successor(BTreeNode *node, int idx, int *count);
 static void merge(BTreeNode *node, int idx, int t);
-static void borrow_from_left(BTreeNode *node, int idx);
-static void borrow_from_right(BTreeNode *node, int idx);
+static void borrow_from_left(BTreeNode *node, int idx, int k);
+static void borrow_from_right(BTreeNode *node, int idx, int k);
 static FillResult fill(BTreeNode *node, int idx, int t);
-static void delete_internal(BTreeNode *node, int key, int t);
+static bool delete_internal(BTreeNode *node, int key, int t);
+
+/* Fence index helper functions */
+static int fence_slots(int t);
+static void fence_update(BTreeNode *node, int from);
+static int node_lower_bound(BTreeNode *node, int key);
+static int node_upper_bound(BTreeNode *node, int key);
+
+/* Aggregate helper functions */
+static void agg_refresh(BTreeNode *parent, int i);
+static void agg_move(BTreeNode *dst, int to, BTreeNode *src, int from, int count);
 
 /* Utility helper functions */
 static int count_node(BTreeNode *node);
 
+/* Bulk build helper functions */
+static BTreeNode *build_levels(BTreeNode **nodes, int *seps, size_t count,
+                               int t);
+
+/* Persistence helper functions */
+static size_t count_nodes(BTreeNode *node);
+static int write_all(int fd, const void *buf, size_t len);
+static unsigned char *read_image(int fd, size_t *out_len);
+
 /* ---------- Trace/Debug Logging ---------- */
 
 #if TRACE_SPLIT
@@ -97,39 +130,259 @@ static void log_borrow_right(int borrowed, int idx) {
 #define log_borrow_right(borrowed, idx) ((void)0)
 #endif
 
+/* ================================================================
+ * NODE ARENA (HUGE-PAGE BACKED)
+ *
+ * With malloc, every node is three scattered allocations, so a lookup
+ * on a large tree touches a new 4 KiB page (and TLB entry) per level.
+ * The arena instead reserves one large virtual region, asks for
+ * transparent huge pages, and carves fixed-size slots holding the node
+ * header, keys and children back to back:
+ *
+ *   2 MiB chunk: [ChunkHeader][slot][slot][slot] ...
+ *   slot:        [BTreeNode][keys: 2t-1 ints][children: 2t ptrs]
+ *
+ * Chunks are 2 MiB aligned, so any node finds its chunk (and arena)
+ * by masking its address - free_node() needs no tree pointer. When a
+ * caller passes a "near" node, the new slot is taken from near's chunk
+ * if it has room, which keeps split siblings (and a split root with
+ * its children) under the same huge-page TLB entry.
+ *
+ * The arena is single-threaded, like the rest of the insert/delete
+ * path.
+ * ================================================================ */
+
+#define ARENA_CHUNK_SIZE ((size_t)2 << 20)          /* One x86-64 huge page */
+#define ARENA_MAX_RESERVE ((size_t)64 << 30)        /* Virtual, not resident */
+#define ARENA_MIN_RESERVE ((size_t)64 << 20)
+#define ARENA_SLOT_ALIGN 64                          /* Cache line */
+
+typedef struct BTreeArena BTreeArena;
+
+typedef struct ChunkHeader {
+    BTreeArena *arena;
+    void *free_list;              /* Freed slots, linked through slot memory */
+    struct ChunkHeader *next_partial;
+    size_t bump;                  /* Offset of the first never-used byte */
+    bool in_partial;              /* On arena->partial list */
+} ChunkHeader;
+
+struct BTreeArena {
+    unsigned char *base;          /* Chunk-aligned start of the reservation */
+    void *mapping;                /* What mmap returned (for munmap) */
+    size_t mapping_size;
+    size_t chunk_count;
+    size_t chunks_used;           /* Chunks opened so far */
+    size_t slot_size;
+    size_t keys_offset, children_offset;
+    int t;
+    ChunkHeader *current;         /* Chunk served by default */
+    ChunkHeader *partial;         /* Older chunks that regained free slots */
+};
+
+#define CHUNK_HEADER_SIZE \
+    ((sizeof(ChunkHeader) + ARENA_SLOT_ALIGN - 1) & ~(size_t)(ARENA_SLOT_ALIGN - 1))
+
+static ChunkHeader *chunk_of(const void *p) {
+    return (ChunkHeader *)((uintptr_t)p & ~(uintptr_t)(ARENA_CHUNK_SIZE - 1));
+}
+
+/*
+ * arena_create - Reserve address space for nodes of minimum degree t
+ *
+ * Tries ARENA_MAX_RESERVE first and halves on failure; only pages that
+ * are actually touched become resident.
+ *
+ * Returns: new arena, or NULL if no reservation could be made
+ */
+static BTreeArena *arena_create(int t) {
+    BTreeArena *arena = (BTreeArena *)calloc(1, sizeof(BTreeArena));
+    if (!arena) return NULL;
+
+    size_t align = sizeof(void *);
+    arena->t = t;
+    arena->keys_offset = (sizeof(BTreeNode) + align - 1) & ~(align - 1);
+    arena->children_offset = (arena->keys_offset + (2 * (size_t)t - 1) * sizeof(int)
+                              + align - 1) & ~(align - 1);
+    arena->slot_size = (arena->children_offset + 2 * (size_t)t * sizeof(BTreeNode *)
+                        + ARENA_SLOT_ALIGN - 1) & ~(size_t)(ARENA_SLOT_ALIGN - 1);
+    if (CHUNK_HEADER_SIZE + arena->slot_size > ARENA_CHUNK_SIZE) {
+        fprintf(stderr, "Error: t=%d nodes do not fit an arena chunk\n", t);
+        free(arena);
+        return NULL;
+    }
+
+    for (size_t reserve = ARENA_MAX_RESERVE; reserve >= ARENA_MIN_RESERVE;
+         reserve /= 2) {
+        /* Over-map by one chunk so the start can be rounded up to 2 MiB */
+        size_t size = reserve + ARENA_CHUNK_SIZE;
+        void *map = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (map == MAP_FAILED) continue;
+
+        uintptr_t aligned = ((uintptr_t)map + ARENA_CHUNK_SIZE - 1)
+                            & ~(uintptr_t)(ARENA_CHUNK_SIZE - 1);
+        arena->base = (unsigned char *)aligned;
+        arena->mapping = map;
+        arena->mapping_size = size;
+        arena->chunk_count = reserve / ARENA_CHUNK_SIZE;
+#ifdef MADV_HUGEPAGE
+        madvise(arena->base, reserve, MADV_HUGEPAGE);  /* Best effort */
+#endif
+        return arena;
+    }
+
+    free(arena);
+    return NULL;
+}
+
+static void arena_destroy(BTreeArena *arena) {
+    if (!arena) return;
+    munmap(arena->mapping, arena->mapping_size);
+    free(arena);
+}
+
+/* chunk_take - Pop a free slot or bump-allocate one; NULL if chunk full */
+static void *chunk_take(BTreeArena *arena, ChunkHeader *chunk) {
+    if (chunk->free_list) {
+        void *slot = chunk->free_list;
+        chunk->free_list = *(void **)slot;
+        return slot;
+    }
+    if (chunk->bump + arena->slot_size <= ARENA_CHUNK_SIZE) {
+        void *slot = (unsigned char *)chunk + chunk->bump;
+        chunk->bump += arena->slot_size;
+        return slot;
+    }
+    return NULL;
+}
+
+/*
+ * arena_alloc - Take a slot, preferring the chunk that holds @near
+ *
+ * Order: near's chunk -> chunks with freed slots -> current chunk ->
+ * a fresh chunk.
+ */
+static void *arena_alloc(BTreeArena *arena, BTreeNode *near) {
+    void *slot;
+    if (near && near->in_arena) {
+        slot = chunk_take(arena, chunk_of(near));
+        if (slot) return slot;
+    }
+
+    while (arena->partial) {
+        ChunkHeader *chunk = arena->partial;
+        arena->partial = chunk->next_partial;
+        chunk->in_partial = false;
+        slot = chunk_take(arena, chunk);
+        if (slot) {
+            /* Keep serving it until its free list runs dry */
+            if (chunk->free_list) {
+                chunk->next_partial = arena->partial;
+                arena->partial = chunk;
+                chunk->in_partial = true;
+            }
+            return slot;
+        }
+    }
+
+    if (arena->current) {
+        slot = chunk_take(arena, arena->current);
+        if (slot) return slot;
+    }
+
+    if (arena->chunks_used == arena->chunk_count) return NULL;
+    ChunkHeader *chunk = (ChunkHeader *)(arena->base +
+                                         arena->chunks_used++ * ARENA_CHUNK_SIZE);
+    chunk->arena = arena;
+    chunk->free_list = NULL;
+    chunk->next_partial = NULL;
+    chunk->bump = CHUNK_HEADER_SIZE;
+    chunk->in_partial = false;
+    arena->current = chunk;
+    return chunk_take(arena, chunk);
+}
+
+static void arena_free(BTreeNode *node) {
+    ChunkHeader *chunk = chunk_of(node);
+    BTreeArena *arena = chunk->arena;
+
+    *(void **)node = chunk->free_list;
+    chunk->free_list = node;
+    if (!chunk->in_partial && chunk != arena->current) {
+        chunk->next_partial = arena->partial;
+        arena->partial = chunk;
+        chunk->in_partial = true;
+    }
+}
+
 /* ================================================================
  * NODE CREATION / DESTRUCTION
  * ================================================================ */
 
 /*
- * create_node - Allocate and initialize a new B-Tree node
- * 
- * @t: minimum degree of the tree
- * @is_leaf: whether this node is a leaf
- * 
+ * alloc_node - Allocate and initialize a node from @arena, or from
+ *              malloc when @arena is NULL
+ *
  * Memory layout:
  *   keys[0..2t-2]      -> max 2t-1 keys
  *   children[0..2t-1]  -> max 2t children
- * 
+ *   counts[0..2t-2]    -> multiplicity per key (multimap trees only;
+ *                         arena trees are sets, so never with @arena)
+ *   fences[..]         -> one per BTREE_FENCE_STRIDE keys (fenced trees
+ *                         only, never with @arena)
+ *   aggs[0..2t-1]      -> summary per child (internal nodes of aggregate
+ *                         trees only, never with @arena)
+ *
  * Returns: pointer to newly allocated node, or NULL on failure
  */
-static BTreeNode *create_node(int t, bool is_leaf) {
-    BTreeNode *node = (BTreeNode *)malloc(sizeof(BTreeNode));
-    if (!node) return NULL;
-
-    /* Allocate arrays for keys and children */
-    node->keys = (int *)malloc((2 * t - 1) * sizeof(int));
-    node->children = (BTreeNode **)malloc(2 * t * sizeof(BTreeNode *));
-    
-    if (!node->keys || !node->children) {
-        free(node->keys);
-        free(node->children);
-        free(node);
-        return NULL;
+static BTreeNode *alloc_node(BTreeArena *arena, int t, bool is_leaf,
+                             BTreeNode *near, bool with_counts,
+                             bool with_fences, bool aggregated) {
+    BTreeNode *node;
+    bool with_aggs = aggregated && !is_leaf;
+
+    if (arena) {
+        unsigned char *slot = (unsigned char *)arena_alloc(arena, near);
+        if (!slot) return NULL;
+
+        node = (BTreeNode *)slot;
+        node->keys = (int *)(slot + arena->keys_offset);
+        node->children = (BTreeNode **)(slot + arena->children_offset);
+        node->counts = NULL;
+        node->fences = NULL;
+        node->aggs = NULL;
+        node->in_arena = true;
+    } else {
+        node = (BTreeNode *)malloc(sizeof(BTreeNode));
+        if (!node) return NULL;
+
+        /* Allocate arrays for keys and children */
+        node->keys = (int *)malloc((2 * t - 1) * sizeof(int));
+        node->children = (BTreeNode **)malloc(2 * t * sizeof(BTreeNode *));
+        node->counts = with_counts ? (int *)malloc((2 * t - 1) * sizeof(int))
+                                   : NULL;
+        node->fences = with_fences ? (int *)malloc(fence_slots(t) * sizeof(int))
+                                   : NULL;
+        node->aggs = with_aggs ? (BTreeAggregate *)malloc(2 * t * sizeof(BTreeAggregate))
+                               : NULL;
+
+        if (!node->keys || !node->children || (with_counts && !node->counts) ||
+            (with_fences && !node->fences) || (with_aggs && !node->aggs)) {
+            free(node->keys);
+            free(node->children);
+            free(node->counts);
+            free(node->fences);
+            free(node->aggs);
+            free(node);
+            return NULL;
+        }
+        node->in_arena = false;
     }
 
     node->n = 0;
     node->is_leaf = is_leaf;
+    node->aggregated = aggregated;
 
     /* Initialize all child pointers to NULL */
     for (int i = 0; i < 2 * t; i++) {
@@ -139,6 +392,41 @@ static BTreeNode *create_node(int t, bool is_leaf) {
     return node;
 }
 
+/*
+ * create_node - Allocate and initialize a new B-Tree node
+ *
+ * @t: minimum degree of the tree
+ * @is_leaf: whether this node is a leaf
+ * @near: existing node of the same tree, or NULL. The new node takes
+ *        the same representation: if @near lives in an arena it comes
+ *        from that arena (close to @near), and if @near carries counts
+ *        (multimap) so does the new node; likewise for fences. Nodes of
+ *        an aggregate tree get aggs[] when internal.
+ *
+ * Returns: pointer to newly allocated node, or NULL on failure
+ */
+static BTreeNode *create_node(int t, bool is_leaf, BTreeNode *near) {
+    BTreeArena *arena = (near && near->in_arena) ? chunk_of(near)->arena : NULL;
+    return alloc_node(arena, t, is_leaf, near, near && near->counts,
+                      near && near->fences, near && near->aggregated);
+}
+
+/*
+ * free_node - Release a single node (no recursion)
+ */
+static void free_node(BTreeNode *node) {
+    if (node->in_arena) {
+        arena_free(node);
+        return;
+    }
+    free(node->keys);
+    free(node->children);
+    free(node->counts);
+    free(node->fences);
+    free(node->aggs);
+    free(node);
+}
+
 /*
  * destroy_node - Recursively free a node and all its descendants
  * 
@@ -154,9 +442,213 @@ static void destroy_node(BTreeNode *node) {
         }
     }
 
-    free(node->keys);
-    free(node->children);
-    free(node);
+    free_node(node);
+}
+
+/* ================================================================
+ * IN-NODE SEARCH (FENCE INDEX)
+ *
+ * With t in the hundreds or thousands, a node's keys[] spans dozens of
+ * cache lines and searching it dominates a lookup. A fenced node also
+ * keeps fences[j] = keys[16j], a small sorted sample of its keys:
+ *
+ *   keys:    [k0 .. k15][k16 .. k31][k32 .. k47] ...
+ *   fences:  [k0,        k16,        k32, ...]
+ *
+ * Search narrows the fences to one 16-entry window by binary search,
+ * counts that window with SIMD compares, then counts one 16-key block
+ * of keys[] the same way: one or two lines of keys instead of log2(n).
+ *
+ * Every change to keys[i..] is followed by fence_update(node, i); only
+ * fences from i/16 onward are rewritten.
+ * ================================================================ */
+
+static int fence_slots(int t) {
+    return (2 * t - 1 + BTREE_FENCE_STRIDE - 1) / BTREE_FENCE_STRIDE;
+}
+
+/*
+ * fence_update - Refresh fences after keys[from..n-1] changed
+ *
+ * No-op for nodes without fences, so callers need not check.
+ */
+static void fence_update(BTreeNode *node, int from) {
+    if (!node->fences) return;
+    if (from < 0) from = 0;
+    for (int j = from / BTREE_FENCE_STRIDE; j * BTREE_FENCE_STRIDE < node->n; j++) {
+        node->fences[j] = node->keys[j * BTREE_FENCE_STRIDE];
+    }
+}
+
+/*
+ * count_below - Number of a[0..m-1] that are < key (@inclusive: <= key)
+ *
+ * a[] is sorted, so the count is also the insertion position.
+ */
+static int count_below(const int *a, int m, int key, bool inclusive) {
+    int c = 0, i = 0;
+#if defined(__SSE2__)
+    __m128i k = _mm_set1_epi32(key);
+    for (; i + 4 <= m; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(a + i));
+        /* inclusive: !(v > key); strict: key > v */
+        __m128i gt = inclusive ? _mm_cmpgt_epi32(v, k) : _mm_cmpgt_epi32(k, v);
+        int bits = __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(gt)));
+        c += inclusive ? 4 - bits : bits;
+    }
+#endif
+    for (; i < m; i++) {
+        c += inclusive ? a[i] <= key : a[i] < key;
+    }
+    return c;
+}
+
+/* fenced_bound - Lower (or upper, if @inclusive) bound via the fences */
+static int fenced_bound(BTreeNode *node, int key, bool inclusive) {
+    int nf = (node->n + BTREE_FENCE_STRIDE - 1) / BTREE_FENCE_STRIDE;
+
+    /* Narrow to a window of at most 16 fences, then count it */
+    int lo = 0, hi = nf;
+    while (hi - lo > BTREE_FENCE_STRIDE) {
+        int mid = lo + (hi - lo) / 2;
+        if (inclusive ? node->fences[mid] <= key : node->fences[mid] < key) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    int c = lo + count_below(node->fences + lo, hi - lo, key, inclusive);
+
+    /* fences[c-1] is below key and fences[c] is not: answer is in block c-1 */
+    if (c == 0) return 0;
+    int start = (c - 1) * BTREE_FENCE_STRIDE + 1;
+    int end = c * BTREE_FENCE_STRIDE < node->n ? c * BTREE_FENCE_STRIDE : node->n;
+    return start + count_below(node->keys + start, end - start, key, inclusive);
+}
+
+/*
+ * node_lower_bound - First index with keys[i] >= key (n if none)
+ */
+static int node_lower_bound(BTreeNode *node, int key) {
+    if (node->fences) return fenced_bound(node, key, false);
+    int i = 0;
+    while (i < node->n && node->keys[i] < key) {
+        i++;
+    }
+    return i;
+}
+
+/*
+ * node_upper_bound - First index with keys[i] > key (n if none)
+ */
+static int node_upper_bound(BTreeNode *node, int key) {
+    if (node->fences) return fenced_bound(node, key, true);
+    int i = node->n;
+    while (i > 0 && node->keys[i - 1] > key) {
+        i--;
+    }
+    return i;
+}
+
+/* ================================================================
+ * AGGREGATES
+ *
+ * In an aggregate tree, internal node X keeps aggs[i] = summary of
+ * every key in the subtree under X->children[i]. A node's own summary
+ * is then its keys plus its aggs[], so refreshing one entry costs O(t)
+ * and never looks further down:
+ *
+ *            [ 20 | 40 ]           aggs: {2, 15, 5, 10}
+ *            /    |    \                {2, 63, 30, 33}
+ *      [5 10] [30 33] [50]                {1, 50, 50, 50}
+ *
+ * Wherever child pointers move between nodes, their aggs[] entries
+ * move with them (agg_move); the nodes whose key sets change are then
+ * re-summarized from their own arrays (agg_refresh).
+ * ================================================================ */
+
+static const BTreeAggregate AGG_EMPTY = { 0, 0, INT_MAX, INT_MIN };
+
+static void agg_add_key(BTreeAggregate *a, int key) {
+    a->count++;
+    a->sum += key;
+    if (key < a->min) a->min = key;
+    if (key > a->max) a->max = key;
+}
+
+static void agg_merge(BTreeAggregate *a, const BTreeAggregate *b) {
+    a->count += b->count;
+    a->sum += b->sum;
+    if (b->min < a->min) a->min = b->min;
+    if (b->max > a->max) a->max = b->max;
+}
+
+/*
+ * agg_of - Summary of the whole subtree under @node
+ *
+ * Uses the node's keys and its per-child summaries: O(t).
+ */
+static BTreeAggregate agg_of(const BTreeNode *node) {
+    BTreeAggregate a = AGG_EMPTY;
+    for (int i = 0; i < node->n; i++) {
+        agg_add_key(&a, node->keys[i]);
+    }
+    if (!node->is_leaf) {
+        for (int i = 0; i <= node->n; i++) {
+            agg_merge(&a, &node->aggs[i]);
+        }
+    }
+    return a;
+}
+
+/*
+ * agg_refresh - Recompute parent->aggs[i] after children[i] changed
+ */
+static void agg_refresh(BTreeNode *parent, int i) {
+    if (parent->aggs) parent->aggs[i] = agg_of(parent->children[i]);
+}
+
+/*
+ * agg_move - Carry @count summaries along with moved child pointers
+ *
+ * Same semantics as memmove of dst->aggs[to..] from src->aggs[from..];
+ * a no-op outside aggregate trees and for leaves.
+ */
+static void agg_move(BTreeNode *dst, int to, BTreeNode *src, int from, int count) {
+    if (dst->aggs && count > 0) {
+        memmove(&dst->aggs[to], &src->aggs[from], count * sizeof(BTreeAggregate));
+    }
+}
+
+/*
+ * agg_range - Add the keys of @node's subtree that lie in [lo, hi]
+ *
+ * @sub_lo, @sub_hi: bounds every key in the subtree is known to obey
+ *
+ * A child whose bounds fall inside [lo, hi] is taken from aggs[] in
+ * O(1); only the children straddling lo or hi are entered, so at most
+ * two root-to-leaf paths are walked. Without aggs[] every overlapping
+ * child is entered, i.e. the range is scanned.
+ */
+static void agg_range(const BTreeNode *node, int lo, int hi,
+                      long long sub_lo, long long sub_hi, BTreeAggregate *out) {
+    for (int i = node_lower_bound((BTreeNode *)node, lo); i <= node->n; i++) {
+        long long c_lo = (i > 0) ? node->keys[i - 1] : sub_lo;
+        long long c_hi = (i < node->n) ? node->keys[i] : sub_hi;
+        if (c_lo > hi) break;
+
+        if (!node->is_leaf) {
+            if (node->aggs && lo <= c_lo && c_hi <= hi) {
+                agg_merge(out, &node->aggs[i]);
+            } else {
+                agg_range(node->children[i], lo, hi, c_lo, c_hi, out);
+            }
+        }
+        if (i < node->n) {
+            if (node->keys[i] > hi) break;
+            agg_add_key(out, node->keys[i]);
+        }
+    }
 }
 
 /* ================================================================
@@ -185,7 +677,9 @@ BTree *btree_create(int t) {
     if (!tree) return NULL;
 
     tree->t = t;
-    tree->root = create_node(t, true);  /* Start with empty leaf as root */
+    tree->bstar = false;
+    tree->writes = 0;
+    tree->root = create_node(t, true, NULL);  /* Start with empty leaf as root */
     
     if (!tree->root) {
         free(tree);
@@ -195,12 +689,135 @@ BTree *btree_create(int t) {
     return tree;
 }
 
+/*
+ * btree_create_arena - Create an empty B-Tree whose nodes live in a
+ *                      huge-page arena (see NODE ARENA above)
+ *
+ * Behaves exactly like btree_create otherwise. Every later node is
+ * allocated near an existing one, so the arena follows from the root.
+ *
+ * Returns: new tree, or NULL if t is invalid or no arena can be mapped
+ */
+BTree *btree_create_arena(int t) {
+    BTree *tree = btree_create(t);
+    if (!tree) return NULL;
+
+    BTreeArena *arena = arena_create(t);
+    if (!arena) {
+        btree_destroy(tree);
+        return NULL;
+    }
+
+    BTreeNode *root = alloc_node(arena, t, true, NULL, false, false, false);
+    if (!root) {
+        arena_destroy(arena);
+        btree_destroy(tree);
+        return NULL;
+    }
+
+    free_node(tree->root);
+    tree->root = root;
+    return tree;
+}
+
+/*
+ * btree_create_multimap - Create an empty B-Tree that keeps duplicates
+ *
+ * Each distinct key is stored once with a multiplicity in the node's
+ * counts[] array (run-length encoding), so a heavy-hitter key costs one
+ * slot no matter how often it is inserted. Node structure and all
+ * invariants are those of the set tree; only the payload differs.
+ *
+ *   btree_insert: increments the count of an existing key
+ *   btree_delete: removes one occurrence (the entry goes at count 0)
+ *   btree_count:  number of distinct keys (entries)
+ *   btree_count_key / btree_equal_range: multiplicity lookups
+ */
+BTree *btree_create_multimap(int t) {
+    BTree *tree = btree_create(t);
+    if (!tree) return NULL;
+
+    BTreeNode *root = alloc_node(NULL, t, true, NULL, true, false, false);
+    if (!root) {
+        btree_destroy(tree);
+        return NULL;
+    }
+    free_node(tree->root);
+    tree->root = root;
+    return tree;
+}
+
+/*
+ * btree_create_fenced - Create an empty B-Tree with fenced nodes
+ *
+ * Meant for large t (256 and up), where in-node search dominates; see
+ * IN-NODE SEARCH above. Costs one int per 16 keys of extra space and a
+ * fence refresh on every node modification.
+ */
+BTree *btree_create_fenced(int t) {
+    BTree *tree = btree_create(t);
+    if (!tree) return NULL;
+
+    BTreeNode *root = alloc_node(NULL, t, true, NULL, false, true, false);
+    if (!root) {
+        btree_destroy(tree);
+        return NULL;
+    }
+    free_node(tree->root);
+    tree->root = root;
+    return tree;
+}
+
+/*
+ * btree_create_bstar - Create an empty B-Tree with the B* insert policy
+ *
+ * A full child is split only when its siblings are full too: first it
+ * hands keys to a sibling with room, and two full siblings become three
+ * nodes about 2/3 full (see make_room). Node structure, search and
+ * delete are unchanged; only where insert puts keys differs.
+ */
+BTree *btree_create_bstar(int t) {
+    BTree *tree = btree_create(t);
+    if (tree) tree->bstar = true;
+    return tree;
+}
+
+/*
+ * btree_create_aggregate - Create an empty B-Tree with subtree summaries
+ *
+ * Every internal node stores, for each child, the count, sum, min and
+ * max of the keys in that child's subtree (see AGGREGATES below), so
+ * btree_range_aggregate() can take whole subtrees in O(1). Inserts add
+ * the key to each summary on the way down; deletes, splits, merges and
+ * borrows recompute the summaries of the nodes they touch, O(t) each.
+ * Keys are summed as themselves: the tree stores no separate values.
+ */
+BTree *btree_create_aggregate(int t) {
+    BTree *tree = btree_create(t);
+    if (!tree) return NULL;
+
+    BTreeNode *root = alloc_node(NULL, t, true, NULL, false, false, true);
+    if (!root) {
+        btree_destroy(tree);
+        return NULL;
+    }
+    free_node(tree->root);
+    tree->root = root;
+    return tree;
+}
+
 /*
  * btree_destroy - Free all memory associated with the tree
+ *
+ * An arena-backed tree is released in one munmap, without walking it.
  */
 void btree_destroy(BTree *tree) {
     if (!tree) return;
-    destroy_node(tree->root);
+    if (tree->root && tree->root->in_arena) {
+        arena_destroy(chunk_of(tree->root)->arena);
+    } else {
+        destroy_node(tree->root);
+    }
     free(tree);
 }
 
@@ -240,7 +857,7 @@ static void split_child(BTreeNode *parent, int i, int t) {
     BTreeNode *full_child = parent->children[i];
     
     /* Create new node for the right half of the split */
-    BTreeNode *new_child = create_node(t, full_child->is_leaf);
+    BTreeNode *new_child = create_node(t, full_child->is_leaf, full_child);
     new_child->n = t - 1;
 
     /* 
@@ -252,6 +869,7 @@ static void split_child(BTreeNode *parent, int i, int t) {
      */
     for (int j = 0; j < t - 1; j++) {
         new_child->keys[j] = full_child->keys[j + t];
+        if (full_child->counts) new_child->counts[j] = full_child->counts[j + t];
     }
 
     /* If not a leaf, also copy the corresponding child pointers */
@@ -259,10 +877,12 @@ static void split_child(BTreeNode *parent, int i, int t) {
         for (int j = 0; j < t; j++) {
             new_child->children[j] = full_child->children[j + t];
         }
+        agg_move(new_child, 0, full_child, t, t);
     }
 
     /* The original child now only has the lower t-1 keys */
     full_child->n = t - 1;
+    fence_update(new_child, 0);
 
     /* 
      * Make room in parent for the new child pointer
@@ -271,6 +891,7 @@ static void split_child(BTreeNode *parent, int i, int t) {
     for (int j = parent->n; j >= i + 1; j--) {
         parent->children[j + 1] = parent->children[j];
     }
+    agg_move(parent, i + 2, parent, i + 1, parent->n - i);
     parent->children[i + 1] = new_child;
 
     /* 
@@ -279,86 +900,284 @@ static void split_child(BTreeNode *parent, int i, int t) {
      */
     for (int j = parent->n - 1; j >= i; j--) {
         parent->keys[j + 1] = parent->keys[j];
+        if (parent->counts) parent->counts[j + 1] = parent->counts[j];
     }
     
     /* Promote the median key to parent */
     parent->keys[i] = full_child->keys[t - 1];
+    if (parent->counts) parent->counts[i] = full_child->counts[t - 1];
     parent->n++;
+    fence_update(parent, i);
+    agg_refresh(parent, i);
+    agg_refresh(parent, i + 1);
 
     log_split(parent, i, parent->keys[i]);
 }
 
 /*
- * insert_non_full - Insert a key into a node that is guaranteed not full
- * 
- * @node: node to insert into (must have n < 2t-1)
- * @key: key to insert
+ * split_three - B* split: two (nearly) full siblings become three nodes
+ *
+ * @parent: parent node (must have room for one more key)
+ * @i: children[i] and children[i+1] hold at least 2t-2 keys each
  * @t: minimum degree
- * 
- * Two cases:
- * 1. Leaf node: directly insert key in sorted position
- * 2. Internal node: find correct child, split if full, then recurse
+ *
+ * The keys of both children plus their separator (4t-1 when both are
+ * full) are dealt out as [a keys] S1 [b keys] S2 [c keys] with a, b, c
+ * within one of each other (about 4t/3), so each node ends up about 2/3
+ * full instead of the half-full pair split_child leaves behind:
+ *
+ *          [.. P ..]                      [.. S1 S2 ..]
+ *           /     \          ->           /    |    \
+ *   [A B C D E] [F G H I J]          [A B C] [E P F] [H I J]
+ *                                   (S1 = D, S2 = G; t = 3)
  */
-static void insert_non_full(BTreeNode *node, int key, int t) {
-    int i = node->n - 1;  /* Start from rightmost key */
+static void split_three(BTreeNode *parent, int i, int t) {
+    BTreeNode *left = parent->children[i];
+    BTreeNode *right = parent->children[i + 1];
+    BTreeNode *mid = create_node(t, left->is_leaf, left);
+    int p_idx = left->n;                    /* Index of P in the sequence */
+    int total = left->n + right->n + 1;     /* Combined sequence, incl. P */
+    int a = (total - 2) / 3;
+    int b = (total - 2 - a) / 2;
+    int c = total - 2 - a - b;
+    int r0 = a + b + 2 - (p_idx + 1);       /* right->keys index of c-run */
+
+    log_split(parent, i, left->keys[a]);
 
-    if (node->is_leaf) {
-        /* 
-         * CASE 1: Leaf node
-         * Find the correct position and shift keys to make room
-         */
-        while (i >= 0 && node->keys[i] > key) {
-            node->keys[i + 1] = node->keys[i];
-            i--;
+    /*
+     * Sequence index j maps to left->keys[j] (j < p_idx), P (j == p_idx)
+     * or right->keys[j - p_idx - 1]. The middle node takes j = a+1 ..
+     * a+b: the tail of left, P, and the head of right.
+     */
+    for (int j = 0; j < b; j++) {
+        int src = a + 1 + j;
+        if (src < p_idx) {
+            mid->keys[j] = left->keys[src];
+            if (left->counts) mid->counts[j] = left->counts[src];
+        } else if (src == p_idx) {
+            mid->keys[j] = parent->keys[i];
+            if (parent->counts) mid->counts[j] = parent->counts[i];
+        } else {
+            mid->keys[j] = right->keys[src - p_idx - 1];
+            if (right->counts) mid->counts[j] = right->counts[src - p_idx - 1];
         }
-        node->keys[i + 1] = key;
-        node->n++;
-        
-        log_insert(key, true);
+    }
+    if (!left->is_leaf) {
+        /* Children follow the same split: a+1 | b+1 | c+1 */
+        for (int j = 0; j <= b; j++) {
+            int src = a + 1 + j;
+            mid->children[j] = src <= p_idx ? left->children[src]
+                                            : right->children[src - p_idx - 1];
+            if (src <= p_idx) {
+                agg_move(mid, j, left, src, 1);
+            } else {
+                agg_move(mid, j, right, src - p_idx - 1, 1);
+            }
+        }
+    }
+    mid->n = b;
+
+    /* Separators: S1 stays in left at index a; S2 is P or in right */
+    int s1 = left->keys[a];
+    int s1_count = left->counts ? left->counts[a] : 0;
+    int s2 = r0 > 0 ? right->keys[r0 - 1] : parent->keys[i];
+    int s2_count = !parent->counts ? 0 : r0 > 0 ? right->counts[r0 - 1]
+                                                : parent->counts[i];
+
+    memmove(&right->keys[0], &right->keys[r0], c * sizeof(int));
+    if (right->counts) {
+        memmove(&right->counts[0], &right->counts[r0], c * sizeof(int));
+    }
+    if (!right->is_leaf) {
+        memmove(&right->children[0], &right->children[r0],
+                (c + 1) * sizeof(BTreeNode *));
+        agg_move(right, 0, right, r0, c + 1);
+    }
+    left->n = a;
+    right->n = c;
+    fence_update(mid, 0);
+    fence_update(right, 0);
+
+    /* Parent: keys[i] = S1, new keys[i+1] = S2, mid between them */
+    memmove(&parent->keys[i + 2], &parent->keys[i + 1],
+            (parent->n - i - 1) * sizeof(int));
+    if (parent->counts) {
+        memmove(&parent->counts[i + 2], &parent->counts[i + 1],
+                (parent->n - i - 1) * sizeof(int));
+    }
+    memmove(&parent->children[i + 2], &parent->children[i + 1],
+            (parent->n - i) * sizeof(BTreeNode *));
+    agg_move(parent, i + 2, parent, i + 1, parent->n - i);
+    parent->keys[i] = s1;
+    parent->keys[i + 1] = s2;
+    if (parent->counts) {
+        parent->counts[i] = s1_count;
+        parent->counts[i + 1] = s2_count;
+    }
+    parent->children[i + 1] = mid;
+    parent->n++;
+    fence_update(parent, i);
+    for (int j = i; j <= i + 2; j++) agg_refresh(parent, j);
+}
+
+/*
+ * make_room - B* policy for a full child on the insert path
+ *
+ * @parent: parent node (not full)
+ * @i: index of the full child
+ * @t: minimum degree
+ *
+ * In order of preference:
+ *   1. a sibling has two or more free slots: move half the difference
+ *      across (one bulk borrow), so the next inserts here do not repeat
+ *      the shift and neither node is left full
+ *   2. otherwise both neighbours are (nearly) full: split_three with
+ *      one of them
+ *
+ * Returns: false if the child has no sibling (caller splits 50/50);
+ *          otherwise the child is no longer full and the caller must
+ *          re-route, since separators have changed
+ */
+static bool make_room(BTreeNode *parent, int i, int t) {
+    BTreeNode *child = parent->children[i];
+    BTreeNode *left = i > 0 ? parent->children[i - 1] : NULL;
+    BTreeNode *right = i < parent->n ? parent->children[i + 1] : NULL;
+
+    if (left && left->n < 2 * t - 2) {
+        borrow_from_right(parent, i - 1, (child->n - left->n + 1) / 2);
+        return true;
+    }
+    if (right && right->n < 2 * t - 2) {
+        borrow_from_left(parent, i + 1, (child->n - right->n + 1) / 2);
+        return true;
+    }
+    if (right) {
+        split_three(parent, i, t);
+        return true;
+    }
+    if (left) {
+        split_three(parent, i - 1, t);
+        return true;
+    }
+    return false;
+}
+
+/*
+ * insert_non_full - Insert a key into a node that is guaranteed not full
+ * 
+ * @node: node to insert into (must have n < 2t-1)
+ * @key: key to insert
+ * @t: minimum degree
+ * @unique: leave a key that is already present alone (set semantics)
+ * 
+ * Two cases:
+ * 1. Leaf node: directly insert key in sorted position
+ * 2. Internal node: find correct child, split if full, then recurse
+ *
+ * Returns false only when @unique found the key. Parent summaries are
+ * updated on the way back up, so a rejected key never reaches them.
+ */
+static bool insert_non_full(BTreeNode *node, int key, int t, bool bstar,
+                            bool unique) {
+    int i = node->n - 1;  /* Start from rightmost key */
+
+    if (node->is_leaf) {
+        /* 
+         * CASE 1: Leaf node
+         * Find the correct position and shift keys to make room
+         */
+        if (node->counts || unique) {
+            /* Multimap: an existing key only gains an occurrence */
+            int pos = find_key(node, key);
+            if (pos < node->n && node->keys[pos] == key) {
+                if (!node->counts) return false;
+                node->counts[pos]++;
+                return true;
+            }
+        }
+        if (node->fences) {
+            /* Fenced: locate via the fences, then one block move */
+            int pos = node_upper_bound(node, key);
+            memmove(&node->keys[pos + 1], &node->keys[pos],
+                    (node->n - pos) * sizeof(int));
+            i = pos - 1;
+        }
+        while (i >= 0 && node->keys[i] > key) {
+            node->keys[i + 1] = node->keys[i];
+            if (node->counts) node->counts[i + 1] = node->counts[i];
+            i--;
+        }
+        node->keys[i + 1] = key;
+        if (node->counts) node->counts[i + 1] = 1;
+        node->n++;
+        fence_update(node, i + 1);
+        
+        log_insert(key, true);
+        return true;
     } else {
         /* 
          * CASE 2: Internal node
          * Find the child which will receive the new key
          */
-        while (i >= 0 && node->keys[i] > key) {
-            i--;
+        i = node_upper_bound(node, key) - 1;
+        if ((node->counts || unique) && i >= 0 && node->keys[i] == key) {
+            if (!node->counts) return false;
+            node->counts[i]++;  /* Multimap: key is a separator here */
+            return true;
         }
         i++;  /* i is now the index of child to descend into */
 
+        /* B*: relieve a full child through its siblings, then re-route */
+        if (bstar && node->children[i]->n == 2 * t - 1 && make_room(node, i, t)) {
+            return insert_non_full(node, key, t, bstar, unique);
+        }
+
         /* If the child is full, split it first (PROACTIVE split) */
         if (node->children[i]->n == 2 * t - 1) {
             split_child(node, i, t);
             
             /* After split, the median key is at keys[i]
              * Decide which of the two children to descend into */
+            if ((node->counts || unique) && key == node->keys[i]) {
+                if (!node->counts) return false;
+                node->counts[i]++;  /* Multimap: key was the median */
+                return true;
+            }
             if (key > node->keys[i]) {
                 i++;
             }
         }
         
         /* Recursively insert into the (possibly new) child */
-        insert_non_full(node->children[i], key, t);
+        if (!insert_non_full(node->children[i], key, t, bstar, unique)) {
+            return false;
+        }
+        if (node->aggs) agg_add_key(&node->aggs[i], key);
+        return true;
     }
 }
 
 /*
- * btree_insert - Insert a key into the B-Tree
+ * insert_key - Shared body of btree_insert and btree_insert_unique
  * 
  * @tree: the B-Tree
  * @key: key to insert
+ * @unique: see insert_non_full
  * 
  * Special case: if root is full, we must create a new root first.
- * This is the ONLY case where tree height increases.
+ * This is the ONLY case where tree height increases. (B* trees split
+ * the root 50/50 as well: it has no siblings to share with.)
  */
-void btree_insert(BTree *tree, int key) {
-    if (!tree) return;
+static bool insert_key(BTree *tree, int key, bool unique) {
+    if (!tree) return false;
+    tree->writes++;
 
     BTreeNode *root = tree->root;
 
     /* Special case: root is full */
     if (root->n == 2 * tree->t - 1) {
         /* Create new root */
-        BTreeNode *new_root = create_node(tree->t, false);
+        BTreeNode *new_root = create_node(tree->t, false, root);
         new_root->children[0] = root;
 
         /* Split the old root */
@@ -366,16 +1185,45 @@ void btree_insert(BTree *tree, int key) {
         log_root_split(new_root->keys[0]);
 
         /* Decide which child of new root should receive the key */
+        tree->root = new_root;
+        if ((new_root->counts || unique) && new_root->keys[0] == key) {
+            if (!new_root->counts) return false;
+            new_root->counts[0]++;  /* Multimap: key was the median */
+            return true;
+        }
         int i = 0;
         if (new_root->keys[0] < key) {
             i++;
         }
-        insert_non_full(new_root->children[i], key, tree->t);
-
-        tree->root = new_root;
-    } else {
-        insert_non_full(root, key, tree->t);
+        if (!insert_non_full(new_root->children[i], key, tree->t,
+                             tree->bstar, unique)) {
+            return false;
+        }
+        if (new_root->aggs) agg_add_key(&new_root->aggs[i], key);
+        return true;
     }
+    return insert_non_full(root, key, tree->t, tree->bstar, unique);
+}
+
+/*
+ * btree_insert - Insert a key into the B-Tree
+ *
+ * A set tree stores a repeated key again; use btree_insert_unique to
+ * keep set semantics.
+ */
+void btree_insert(BTree *tree, int key) {
+    insert_key(tree, key, false);
+}
+
+/*
+ * btree_insert_unique - Insert a key unless it is already present
+ *
+ * Returns true if the key was added (a multimap always adds an
+ * occurrence). The duplicate check rides on the insert descent, so
+ * callers need no btree_search first.
+ */
+bool btree_insert_unique(BTree *tree, int key) {
+    return insert_key(tree, key, true);
 }
 
 /* ================================================================
@@ -392,7 +1240,7 @@ void btree_insert(BTree *tree, int key) {
  * Returns: pointer to node containing key, or NULL if not found
  *
  * Algorithm:
- * 1. Linear search through node->keys to find position
+ * 1. Search node->keys for the position (linear, or via fences)
  * 2. If key found, return this node
  * 3. If leaf reached, key doesn't exist
  * 4. Otherwise, recurse into appropriate child
@@ -401,10 +1249,7 @@ BTreeNode *btree_search(BTreeNode *node, int key, int *idx) {
     if (!node) return NULL;
 
     /* Find the first key >= search key */
-    int i = 0;
-    while (i < node->n && key > node->keys[i]) {
-        i++;
-    }
+    int i = node_lower_bound(node, key);
 
     /* Check if we found the key */
     if (i < node->n && key == node->keys[i]) {
@@ -421,6 +1266,51 @@ BTreeNode *btree_search(BTreeNode *node, int key, int *idx) {
     return btree_search(node->children[i], key, idx);
 }
 
+/*
+ * btree_count_key - Number of occurrences of @key, in O(t log n)
+ *
+ * Multimap trees report the stored count; set trees report 0 or 1.
+ */
+long btree_count_key(BTree *tree, int key) {
+    return btree_equal_range(tree, key, NULL, NULL);
+}
+
+/*
+ * btree_equal_range - Locate the run of entries equal to @key
+ *
+ * @node, @idx: receive the node and index holding the run (NULL if
+ *              absent). With run encoding all occurrences of a key share
+ *              one entry, so the range is a single slot plus a count.
+ *
+ * Returns: run length (occurrences of key), 0 if absent
+ */
+long btree_equal_range(BTree *tree, int key, BTreeNode **node, int *idx) {
+    int i = 0;
+    BTreeNode *found = tree ? btree_search(tree->root, key, &i) : NULL;
+
+    if (node) *node = found;
+    if (idx) *idx = found ? i : -1;
+    if (!found) return 0;
+    return found->counts ? found->counts[i] : 1;
+}
+
+/*
+ * btree_range_aggregate - Count, sum, min and max of keys in [lo, hi]
+ *
+ * O(t log n) on trees from btree_create_aggregate(); on any other tree
+ * the same walk visits every key in the range (the scan it replaces).
+ * Like btree_count, a multimap entry counts once.
+ *
+ * Returns: the summary; count 0 (min INT_MAX, max INT_MIN) if empty
+ */
+BTreeAggregate btree_range_aggregate(BTree *tree, int lo, int hi) {
+    BTreeAggregate out = AGG_EMPTY;
+    if (tree && tree->root && lo <= hi) {
+        agg_range(tree->root, lo, hi, INT_MIN, INT_MAX, &out);
+    }
+    return out;
+}
+
 /* ================================================================
  * DELETE OPERATION
  *
@@ -448,11 +1338,7 @@ BTreeNode *btree_search(BTreeNode *node, int key, int *idx) {
  * Returns: index i where keys[i] >= key, or n if key > all keys
  */
 static int find_key(BTreeNode *node, int key) {
-    int idx = 0;
-    while (idx < node->n && node->keys[idx] < key) {
-        idx++;
-    }
-    return idx;
+    return node_lower_bound(node, key);
 }
 
 /*
@@ -460,15 +1346,17 @@ static int find_key(BTreeNode *node, int key) {
  *
  * @node: internal node containing the key
  * @idx: index of the key whose predecessor we want
+ * @count: receives the predecessor's multiplicity (multimap trees)
  *
  * The predecessor is the rightmost key in the left subtree,
  * i.e., follow children[idx] and then always go right.
  */
-static int get_predecessor(BTreeNode *node, int idx) {
+static int get_predecessor(BTreeNode *node, int idx, int *count) {
     BTreeNode *cur = node->children[idx];
     while (!cur->is_leaf) {
         cur = cur->children[cur->n];
     }
+    if (cur->counts) *count = cur->counts[cur->n - 1];
     return cur->keys[cur->n - 1];
 }
 
@@ -477,15 +1365,17 @@ static int get_predecessor(BTreeNode *node, int idx) {
  *
  * @node: internal node containing the key
  * @idx: index of the key whose successor we want
+ * @count: receives the successor's multiplicity (multimap trees)
  *
  * The successor is the leftmost key in the right subtree,
  * i.e., follow children[idx+1] and then always go left.
  */
-static int get_successor(BTreeNode *node, int idx) {
+static int get_successor(BTreeNode *node, int idx, int *count) {
     BTreeNode *cur = node->children[idx + 1];
     while (!cur->is_leaf) {
         cur = cur->children[0];
     }
+    if (cur->counts) *count = cur->counts[0];
     return cur->keys[0];
 }
 
@@ -516,10 +1406,12 @@ static void merge(BTreeNode *node, int idx, int t) {
 
     /* Pull down the key from parent into left child */
     left->keys[t - 1] = node->keys[idx];
+    if (node->counts) left->counts[t - 1] = node->counts[idx];
 
     /* Copy all keys from right child to left child */
     for (int i = 0; i < right->n; i++) {
         left->keys[t + i] = right->keys[i];
+        if (right->counts) left->counts[t + i] = right->counts[i];
     }
 
     /* Copy all children from right child to left child (if not leaf) */
@@ -527,35 +1419,40 @@ static void merge(BTreeNode *node, int idx, int t) {
         for (int i = 0; i <= right->n; i++) {
             left->children[t + i] = right->children[i];
         }
+        agg_move(left, t, right, 0, right->n + 1);
     }
 
     /* Update key count of left child */
     left->n = 2 * t - 1;
+    fence_update(left, t - 1);
 
     /* Remove keys[idx] from parent by shifting */
     for (int i = idx; i < node->n - 1; i++) {
         node->keys[i] = node->keys[i + 1];
+        if (node->counts) node->counts[i] = node->counts[i + 1];
     }
 
     /* Remove children[idx+1] from parent by shifting */
     for (int i = idx + 1; i < node->n; i++) {
         node->children[i] = node->children[i + 1];
     }
+    agg_move(node, idx + 1, node, idx + 2, node->n - idx - 1);
     node->n--;
+    fence_update(node, idx);
+    agg_refresh(node, idx);
 
     /* Free the now-empty right child */
-    free(right->keys);
-    free(right->children);
-    free(right);
+    free_node(right);
 }
 
 /*
- * borrow_from_left - Borrow a key from left sibling through parent
+ * borrow_from_left - Borrow k keys from left sibling through parent
  *
  * @node: parent node
- * @idx: index of the child that needs a key
+ * @idx: index of the child that needs keys
+ * @k: keys to move (delete moves 1; B* insert moves several at once)
  *
- * Before:
+ * Before (k = 1):
  *     [..., P, ...]          <- parent, P = keys[idx-1]
  *        /     \
  *   [A B C]     [D]          <- sibling has extra, child needs key
@@ -564,44 +1461,63 @@ static void merge(BTreeNode *node, int idx, int t) {
  *     [..., C, ...]          <- C moved up to parent
  *        /     \
  *   [A B]       [P D]        <- P moved down to child
+ *
+ * For k > 1 the keys rotate the same way: P and the sibling's last
+ * k-1 keys go to the child, the sibling's k-th last key goes up.
  */
-static void borrow_from_left(BTreeNode *node, int idx) {
+static void borrow_from_left(BTreeNode *node, int idx, int k) {
     BTreeNode *child = node->children[idx];
     BTreeNode *sibling = node->children[idx - 1];
+    int from = sibling->n - k;  /* Sibling key that moves up */
 
-    log_borrow_left(sibling->keys[sibling->n - 1], idx);
+    log_borrow_left(sibling->keys[from], idx);
 
     /* Shift all keys in child to the right to make room at front */
-    for (int i = child->n - 1; i >= 0; i--) {
-        child->keys[i + 1] = child->keys[i];
+    memmove(&child->keys[k], &child->keys[0], child->n * sizeof(int));
+    if (child->counts) {
+        memmove(&child->counts[k], &child->counts[0], child->n * sizeof(int));
     }
 
     /* Shift all children in child to the right (if not leaf) */
     if (!child->is_leaf) {
-        for (int i = child->n; i >= 0; i--) {
-            child->children[i + 1] = child->children[i];
-        }
-        /* Move sibling's rightmost child to child's first position */
-        child->children[0] = sibling->children[sibling->n];
+        memmove(&child->children[k], &child->children[0],
+                (child->n + 1) * sizeof(BTreeNode *));
+        agg_move(child, k, child, 0, child->n + 1);
+        /* Move sibling's rightmost k children to child's front */
+        memcpy(&child->children[0], &sibling->children[from + 1],
+               k * sizeof(BTreeNode *));
+        agg_move(child, 0, sibling, from + 1, k);
     }
 
-    /* Move parent's key down to child's first position */
-    child->keys[0] = node->keys[idx - 1];
+    /* Move parent's key down, after the sibling's last k-1 keys */
+    memcpy(&child->keys[0], &sibling->keys[from + 1], (k - 1) * sizeof(int));
+    child->keys[k - 1] = node->keys[idx - 1];
+    if (node->counts) {
+        memcpy(&child->counts[0], &sibling->counts[from + 1],
+               (k - 1) * sizeof(int));
+        child->counts[k - 1] = node->counts[idx - 1];
+    }
 
-    /* Move sibling's last key up to parent */
-    node->keys[idx - 1] = sibling->keys[sibling->n - 1];
+    /* Move sibling's key up to parent */
+    node->keys[idx - 1] = sibling->keys[from];
+    if (node->counts) node->counts[idx - 1] = sibling->counts[from];
 
-    child->n++;
-    sibling->n--;
+    child->n += k;
+    sibling->n -= k;
+    fence_update(child, 0);
+    fence_update(node, idx - 1);
+    agg_refresh(node, idx - 1);
+    agg_refresh(node, idx);
 }
 
 /*
- * borrow_from_right - Borrow a key from right sibling through parent
+ * borrow_from_right - Borrow k keys from right sibling through parent
  *
  * @node: parent node
- * @idx: index of the child that needs a key
+ * @idx: index of the child that needs keys
+ * @k: keys to move (delete moves 1; B* insert moves several at once)
  *
- * Before:
+ * Before (k = 1):
  *     [..., P, ...]          <- parent, P = keys[idx]
  *        /     \
  *     [A]       [B C D]      <- child needs key, sibling has extra
@@ -611,37 +1527,54 @@ static void borrow_from_left(BTreeNode *node, int idx) {
  *        /     \
  *   [A P]       [C D]        <- P moved down to child
  */
-static void borrow_from_right(BTreeNode *node, int idx) {
+static void borrow_from_right(BTreeNode *node, int idx, int k) {
     BTreeNode *child = node->children[idx];
     BTreeNode *sibling = node->children[idx + 1];
 
-    log_borrow_right(sibling->keys[0], idx);
+    log_borrow_right(sibling->keys[k - 1], idx);
 
-    /* Move parent's key down to child's last position */
+    /* Move parent's key down to child's end, then sibling's first k-1 */
     child->keys[child->n] = node->keys[idx];
+    memcpy(&child->keys[child->n + 1], &sibling->keys[0], (k - 1) * sizeof(int));
+    if (node->counts) {
+        child->counts[child->n] = node->counts[idx];
+        memcpy(&child->counts[child->n + 1], &sibling->counts[0],
+               (k - 1) * sizeof(int));
+    }
 
-    /* Move sibling's first child to child's last position (if not leaf) */
+    /* Move sibling's first k children to child's end (if not leaf) */
     if (!child->is_leaf) {
-        child->children[child->n + 1] = sibling->children[0];
+        memcpy(&child->children[child->n + 1], &sibling->children[0],
+               k * sizeof(BTreeNode *));
+        agg_move(child, child->n + 1, sibling, 0, k);
     }
 
-    /* Move sibling's first key up to parent */
-    node->keys[idx] = sibling->keys[0];
+    /* Move sibling's k-th key up to parent */
+    node->keys[idx] = sibling->keys[k - 1];
+    if (node->counts) node->counts[idx] = sibling->counts[k - 1];
 
-    /* Shift all keys in sibling to the left */
-    for (int i = 0; i < sibling->n - 1; i++) {
-        sibling->keys[i] = sibling->keys[i + 1];
+    /* Shift remaining keys in sibling to the left */
+    memmove(&sibling->keys[0], &sibling->keys[k], (sibling->n - k) * sizeof(int));
+    if (sibling->counts) {
+        memmove(&sibling->counts[0], &sibling->counts[k],
+                (sibling->n - k) * sizeof(int));
     }
 
-    /* Shift all children in sibling to the left (if not leaf) */
+    /* Shift remaining children in sibling to the left (if not leaf) */
     if (!sibling->is_leaf) {
-        for (int i = 0; i < sibling->n; i++) {
-            sibling->children[i] = sibling->children[i + 1];
-        }
+        memmove(&sibling->children[0], &sibling->children[k],
+                (sibling->n - k + 1) * sizeof(BTreeNode *));
+        agg_move(sibling, 0, sibling, k, sibling->n - k + 1);
     }
 
-    child->n++;
-    sibling->n--;
+    int old_n = child->n;
+    child->n += k;
+    sibling->n -= k;
+    fence_update(child, old_n);
+    fence_update(node, idx);
+    fence_update(sibling, 0);
+    agg_refresh(node, idx);
+    agg_refresh(node, idx + 1);
 }
 
 /*
@@ -665,12 +1598,12 @@ static void borrow_from_right(BTreeNode *node, int idx) {
 static FillResult fill(BTreeNode *node, int idx, int t) {
     /* Try borrowing from left sibling */
     if (idx > 0 && node->children[idx - 1]->n >= t) {
-        borrow_from_left(node, idx);
+        borrow_from_left(node, idx, 1);
         return FILL_BORROWED;
     }
     /* Try borrowing from right sibling */
     if (idx < node->n && node->children[idx + 1]->n >= t) {
-        borrow_from_right(node, idx);
+        borrow_from_right(node, idx, 1);
         return FILL_BORROWED;
     }
     /* Must merge */
@@ -693,8 +1626,9 @@ static FillResult fill(BTreeNode *node, int idx, int t) {
  * @t: minimum degree
  *
  * This function handles all three cases of B-Tree deletion.
+ * Returns true if the key was found and removed.
  */
-static void delete_internal(BTreeNode *node, int key, int t) {
+static bool delete_internal(BTreeNode *node, int key, int t) {
     int idx = find_key(node, key);
 
     /* Case 1 & 2: Key is in this node */
@@ -707,8 +1641,11 @@ static void delete_internal(BTreeNode *node, int key, int t) {
             log_delete_leaf(key);
             for (int i = idx; i < node->n - 1; i++) {
                 node->keys[i] = node->keys[i + 1];
+                if (node->counts) node->counts[i] = node->counts[i + 1];
             }
             node->n--;
+            fence_update(node, idx);
+            return true;
         } else {
             /*
              * Case 2: Key is in an internal node
@@ -718,19 +1655,29 @@ static void delete_internal(BTreeNode *node, int key, int t) {
                  * Case 2a: Left child has >= t keys
                  * Replace key with predecessor and delete predecessor
                  */
-                int pred = get_predecessor(node, idx);
+                int pred_count = 1;
+                int pred = get_predecessor(node, idx, &pred_count);
                 log_delete_predecessor(key, pred);
                 node->keys[idx] = pred;
+                if (node->counts) node->counts[idx] = pred_count;
+                fence_update(node, idx);
                 delete_internal(node->children[idx], pred, t);
+                agg_refresh(node, idx);
+                return true;
             } else if (node->children[idx + 1]->n >= t) {
                 /*
                  * Case 2b: Right child has >= t keys
                  * Replace key with successor and delete successor
                  */
-                int succ = get_successor(node, idx);
+                int succ_count = 1;
+                int succ = get_successor(node, idx, &succ_count);
                 log_delete_successor(key, succ);
                 node->keys[idx] = succ;
+                if (node->counts) node->counts[idx] = succ_count;
+                fence_update(node, idx);
                 delete_internal(node->children[idx + 1], succ, t);
+                agg_refresh(node, idx + 1);
+                return true;
             } else {
                 /*
                  * Case 2c: Both children have t-1 keys
@@ -738,6 +1685,8 @@ static void delete_internal(BTreeNode *node, int key, int t) {
                  */
                 merge(node, idx, t);
                 delete_internal(node->children[idx], key, t);
+                agg_refresh(node, idx);
+                return true;
             }
         }
     } else {
@@ -747,7 +1696,7 @@ static void delete_internal(BTreeNode *node, int key, int t) {
          */
         if (node->is_leaf) {
             /* Key not found in tree */
-            return;
+            return false;
         }
 
         /*
@@ -766,7 +1715,9 @@ static void delete_internal(BTreeNode *node, int key, int t) {
             }
         }
 
-        delete_internal(node->children[idx], key, t);
+        bool removed = delete_internal(node->children[idx], key, t);
+        agg_refresh(node, idx);
+        return removed;
     }
 }
 
@@ -778,12 +1729,28 @@ static void delete_internal(BTreeNode *node, int key, int t) {
  *
  * This is the public interface for deletion. It handles the special
  * case where the root becomes empty after deletion.
+ *
+ * In a multimap tree one occurrence is removed: the count drops in
+ * place, and the entry is only deleted structurally at its last copy.
+ *
+ * Returns true if the key (or one occurrence of it) was removed.
  */
-void btree_delete(BTree *tree, int key) {
-    if (!tree || !tree->root) return;
-    if (tree->root->n == 0) return;  /* Empty tree */
+bool btree_delete(BTree *tree, int key) {
+    if (!tree || !tree->root) return false;
+    tree->writes++;
+    if (tree->root->n == 0) return false;  /* Empty tree */
+
+    if (tree->root->counts) {
+        int idx;
+        BTreeNode *found = btree_search(tree->root, key, &idx);
+        if (!found) return false;
+        if (found->counts[idx] > 1) {
+            found->counts[idx]--;
+            return true;
+        }
+    }
 
-    delete_internal(tree->root, key, tree->t);
+    bool removed = delete_internal(tree->root, key, tree->t);
 
     /*
      * Special case: if the root has no keys left but has a child,
@@ -792,10 +1759,9 @@ void btree_delete(BTree *tree, int key) {
     if (tree->root->n == 0 && !tree->root->is_leaf) {
         BTreeNode *old_root = tree->root;
         tree->root = tree->root->children[0];
-        free(old_root->keys);
-        free(old_root->children);
-        free(old_root);
+        free_node(old_root);
     }
+    return removed;
 }
 
 /* ================================================================
@@ -940,41 +1906,38 @@ int btree_count(BTree *tree) {
 }
 
 /*
- * validate_node - Recursively validate a node and its subtree
+ * check_node_keys - Validate one node in isolation (no recursion)
  *
- * @node: node to validate
+ * @node: node to check
  * @t: minimum degree
- * @min: minimum allowed key value (exclusive, INT_MIN for no limit)
- * @max: maximum allowed key value (exclusive, INT_MAX for no limit)
- * @expected_depth: expected depth of leaves (-1 to compute)
- * @current_depth: current depth in tree
+ * @min, @max: exclusive key bounds inherited from ancestors
  * @is_root: true if this is the root node
  *
- * Returns: depth of leaves if valid, -1 if invalid
+ * Covers checks 2 and 3 below; shared by the serial and parallel walks.
+ *
+ * Returns: true if the node's key count and key order are valid
  */
-static int validate_node(BTreeNode *node, int t, int min, int max,
-                         int expected_depth, int current_depth, bool is_root) {
-    if (!node) return -1;
-
+static bool check_node_keys(BTreeNode *node, int t, int min, int max,
+                            bool is_root) {
     /* Check 2: Key count bounds */
     if (is_root) {
         /* Root can have 1 to 2t-1 keys (or 0 if tree is empty) */
         if (node->n > 2 * t - 1) {
             fprintf(stderr, "Validation error: root has %d keys (max %d)\n",
                     node->n, 2 * t - 1);
-            return -1;
+            return false;
         }
     } else {
         /* Non-root must have [t-1, 2t-1] keys */
         if (node->n < t - 1) {
             fprintf(stderr, "Validation error: node has %d keys (min %d)\n",
                     node->n, t - 1);
-            return -1;
+            return false;
         }
         if (node->n > 2 * t - 1) {
             fprintf(stderr, "Validation error: node has %d keys (max %d)\n",
                     node->n, 2 * t - 1);
-            return -1;
+            return false;
         }
     }
 
@@ -983,13 +1946,59 @@ static int validate_node(BTreeNode *node, int t, int min, int max,
         if (node->keys[i] <= min || node->keys[i] >= max) {
             fprintf(stderr, "Validation error: key %d out of range (%d, %d)\n",
                     node->keys[i], min, max);
-            return -1;
+            return false;
         }
         if (i > 0 && node->keys[i] <= node->keys[i - 1]) {
             fprintf(stderr, "Validation error: keys not sorted at index %d\n", i);
-            return -1;
+            return false;
+        }
+        /* Multimap: duplicates live in counts, never as repeated keys */
+        if (node->counts && node->counts[i] < 1) {
+            fprintf(stderr, "Validation error: key %d has count %d\n",
+                    node->keys[i], node->counts[i]);
+            return false;
+        }
+        /* Fenced: every 16th key is mirrored in fences[] */
+        if (node->fences && i % BTREE_FENCE_STRIDE == 0 &&
+            node->fences[i / BTREE_FENCE_STRIDE] != node->keys[i]) {
+            fprintf(stderr, "Validation error: stale fence at key index %d\n", i);
+            return false;
         }
     }
+    return true;
+}
+
+/*
+ * stats_add_node - Account one node in a BTreeStats accumulator
+ */
+static void stats_add_node(BTreeStats *stats, BTreeNode *node) {
+    if (!stats) return;
+    stats->keys += node->n;
+    stats->nodes++;
+    if (node->is_leaf) stats->leaves++;
+}
+
+/*
+ * validate_node - Recursively validate a node and its subtree
+ *
+ * @node: node to validate
+ * @t: minimum degree
+ * @min: minimum allowed key value (exclusive, INT_MIN for no limit)
+ * @max: maximum allowed key value (exclusive, INT_MAX for no limit)
+ * @expected_depth: expected depth of leaves (-1 to compute)
+ * @current_depth: current depth in tree
+ * @is_root: true if this is the root node
+ * @stats: accumulator for key/node counts, or NULL
+ *
+ * Returns: depth of leaves if valid, -1 if invalid
+ */
+static int validate_node(BTreeNode *node, int t, int min, int max,
+                         int expected_depth, int current_depth, bool is_root,
+                         BTreeStats *stats) {
+    if (!node) return -1;
+
+    if (!check_node_keys(node, t, min, max, is_root)) return -1;
+    stats_add_node(stats, node);
 
     /* Check 1: All leaves at same depth */
     if (node->is_leaf) {
@@ -1015,9 +2024,21 @@ static int validate_node(BTreeNode *node, int t, int min, int max,
         int child_max = (i == node->n) ? max : node->keys[i];
 
         int depth = validate_node(node->children[i], t, child_min, child_max,
-                                  leaf_depth, current_depth + 1, false);
+                                  leaf_depth, current_depth + 1, false, stats);
         if (depth == -1) return -1;
 
+        /* Check 6: Aggregate trees summarize each child correctly.
+         * Children were validated first, so one level suffices. */
+        if (node->aggs) {
+            BTreeAggregate a = agg_of(node->children[i]);
+            BTreeAggregate *have = &node->aggs[i];
+            if (a.count != have->count || a.sum != have->sum ||
+                a.min != have->min || a.max != have->max) {
+                fprintf(stderr, "Validation error: stale aggregate for child %d\n", i);
+                return -1;
+            }
+        }
+
         if (leaf_depth == -1) {
             leaf_depth = depth;  /* First leaf sets expected depth */
         }
@@ -1035,6 +2056,16 @@ static bool btree_is_empty(BTree *tree) {
     return !tree || !tree->root || tree->root->n == 0;
 }
 
+/*
+ * stats_finish - Derive height and fill factor once counts are summed
+ */
+static void stats_finish(BTreeStats *stats, int leaf_depth, int t) {
+    if (!stats) return;
+    stats->height = (stats->keys == 0) ? 0 : leaf_depth + 1;
+    stats->fill = (stats->nodes == 0) ? 0.0
+                : (double)stats->keys / ((double)stats->nodes * (2 * t - 1));
+}
+
 /*
  * btree_validate - Verify all B-Tree invariants
  *
@@ -1044,18 +2075,1395 @@ static bool btree_is_empty(BTree *tree) {
  * 3. Keys in each node are sorted
  * 4. For internal nodes: keys[i] separates children[i] and children[i+1]
  * 5. Non-leaf with k keys has exactly k+1 children
+ * 6. Aggregate trees: aggs[i] matches the subtree under children[i]
  *
  * Returns: 1 if valid, 0 if invalid
  */
 int btree_validate(BTree *tree) {
+    return btree_validate_stats(tree, NULL);
+}
+
+/*
+ * btree_validate_stats - btree_validate that also fills @stats
+ *
+ * @stats: receives counts, height and fill factor (may be NULL).
+ *         Contents are only meaningful when the tree is valid.
+ *
+ * Returns: 1 if valid, 0 if invalid
+ */
+int btree_validate_stats(BTree *tree, BTreeStats *stats) {
+    if (stats) memset(stats, 0, sizeof(*stats));
     if (!tree || !tree->root) return 0;
 
     /* Empty tree is valid (consistent with btree_count returning 0) */
     if (btree_is_empty(tree)) {
+        stats_add_node(stats, tree->root);
+        stats_finish(stats, 0, tree->t);
         return 1;
     }
 
     int result = validate_node(tree->root, tree->t, INT_MIN, INT_MAX,
-                               -1, 0, true);
+                               -1, 0, true, stats);
+    stats_finish(stats, result, tree->t);
     return result != -1;
 }
+
+/* ================================================================
+ * PARALLEL VALIDATION
+ *
+ * The top of the tree is checked on the calling thread and expanded
+ * breadth-first until there are several subtrees per thread. Workers
+ * then claim subtrees from a shared atomic cursor, so a slow subtree
+ * never leaves the other threads idle (self-scheduling; no stealing
+ * deque is needed because tasks are independent and uniform).
+ *
+ * Each subtree reports its leaf depth and private statistics; the
+ * caller compares depths and sums statistics after the join.
+ * ================================================================ */
+
+#define VALIDATE_TASKS_PER_THREAD 4
+
+typedef struct {
+    BTreeNode *node;
+    int min, max;       /* Exclusive key bounds from ancestors */
+    int depth;          /* Depth of node */
+    bool is_root;
+    int leaf_depth;     /* Result: leaf depth, or -1 if invalid */
+    BTreeStats stats;   /* Result: statistics of this subtree */
+} ValidateTask;
+
+typedef struct {
+    ValidateTask *tasks;
+    size_t count;
+    int t;
+    atomic_size_t next;   /* Next unclaimed task */
+    atomic_bool failed;   /* Set by the first failing task */
+} ValidateJob;
+
+static void *validate_worker(void *arg) {
+    ValidateJob *job = (ValidateJob *)arg;
+
+    for (;;) {
+        if (atomic_load_explicit(&job->failed, memory_order_relaxed)) break;
+        size_t i = atomic_fetch_add_explicit(&job->next, 1, memory_order_relaxed);
+        if (i >= job->count) break;
+
+        ValidateTask *task = &job->tasks[i];
+        task->leaf_depth = validate_node(task->node, job->t, task->min,
+                                         task->max, -1, task->depth,
+                                         task->is_root, &task->stats);
+        if (task->leaf_depth == -1) {
+            atomic_store_explicit(&job->failed, true, memory_order_relaxed);
+        }
+    }
+    return NULL;
+}
+
+/*
+ * expand_frontier - Replace internal tasks by their children, one level
+ *
+ * Each expanded node is checked locally (keys, fill, child links and
+ * aggregates) and counted into @top.
+ *
+ * Returns: new task array (old one freed), or NULL on validation
+ *          failure / allocation failure (*ok tells which)
+ */
+static ValidateTask *expand_frontier(ValidateTask *tasks, size_t *count,
+                                     int t, BTreeStats *top, bool *ok) {
+    size_t new_count = 0;
+    for (size_t i = 0; i < *count; i++) {
+        new_count += tasks[i].node->is_leaf ? 1 : (size_t)tasks[i].node->n + 1;
+    }
+
+    ValidateTask *next = (ValidateTask *)calloc(new_count, sizeof(ValidateTask));
+    if (!next) {
+        free(tasks);
+        *ok = true;  /* Not a validation failure */
+        return NULL;
+    }
+
+    size_t k = 0;
+    for (size_t i = 0; i < *count; i++) {
+        ValidateTask *task = &tasks[i];
+        BTreeNode *node = task->node;
+        if (node->is_leaf) {
+            next[k++] = *task;
+            continue;
+        }
+
+        if (!check_node_keys(node, t, task->min, task->max, task->is_root)) {
+            free(next);
+            free(tasks);
+            *ok = false;
+            return NULL;
+        }
+        stats_add_node(top, node);
+
+        for (int c = 0; c <= node->n; c++) {
+            if (!node->children[c]) {
+                fprintf(stderr, "Validation error: NULL child at index %d\n", c);
+                free(next);
+                free(tasks);
+                *ok = false;
+                return NULL;
+            }
+            /* Check 6 as in validate_node: the child's own summaries
+             * are checked later (deeper level or worker task), so one
+             * level suffices here too. */
+            if (node->aggs) {
+                BTreeAggregate a = agg_of(node->children[c]);
+                BTreeAggregate *have = &node->aggs[c];
+                if (a.count != have->count || a.sum != have->sum ||
+                    a.min != have->min || a.max != have->max) {
+                    fprintf(stderr, "Validation error: stale aggregate for child %d\n", c);
+                    free(next);
+                    free(tasks);
+                    *ok = false;
+                    return NULL;
+                }
+            }
+            next[k].node = node->children[c];
+            next[k].min = (c == 0) ? task->min : node->keys[c - 1];
+            next[k].max = (c == node->n) ? task->max : node->keys[c];
+            next[k].depth = task->depth + 1;
+            next[k].is_root = false;
+            k++;
+        }
+    }
+
+    free(tasks);
+    *count = new_count;
+    return next;
+}
+
+/*
+ * btree_validate_parallel - btree_validate fanned out over @threads
+ *
+ * @tree: the B-Tree
+ * @threads: worker count including the caller (<= 1 runs serially)
+ * @stats: receives counts, height and fill factor (may be NULL)
+ *
+ * Reports the same errors as btree_validate; when several subtrees are
+ * broken, which message is printed first may differ between runs.
+ *
+ * Returns: 1 if valid, 0 if invalid
+ */
+int btree_validate_parallel(BTree *tree, int threads, BTreeStats *stats) {
+    if (threads <= 1 || btree_is_empty(tree)) {
+        return btree_validate_stats(tree, stats);
+    }
+    if (stats) memset(stats, 0, sizeof(*stats));
+
+    int t = tree->t;
+    BTreeStats top = {0};
+    size_t count = 1;
+    ValidateTask *tasks = (ValidateTask *)calloc(1, sizeof(ValidateTask));
+    if (!tasks) return btree_validate_stats(tree, stats);
+    tasks[0].node = tree->root;
+    tasks[0].min = INT_MIN;
+    tasks[0].max = INT_MAX;
+    tasks[0].is_root = true;
+
+    /* Expand until there is enough work to balance across threads */
+    size_t target = (size_t)threads * VALIDATE_TASKS_PER_THREAD;
+    while (count < target && !tasks[0].node->is_leaf) {
+        bool ok = true;
+        tasks = expand_frontier(tasks, &count, t, &top, &ok);
+        if (!tasks) {
+            return ok ? btree_validate_stats(tree, stats) : 0;
+        }
+    }
+
+    ValidateJob job = { .tasks = tasks, .count = count, .t = t };
+    atomic_init(&job.next, 0);
+    atomic_init(&job.failed, false);
+
+    int spawned = 0;
+    pthread_t *workers = (pthread_t *)malloc((threads - 1) * sizeof(pthread_t));
+    for (int i = 0; workers && i < threads - 1; i++) {
+        if (pthread_create(&workers[spawned], NULL, validate_worker, &job) == 0) {
+            spawned++;
+        }
+    }
+    validate_worker(&job);  /* Calling thread works too */
+    for (int i = 0; i < spawned; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    free(workers);
+
+    /* Combine: every subtree valid, and all leaves at one depth */
+    int valid = !atomic_load(&job.failed);
+    int leaf_depth = -1;
+    for (size_t i = 0; valid && i < count; i++) {
+        if (leaf_depth == -1) {
+            leaf_depth = tasks[i].leaf_depth;
+        } else if (tasks[i].leaf_depth != leaf_depth) {
+            fprintf(stderr, "Validation error: leaf at depth %d, expected %d\n",
+                    tasks[i].leaf_depth, leaf_depth);
+            valid = 0;
+        }
+        top.keys += tasks[i].stats.keys;
+        top.nodes += tasks[i].stats.nodes;
+        top.leaves += tasks[i].stats.leaves;
+    }
+    free(tasks);
+
+    if (valid && stats) {
+        *stats = top;
+        stats_finish(stats, leaf_depth, t);
+    }
+    return valid;
+}
+
+/* ================================================================
+ * PERSISTENCE (SAVE / LOAD)
+ *
+ * Nodes are written in level order, so the children of any node are
+ * a contiguous run of records. Each record stores the index of its
+ * first child instead of pointers. Loading reads the whole image with
+ * one sequential read and relinks children by index - no per-key
+ * inserts, no splits.
+ *
+ *   [header][rec 0][keys 0][rec 1][keys 1] ... [rec N-1][keys N-1]
+ *
+ * Keys are stored as native 32-bit ints; the image is not portable
+ * across endianness (the magic check rejects a byte-swapped file).
+ *
+ * The header's flags record how the tree was created (arena, fenced,
+ * B*, aggregate). Fences and per-child summaries are derived from the
+ * keys, so they are not stored: load recomputes them bottom-up.
+ * Multimap counts are payload and not part of the format.
+ * ================================================================ */
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t t;
+    uint32_t height;
+    uint64_t node_count;
+    uint64_t key_count;
+    uint32_t flags;        /* BTREE_FILE_* mode bits of the saved tree */
+    uint32_t reserved;     /* Zero */
+} BTreeFileHeader;
+
+typedef struct {
+    uint32_t n;
+    uint32_t is_leaf;
+    uint64_t first_child;  /* Record index of children[0] (0 for leaves) */
+} BTreeFileNode;
+
+#define SAVE_BUF_SIZE (1 << 20)
+
+/*
+ * count_nodes - Count nodes (not keys) in a subtree
+ */
+static size_t count_nodes(BTreeNode *node) {
+    if (!node) return 0;
+
+    size_t total = 1;
+    if (!node->is_leaf) {
+        for (int i = 0; i <= node->n; i++) {
+            total += count_nodes(node->children[i]);
+        }
+    }
+    return total;
+}
+
+/*
+ * write_all - write() until every byte is out, retrying on EINTR
+ *
+ * Returns: 0 on success, -1 on error
+ */
+static int write_all(int fd, const void *buf, size_t len) {
+    const unsigned char *p = (const unsigned char *)buf;
+    while (len > 0) {
+        ssize_t w = write(fd, p, len);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += w;
+        len -= (size_t)w;
+    }
+    return 0;
+}
+
+/*
+ * read_image - Read everything from fd's current offset to EOF
+ *
+ * For regular files the buffer is sized from fstat() up front, so the
+ * whole image arrives in one sequential read. Pipes fall back to a
+ * doubling buffer.
+ *
+ * Returns: malloc'd buffer (caller frees), or NULL on error
+ */
+static unsigned char *read_image(int fd, size_t *out_len) {
+    size_t cap = 1 << 16;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        off_t pos = lseek(fd, 0, SEEK_CUR);
+        if (pos >= 0 && st.st_size > pos) {
+            cap = (size_t)(st.st_size - pos) + 1;  /* +1 to observe EOF */
+        }
+    }
+
+    unsigned char *buf = (unsigned char *)malloc(cap);
+    if (!buf) return NULL;
+
+    size_t len = 0;
+    for (;;) {
+        if (len == cap) {
+            unsigned char *grown = (unsigned char *)realloc(buf, cap * 2);
+            if (!grown) {
+                free(buf);
+                return NULL;
+            }
+            buf = grown;
+            cap *= 2;
+        }
+        ssize_t r = read(fd, buf + len, cap - len);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            free(buf);
+            return NULL;
+        }
+        if (r == 0) break;
+        len += (size_t)r;
+    }
+
+    *out_len = len;
+    return buf;
+}
+
+/*
+ * btree_save - Write the tree to fd in the level-order image format
+ *
+ * @tree: the B-Tree
+ * @fd: file descriptor open for writing (written from its current offset)
+ *
+ * Output goes through a 1 MiB staging buffer so large trees are written
+ * in big sequential chunks rather than one syscall per node. The tree's
+ * mode goes into the header flags; multimap trees are refused.
+ *
+ * Returns: 0 on success, -1 on error
+ */
+int btree_save(BTree *tree, int fd) {
+    if (!tree || !tree->root || fd < 0) return -1;
+    if (tree->root->counts) {
+        fprintf(stderr, "Save error: multimap counts are not in format v%u\n",
+                BTREE_FILE_VERSION);
+        return -1;
+    }
+
+    size_t node_count = count_nodes(tree->root);
+    BTreeNode **queue = (BTreeNode **)malloc(node_count * sizeof(BTreeNode *));
+    unsigned char *buf = (unsigned char *)malloc(SAVE_BUF_SIZE);
+    if (!queue || !buf) {
+        free(queue);
+        free(buf);
+        return -1;
+    }
+
+    uint32_t flags = 0;
+    if (tree->root->in_arena) flags |= BTREE_FILE_ARENA;
+    if (tree->root->fences) flags |= BTREE_FILE_FENCED;
+    if (tree->bstar) flags |= BTREE_FILE_BSTAR;
+    if (tree->root->aggregated) flags |= BTREE_FILE_AGGREGATE;
+
+    BTreeFileHeader header = {
+        .magic = BTREE_FILE_MAGIC,
+        .version = BTREE_FILE_VERSION,
+        .t = (uint32_t)tree->t,
+        .height = (uint32_t)btree_height(tree),
+        .node_count = node_count,
+        .key_count = (uint64_t)btree_count(tree),
+        .flags = flags
+    };
+
+    int rc = write_all(fd, &header, sizeof(header));
+    size_t used = 0;
+    size_t head = 0, tail = 0;
+    queue[tail++] = tree->root;
+
+    /* Breadth-first: children are appended to the queue in order, so
+     * the queue position of children[0] is exactly its record index. */
+    while (rc == 0 && head < tail) {
+        BTreeNode *node = queue[head++];
+
+        BTreeFileNode rec = {
+            .n = (uint32_t)node->n,
+            .is_leaf = node->is_leaf ? 1u : 0u,
+            .first_child = node->is_leaf ? 0 : (uint64_t)tail
+        };
+        if (!node->is_leaf) {
+            for (int i = 0; i <= node->n; i++) {
+                queue[tail++] = node->children[i];
+            }
+        }
+
+        size_t key_bytes = (size_t)node->n * sizeof(int);
+        if (used + sizeof(rec) + key_bytes > SAVE_BUF_SIZE) {
+            rc = write_all(fd, buf, used);
+            used = 0;
+        }
+        if (sizeof(rec) + key_bytes > SAVE_BUF_SIZE) {
+            /* Node larger than the staging buffer: write it directly */
+            if (rc == 0) rc = write_all(fd, &rec, sizeof(rec));
+            if (rc == 0) rc = write_all(fd, node->keys, key_bytes);
+            continue;
+        }
+        memcpy(buf + used, &rec, sizeof(rec));
+        memcpy(buf + used + sizeof(rec), node->keys, key_bytes);
+        used += sizeof(rec) + key_bytes;
+    }
+    if (rc == 0 && used > 0) {
+        rc = write_all(fd, buf, used);
+    }
+
+    free(buf);
+    free(queue);
+    return rc;
+}
+
+/*
+ * btree_load - Rebuild a tree from an image written by btree_save
+ *
+ * @fd: file descriptor open for reading (read from its current offset)
+ *
+ * The tree comes back in the mode it was saved in: arena nodes are
+ * allocated from a new arena, and fences and aggregates are rebuilt
+ * from the keys. Every record is bounds-checked against the header,
+ * and the linked tree must pass btree_validate and match the stored
+ * height, so a truncated or corrupt file yields NULL rather than a
+ * malformed tree.
+ *
+ * Returns: the loaded tree, or NULL on I/O error or bad image
+ */
+BTree *btree_load(int fd) {
+    size_t len = 0;
+    unsigned char *image = read_image(fd, &len);
+    if (!image) return NULL;
+
+    BTreeFileHeader header;
+    if (len < sizeof(header)) {
+        fprintf(stderr, "Load error: image too short for header\n");
+        free(image);
+        return NULL;
+    }
+    memcpy(&header, image, sizeof(header));
+
+    if (header.magic != BTREE_FILE_MAGIC ||
+        header.version != BTREE_FILE_VERSION) {
+        fprintf(stderr, "Load error: bad magic or unsupported version %u\n",
+                header.version);
+        free(image);
+        return NULL;
+    }
+    uint32_t flags = header.flags;
+    bool arena_mode = (flags & BTREE_FILE_ARENA) != 0;
+    bool fenced = (flags & BTREE_FILE_FENCED) != 0;
+    bool aggregated = (flags & BTREE_FILE_AGGREGATE) != 0;
+    if (header.t < 2 || header.t > INT_MAX / 2 || header.node_count == 0 ||
+        header.node_count > (len - sizeof(header)) / sizeof(BTreeFileNode) ||
+        (flags & ~BTREE_FILE_FLAGS) != 0 || header.reserved != 0 ||
+        (arena_mode && (fenced || aggregated))) {
+        fprintf(stderr, "Load error: inconsistent header\n");
+        free(image);
+        return NULL;
+    }
+
+    int t = (int)header.t;
+    size_t node_count = (size_t)header.node_count;
+    BTreeNode **nodes = (BTreeNode **)calloc(node_count, sizeof(BTreeNode *));
+    uint64_t *first_child = (uint64_t *)malloc(node_count * sizeof(uint64_t));
+    BTree *tree = (BTree *)malloc(sizeof(BTree));
+    BTreeArena *arena = NULL;
+    if (!nodes || !first_child || !tree) goto fail;
+    if (arena_mode && !(arena = arena_create(t))) goto fail;
+
+    /* Pass 1: materialize every node and copy its keys in bulk */
+    size_t off = sizeof(header);
+    uint64_t keys_seen = 0;
+    uint64_t next_child = 1;  /* Level order: children claim records in turn */
+    for (size_t i = 0; i < node_count; i++) {
+        BTreeFileNode rec;
+        if (len - off < sizeof(rec)) goto corrupt;
+        memcpy(&rec, image + off, sizeof(rec));
+        off += sizeof(rec);
+
+        size_t key_bytes = (size_t)rec.n * sizeof(int);
+        if (rec.n > (uint32_t)(2 * t - 1) || len - off < key_bytes) goto corrupt;
+        if (!rec.is_leaf) {
+            if (rec.first_child != next_child ||
+                rec.first_child + rec.n >= node_count) {
+                goto corrupt;
+            }
+            next_child += (uint64_t)rec.n + 1;
+        }
+
+        /* Level order: the previous record is a sibling or cousin */
+        nodes[i] = alloc_node(arena, t, rec.is_leaf != 0, i > 0 ? nodes[i - 1] : NULL,
+                              false, fenced, aggregated);
+        if (!nodes[i]) goto fail;
+        memcpy(nodes[i]->keys, image + off, key_bytes);
+        nodes[i]->n = (int)rec.n;
+        first_child[i] = rec.first_child;
+        off += key_bytes;
+        keys_seen += rec.n;
+    }
+    if (off != len || keys_seen != header.key_count ||
+        next_child != node_count) {
+        goto corrupt;
+    }
+
+    /* Pass 2: turn record offsets back into child pointers */
+    for (size_t i = 0; i < node_count; i++) {
+        if (nodes[i]->is_leaf) continue;
+        for (int j = 0; j <= nodes[i]->n; j++) {
+            nodes[i]->children[j] = nodes[first_child[i] + j];
+        }
+    }
+
+    /* Derived data: children follow their parent in level order, so a
+     * backward sweep sees every child before the node summarizing it */
+    for (size_t i = node_count; i-- > 0;) {
+        fence_update(nodes[i], 0);
+        if (nodes[i]->aggs) {
+            for (int j = 0; j <= nodes[i]->n; j++) {
+                agg_refresh(nodes[i], j);
+            }
+        }
+    }
+
+    tree->t = t;
+    tree->bstar = (flags & BTREE_FILE_BSTAR) != 0;
+    tree->writes = 0;
+    tree->root = nodes[0];
+    free(first_child);
+    free(nodes);
+    free(image);
+
+    /* Records were well-formed; now check the tree they describe: key
+     * order, fill, equal leaf depth (btree_validate) and the stored
+     * height. An empty root must be the only node, which
+     * btree_validate does not look at. */
+    if ((tree->root->n == 0 && node_count != 1) ||
+        (uint32_t)btree_height(tree) != header.height ||
+        !btree_validate(tree)) {
+        fprintf(stderr, "Load error: image does not hold a valid B-Tree\n");
+        btree_destroy(tree);
+        return NULL;
+    }
+    return tree;
+
+corrupt:
+    fprintf(stderr, "Load error: corrupt node records\n");
+fail:
+    /* Nothing is linked yet, so each node is freed on its own (arena
+     * nodes all go with their arena) */
+    if (arena) {
+        arena_destroy(arena);
+    } else if (nodes) {
+        for (size_t i = 0; i < node_count; i++) {
+            destroy_node(nodes[i]);
+        }
+    }
+    free(first_child);
+    free(nodes);
+    free(tree);
+    free(image);
+    return NULL;
+}
+
+/* ================================================================
+ * PARALLEL BULK BUILD
+ *
+ * Building bottom-up from sorted keys avoids every split and every
+ * root-to-leaf descent of n separate inserts:
+ *
+ *   1. Sort:   each thread qsorts one chunk, then runs are merged
+ *              pairwise, one merge per thread per round.
+ *   2. Leaves: sorted keys are cut into L leaves with one separator
+ *              between neighbours. Leaf boundaries are pure arithmetic,
+ *              so each thread fills its own range of leaves.
+ *   3. Levels: separators and child pointers are packed into parents
+ *              the same way until a single root remains (cheap: only
+ *              ~1/t of the nodes are internal).
+ *
+ * Groups are sized evenly (sizes differ by at most one), which keeps
+ * every non-root node within [t-1, 2t-1] keys.
+ * ================================================================ */
+
+typedef struct {
+    int *base;
+    size_t len;
+} SortTask;
+
+typedef struct {
+    const int *a, *b;
+    size_t na, nb;
+    int *out;
+} MergeTask;
+
+typedef struct {
+    const int *sorted;
+    BTreeNode **leaves;
+    size_t first, last;  /* Leaf index range [first, last) */
+    size_t base, extra;  /* Leaf i holds base + (i < extra) keys */
+    int t;
+    bool failed;
+} LeafTask;
+
+/*
+ * run_tasks - Run fn over @count task structs, one thread each
+ *
+ * The caller runs task 0 itself; if a thread cannot be spawned its
+ * task runs inline, so the result never depends on thread creation.
+ */
+static void run_tasks(void *(*fn)(void *), void *tasks, size_t task_size,
+                      size_t count) {
+    if (count == 0) return;
+    pthread_t *ids = (pthread_t *)malloc(count * sizeof(pthread_t));
+    bool *spawned = (bool *)calloc(count, sizeof(bool));
+
+    for (size_t i = 1; i < count; i++) {
+        void *task = (char *)tasks + i * task_size;
+        if (ids && spawned && pthread_create(&ids[i], NULL, fn, task) == 0) {
+            spawned[i] = true;
+        } else {
+            fn(task);
+        }
+    }
+    fn(tasks);
+    for (size_t i = 1; i < count; i++) {
+        if (spawned && spawned[i]) pthread_join(ids[i], NULL);
+    }
+    free(spawned);
+    free(ids);
+}
+
+static int compare_ints(const void *a, const void *b) {
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+static void *sort_worker(void *arg) {
+    SortTask *task = (SortTask *)arg;
+    qsort(task->base, task->len, sizeof(int), compare_ints);
+    return NULL;
+}
+
+static void *merge_worker(void *arg) {
+    MergeTask *task = (MergeTask *)arg;
+    size_t i = 0, j = 0, k = 0;
+    while (i < task->na && j < task->nb) {
+        task->out[k++] = (task->b[j] < task->a[i]) ? task->b[j++] : task->a[i++];
+    }
+    memcpy(task->out + k, task->a + i, (task->na - i) * sizeof(int));
+    k += task->na - i;
+    memcpy(task->out + k, task->b + j, (task->nb - j) * sizeof(int));
+    return NULL;
+}
+
+/*
+ * parallel_sort - Sort @n ints using @threads threads
+ *
+ * @buf, @tmp: two buffers of n ints; input is in buf
+ *
+ * Returns: whichever buffer holds the sorted output
+ */
+static int *parallel_sort(int *buf, int *tmp, size_t n, int threads) {
+    size_t runs = (size_t)threads;
+    if (runs > n) runs = n ? n : 1;
+
+    size_t *bounds = (size_t *)malloc((runs + 1) * sizeof(size_t));
+    SortTask *sorts = (SortTask *)malloc(runs * sizeof(SortTask));
+    MergeTask *merges = (MergeTask *)malloc(runs * sizeof(MergeTask));
+    if (!bounds || !sorts || !merges) {
+        free(bounds);
+        free(sorts);
+        free(merges);
+        qsort(buf, n, sizeof(int), compare_ints);
+        return buf;
+    }
+
+    for (size_t r = 0; r <= runs; r++) {
+        bounds[r] = n * r / runs;
+    }
+    for (size_t r = 0; r < runs; r++) {
+        sorts[r].base = buf + bounds[r];
+        sorts[r].len = bounds[r + 1] - bounds[r];
+    }
+    run_tasks(sort_worker, sorts, sizeof(SortTask), runs);
+
+    /* Merge adjacent runs pairwise until one run remains */
+    while (runs > 1) {
+        size_t pairs = runs / 2;
+        for (size_t p = 0; p < pairs; p++) {
+            size_t lo = bounds[2 * p], mid = bounds[2 * p + 1];
+            size_t hi = bounds[2 * p + 2];
+            merges[p] = (MergeTask){ buf + lo, buf + mid, mid - lo, hi - mid,
+                                     tmp + lo };
+        }
+        run_tasks(merge_worker, merges, sizeof(MergeTask), pairs);
+        if (runs % 2) {
+            size_t lo = bounds[runs - 1];
+            memcpy(tmp + lo, buf + lo, (n - lo) * sizeof(int));
+        }
+
+        for (size_t p = 0; p < pairs; p++) {
+            bounds[p] = bounds[2 * p];
+        }
+        if (runs % 2) bounds[pairs] = bounds[runs - 1];
+        runs = (runs + 1) / 2;
+        bounds[runs] = n;
+
+        int *swap = buf;
+        buf = tmp;
+        tmp = swap;
+    }
+
+    free(merges);
+    free(sorts);
+    free(bounds);
+    return buf;
+}
+
+static void *leaf_worker(void *arg) {
+    LeafTask *task = (LeafTask *)arg;
+    for (size_t i = task->first; i < task->last; i++) {
+        /* Leaf i starts after i earlier leaves and i separators */
+        size_t start = i * (task->base + 1) + (i < task->extra ? i : task->extra);
+        size_t size = task->base + (i < task->extra ? 1 : 0);
+
+        BTreeNode *leaf = create_node(task->t, true, NULL);
+        if (!leaf) {
+            task->failed = true;
+            return NULL;
+        }
+        memcpy(leaf->keys, task->sorted + start, size * sizeof(int));
+        leaf->n = (int)size;
+        task->leaves[i] = leaf;
+    }
+    return NULL;
+}
+
+/*
+ * build_levels - Stack internal levels over a row of nodes
+ *
+ * @nodes: row of @count subtrees (count >= 2); reused as output row
+ * @seps: the count-1 keys separating them; reused as output separators
+ *
+ * Returns: the root, or NULL on allocation failure (row is freed)
+ */
+static BTreeNode *build_levels(BTreeNode **nodes, int *seps, size_t count,
+                               int t) {
+    while (count > 1) {
+        size_t parents = (count + 2 * (size_t)t - 1) / (2 * (size_t)t);
+        size_t base = count / parents, extra = count % parents;
+        size_t child = 0;
+
+        for (size_t p = 0; p < parents; p++) {
+            size_t k = base + (p < extra ? 1 : 0);  /* children of parent p */
+            BTreeNode *parent = create_node(t, false, NULL);
+            if (!parent) {
+                for (size_t i = 0; i < p; i++) destroy_node(nodes[i]);
+                for (size_t i = child; i < count; i++) destroy_node(nodes[i]);
+                return NULL;
+            }
+            for (size_t c = 0; c < k; c++) {
+                parent->children[c] = nodes[child + c];
+                if (c > 0) parent->keys[c - 1] = seps[child + c - 1];
+            }
+            parent->n = (int)k - 1;
+
+            /* In-place is safe: index p never passes child */
+            nodes[p] = parent;
+            if (p > 0) seps[p - 1] = seps[child - 1];
+            child += k;
+        }
+        count = parents;
+    }
+    return nodes[0];
+}
+
+/*
+ * btree_build_parallel - Build a B-Tree from unsorted keys
+ *
+ * @t: minimum degree (must be >= 2)
+ * @keys: keys in any order; duplicates are stored once (like insert
+ *        followed by validate expects). Not modified.
+ * @n: number of keys
+ * @threads: worker count including the caller
+ *
+ * Returns: a tree that passes btree_validate, or NULL on failure
+ */
+BTree *btree_build_parallel(int t, const int *keys, int n, int threads) {
+    if (n <= 0 || !keys) return btree_create(t);
+    BTree *tree = btree_create(t);
+    if (!tree) return NULL;
+    if (threads < 1) threads = 1;
+
+    size_t count = (size_t)n;
+    int *buf = (int *)malloc(count * sizeof(int));
+    int *tmp = (int *)malloc(count * sizeof(int));
+    if (!buf || !tmp) goto fail;
+    memcpy(buf, keys, count * sizeof(int));
+
+    /* 1. Sort, then drop duplicates */
+    int *sorted = parallel_sort(buf, tmp, count, threads);
+    size_t m = 1;
+    for (size_t i = 1; i < count; i++) {
+        if (sorted[i] != sorted[m - 1]) sorted[m++] = sorted[i];
+    }
+
+    if (m <= (size_t)(2 * t - 1)) {
+        memcpy(tree->root->keys, sorted, m * sizeof(int));
+        tree->root->n = (int)m;
+        free(buf);
+        free(tmp);
+        return tree;
+    }
+
+    /* 2. Leaves: L groups + (L-1) separators, each group <= 2t-1 keys */
+    size_t leaves = (m + 1 + 2 * (size_t)t - 1) / (2 * (size_t)t);
+    size_t base = (m - (leaves - 1)) / leaves;
+    size_t extra = (m - (leaves - 1)) % leaves;
+
+    BTreeNode **row = (BTreeNode **)calloc(leaves, sizeof(BTreeNode *));
+    int *seps = (int *)malloc(leaves * sizeof(int));
+    size_t workers = (size_t)threads < leaves ? (size_t)threads : leaves;
+    LeafTask *tasks = (LeafTask *)calloc(workers, sizeof(LeafTask));
+    if (!row || !seps || !tasks) {
+        free(row);
+        free(seps);
+        free(tasks);
+        goto fail;
+    }
+
+    for (size_t w = 0; w < workers; w++) {
+        tasks[w] = (LeafTask){ sorted, row, leaves * w / workers,
+                               leaves * (w + 1) / workers, base, extra, t,
+                               false };
+    }
+    run_tasks(leaf_worker, tasks, sizeof(LeafTask), workers);
+
+    bool failed = false;
+    for (size_t w = 0; w < workers; w++) failed |= tasks[w].failed;
+    free(tasks);
+    for (size_t i = 0; i + 1 < leaves; i++) {
+        size_t end = (i + 1) * base + (i < extra ? i + 1 : extra) + i;
+        seps[i] = sorted[end];
+    }
+
+    /* 3. Internal levels */
+    BTreeNode *root = NULL;
+    if (failed) {
+        for (size_t i = 0; i < leaves; i++) destroy_node(row[i]);
+    } else {
+        root = build_levels(row, seps, leaves, t);
+    }
+    free(row);
+    free(seps);
+    if (!root) goto fail;
+
+    destroy_node(tree->root);
+    tree->root = root;
+    free(buf);
+    free(tmp);
+    return tree;
+
+fail:
+    free(buf);
+    free(tmp);
+    btree_destroy(tree);
+    return NULL;
+}
+
+/* ================================================================
+ * RELAYOUT
+ *
+ * After long insert/delete churn, malloc'd nodes sit wherever the
+ * allocator had holes, so consecutive levels of a lookup land on
+ * unrelated pages. Relayout copies every node into a fresh arena
+ * (see NODE ARENA), in one of two orders:
+ *
+ *   BFS: root, then level 1 left to right, then level 2, ... The top
+ *        levels, which every lookup reads, share a few pages.
+ *   vEB: a tree of height h is cut at h/2; the top half is laid out
+ *        (recursively), then each bottom subtree after it. Any
+ *        root-to-leaf path crosses O(log_B n) blocks for every block
+ *        size B at once.
+ *
+ * The work is a plan (the node order, each entry naming its parent's
+ * plan position and child slot) executed in bounded steps: copy the
+ * node into the next arena slot, repoint its parent (already moved,
+ * since parents come first in both orders), free the old node. The
+ * tree is consistent after every node, so it can be searched and
+ * modified between steps; a write invalidates the plan, and the next
+ * step re-plans, skipping nodes that already live in the new arena.
+ * Nodes that splits create meanwhile are allocated next to their
+ * sibling, i.e. in the new arena, but out of order; a relayout with no
+ * concurrent writes yields the exact order.
+ *
+ * Like btree_create_arena, this is for set trees without counts,
+ * fences or aggregates. The result is an arena tree.
+ * ================================================================ */
+
+typedef struct {
+    BTreeNode *node;   /* Node as found when planning */
+    BTreeNode *copy;   /* Its home in the new arena, once moved */
+    long parent;       /* Plan position of the parent, -1 for the root */
+    int slot;          /* Index in the parent's children[] */
+    int depth;
+} RelayoutEntry;
+
+struct BTreeRelayout {
+    BTree *tree;
+    BTreeLayout order;
+    BTreeArena *target;
+    BTreeArena *source;      /* Arena the tree lived in before, if any */
+    RelayoutEntry *plan;
+    long planned, cap;
+    long next;               /* First entry not yet executed */
+    unsigned long writes;    /* tree->writes when the plan was made */
+    bool failed;
+};
+
+static bool relayout_emit(BTreeRelayout *r, BTreeNode *node, long parent,
+                          int slot, int depth) {
+    if (r->planned == r->cap) {
+        long cap = r->cap ? 2 * r->cap : 1024;
+        RelayoutEntry *grown = (RelayoutEntry *)realloc(r->plan, cap * sizeof(RelayoutEntry));
+        if (!grown) return false;
+        r->plan = grown;
+        r->cap = cap;
+    }
+    r->plan[r->planned++] = (RelayoutEntry){ node, NULL, parent, slot, depth };
+    return true;
+}
+
+/*
+ * relayout_plan_veb - Emit the subtree of @height levels under @node
+ *
+ * Every node is emitted by the height-1 base case; the split only
+ * decides the order. After the top half is emitted, its deepest
+ * entries are found in the plan range it occupies, and each of their
+ * children roots a bottom subtree.
+ */
+static bool relayout_plan_veb(BTreeRelayout *r, BTreeNode *node, long parent,
+                              int slot, int depth, int height) {
+    if (height == 1) return relayout_emit(r, node, parent, slot, depth);
+
+    int top = height / 2;
+    long first = r->planned;
+    if (!relayout_plan_veb(r, node, parent, slot, depth, top)) return false;
+    long last = r->planned;
+
+    for (long pos = first; pos < last; pos++) {
+        BTreeNode *leaf = r->plan[pos].node;
+        if (r->plan[pos].depth != depth + top - 1 || leaf->is_leaf) continue;
+        for (int i = 0; i <= leaf->n; i++) {
+            if (!relayout_plan_veb(r, leaf->children[i], pos, i,
+                                   depth + top, height - top)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/* relayout_plan - (Re)build the plan from the tree as it is now */
+static bool relayout_plan(BTreeRelayout *r) {
+    r->planned = 0;
+    r->next = 0;
+    r->writes = r->tree->writes;
+
+    BTreeNode *root = r->tree->root;
+    if (r->order == BTREE_LAYOUT_VEB) {
+        int height = 1;
+        for (BTreeNode *n = root; !n->is_leaf; n = n->children[0]) height++;
+        return relayout_plan_veb(r, root, -1, 0, 0, height);
+    }
+
+    /* BFS: the plan doubles as the queue */
+    if (!relayout_emit(r, root, -1, 0, 0)) return false;
+    for (long pos = 0; pos < r->planned; pos++) {
+        BTreeNode *node = r->plan[pos].node;
+        if (node->is_leaf) continue;
+        for (int i = 0; i <= node->n; i++) {
+            if (!relayout_emit(r, node->children[i], pos, i, r->plan[pos].depth + 1)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool in_target(const BTreeRelayout *r, const BTreeNode *node) {
+    return node->in_arena && chunk_of(node)->arena == r->target;
+}
+
+/*
+ * btree_relayout_begin - Prepare an incremental relayout of @tree
+ *
+ * Every begin must be paired with btree_relayout_end before the tree
+ * is destroyed: until then its nodes may be split between malloc (or
+ * the old arena) and the new arena.
+ *
+ * Returns: handle for btree_relayout_step/end, or NULL if the tree has
+ *          counts, fences or aggregates, or on allocation failure
+ */
+BTreeRelayout *btree_relayout_begin(BTree *tree, BTreeLayout order) {
+    if (!tree || !tree->root) return NULL;
+    BTreeNode *root = tree->root;
+    if (root->counts || root->fences || root->aggregated) {
+        fprintf(stderr, "Error: relayout supports plain set trees only\n");
+        return NULL;
+    }
+
+    BTreeRelayout *r = (BTreeRelayout *)calloc(1, sizeof(BTreeRelayout));
+    if (!r) return NULL;
+    r->tree = tree;
+    r->order = order;
+    r->source = root->in_arena ? chunk_of(root)->arena : NULL;
+    r->target = arena_create(tree->t);
+    if (!r->target || !relayout_plan(r)) {
+        arena_destroy(r->target);
+        free(r->plan);
+        free(r);
+        return NULL;
+    }
+    return r;
+}
+
+/*
+ * btree_relayout_step - Move up to @max_nodes nodes
+ *
+ * Between steps the tree is valid and may be searched or modified;
+ * after a write the step first re-plans (one O(n) walk).
+ *
+ * Returns: 1 when every node lives in the new arena, 0 if work
+ *          remains, -1 if the new arena is exhausted (tree still valid)
+ */
+int btree_relayout_step(BTreeRelayout *r, long max_nodes) {
+    if (!r || r->failed) return -1;
+    if (r->writes != r->tree->writes && !relayout_plan(r)) return -1;
+
+    int t = r->tree->t;
+    long done = 0;
+    while (done < max_nodes && r->next < r->planned) {
+        RelayoutEntry *e = &r->plan[r->next];
+        BTreeNode *old = e->node;
+
+        if (in_target(r, old)) {
+            e->copy = old;  /* Moved before a re-plan, or created there: free */
+        } else {
+            BTreeNode *copy = alloc_node(r->target, t, old->is_leaf, NULL,
+                                         false, false, false);
+            if (!copy) {
+                r->failed = true;
+                return -1;
+            }
+            copy->n = old->n;
+            memcpy(copy->keys, old->keys, old->n * sizeof(int));
+            if (!old->is_leaf) {
+                memcpy(copy->children, old->children,
+                       (old->n + 1) * sizeof(BTreeNode *));
+            }
+            e->copy = copy;
+            free_node(old);
+            done++;
+        }
+
+        if (e->parent < 0) {
+            r->tree->root = e->copy;
+        } else {
+            r->plan[e->parent].copy->children[e->slot] = e->copy;
+        }
+        r->next++;
+    }
+    return r->next == r->planned ? 1 : 0;
+}
+
+/*
+ * btree_relayout_end - Finish any remaining steps and release @r
+ *
+ * The old arena (for a tree that was already arena-backed) is unmapped
+ * once no node is left in it.
+ *
+ * Returns: 0 on success, -1 if the relayout could not complete (the
+ *          tree is still valid; its nodes may span old and new memory)
+ */
+int btree_relayout_end(BTreeRelayout *r) {
+    if (!r) return -1;
+    int rc = btree_relayout_step(r, LONG_MAX);  /* Runs the plan to its end */
+    if (rc == 1 && r->source && r->source != r->target) {
+        arena_destroy(r->source);
+    }
+    /* On failure both arenas may still hold live nodes: keep them */
+    free(r->plan);
+    free(r);
+    return rc == 1 ? 0 : -1;
+}
+
+/*
+ * btree_relayout - Rewrite every node of @tree contiguously in @order
+ *
+ * Returns: 0 on success, -1 on error
+ */
+int btree_relayout(BTree *tree, BTreeLayout order) {
+    BTreeRelayout *r = btree_relayout_begin(tree, order);
+    return r ? btree_relayout_end(r) : -1;
+}
+
+/* ================================================================
+ * AUTO-TUNING
+ *
+ * The best t depends on the machine (cache line, L1/L2 size, TLB) and
+ * on the workload: searches favour nodes that fit a few cache lines,
+ * inserts/deletes pay for shifting keys and so prefer smaller nodes.
+ * btree_tune measures instead of guessing:
+ *
+ *   1. Candidates: powers of two whose key array spans from one cache
+ *      line up to half of L1d (each candidate's node must fit L2).
+ *   2. Each candidate runs the same seeded op stream three times on a
+ *      tree preloaded with n keys; the best run counts.
+ *   3. The two geometric midpoints around the winner are tried too.
+ * ================================================================ */
+
+static long cache_param(int name, long fallback) {
+    long v = sysconf(name);
+    return v > 0 ? v : fallback;
+}
+
+static double tune_now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint32_t tune_rand(uint32_t *state) {
+    /* xorshift32: fixed stream per run, independent of rand() */
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+/*
+ * tune_run - Ops/sec for one t on one workload mix
+ *
+ * Keys are drawn from [0, 2n), so inserts and deletes hit and miss
+ * about equally and the tree stays near n keys.
+ */
+static double tune_run(int t, BTreeWorkload workload, int n) {
+    int search_pct = workload == BTREE_WORKLOAD_SEARCH ? 90
+                   : workload == BTREE_WORKLOAD_MIXED  ? 50 : 10;
+    double best = 0;
+
+    for (int rep = 0; rep < 3; rep++) {
+        BTree *tree = btree_create(t);
+        if (!tree) return 0;
+        uint32_t rng = 0x9E3779B9u;
+        for (int i = 0; i < n; i++) {
+            btree_insert(tree, (int)(tune_rand(&rng) % (2u * n)));
+        }
+
+        volatile long hits = 0;
+        double start = tune_now_sec();
+        for (int i = 0; i < n; i++) {
+            uint32_t r = tune_rand(&rng);
+            int key = (int)(tune_rand(&rng) % (2u * n));
+            if ((int)(r % 100) < search_pct) {
+                hits += btree_search(tree->root, key, NULL) != NULL;
+            } else if (r & 0x100) {
+                btree_insert(tree, key);
+            } else {
+                btree_delete(tree, key);
+            }
+        }
+        double elapsed = tune_now_sec() - start;
+        btree_destroy(tree);
+
+        if (elapsed > 0 && n / elapsed > best) best = n / elapsed;
+    }
+    return best;
+}
+
+/* tune_record - Add a sweep result, keeping cand_t sorted */
+static void tune_record(BTreeTuning *out, int t, double ops) {
+    if (out->candidates >= BTREE_TUNE_MAX_CANDIDATES) return;
+    int i = out->candidates++;
+    while (i > 0 && out->cand_t[i - 1] > t) {
+        out->cand_t[i] = out->cand_t[i - 1];
+        out->cand_ops[i] = out->cand_ops[i - 1];
+        i--;
+    }
+    out->cand_t[i] = t;
+    out->cand_ops[i] = ops;
+    if (ops > out->ops_per_sec) {
+        out->ops_per_sec = ops;
+        out->t = t;
+    }
+}
+
+const char *btree_workload_name(BTreeWorkload workload) {
+    switch (workload) {
+    case BTREE_WORKLOAD_SEARCH: return "search";
+    case BTREE_WORKLOAD_MIXED:  return "mixed";
+    case BTREE_WORKLOAD_INSERT: return "insert";
+    }
+    return "unknown";
+}
+
+/*
+ * btree_tune - Pick the fastest t for a workload on this machine
+ *
+ * @n: keys in the measurement tree (<= 0 uses BTREE_TUNE_DEFAULT_KEYS);
+ *     should resemble the real tree size, since a tree that fits L2
+ *     favours different nodes than one that spills to DRAM
+ *
+ * Takes a few seconds at the default size.
+ *
+ * Returns: 0 on success, -1 if no candidate could be measured
+ */
+int btree_tune(BTreeWorkload workload, int n, BTreeTuning *out) {
+    if (n <= 0) n = BTREE_TUNE_DEFAULT_KEYS;
+    memset(out, 0, sizeof(*out));
+    out->workload = workload;
+
+#ifdef _SC_LEVEL1_DCACHE_SIZE
+    out->l1d = cache_param(_SC_LEVEL1_DCACHE_SIZE, 32 * 1024);
+    out->l2 = cache_param(_SC_LEVEL2_CACHE_SIZE, 1024 * 1024);
+    out->line = cache_param(_SC_LEVEL1_DCACHE_LINESIZE, 64);
+#else
+    out->l1d = 32 * 1024;
+    out->l2 = 1024 * 1024;
+    out->line = 64;
+#endif
+
+    /* Key array of (2t-1) ints spans [one line, L1d/2] */
+    int t_min = (int)(out->line / (2 * sizeof(int)));
+    int t_max = (int)(out->l1d / 2 / (2 * sizeof(int)));
+    if (t_min < 2) t_min = 2;
+    while ((long)(2 * t_max * (sizeof(int) + sizeof(BTreeNode *))) > out->l2) {
+        t_max /= 2;
+    }
+    if (t_max < t_min) t_max = t_min;
+
+    int t = 2;
+    while (t < t_min) t *= 2;
+    /* Always include t=2 as the binary-tree-like baseline */
+    if (t > 2) tune_record(out, 2, tune_run(2, workload, n));
+    for (; t <= t_max; t *= 2) {
+        tune_record(out, t, tune_run(t, workload, n));
+    }
+
+    /* Refine between the winner and its neighbours */
+    int best = out->t;
+    int lo = best * 3 / 4, hi = best * 3 / 2;
+    if (lo >= 2 && lo != best) tune_record(out, lo, tune_run(lo, workload, n));
+    if (hi != best) tune_record(out, hi, tune_run(hi, workload, n));
+
+    return out->ops_per_sec > 0 ? 0 : -1;
+}
+
+/*
+ * btree_tuning_path - Config file path (see b-tree.h)
+ */
+const char *btree_tuning_path(void) {
+    static char path[PATH_MAX];
+    const char *env = getenv("BTREE_TUNE_FILE");
+    if (env && *env) return env;
+    const char *home = getenv("HOME");
+    if (home && *home &&
+        snprintf(path, sizeof(path), "%s/.btree_tune", home) < (int)sizeof(path)) {
+        return path;
+    }
+    return ".btree_tune";
+}
+
+/*
+ * btree_tuning_save - Record tuning->t for its workload
+ *
+ * Lines for other workloads are kept; the file is replaced atomically
+ * via a temporary file and rename().
+ *
+ * Returns: 0 on success, -1 on I/O error
+ */
+int btree_tuning_save(const BTreeTuning *tuning, const char *path) {
+    if (!path) path = btree_tuning_path();
+
+    char tmp[PATH_MAX];
+    if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp)) return -1;
+    FILE *out = fopen(tmp, "w");
+    if (!out) return -1;
+
+    const char *name = btree_workload_name(tuning->workload);
+    FILE *in = fopen(path, "r");
+    if (in) {
+        char line[256], word[32];
+        while (fgets(line, sizeof(line), in)) {
+            if (sscanf(line, "%31s", word) == 1 && strcmp(word, name) == 0) continue;
+            fputs(line, out);
+        }
+        fclose(in);
+    }
+    fprintf(out, "%s %d %.0f\n", name, tuning->t, tuning->ops_per_sec);
+
+    if (fclose(out) != 0 || rename(tmp, path) != 0) {
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * btree_tuning_load - Read the saved t for a workload
+ *
+ * Only workload, t and ops_per_sec are filled; the sweep is not stored.
+ *
+ * Returns: 0 if found, -1 if the file or the workload line is missing
+ */
+int btree_tuning_load(BTreeWorkload workload, const char *path,
+                      BTreeTuning *out) {
+    if (!path) path = btree_tuning_path();
+    FILE *in = fopen(path, "r");
+    if (!in) return -1;
+
+    const char *name = btree_workload_name(workload);
+    char line[256], word[32];
+    int t;
+    double ops;
+    int found = -1;
+    while (fgets(line, sizeof(line), in)) {
+        if (sscanf(line, "%31s %d %lf", word, &t, &ops) == 3 &&
+            strcmp(word, name) == 0 && t >= 2) {
+            memset(out, 0, sizeof(*out));
+            out->workload = workload;
+            out->t = t;
+            out->ops_per_sec = ops;
+            found = 0;
+        }
+    }
+    fclose(in);
+    return found;
+}
+
+/*
+ * btree_create_auto - Create a B-Tree with the t tuned for this machine
+ *
+ * Uses the saved t for the workload; on first use it runs btree_tune
+ * at the default size and saves the result (a failed save is not an
+ * error, the tree is still created).
+ */
+BTree *btree_create_auto(BTreeWorkload workload) {
+    BTreeTuning tuning;
+    if (btree_tuning_load(workload, NULL, &tuning) != 0) {
+        if (btree_tune(workload, 0, &tuning) != 0) return NULL;
+        btree_tuning_save(&tuning, NULL);
+    }
+    return btree_create(tuning.t);
+}
@@ -20,14 +20,28 @@
  * [x] 2. CREATE / DESTROY
  *     - btree_create(): allocate tree and empty root
  *     - btree_destroy(): recursively free all nodes
+ *     - btree_create_arena(): nodes come from a huge-page arena, with
+ *       split siblings placed in the same 2 MiB page as their source
+ *     - btree_create_multimap(): duplicates kept as (key, count) entries
+ *     - btree_create_fenced(): nodes carry a fence array (every 16th
+ *       key) so in-node search touches one or two cache lines
+ *     - btree_create_bstar(): inserts redistribute before splitting
+ *     - btree_create_aggregate(): internal nodes keep a (count, sum,
+ *       min, max) summary per child for btree_range_aggregate()
  * 
  * [x] 3. INSERT (Proactive Splitting)
  *     - split_child(): split a full child before descending
  *     - insert_non_full(): insert into a node that has room
  *     - btree_insert(): handle root split specially
+ *     - B* policy: a full child first shifts keys into a sibling with
+ *       room (bulk borrow through the parent separator); two full
+ *       siblings split 2-to-3, leaving nodes about 2/3 full
  *
  * [x] 4. SEARCH
  *     - btree_search(): find key in tree, return node and index
+ *     - btree_count_key() / btree_equal_range(): multiplicity of a key
+ *     - btree_range_aggregate(): count/sum/min/max of keys in [lo, hi],
+ *       O(t log n) on aggregate trees (whole subtrees use their summary)
  *
  * [x] 5. DELETE (Complex - Multiple Cases)
  *     - Case 1: Key in leaf node
@@ -48,6 +62,29 @@
  *     - btree_height(): tree height
  *     - btree_count(): total key count
  *     - btree_validate(): check B-Tree invariants
+ *     - btree_validate_parallel(): same checks fanned out over threads,
+ *       filling BTreeStats (count, height, fill) in the same pass
+ *
+ * [x] 8. PERSISTENCE
+ *     - btree_save(): write a compact level-order image to a file
+ *     - btree_load(): rebuild the tree from one sequential read, in
+ *       the mode it was saved in (arena, fenced, B*, aggregate)
+ *
+ * [x] 9. BULK BUILD
+ *     - btree_build_parallel(): sort unsorted keys on several threads,
+ *       pack leaves per thread, then assemble internal levels
+ *
+ * [x] 10. AUTO-TUNING
+ *     - btree_tune(): time a workload mix across candidate t values
+ *       sized from the cache hierarchy, keep the fastest
+ *     - btree_create_auto(): use the t saved for this machine, tuning
+ *       (and saving) once if none is recorded
+ *
+ * [x] 11. RELAYOUT
+ *     - btree_relayout(): copy every node into a fresh arena in
+ *       breadth-first or van Emde Boas order, freeing the old ones
+ *     - btree_relayout_begin/step/end(): the same work in bounded
+ *       steps; the tree stays usable (and writable) in between
  * ============================================================ */
 
 #ifndef B_TREE_H
@@ -56,30 +93,71 @@
 #include <stdbool.h>
 #include <stdlib.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /* ---------- Data Structures ---------- */
 
+/* Summary of a set of keys; an empty set has count 0, min INT_MAX, max INT_MIN */
+typedef struct BTreeAggregate {
+    long count;
+    long long sum;
+    int min;
+    int max;
+} BTreeAggregate;
+
 typedef struct BTreeNode {
     int *keys;                    /* Array of keys (max 2t-1) */
     struct BTreeNode **children;  /* Array of child pointers (max 2t) */
     int n;                        /* Current number of keys */
     bool is_leaf;                 /* True if this is a leaf node */
+    bool in_arena;                /* True if carved from a node arena slot */
+    int *counts;                  /* Multiplicity per key (multimap), else NULL */
+    int *fences;                  /* keys[0], keys[16], ... (fenced), else NULL */
+    bool aggregated;              /* Part of an aggregate tree */
+    BTreeAggregate *aggs;         /* Per-child subtree summary (internal nodes
+                                     of aggregate trees), else NULL */
 } BTreeNode;
 
+#define BTREE_FENCE_STRIDE 16     /* Keys per fence: one 64-byte line of ints */
+
 typedef struct BTree {
     BTreeNode *root;
     int t;  /* Minimum degree: each node has [t-1, 2t-1] keys */
+    bool bstar;  /* Insert redistributes / splits 2-to-3 (btree_create_bstar) */
+    unsigned long writes;  /* Bumped by insert/delete (relayout re-plans) */
 } BTree;
 
+/* Shape statistics gathered during validation */
+typedef struct BTreeStats {
+    long keys;      /* Total keys (same as btree_count) */
+    long nodes;     /* Total nodes */
+    long leaves;    /* Leaf nodes */
+    int height;     /* Levels (same as btree_height) */
+    double fill;    /* keys / (nodes * (2t-1)): average node utilization */
+} BTreeStats;
+
 /* ---------- Create / Destroy ---------- */
 
 BTree *btree_create(int t);
+BTree *btree_create_arena(int t);
+BTree *btree_create_multimap(int t);
+BTree *btree_create_fenced(int t);
+BTree *btree_create_bstar(int t);
+BTree *btree_create_aggregate(int t);
 void btree_destroy(BTree *tree);
+BTree *btree_build_parallel(int t, const int *keys, int n, int threads);
 
 /* ---------- Core Operations ---------- */
 
 void btree_insert(BTree *tree, int key);
+bool btree_insert_unique(BTree *tree, int key);
 BTreeNode *btree_search(BTreeNode *node, int key, int *idx);
-void btree_delete(BTree *tree, int key);
+long btree_count_key(BTree *tree, int key);
+long btree_equal_range(BTree *tree, int key, BTreeNode **node, int *idx);
+BTreeAggregate btree_range_aggregate(BTree *tree, int lo, int hi);
+bool btree_delete(BTree *tree, int key);
 
 /* ---------- Traversal ---------- */
 
@@ -92,5 +170,82 @@ void btree_print_debug(BTree *tree);
 int btree_height(BTree *tree);
 int btree_count(BTree *tree);
 int btree_validate(BTree *tree);
+int btree_validate_stats(BTree *tree, BTreeStats *stats);
+int btree_validate_parallel(BTree *tree, int threads, BTreeStats *stats);
+
+/* ---------- Persistence ---------- */
+
+/*
+ * On-disk format (version 2, native endianness):
+ *   header:  magic "BTRE", version, t, height, node_count, key_count,
+ *            flags (BTREE_FILE_*: the mode the tree was created in)
+ *   nodes:   level order; each record is {n, is_leaf, first_child}
+ *            followed by n keys. Children of a node are the records
+ *            first_child .. first_child + n, so no pointers are stored.
+ * Fences and aggregates are rebuilt on load; multimap trees cannot be
+ * saved.
+ */
+#define BTREE_FILE_MAGIC   0x45525442u  /* "BTRE" little-endian */
+#define BTREE_FILE_VERSION 2u
+
+#define BTREE_FILE_ARENA     0x1u  /* btree_create_arena */
+#define BTREE_FILE_FENCED    0x2u  /* btree_create_fenced */
+#define BTREE_FILE_BSTAR     0x4u  /* btree_create_bstar */
+#define BTREE_FILE_AGGREGATE 0x8u  /* btree_create_aggregate */
+#define BTREE_FILE_FLAGS     0xfu  /* All known flags */
+
+int btree_save(BTree *tree, int fd);
+BTree *btree_load(int fd);
+
+/* ---------- Auto-Tuning ---------- */
+
+typedef enum {
+    BTREE_WORKLOAD_SEARCH,   /* 90% search, 10% insert/delete */
+    BTREE_WORKLOAD_MIXED,    /* 50% search, 50% insert/delete */
+    BTREE_WORKLOAD_INSERT    /* 10% search, 90% insert/delete */
+} BTreeWorkload;
+
+#define BTREE_TUNE_MAX_CANDIDATES 32
+#define BTREE_TUNE_DEFAULT_KEYS   200000
+
+typedef struct BTreeTuning {
+    BTreeWorkload workload;
+    int t;                  /* Chosen minimum degree */
+    double ops_per_sec;     /* Measured throughput at t */
+    long l1d, l2, line;     /* Cache sizes used to pick candidates (bytes) */
+    int candidates;         /* Sweep results, in increasing t */
+    int cand_t[BTREE_TUNE_MAX_CANDIDATES];
+    double cand_ops[BTREE_TUNE_MAX_CANDIDATES];
+} BTreeTuning;
+
+/*
+ * Config file: one "<workload> <t> <ops_per_sec>" line per workload.
+ * Path is $BTREE_TUNE_FILE, else $HOME/.btree_tune, else ./.btree_tune.
+ */
+const char *btree_workload_name(BTreeWorkload workload);
+int btree_tune(BTreeWorkload workload, int n, BTreeTuning *out);
+int btree_tuning_save(const BTreeTuning *tuning, const char *path);
+int btree_tuning_load(BTreeWorkload workload, const char *path,
+                      BTreeTuning *out);
+const char *btree_tuning_path(void);
+BTree *btree_create_auto(BTreeWorkload workload);
+
+/* ---------- Relayout ---------- */
+
+typedef enum {
+    BTREE_LAYOUT_BFS,   /* Level by level: upper levels packed together */
+    BTREE_LAYOUT_VEB    /* van Emde Boas: recursive top/bottom halves */
+} BTreeLayout;
+
+typedef struct BTreeRelayout BTreeRelayout;  /* Layout is private */
+
+int btree_relayout(BTree *tree, BTreeLayout order);
+BTreeRelayout *btree_relayout_begin(BTree *tree, BTreeLayout order);
+int btree_relayout_step(BTreeRelayout *relayout, long max_nodes);
+int btree_relayout_end(BTreeRelayout *relayout);
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif /* B_TREE_H */
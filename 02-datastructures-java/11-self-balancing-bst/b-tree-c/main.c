@@ -1,8 +1,24 @@
+/*
+ * B-Tree tests and benchmarks
+ *
+ * Compile: gcc -O2 -pthread -o btree_test main.c b-tree.c b-tree-forest.c \
+ *          b-tree-gapped.c b-tree-string.c -lm
+ * Usage:   ./btree_test [--bench | --all | --bench-<name> [args] |
+ *                        --tune [search|mixed|insert] [n]]
+ */
+
+#include <limits.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "b-tree.h"
+#include "b-tree-forest.h"
+#include "b-tree-gapped.h"
+#include "b-tree-string.h"
 
 /* ================================================================
  * TEST UTILITIES
@@ -80,6 +96,16 @@ static void test_insert_search(void) {
     ASSERT(btree_search(tree->root, 0, &idx) == NULL,
            "search returns NULL for missing key");
 
+    /* Set semantics: a present key is reported and left alone */
+    int dup_ok = 1;
+    for (int i = 0; i < n; i++) {
+        if (btree_insert_unique(tree, keys[i])) dup_ok = 0;
+    }
+    ASSERT(dup_ok && btree_count(tree) == n, "insert_unique rejects present keys");
+    ASSERT(btree_insert_unique(tree, 100), "insert_unique adds a new key");
+    ASSERT(btree_count(tree) == n + 1 && btree_validate(tree),
+           "tree valid after insert_unique");
+
     btree_destroy(tree);
 }
 
@@ -255,11 +281,13 @@ static void test_delete_nonexistent(void) {
     int count_before = btree_count(tree);
 
     /* Try to delete keys that don't exist */
-    btree_delete(tree, 100);  /* Too large */
-    btree_delete(tree, 0);    /* Too small */
-    btree_delete(tree, 5);    /* In range but not present */
+    bool removed = btree_delete(tree, 100);  /* Too large */
+    removed |= btree_delete(tree, 0);        /* Too small */
+    removed |= btree_delete(tree, 5);        /* In range but not present */
 
+    ASSERT(!removed, "delete reports missing keys");
     ASSERT(btree_count(tree) == count_before, "count unchanged");
+    ASSERT(btree_delete(tree, 4), "delete reports a removed key");
     ASSERT(btree_validate(tree), "tree still valid");
 
     btree_destroy(tree);
@@ -351,6 +379,1053 @@ static void test_large_random(void) {
     btree_destroy(tree);
 }
 
+/* ================================================================
+ * PERSISTENCE TESTS
+ * ================================================================ */
+
+static void test_save_load(void) {
+    TEST("Save and Load (Persistence)");
+
+    BTree *tree = btree_create(4);
+    int n = 5000;
+    int *keys = malloc(n * sizeof(int));
+    for (int i = 0; i < n; i++) {
+        keys[i] = i * 3;
+    }
+    shuffle(keys, n);
+    for (int i = 0; i < n; i++) {
+        btree_insert(tree, keys[i]);
+    }
+
+    FILE *fp = tmpfile();
+    int fd = fileno(fp);
+    ASSERT(btree_save(tree, fd) == 0, "btree_save succeeds");
+
+    lseek(fd, 0, SEEK_SET);
+    BTree *loaded = btree_load(fd);
+    ASSERT(loaded != NULL, "btree_load returns a tree");
+    ASSERT(loaded && loaded->t == tree->t, "minimum degree round-trips");
+    ASSERT(loaded && btree_count(loaded) == n, "key count round-trips");
+    ASSERT(loaded && btree_height(loaded) == btree_height(tree),
+           "height round-trips");
+    ASSERT(loaded && btree_validate(loaded), "loaded tree is valid");
+
+    int all_found = 1;
+    for (int i = 0; loaded && i < n; i++) {
+        if (!btree_search(loaded->root, keys[i], NULL)) all_found = 0;
+    }
+    ASSERT(all_found, "every key is found in loaded tree");
+    ASSERT(loaded && btree_search(loaded->root, 1, NULL) == NULL,
+           "missing key stays missing");
+
+    /* A truncated image must be rejected, not half-loaded */
+    struct stat st;
+    fstat(fd, &st);
+    ASSERT(ftruncate(fd, st.st_size / 2) == 0, "image truncated");
+    lseek(fd, 0, SEEK_SET);
+    ASSERT(btree_load(fd) == NULL, "truncated image is rejected");
+    fclose(fp);
+
+    /* Well-formed records describing a bad tree must be rejected too.
+     * Image layout: 40-byte header (height at offset 12), then the
+     * root's 16-byte record followed by its keys. */
+    BTree *small = btree_create(4);
+    for (int i = 0; i < 1000; i++) {
+        btree_insert(small, i);
+    }
+    fp = tmpfile();
+    fd = fileno(fp);
+    ASSERT(btree_save(small, fd) == 0, "btree_save succeeds");
+    int bad_key = 999999;
+    ASSERT(pwrite(fd, &bad_key, sizeof(bad_key), 56) == sizeof(bad_key),
+           "root key overwritten");
+    lseek(fd, 0, SEEK_SET);
+    ASSERT(btree_load(fd) == NULL, "image with unsorted keys is rejected");
+    fclose(fp);
+
+    fp = tmpfile();
+    fd = fileno(fp);
+    ASSERT(btree_save(small, fd) == 0, "btree_save succeeds");
+    uint32_t bad_height = (uint32_t)btree_height(small) + 1;
+    ASSERT(pwrite(fd, &bad_height, sizeof(bad_height), 12) == sizeof(bad_height),
+           "header height overwritten");
+    lseek(fd, 0, SEEK_SET);
+    ASSERT(btree_load(fd) == NULL, "image with wrong height is rejected");
+    fclose(fp);
+    btree_destroy(small);
+
+    /* Empty tree round-trip */
+    BTree *empty = btree_create(3);
+    fp = tmpfile();
+    fd = fileno(fp);
+    btree_save(empty, fd);
+    lseek(fd, 0, SEEK_SET);
+    BTree *empty_loaded = btree_load(fd);
+    ASSERT(empty_loaded && btree_count(empty_loaded) == 0 &&
+           btree_validate(empty_loaded), "empty tree round-trips");
+    fclose(fp);
+
+    btree_destroy(empty_loaded);
+    btree_destroy(empty);
+    btree_destroy(loaded);
+    btree_destroy(tree);
+    free(keys);
+}
+
+/* ================================================================
+ * PARALLEL VALIDATION TESTS
+ * ================================================================ */
+
+/* roundtrip - Save @tree to a temporary file and load it back */
+static BTree *roundtrip(BTree *tree) {
+    FILE *fp = tmpfile();
+    int fd = fileno(fp);
+    BTree *loaded = NULL;
+    if (btree_save(tree, fd) == 0) {
+        lseek(fd, 0, SEEK_SET);
+        loaded = btree_load(fd);
+    }
+    fclose(fp);
+    return loaded;
+}
+
+static void test_save_load_modes(void) {
+    TEST("Save and Load Keep the Tree Mode");
+
+    const char *names[] = {"arena", "fenced", "B*", "aggregate"};
+    BTree *(*creators[])(int) = {btree_create_arena, btree_create_fenced,
+                                 btree_create_bstar, btree_create_aggregate};
+    int degrees[] = {4, 64, 4, 4};
+    int n = 3000;
+    int *keys = malloc(n * sizeof(int));
+    char msg[96];
+
+    for (int m = 0; m < 4; m++) {
+        BTree *tree = creators[m](degrees[m]);
+        for (int i = 0; i < n; i++) {
+            keys[i] = i * 2;
+        }
+        shuffle(keys, n);
+        for (int i = 0; i < n; i++) {
+            btree_insert(tree, keys[i]);
+        }
+
+        BTree *loaded = roundtrip(tree);
+        int same_mode = loaded &&
+                        loaded->root->in_arena == tree->root->in_arena &&
+                        (loaded->root->fences != NULL) == (tree->root->fences != NULL) &&
+                        loaded->bstar == tree->bstar &&
+                        loaded->root->aggregated == tree->root->aggregated;
+        snprintf(msg, sizeof(msg), "%s tree loads back in %s mode", names[m], names[m]);
+        ASSERT(same_mode, msg);
+
+        int all_found = loaded != NULL && btree_count(loaded) == n;
+        for (int i = 0; all_found && i < n; i++) {
+            if (!btree_search(loaded->root, keys[i], NULL)) all_found = 0;
+        }
+        snprintf(msg, sizeof(msg), "%s tree keeps every key", names[m]);
+        ASSERT(all_found, msg);
+
+        /* Rebuilt fences/summaries must keep up with further updates */
+        for (int i = 0; loaded && i < n; i++) {
+            btree_insert(loaded, keys[i] + 1);
+            if (i % 2) btree_delete(loaded, keys[i]);
+        }
+        snprintf(msg, sizeof(msg), "%s tree stays valid under updates after load",
+                 names[m]);
+        ASSERT(loaded && btree_validate(loaded) && btree_count(loaded) == n + n / 2, msg);
+
+        btree_destroy(loaded);
+        btree_destroy(tree);
+    }
+
+    BTree *mm = btree_create_multimap(3);
+    btree_insert(mm, 1);
+    FILE *fp = tmpfile();
+    ASSERT(btree_save(mm, fileno(fp)) == -1, "multimap tree is refused by save");
+    fclose(fp);
+    btree_destroy(mm);
+    free(keys);
+}
+
+static void test_validate_parallel(void) {
+    TEST("Parallel Validation and Statistics");
+
+    BTree *tree = btree_create(3);
+    int n = 20000;
+    int *keys = malloc(n * sizeof(int));
+    for (int i = 0; i < n; i++) {
+        keys[i] = i;
+    }
+    shuffle(keys, n);
+    for (int i = 0; i < n; i++) {
+        btree_insert(tree, keys[i]);
+    }
+
+    BTreeStats serial, parallel;
+    ASSERT(btree_validate_stats(tree, &serial), "serial validator passes");
+    ASSERT(btree_validate_parallel(tree, 4, &parallel),
+           "parallel validator passes");
+    ASSERT(parallel.keys == btree_count(tree), "stats.keys matches btree_count");
+    ASSERT(parallel.height == btree_height(tree),
+           "stats.height matches btree_height");
+    ASSERT(parallel.nodes == serial.nodes && parallel.leaves == serial.leaves,
+           "node and leaf counts match serial pass");
+    ASSERT(parallel.fill > 0.5 && parallel.fill <= 1.0,
+           "fill factor within B-Tree bounds");
+
+    /* Break ordering in one leaf: both validators must reject it */
+    BTreeNode *leaf = tree->root;
+    while (!leaf->is_leaf) {
+        leaf = leaf->children[leaf->n / 2];
+    }
+    int saved = leaf->keys[0];
+    leaf->keys[0] = n + 1;
+    ASSERT(!btree_validate(tree), "serial validator rejects corruption");
+    ASSERT(!btree_validate_parallel(tree, 4, NULL),
+           "parallel validator rejects corruption");
+    leaf->keys[0] = saved;
+
+    /* Small tree (root is a leaf) takes the serial path */
+    BTree *small = btree_create(3);
+    btree_insert(small, 1);
+    ASSERT(btree_validate_parallel(small, 8, &parallel) && parallel.height == 1,
+           "single-node tree validates in parallel mode");
+
+    btree_destroy(small);
+    btree_destroy(tree);
+    free(keys);
+}
+
+/* ================================================================
+ * BULK BUILD TESTS
+ * ================================================================ */
+
+static void test_build_parallel(void) {
+    TEST("Parallel Bulk Build");
+
+    int sizes[] = {0, 1, 5, 6, 7, 11, 12, 100, 1000, 12345};
+    int degrees[] = {2, 3, 50};
+    int all_ok = 1;
+
+    for (int d = 0; d < 3; d++) {
+        for (int s = 0; s < 10; s++) {
+            int n = sizes[s];
+            int *keys = malloc((n + 1) * sizeof(int));
+            for (int i = 0; i < n; i++) {
+                keys[i] = i * 2;
+            }
+            shuffle(keys, n);
+
+            for (int threads = 1; threads <= 4; threads += 3) {
+                BTree *tree = btree_build_parallel(degrees[d], keys, n, threads);
+                int ok = tree && btree_validate(tree) && btree_count(tree) == n;
+                for (int i = 0; ok && i < n; i++) {
+                    ok = btree_search(tree->root, keys[i], NULL) != NULL;
+                }
+                if (!ok) {
+                    printf("  FAIL: t=%d n=%d threads=%d\n",
+                           degrees[d], n, threads);
+                    all_ok = 0;
+                }
+                btree_destroy(tree);
+            }
+            free(keys);
+        }
+    }
+    ASSERT(all_ok, "built trees are valid and complete for all n, t, threads");
+
+    /* Duplicates collapse to one key, as with btree_insert + validate */
+    int dups[] = {5, 3, 5, 1, 3, 5, 9, 1};
+    BTree *tree = btree_build_parallel(2, dups, 8, 3);
+    ASSERT(tree && btree_count(tree) == 4 && btree_validate(tree),
+           "duplicate keys are stored once");
+
+    /* A built tree supports normal updates afterwards */
+    for (int i = 100; i < 200; i++) {
+        btree_insert(tree, i);
+    }
+    btree_delete(tree, 5);
+    ASSERT(btree_validate(tree) && btree_count(tree) == 103,
+           "insert/delete work on a bulk-built tree");
+    btree_destroy(tree);
+}
+
+/* ================================================================
+ * ARENA TESTS
+ * ================================================================ */
+
+static void test_arena(void) {
+    TEST("Huge-Page Node Arena");
+
+    BTree *tree = btree_create_arena(3);
+    ASSERT(tree != NULL, "btree_create_arena returns non-NULL");
+    ASSERT(tree->root->in_arena, "root lives in the arena");
+
+    int n = 20000;
+    int *keys = malloc(n * sizeof(int));
+    for (int i = 0; i < n; i++) {
+        keys[i] = i;
+    }
+    shuffle(keys, n);
+    for (int i = 0; i < n; i++) {
+        btree_insert(tree, keys[i]);
+    }
+    ASSERT(btree_count(tree) == n && btree_validate(tree),
+           "arena tree valid after random inserts");
+
+    BTreeNode *left = tree->root->children[0];
+    BTreeNode *right = tree->root->children[1];
+    ASSERT(left->in_arena && right->in_arena, "split children are arena nodes");
+    long gap = labs((long)((char *)right - (char *)left));
+    ASSERT(gap < (2L << 20), "split siblings share a 2 MiB chunk");
+
+    /* Deletes return slots to the arena; reinserts reuse them */
+    shuffle(keys, n);
+    for (int i = 0; i < n / 2; i++) {
+        btree_delete(tree, keys[i]);
+    }
+    for (int i = 0; i < n / 2; i++) {
+        btree_insert(tree, keys[i]);
+    }
+    ASSERT(btree_count(tree) == n && btree_validate(tree),
+           "arena tree valid after delete/reinsert churn");
+
+    btree_destroy(tree);
+    free(keys);
+}
+
+/* ================================================================
+ * MULTIMAP TESTS
+ * ================================================================ */
+
+static void test_multimap(void) {
+    TEST("Multimap (Duplicate Keys as Counts)");
+
+    BTree *tree = btree_create_multimap(2);
+    ASSERT(tree != NULL && btree_validate(tree), "empty multimap is valid");
+
+    /* Reference multiplicities for keys in [0, 200) */
+    int universe = 200;
+    int *expected = calloc(universe, sizeof(int));
+    int ok = 1;
+
+    for (int round = 0; round < 20000; round++) {
+        /* Skewed: low keys are hit far more often */
+        int key = (rand() % universe) * (rand() % universe) / universe;
+        if (rand() % 3 == 0) {
+            btree_delete(tree, key);
+            if (expected[key] > 0) expected[key]--;
+        } else {
+            btree_insert(tree, key);
+            expected[key]++;
+        }
+        if (round % 2000 == 0 && !btree_validate(tree)) ok = 0;
+    }
+    ASSERT(ok, "tree valid throughout insert/delete churn");
+    ASSERT(btree_validate(tree), "tree valid after churn");
+
+    int distinct = 0, counts_ok = 1;
+    for (int k = 0; k < universe; k++) {
+        if (expected[k] > 0) distinct++;
+        if (btree_count_key(tree, k) != expected[k]) counts_ok = 0;
+    }
+    ASSERT(counts_ok, "btree_count_key matches reference for every key");
+    ASSERT(btree_count(tree) == distinct, "btree_count counts distinct keys");
+
+    BTreeNode *node;
+    int idx;
+    long run = btree_equal_range(tree, 0, &node, &idx);
+    ASSERT(run == expected[0] && (run == 0 || node->keys[idx] == 0),
+           "btree_equal_range returns the run for a key");
+    ASSERT(btree_equal_range(tree, universe + 5, &node, &idx) == 0 &&
+           node == NULL, "btree_equal_range is empty for a missing key");
+
+    /* Draining every occurrence empties the tree */
+    for (int k = 0; k < universe; k++) {
+        while (expected[k]-- > 0) {
+            btree_delete(tree, k);
+        }
+    }
+    ASSERT(btree_count(tree) == 0 && btree_validate(tree),
+           "tree empty after deleting every occurrence");
+
+    /* Set trees answer count queries with 0/1 */
+    BTree *set = btree_create(3);
+    btree_insert(set, 7);
+    ASSERT(btree_count_key(set, 7) == 1 && btree_count_key(set, 8) == 0,
+           "set tree count_key is 0/1");
+
+    btree_destroy(set);
+    btree_destroy(tree);
+    free(expected);
+}
+
+/* make_url - Write a URL-like key for id into buf; returns its length */
+static int make_url(char *buf, size_t size, unsigned int id) {
+    static const char *hosts[] = {
+        "example.com", "docs.example.com", "cdn.static-assets.net",
+        "en.wikipedia.org", "github.com", "news.ycombinator.com"
+    };
+    static const char *dirs[] = {
+        "articles", "images", "api/v2/users", "wiki", "blob/main/src", "item"
+    };
+    unsigned int h = id * 2654435761u;
+    return snprintf(buf, size, "https://%s/%s/%u/page-%u?id=%u",
+                    hosts[h % 6], dirs[(h >> 8) % 6], (h >> 16) % 97,
+                    (h >> 4) % 1000, id);
+}
+
+static void test_string_keys(void) {
+    TEST("String Keys (Slotted Pages)");
+
+    ASSERT(sbtree_create(100) == NULL, "rejects page size below minimum");
+
+    SBTree *tree = sbtree_create(1024);  /* Small pages force deep trees */
+    ASSERT(tree != NULL && sbtree_validate(tree), "empty tree is valid");
+
+    int n = 20000;
+    char buf[256];
+    int ok = 1;
+    for (int i = 0; i < n; i++) {
+        int len = make_url(buf, sizeof(buf), (unsigned int)(rand() % (2 * n)));
+        int rc = sbtree_insert(tree, buf, len);
+        if (rc < 0) ok = 0;
+        if (i % 5000 == 0 && !sbtree_validate(tree)) ok = 0;
+    }
+    ASSERT(ok, "random URL inserts succeed and stay valid");
+    ASSERT(sbtree_validate(tree), "tree valid after inserts");
+    ASSERT(tree->height > 2, "small pages produce a multi-level tree");
+
+    int found = 1;
+    long present = 0;
+    for (unsigned int id = 0; id < (unsigned int)(2 * n); id++) {
+        int len = make_url(buf, sizeof(buf), id);
+        bool in = sbtree_contains(tree, buf, len);
+        present += in;
+        /* Re-inserting answers whether it was already there */
+        if (sbtree_insert(tree, buf, len) != (in ? 0 : 1)) found = 0;
+        if (!sbtree_contains(tree, buf, len)) found = 0;
+        /* A strict prefix of a stored key is a different key */
+        if (sbtree_contains(tree, buf, len - 1) &&
+            sbtree_insert(tree, buf, len - 1) != 0) found = 0;
+    }
+    ASSERT(found, "contains and duplicate detection agree");
+    ASSERT(tree->keys == 2 * n && sbtree_validate(tree),
+           "key count matches after filling every id");
+
+    /* Keys sharing long prefixes and differing only at the end */
+    SBTree *shared = sbtree_create(1024);
+    memset(buf, 'a', 100);
+    for (int i = 0; i < 2000; i++) {
+        int len = 100 + snprintf(buf + 100, sizeof(buf) - 100, "%d", i);
+        sbtree_insert(shared, buf, len);
+    }
+    buf[100] = '\0';
+    ASSERT(sbtree_insert(shared, "", 0) == 1 && sbtree_contains(shared, "", 0),
+           "empty key is a valid key");
+    ASSERT(sbtree_insert(shared, buf, 100) == 1 && sbtree_validate(shared),
+           "long shared prefixes stay valid");
+    SBTreeStats stats;
+    sbtree_stats(shared, &stats);
+    ASSERT(stats.keys == 2002 && stats.prefix_saved > 0,
+           "per-page prefixes elide shared bytes");
+
+    char big[SBTREE_MAX_KEY + 1];
+    memset(big, 'x', sizeof(big));
+    ASSERT(sbtree_insert(tree, big, tree->max_key_len + 1) == -1,
+           "keys over max_key_len are rejected");
+
+    sbtree_destroy(shared);
+    sbtree_destroy(tree);
+}
+
+/* ================================================================
+ * FENCE INDEX TESTS
+ * ================================================================ */
+
+static void test_fenced(void) {
+    TEST("Fenced Nodes (In-Node Micro-Index)");
+
+    /* t=2 has one fence per node; t=100 has up to 13 */
+    int degrees[] = {2, 9, 100};
+    int universe = 20000;
+    char *present = malloc(universe);
+
+    for (int d = 0; d < 3; d++) {
+        BTree *tree = btree_create_fenced(degrees[d]);
+        memset(present, 0, universe);
+        int ok = tree != NULL;
+
+        /* Churn exercises split, merge, both borrows and leaf shifts */
+        for (int round = 0; ok && round < 60000; round++) {
+            int key = rand() % universe;
+            if (round < 20000 || rand() % 2) {
+                if (!present[key]) btree_insert(tree, key);
+                present[key] = 1;
+            } else {
+                btree_delete(tree, key);
+                present[key] = 0;
+            }
+            if (round % 5000 == 0 && !btree_validate(tree)) ok = 0;
+        }
+        int found_ok = 1;
+        for (int k = 0; ok && k < universe; k++) {
+            if ((btree_search(tree->root, k, NULL) != NULL) != present[k]) {
+                found_ok = 0;
+            }
+        }
+
+        printf("  (t=%d)\n", degrees[d]);
+        ASSERT(ok && btree_validate(tree), "fences stay consistent under churn");
+        ASSERT(found_ok, "fenced search agrees with reference set");
+
+        for (int k = 0; k < universe; k++) {
+            btree_delete(tree, k);
+        }
+        ASSERT(btree_count(tree) == 0 && btree_validate(tree),
+               "tree empty after deleting everything");
+        btree_destroy(tree);
+    }
+    free(present);
+}
+
+/* ================================================================
+ * GAPPED LEAF TESTS
+ * ================================================================ */
+
+static void test_gapped(void) {
+    TEST("Gapped Leaves (Packed-Memory-Array)");
+
+    ASSERT(gbtree_create(1) == NULL, "rejects t < 2");
+
+    int degrees[] = {2, 5, 50};
+    int universe = 20000;
+    char *present = malloc(universe);
+
+    for (int d = 0; d < 3; d++) {
+        GBTree *tree = gbtree_create(degrees[d]);
+        memset(present, 0, universe);
+        int ok = tree != NULL && gbtree_validate(tree);
+        long expected = 0;
+
+        /* Grow, then churn: splits, re-spreads, borrows and merges */
+        for (int round = 0; ok && round < 60000; round++) {
+            int key = rand() % universe;
+            if (round < 20000 || rand() % 2) {
+                if (gbtree_insert(tree, key) != !present[key]) ok = 0;
+                if (!present[key]) expected++;
+                present[key] = 1;
+            } else {
+                if (gbtree_delete(tree, key) != present[key]) ok = 0;
+                if (present[key]) expected--;
+                present[key] = 0;
+            }
+            if (round % 5000 == 0 && !gbtree_validate(tree)) ok = 0;
+        }
+        int found_ok = 1;
+        for (int k = 0; ok && k < universe; k++) {
+            if (gbtree_search(tree, k) != present[k]) found_ok = 0;
+        }
+
+        printf("  (t=%d)\n", degrees[d]);
+        ASSERT(ok && gbtree_validate(tree), "valid under insert/delete churn");
+        ASSERT(found_ok && gbtree_count(tree) == expected,
+               "search and count agree with reference set");
+
+        /* Ascending inserts hit the trailing-gap path every time */
+        for (int k = universe; k < universe + 5000; k++) {
+            gbtree_insert(tree, k);
+        }
+        for (int k = 0; k < universe + 5000; k++) {
+            gbtree_delete(tree, k);
+        }
+        ASSERT(gbtree_count(tree) == 0 && gbtree_height(tree) == 1 &&
+               gbtree_validate(tree), "tree empty after deleting everything");
+        gbtree_destroy(tree);
+    }
+    free(present);
+}
+
+/* ================================================================
+ * B* INSERT POLICY TESTS
+ * ================================================================ */
+
+static void test_bstar(void) {
+    TEST("B* Insert Policy (Redistribute, 2-to-3 Split)");
+
+    int degrees[] = {2, 3, 50};
+    int universe = 20000;
+    char *present = malloc(universe);
+
+    for (int d = 0; d < 3; d++) {
+        int t = degrees[d];
+        BTree *tree = btree_create_bstar(t);
+        BTree *plain = btree_create(t);
+        memset(present, 0, universe);
+        int ok = tree != NULL && tree->bstar;
+
+        /* Random inserts only: shifts and 2-to-3 splits at every level */
+        for (int round = 0; ok && round < 15000; round++) {
+            int key = rand() % universe;
+            if (!present[key]) {
+                btree_insert(tree, key);
+                btree_insert(plain, key);
+            }
+            present[key] = 1;
+            if (round % 3000 == 0 && !btree_validate(tree)) ok = 0;
+        }
+        BTreeStats bs, ps;
+        btree_validate_stats(tree, &bs);
+        btree_validate_stats(plain, &ps);
+
+        printf("  (t=%d, fill %.1f%% vs. %.1f%%)\n", t, bs.fill * 100.0,
+               ps.fill * 100.0);
+        ASSERT(ok && btree_validate(tree), "valid after random inserts");
+        ASSERT(bs.keys == ps.keys, "same key count as 50/50 policy");
+        ASSERT(bs.fill > ps.fill, "higher fill than 50/50 policy");
+
+        /* Deletes reuse the same (k = 1) borrows; mix both */
+        for (int round = 0; ok && round < 40000; round++) {
+            int key = rand() % universe;
+            if (rand() % 2) {
+                if (!present[key]) btree_insert(tree, key);
+                present[key] = 1;
+            } else {
+                btree_delete(tree, key);
+                present[key] = 0;
+            }
+            if (round % 5000 == 0 && !btree_validate(tree)) ok = 0;
+        }
+        int found_ok = 1;
+        for (int k = 0; ok && k < universe; k++) {
+            if ((btree_search(tree->root, k, NULL) != NULL) != present[k]) {
+                found_ok = 0;
+            }
+        }
+        ASSERT(ok && btree_validate(tree), "valid under insert/delete churn");
+        ASSERT(found_ok, "search agrees with reference set");
+        btree_destroy(tree);
+        btree_destroy(plain);
+    }
+
+    /* The policy moves counts[] and fences[] along with keys */
+    BTree *mm = btree_create_multimap(3);
+    BTree *fenced = btree_create_fenced(20);
+    mm->bstar = fenced->bstar = true;
+    for (int i = 0; i < 20000; i++) {
+        btree_insert(mm, rand() % 500);
+        btree_insert(fenced, i * 7919 % 20011);
+    }
+    long total = 0;
+    for (int k = 0; k < 500; k++) total += btree_count_key(mm, k);
+    ASSERT(btree_validate(mm) && total == 20000, "multimap counts preserved");
+    ASSERT(btree_validate(fenced) && btree_count(fenced) == 20000,
+           "fences consistent after redistribution");
+    btree_destroy(mm);
+    btree_destroy(fenced);
+    free(present);
+}
+
+/* ================================================================
+ * AGGREGATE TESTS
+ * ================================================================ */
+
+/* Reference answer: scan the presence array */
+static BTreeAggregate brute_aggregate(const char *present, int universe,
+                                      int lo, int hi) {
+    BTreeAggregate a = {0, 0, INT_MAX, INT_MIN};
+    for (int k = lo < 0 ? 0 : lo; k <= hi && k < universe; k++) {
+        if (!present[k]) continue;
+        a.count++;
+        a.sum += k;
+        if (k < a.min) a.min = k;
+        if (k > a.max) a.max = k;
+    }
+    return a;
+}
+
+static int same_aggregate(BTreeAggregate a, BTreeAggregate b) {
+    return a.count == b.count && a.sum == b.sum && a.min == b.min &&
+           a.max == b.max;
+}
+
+static void test_aggregate(void) {
+    TEST("Aggregate-Augmented Range Queries");
+
+    int degrees[] = {2, 3, 20};
+    int universe = 20000;
+    char *present = malloc(universe);
+
+    for (int d = 0; d < 4; d++) {
+        int t = degrees[d % 3];
+        BTree *tree = btree_create_aggregate(t);
+        BTree *plain = btree_create(t);
+        if (d == 3) tree->bstar = true;  /* Redistribution moves aggs too */
+        memset(present, 0, universe);
+        int ok = tree != NULL && btree_validate(tree);
+
+        /* Churn runs every split, merge and borrow path; repeated keys
+         * must be rejected without touching the summaries */
+        for (int round = 0; ok && round < 60000; round++) {
+            int key = rand() % universe;
+            if (round < 20000 || rand() % 2) {
+                if (btree_insert_unique(tree, key) != !present[key]) ok = 0;
+                if (!present[key]) btree_insert(plain, key);
+                present[key] = 1;
+            } else {
+                if (btree_delete(tree, key) != present[key]) ok = 0;
+                btree_delete(plain, key);
+                present[key] = 0;
+            }
+            if (round % 5000 == 0 && !btree_validate(tree)) ok = 0;
+        }
+
+        int query_ok = 1, scan_ok = 1;
+        for (int q = 0; ok && q < 500; q++) {
+            int lo = rand() % (universe + 200) - 100;
+            int hi = lo + rand() % (q % 2 ? 100 : universe);
+            BTreeAggregate want = brute_aggregate(present, universe, lo, hi);
+            if (!same_aggregate(btree_range_aggregate(tree, lo, hi), want)) query_ok = 0;
+            if (!same_aggregate(btree_range_aggregate(plain, lo, hi), want)) scan_ok = 0;
+        }
+
+        /* Summaries are not in the image: load must rebuild them */
+        BTree *loaded = roundtrip(tree);
+        int reload_ok = loaded != NULL && loaded->root->aggregated;
+        for (int q = 0; reload_ok && q < 2000; q++) {
+            int lo = rand() % (universe + 200) - 100;
+            int hi = lo + rand() % (q % 2 ? 100 : universe);
+            BTreeAggregate want = brute_aggregate(present, universe, lo, hi);
+            if (!same_aggregate(btree_range_aggregate(loaded, lo, hi), want)) reload_ok = 0;
+        }
+
+        printf("  (t=%d%s)\n", t, d == 3 ? ", B*" : "");
+        ASSERT(ok && btree_validate(tree), "summaries stay exact under churn");
+        ASSERT(query_ok, "range aggregates match brute force");
+        ASSERT(scan_ok, "plain tree answers by scanning");
+        ASSERT(reload_ok, "reloaded tree answers range aggregates");
+        btree_destroy(loaded);
+        btree_destroy(tree);
+        btree_destroy(plain);
+    }
+
+    /* A stale top-level summary must fail both validators: the
+     * parallel one checks the root while expanding, not in a worker */
+    BTree *stale = btree_create_aggregate(3);
+    for (int i = 0; i < 2000; i++) btree_insert(stale, i);
+    ASSERT(btree_validate(stale) && btree_validate_parallel(stale, 4, NULL),
+           "aggregate tree validates serially and in parallel");
+    stale->root->aggs[0].sum += 1;
+    ASSERT(!btree_validate(stale), "serial validator rejects stale root aggs");
+    ASSERT(!btree_validate_parallel(stale, 4, NULL),
+           "parallel validator rejects stale root aggs");
+    stale->root->aggs[0].sum -= 1;
+    btree_destroy(stale);
+
+    BTree *tree = btree_create_aggregate(3);
+    BTreeAggregate empty = btree_range_aggregate(tree, INT_MIN, INT_MAX);
+    ASSERT(empty.count == 0 && empty.min == INT_MAX && empty.max == INT_MIN,
+           "empty tree gives the empty summary");
+    btree_insert(tree, INT_MIN);
+    btree_insert(tree, INT_MAX);
+    BTreeAggregate ends = btree_range_aggregate(tree, INT_MIN, INT_MAX);
+    ASSERT(ends.count == 2 && ends.sum == -1LL, "extreme keys included");
+    ASSERT(btree_range_aggregate(tree, 5, 4).count == 0, "lo > hi is empty");
+    btree_destroy(tree);
+    free(present);
+}
+
+/* ================================================================
+ * RELAYOUT TESTS
+ * ================================================================ */
+
+/* bfs_addresses_increase - True if BFS order matches address order */
+static int bfs_addresses_increase(BTree *tree) {
+    int cap = btree_count(tree) + 1, head = 0, tail = 0, ok = 1;
+    BTreeNode **queue = malloc(cap * sizeof(BTreeNode *));
+    queue[tail++] = tree->root;
+    while (head < tail) {
+        BTreeNode *node = queue[head++];
+        if (head > 1 && (char *)node <= (char *)queue[head - 2]) ok = 0;
+        for (int i = 0; !node->is_leaf && i <= node->n; i++) {
+            queue[tail++] = node->children[i];
+        }
+    }
+    free(queue);
+    return ok;
+}
+
+static void test_relayout(void) {
+    TEST("Relayout (BFS / vEB Order)");
+
+    int universe = 20000;
+    char *present = calloc(universe, 1);
+    BTree *tree = btree_create(3);
+
+    /* Churned malloc tree */
+    for (int round = 0; round < 40000; round++) {
+        int key = rand() % universe;
+        if (round < 15000 || rand() % 2) {
+            if (!present[key]) btree_insert(tree, key);
+            present[key] = 1;
+        } else {
+            btree_delete(tree, key);
+            present[key] = 0;
+        }
+    }
+
+    ASSERT(btree_relayout(tree, BTREE_LAYOUT_BFS) == 0, "BFS relayout succeeds");
+    int found_ok = 1;
+    for (int k = 0; k < universe; k++) {
+        if ((btree_search(tree->root, k, NULL) != NULL) != present[k]) found_ok = 0;
+    }
+    ASSERT(btree_validate(tree) && found_ok, "tree intact after BFS relayout");
+    ASSERT(tree->root->in_arena, "nodes now live in an arena");
+    ASSERT(bfs_addresses_increase(tree), "BFS order is address order");
+
+    /* Arena tree -> fresh arena, vEB order (the old arena is released) */
+    int height = btree_height(tree);
+    ASSERT(btree_relayout(tree, BTREE_LAYOUT_VEB) == 0, "vEB relayout succeeds");
+    ASSERT(btree_validate(tree) && btree_height(tree) == height,
+           "tree intact after vEB relayout");
+    ASSERT(height < 3 || !bfs_addresses_increase(tree), "vEB order differs from BFS");
+
+    /* Incremental: write, read and validate between small steps */
+    BTreeRelayout *r = btree_relayout_begin(tree, BTREE_LAYOUT_BFS);
+    int steps = 0, ok = r != NULL, rc = 0;
+    while (ok && (rc = btree_relayout_step(r, 50)) == 0) {
+        for (int i = 0; i < 20; i++) {
+            int key = rand() % universe;
+            if (rand() % 2) {
+                if (!present[key]) btree_insert(tree, key);
+                present[key] = 1;
+            } else {
+                btree_delete(tree, key);
+                present[key] = 0;
+            }
+        }
+        if (!btree_validate(tree)) ok = 0;
+        steps++;
+    }
+    ASSERT(ok && rc == 1 && steps > 1, "incremental steps interleave with writes");
+    ASSERT(btree_relayout_end(r) == 0, "btree_relayout_end completes");
+    found_ok = 1;
+    for (int k = 0; k < universe; k++) {
+        if ((btree_search(tree->root, k, NULL) != NULL) != present[k]) found_ok = 0;
+    }
+    ASSERT(btree_validate(tree) && found_ok, "tree intact after incremental relayout");
+
+    /* Nodes split off mid-relayout sit wherever the arena put them */
+    ASSERT(btree_relayout(tree, BTREE_LAYOUT_BFS) == 0 && bfs_addresses_increase(tree),
+           "quiet relayout restores strict BFS order");
+    btree_destroy(tree);
+
+    BTree *mm = btree_create_multimap(3);
+    ASSERT(btree_relayout(mm, BTREE_LAYOUT_BFS) == -1, "multimap tree rejected");
+    btree_destroy(mm);
+    free(present);
+}
+
+/* ================================================================
+ * FOREST TESTS
+ * ================================================================ */
+
+typedef struct {
+    BTreeForest *forest;
+    int first;       /* Keys first, first + stride, ... are this client's */
+    int stride;
+    int count;
+    int ok;
+} ForestClient;
+
+/* forest_client - Insert, re-insert and delete its own keys in batches */
+static void *forest_client(void *arg) {
+    ForestClient *c = (ForestClient *)arg;
+    BTreeForestOp ops[64];
+    c->ok = 1;
+    for (int base = 0; base < c->count; base += 32) {
+        int m = c->count - base < 32 ? c->count - base : 32;
+        for (int j = 0; j < m; j++) {
+            int key = c->first + (base + j) * c->stride;
+            ops[2 * j] = (BTreeForestOp){ key, BTREE_FOREST_INSERT, false };
+            ops[2 * j + 1] = (BTreeForestOp){ key, BTREE_FOREST_INSERT, false };
+        }
+        if (btree_forest_execute(c->forest, ops, 2 * m) != 0) c->ok = 0;
+        for (int j = 0; j < m; j++) {
+            if (!ops[2 * j].result || ops[2 * j + 1].result) c->ok = 0;
+        }
+    }
+    return NULL;
+}
+
+static void test_forest(void) {
+    TEST("Range-Partitioned Forest");
+
+    BTreeForest *forest = btree_forest_create(4, 3, 0, 9999);
+    ASSERT(forest != NULL, "btree_forest_create returns non-NULL");
+    ASSERT(btree_forest_create(0, 3, 0, 10) == NULL, "zero shards rejected");
+
+    /* Random batches against a reference set */
+    char *present = calloc(10000, 1);
+    BTreeForestOp ops[500];
+    int ok = 1;
+    for (int round = 0; round < 200; round++) {
+        char expect[500];
+        for (int i = 0; i < 500; i++) {
+            int key = rand() % 10000;
+            int kind = rand() % 3;
+            ops[i] = (BTreeForestOp){ key, (BTreeForestOpKind)kind, false };
+            if (kind == BTREE_FOREST_INSERT) {
+                expect[i] = !present[key];
+                present[key] = 1;
+            } else if (kind == BTREE_FOREST_DELETE) {
+                expect[i] = present[key];
+                present[key] = 0;
+            } else {
+                expect[i] = present[key];
+            }
+        }
+        if (btree_forest_execute(forest, ops, 500) != 0) ok = 0;
+        for (int i = 0; i < 500; i++) {
+            if (ops[i].result != expect[i]) ok = 0;
+        }
+    }
+    ASSERT(ok, "batch results match a sequential reference");
+
+    /* Same key several times in one batch keeps batch order */
+    BTreeForestOp seq[] = {
+        { 20000, BTREE_FOREST_INSERT, false }, { 20000, BTREE_FOREST_SEARCH, false },
+        { 20000, BTREE_FOREST_DELETE, false }, { 20000, BTREE_FOREST_SEARCH, false },
+        { -7, BTREE_FOREST_INSERT, false },    { -7, BTREE_FOREST_INSERT, false },
+    };
+    btree_forest_execute(forest, seq, 6);
+    ASSERT(seq[0].result && seq[1].result && seq[2].result && !seq[3].result &&
+           seq[4].result && !seq[5].result,
+           "ops on one key run in batch order; out-of-range keys accepted");
+
+    BTreeForestStats stats;
+    btree_forest_stats(forest, &stats);
+    long live = 1;  /* -7 */
+    for (int k = 0; k < 10000; k++) live += present[k];
+    long total = 0;
+    for (int s = 0; s < stats.shards; s++) total += stats.keys[s];
+    ASSERT(stats.shards == 4 && total == live, "shard key counts add up");
+    ASSERT(btree_forest_validate(forest), "every shard valid and in range");
+    btree_forest_destroy(forest);
+
+    /* Concurrent clients on interleaved keys */
+    forest = btree_forest_create(3, 4, 0, 40000);
+    ForestClient clients[4];
+    pthread_t threads[4];
+    for (int c = 0; c < 4; c++) {
+        clients[c] = (ForestClient){ forest, c, 4, 10000, 0 };
+        pthread_create(&threads[c], NULL, forest_client, &clients[c]);
+    }
+    ok = 1;
+    for (int c = 0; c < 4; c++) {
+        pthread_join(threads[c], NULL);
+        ok &= clients[c].ok;
+    }
+    btree_forest_stats(forest, &stats);
+    total = 0;
+    for (int s = 0; s < stats.shards; s++) total += stats.keys[s];
+    ASSERT(ok && total == 40000, "concurrent clients see their own results");
+    ASSERT(btree_forest_validate(forest), "forest valid after concurrent batches");
+
+    /* Skewed load: all traffic on shard 0's range gets it split */
+    for (int round = 0; round < 100; round++) {
+        for (int i = 0; i < 500; i++) {
+            ops[i] = (BTreeForestOp){ rand() % 1000, BTREE_FOREST_SEARCH, false };
+        }
+        btree_forest_execute(forest, ops, 500);
+    }
+    ASSERT(btree_forest_rebalance(forest, 1.5) == 1, "hot shard is split");
+    btree_forest_stats(forest, &stats);
+    ASSERT(stats.shards == 4 && stats.lo[1] > 0 && stats.lo[1] < 1000,
+           "split key falls inside the hot range");
+    ASSERT(btree_forest_rebalance(forest, 1.5) == 0, "no split without new load");
+
+    for (int round = 0; round < 20; round++) {
+        for (int i = 0; i < 500; i++) {
+            ops[i] = (BTreeForestOp){ rand() % 1000, BTREE_FOREST_SEARCH, false };
+        }
+        btree_forest_execute(forest, ops, 500);
+    }
+    btree_forest_stats(forest, &stats);
+    ASSERT(stats.ops[0] < 7500 && stats.ops[1] < 7500 && stats.ops[0] + stats.ops[1] == 10000,
+           "hot range now shared by two shards");
+
+    ok = 1;
+    for (int k = 0; k < 40000; k += 97) {
+        BTreeForestOp op = { k, BTREE_FOREST_SEARCH, false };
+        btree_forest_execute(forest, &op, 1);
+        if (!op.result) ok = 0;
+    }
+    ASSERT(ok && btree_forest_validate(forest), "keys survive the split");
+
+    btree_forest_destroy(forest);
+    free(present);
+}
+
+/* ================================================================
+ * AUTO-TUNING TESTS
+ * ================================================================ */
+
+static void test_tuning(void) {
+    TEST("Auto-Tuning (Minimum Degree)");
+
+    /* Keep the user's real config untouched */
+    char path[] = "/tmp/btree_tune_testXXXXXX";
+    int fd = mkstemp(path);
+    close(fd);
+    unlink(path);
+    setenv("BTREE_TUNE_FILE", path, 1);
+
+    BTreeTuning tuning;
+    ASSERT(btree_tuning_load(BTREE_WORKLOAD_SEARCH, NULL, &tuning) == -1,
+           "missing config reports not found");
+
+    ASSERT(btree_tune(BTREE_WORKLOAD_MIXED, 2000, &tuning) == 0,
+           "btree_tune measures candidates");
+    int sorted = 1, has_best = 0;
+    for (int i = 0; i < tuning.candidates; i++) {
+        if (i > 0 && tuning.cand_t[i - 1] >= tuning.cand_t[i]) sorted = 0;
+        if (tuning.cand_t[i] == tuning.t &&
+            tuning.cand_ops[i] == tuning.ops_per_sec) has_best = 1;
+        if (tuning.cand_ops[i] > tuning.ops_per_sec) has_best = 0;
+    }
+    ASSERT(tuning.candidates >= 3 && sorted, "sweep covers several t in order");
+    ASSERT(has_best && tuning.t >= 2, "chosen t is the fastest candidate");
+
+    /* Save two workloads; each keeps its own line */
+    ASSERT(btree_tuning_save(&tuning, NULL) == 0, "btree_tuning_save succeeds");
+    BTreeTuning other = tuning;
+    other.workload = BTREE_WORKLOAD_SEARCH;
+    other.t = 77;
+    btree_tuning_save(&other, NULL);
+    other.t = 78;  /* Overwrites rather than appends */
+    btree_tuning_save(&other, NULL);
+
+    BTreeTuning loaded;
+    ASSERT(btree_tuning_load(BTREE_WORKLOAD_MIXED, NULL, &loaded) == 0 &&
+           loaded.t == tuning.t, "mixed workload t round-trips");
+    ASSERT(btree_tuning_load(BTREE_WORKLOAD_SEARCH, NULL, &loaded) == 0 &&
+           loaded.t == 78, "re-saving a workload replaces its line");
+
+    BTree *tree = btree_create_auto(BTREE_WORKLOAD_SEARCH);
+    ASSERT(tree && tree->t == 78, "btree_create_auto uses the saved t");
+    for (int i = 0; tree && i < 1000; i++) {
+        btree_insert(tree, i);
+    }
+    ASSERT(tree && btree_validate(tree) && btree_count(tree) == 1000,
+           "auto-created tree works");
+
+    btree_destroy(tree);
+    unlink(path);
+    unsetenv("BTREE_TUNE_FILE");
+}
+
 /* ================================================================
  * PERFORMANCE BENCHMARKS
  *
@@ -538,16 +1613,887 @@ static void benchmark_mixed(int n, int t) {
            ops, t, mean, stddev, ops_per_sec);
 }
 
-static void run_benchmarks(void) {
-    printf("\n===== PERFORMANCE BENCHMARKS =====\n");
-    printf("(Running %d iterations per benchmark, showing mean ± stddev)\n",
-           BENCH_ITERATIONS);
-
-    int sizes[] = {1000, 10000, 100000};
-    int degrees[] = {2, 10, 50, 100};
-
-    printf("\n--- Varying Size (t=50) ---\n");
-    for (int i = 0; i < 3; i++) {
+/*
+ * benchmark_persist - Rebuild-by-insert vs. btree_load of a saved image
+ *
+ * The image is read back from a warm page cache, so load time is the
+ * cost of one sequential read plus node allocation, not disk latency.
+ * The key array, both trees and the image buffer are live at once, so
+ * 100M keys needs a few GB of RAM and minutes for the rebuild.
+ */
+static void benchmark_persist(int n, int t) {
+    int *keys = malloc(n * sizeof(int));
+    for (int i = 0; i < n; i++) {
+        keys[i] = i;
+    }
+    shuffle(keys, n);
+
+    double start = get_time_ns();
+    BTree *tree = btree_create(t);
+    for (int i = 0; i < n; i++) {
+        btree_insert(tree, keys[i]);
+    }
+    double rebuild_ms = (get_time_ns() - start) / 1e6;
+
+    FILE *fp = tmpfile();
+    int fd = fileno(fp);
+    start = get_time_ns();
+    btree_save(tree, fd);
+    double save_ms = (get_time_ns() - start) / 1e6;
+
+    struct stat st;
+    fstat(fd, &st);
+
+    lseek(fd, 0, SEEK_SET);
+    start = get_time_ns();
+    BTree *loaded = btree_load(fd);
+    double load_ms = (get_time_ns() - start) / 1e6;
+
+    printf("  n=%9d (t=%3d): rebuild %9.2f ms | save %8.2f ms | "
+           "load %8.2f ms (%5.1fx faster) | %.2f bytes/key%s\n",
+           n, t, rebuild_ms, save_ms, load_ms,
+           load_ms > 0 ? rebuild_ms / load_ms : 0.0,
+           (double)st.st_size / n,
+           (loaded && btree_count(loaded) == n) ? "" : "  !! MISMATCH");
+
+    fclose(fp);
+    btree_destroy(loaded);
+    btree_destroy(tree);
+    free(keys);
+}
+
+static void run_persist_benchmarks(int argc, char *argv[]) {
+    printf("\n===== PERSISTENCE BENCHMARK (rebuild vs. load) =====\n");
+    printf("(pass sizes as extra arguments, e.g. --bench-persist 10000000 100000000)\n");
+
+    if (argc <= 2) {
+        benchmark_persist(1000000, 50);
+        return;
+    }
+    for (int i = 2; i < argc; i++) {
+        benchmark_persist(atoi(argv[i]), 50);
+    }
+}
+
+/*
+ * benchmark_validate - Serial validation vs. parallel on 1..16 threads
+ */
+static void benchmark_validate(int n, int t) {
+    int *keys = malloc(n * sizeof(int));
+    for (int i = 0; i < n; i++) {
+        keys[i] = i;
+    }
+    shuffle(keys, n);
+
+    BTree *tree = btree_create(t);
+    for (int i = 0; i < n; i++) {
+        btree_insert(tree, keys[i]);
+    }
+    free(keys);
+
+    double start = get_time_ns();
+    int ok = btree_validate(tree);
+    double serial_ms = (get_time_ns() - start) / 1e6;
+    printf("  n=%d (t=%d)  serial btree_validate: %8.2f ms%s\n",
+           n, t, serial_ms, ok ? "" : "  !! INVALID");
+
+    int thread_counts[] = {1, 2, 4, 8, 16};
+    for (int i = 0; i < 5; i++) {
+        BTreeStats stats;
+        start = get_time_ns();
+        ok = btree_validate_parallel(tree, thread_counts[i], &stats);
+        double ms = (get_time_ns() - start) / 1e6;
+        printf("  threads=%2d: %8.2f ms  speedup %5.2fx  "
+               "(keys=%ld height=%d fill=%.1f%%)%s\n",
+               thread_counts[i], ms, ms > 0 ? serial_ms / ms : 0.0,
+               stats.keys, stats.height, stats.fill * 100.0,
+               ok ? "" : "  !! INVALID");
+    }
+
+    btree_destroy(tree);
+}
+
+static void run_validate_benchmarks(int argc, char *argv[]) {
+    printf("\n===== VALIDATION BENCHMARK (serial vs. parallel) =====\n");
+    printf("(online CPUs: %ld)\n", sysconf(_SC_NPROCESSORS_ONLN));
+    benchmark_validate(argc > 2 ? atoi(argv[2]) : 2000000, 50);
+}
+
+/*
+ * benchmark_build - n sequential btree_insert calls vs. bulk build
+ */
+static void benchmark_build(int n, int t) {
+    int *keys = malloc(n * sizeof(int));
+    for (int i = 0; i < n; i++) {
+        keys[i] = i;
+    }
+    shuffle(keys, n);
+
+    double start = get_time_ns();
+    BTree *tree = btree_create(t);
+    for (int i = 0; i < n; i++) {
+        btree_insert(tree, keys[i]);
+    }
+    double insert_ms = (get_time_ns() - start) / 1e6;
+    BTreeStats stats;
+    btree_validate_stats(tree, &stats);
+    printf("  n=%d (t=%d)  sequential insert: %9.2f ms  "
+           "(height=%d fill=%.1f%%)\n",
+           n, t, insert_ms, stats.height, stats.fill * 100.0);
+    btree_destroy(tree);
+
+    int thread_counts[] = {1, 2, 4, 8};
+    for (int i = 0; i < 4; i++) {
+        start = get_time_ns();
+        tree = btree_build_parallel(t, keys, n, thread_counts[i]);
+        double ms = (get_time_ns() - start) / 1e6;
+        int ok = btree_validate_stats(tree, &stats);
+        printf("  build threads=%d:        %9.2f ms  speedup %5.2fx  "
+               "(height=%d fill=%.1f%%)%s\n",
+               thread_counts[i], ms, ms > 0 ? insert_ms / ms : 0.0,
+               stats.height, stats.fill * 100.0, ok ? "" : "  !! INVALID");
+        btree_destroy(tree);
+    }
+    free(keys);
+}
+
+static void run_build_benchmarks(int argc, char *argv[]) {
+    printf("\n===== BULK BUILD BENCHMARK (insert vs. build_parallel) =====\n");
+    printf("(online CPUs: %ld)\n", sysconf(_SC_NPROCESSORS_ONLN));
+    benchmark_build(argc > 2 ? atoi(argv[2]) : 2000000, 50);
+}
+
+/*
+ * dTLB miss counting via perf_event_open (Linux only). Returns -1 where
+ * the counter is unavailable (other OS, containers, perf_event_paranoid).
+ */
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+
+static int perf_open_dtlb_misses(void) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB |
+                  (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static void perf_start(int fd) {
+    if (fd < 0) return;
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+}
+
+static long long perf_stop(int fd) {
+    long long count = -1;
+    if (fd < 0) return -1;
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    if (read(fd, &count, sizeof(count)) != sizeof(count)) return -1;
+    return count;
+}
+#else
+static int perf_open_dtlb_misses(void) { return -1; }
+static void perf_start(int fd) { (void)fd; }
+static long long perf_stop(int fd) { (void)fd; return -1; }
+#endif
+
+/*
+ * benchmark_arena - Random lookups on a malloc tree vs. an arena tree
+ */
+static void benchmark_arena(int n, int t) {
+    int *keys = malloc(n * sizeof(int));
+    for (int i = 0; i < n; i++) {
+        keys[i] = i;
+    }
+    shuffle(keys, n);
+
+    int fd = perf_open_dtlb_misses();
+    for (int use_arena = 0; use_arena <= 1; use_arena++) {
+        BTree *tree = use_arena ? btree_create_arena(t) : btree_create(t);
+        if (!tree) {
+            printf("  %-6s: (arena unavailable)\n", use_arena ? "arena" : "malloc");
+            continue;
+        }
+        for (int i = 0; i < n; i++) {
+            btree_insert(tree, keys[i]);
+        }
+        shuffle(keys, n);
+
+        volatile int found = 0;
+        perf_start(fd);
+        double start = get_time_ns();
+        for (int i = 0; i < n; i++) {
+            found += btree_search(tree->root, keys[i], NULL) != NULL;
+        }
+        double ns = (get_time_ns() - start) / n;
+        long long misses = perf_stop(fd);
+
+        if (misses >= 0) {
+            printf("  %-6s n=%d (t=%3d): %7.1f ns/lookup  %6.3f dTLB misses/lookup\n",
+                   use_arena ? "arena" : "malloc", n, t, ns, (double)misses / n);
+        } else {
+            printf("  %-6s n=%d (t=%3d): %7.1f ns/lookup  dTLB misses n/a\n",
+                   use_arena ? "arena" : "malloc", n, t, ns);
+        }
+        btree_destroy(tree);
+    }
+    if (fd >= 0) close(fd);
+    free(keys);
+}
+
+static void run_arena_benchmarks(int argc, char *argv[]) {
+    printf("\n===== NODE ARENA BENCHMARK (malloc vs. huge-page arena) =====\n");
+    int n = argc > 2 ? atoi(argv[2]) : 4000000;
+    benchmark_arena(n, 8);
+    benchmark_arena(n, 50);
+}
+
+/*
+ * zipf_keys - Draw n keys from Zipf(s) over [0, universe)
+ *
+ * Inverse-CDF sampling: rank r has weight 1/(r+1)^s. Ranks are mapped
+ * through a fixed permutation so hot keys are spread over the range.
+ */
+static void zipf_keys(int *out, int n, int universe, double s) {
+    double *cdf = malloc(universe * sizeof(double));
+    int *perm = malloc(universe * sizeof(int));
+    double sum = 0;
+    for (int r = 0; r < universe; r++) {
+        sum += 1.0 / pow(r + 1, s);
+        cdf[r] = sum;
+        perm[r] = r;
+    }
+    shuffle(perm, universe);
+
+    for (int i = 0; i < n; i++) {
+        double u = ((double)rand() / RAND_MAX) * sum;
+        int lo = 0, hi = universe - 1;
+        while (lo < hi) {
+            int mid = lo + (hi - lo) / 2;
+            if (cdf[mid] < u) lo = mid + 1; else hi = mid;
+        }
+        out[i] = perm[lo];
+    }
+    free(perm);
+    free(cdf);
+}
+
+/* count_tree_nodes - Node count that does not depend on validation */
+static long count_tree_nodes(BTreeNode *node) {
+    long total = 1;
+    if (!node->is_leaf) {
+        for (int i = 0; i <= node->n; i++) {
+            total += count_tree_nodes(node->children[i]);
+        }
+    }
+    return total;
+}
+
+/*
+ * benchmark_multimap - Zipf keys: counted entries vs. plain duplicates
+ *
+ * The "duplicates" tree uses btree_insert on a set tree, which stores
+ * every repeat as its own key; it is only a size/speed baseline (its
+ * delete and validate have no multiset semantics).
+ */
+static void benchmark_multimap(int n, int universe, double skew) {
+    int *keys = malloc(n * sizeof(int));
+    zipf_keys(keys, n, universe, skew);
+
+    int t = 50;
+    for (int mode = 0; mode <= 1; mode++) {
+        BTree *tree = mode ? btree_create_multimap(t) : btree_create(t);
+
+        double start = get_time_ns();
+        for (int i = 0; i < n; i++) {
+            btree_insert(tree, keys[i]);
+        }
+        double insert_ms = (get_time_ns() - start) / 1e6;
+
+        volatile long total = 0;
+        start = get_time_ns();
+        for (int i = 0; i < n; i++) {
+            if (mode) {
+                total += btree_count_key(tree, keys[i]);
+            } else {
+                total += btree_search(tree->root, keys[i], NULL) != NULL;
+            }
+        }
+        double query_ms = (get_time_ns() - start) / 1e6;
+
+        long nodes = count_tree_nodes(tree->root);
+        size_t node_bytes = (2 * t - 1) * sizeof(int) * (mode ? 2 : 1)
+                          + 2 * t * sizeof(BTreeNode *) + sizeof(BTreeNode);
+        printf("  %-10s s=%.2f: insert %8.2f ms | %s %8.2f ms | "
+               "entries %9d nodes %7ld (%.1f KiB) height %d\n",
+               mode ? "multimap" : "duplicates", skew, insert_ms,
+               mode ? "count_key" : "search   ", query_ms,
+               btree_count(tree), nodes,
+               nodes * (double)node_bytes / 1024.0,
+               btree_height(tree));
+        btree_destroy(tree);
+    }
+    free(keys);
+}
+
+static void run_multimap_benchmarks(int argc, char *argv[]) {
+    printf("\n===== MULTIMAP BENCHMARK (Zipf keys) =====\n");
+    int n = argc > 2 ? atoi(argv[2]) : 2000000;
+    double skews[] = {0.8, 1.0, 1.2};
+    for (int i = 0; i < 3; i++) {
+        benchmark_multimap(n, 1000000, skews[i]);
+    }
+}
+
+static int compare_cstr(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+/*
+ * benchmark_string - URL corpus: slotted B+-tree vs. sorted char* array
+ *
+ * The baseline keeps one strdup'd key per entry plus its pointer;
+ * lookups there are bsearch with strcmp.
+ */
+static void benchmark_string(int n, size_t page_size) {
+    char **keys = malloc(n * sizeof(char *));
+    size_t raw = 0;
+    char buf[256];
+    for (int i = 0; i < n; i++) {
+        make_url(buf, sizeof(buf), (unsigned int)i);
+        keys[i] = strdup(buf);
+        raw += strlen(buf);
+    }
+
+    SBTree *tree = sbtree_create(page_size);
+    double start = get_time_ns();
+    for (int i = 0; i < n; i++) {
+        sbtree_insert(tree, keys[i], strlen(keys[i]));
+    }
+    double insert_ms = (get_time_ns() - start) / 1e6;
+
+    /* Probe order is independent of insert order */
+    int *probe = malloc(n * sizeof(int));
+    for (int i = 0; i < n; i++) probe[i] = i;
+    shuffle(probe, n);
+
+    volatile long hits = 0;
+    start = get_time_ns();
+    for (int i = 0; i < n; i++) {
+        const char *k = keys[probe[i]];
+        hits += sbtree_contains(tree, k, strlen(k));
+    }
+    double tree_ms = (get_time_ns() - start) / 1e6;
+
+    char **sorted = malloc(n * sizeof(char *));
+    memcpy(sorted, keys, n * sizeof(char *));
+    qsort(sorted, n, sizeof(char *), compare_cstr);
+    start = get_time_ns();
+    for (int i = 0; i < n; i++) {
+        hits += bsearch(&keys[probe[i]], sorted, n, sizeof(char *),
+                        compare_cstr) != NULL;
+    }
+    double array_ms = (get_time_ns() - start) / 1e6;
+
+    SBTreeStats stats;
+    sbtree_stats(tree, &stats);
+    size_t tree_bytes = (size_t)stats.pages * page_size;
+    /* malloc rounds each strdup up to 16 bytes plus an 8-byte header */
+    size_t array_bytes = n * sizeof(char *);
+    for (int i = 0; i < n; i++) {
+        array_bytes += (strlen(keys[i]) + 1 + 8 + 15) & ~(size_t)15;
+    }
+
+    printf("  page %5zu: height %d pages %6ld | %5.1f B/key allocated "
+           "(%5.1f B/key used, raw %5.1f) vs char* array %5.1f B/key\n",
+           page_size, stats.height, stats.pages, (double)tree_bytes / n,
+           (double)stats.used_bytes / n, (double)raw / n,
+           (double)array_bytes / n);
+    printf("              insert %8.2f ms | lookup %6.2f M/s "
+           "vs bsearch %6.2f M/s | prefix saved %.1f B/key\n",
+           insert_ms, n / tree_ms / 1e3, n / array_ms / 1e3,
+           (double)stats.prefix_saved / n);
+
+    sbtree_destroy(tree);
+    for (int i = 0; i < n; i++) free(keys[i]);
+    free(keys);
+    free(sorted);
+    free(probe);
+}
+
+static void run_string_benchmarks(int argc, char *argv[]) {
+    printf("\n===== STRING KEY BENCHMARK (URL corpus) =====\n");
+    int n = argc > 2 ? atoi(argv[2]) : 1000000;
+    size_t pages[] = {1024, 4096, 16384};
+    for (int i = 0; i < 3; i++) {
+        benchmark_string(n, pages[i]);
+    }
+}
+
+/*
+ * benchmark_fence - Plain vs. fenced nodes for large t
+ *
+ * Same random keys for both; searches probe present and absent keys.
+ */
+static void benchmark_fence(int n, int t) {
+    int *keys = malloc(n * sizeof(int));
+    for (int i = 0; i < n; i++) {
+        keys[i] = rand();
+    }
+
+    double insert_ms[2], search_ms[2], delete_ms[2];
+    for (int mode = 0; mode <= 1; mode++) {
+        BTree *tree = mode ? btree_create_fenced(t) : btree_create(t);
+
+        double start = get_time_ns();
+        for (int i = 0; i < n; i++) {
+            btree_insert(tree, keys[i]);
+        }
+        insert_ms[mode] = (get_time_ns() - start) / 1e6;
+
+        volatile long hits = 0;
+        start = get_time_ns();
+        for (int i = 0; i < n; i++) {
+            hits += btree_search(tree->root, keys[i] ^ (i & 1), NULL) != NULL;
+        }
+        search_ms[mode] = (get_time_ns() - start) / 1e6;
+
+        start = get_time_ns();
+        for (int i = 0; i < n; i++) {
+            btree_delete(tree, keys[i]);
+        }
+        delete_ms[mode] = (get_time_ns() - start) / 1e6;
+        btree_destroy(tree);
+    }
+
+    printf("  t=%5d: search %8.2f -> %8.2f ms (%5.2fx) | insert %8.2f -> "
+           "%8.2f ms | delete %8.2f -> %8.2f ms\n", t,
+           search_ms[0], search_ms[1], search_ms[0] / search_ms[1],
+           insert_ms[0], insert_ms[1], delete_ms[0], delete_ms[1]);
+    free(keys);
+}
+
+static void run_fence_benchmarks(int argc, char *argv[]) {
+    printf("\n===== FENCE INDEX BENCHMARK (plain -> fenced) =====\n");
+    int n = argc > 2 ? atoi(argv[2]) : 1000000;
+    int degrees[] = {16, 64, 256, 512, 1024, 2048};
+    for (int i = 0; i < 6; i++) {
+        benchmark_fence(n, degrees[i]);
+    }
+}
+
+/*
+ * benchmark_gapped - Dense (b-tree.c) vs. gapped leaves
+ *
+ * Same random keys for both. The gapped tree also reports leaf slot
+ * writes per insert, against about t per insert for a dense leaf.
+ */
+static void benchmark_gapped(int n, int t) {
+    int *keys = malloc(n * sizeof(int));
+    for (int i = 0; i < n; i++) {
+        keys[i] = rand();
+    }
+    int *order = malloc(n * sizeof(int));
+    for (int i = 0; i < n; i++) order[i] = i;
+    shuffle(order, n);
+
+    BTree *dense = btree_create(t);
+    double start = get_time_ns();
+    for (int i = 0; i < n; i++) btree_insert(dense, keys[i]);
+    double dense_insert = (get_time_ns() - start) / 1e6;
+    volatile long hits = 0;
+    start = get_time_ns();
+    for (int i = 0; i < n; i++) hits += btree_search(dense->root, keys[order[i]], NULL) != NULL;
+    double dense_search = (get_time_ns() - start) / 1e6;
+    start = get_time_ns();
+    for (int i = 0; i < n; i++) btree_delete(dense, keys[order[i]]);
+    double dense_delete = (get_time_ns() - start) / 1e6;
+    btree_destroy(dense);
+
+    GBTree *gapped = gbtree_create(t);
+    start = get_time_ns();
+    for (int i = 0; i < n; i++) gbtree_insert(gapped, keys[i]);
+    double gapped_insert = (get_time_ns() - start) / 1e6;
+    double moves = (double)gapped->moves / gbtree_count(gapped);
+    start = get_time_ns();
+    for (int i = 0; i < n; i++) hits += gbtree_search(gapped, keys[order[i]]);
+    double gapped_search = (get_time_ns() - start) / 1e6;
+    start = get_time_ns();
+    for (int i = 0; i < n; i++) gbtree_delete(gapped, keys[order[i]]);
+    double gapped_delete = (get_time_ns() - start) / 1e6;
+    gbtree_destroy(gapped);
+
+    printf("  t=%4d: insert %8.2f -> %8.2f ms | delete %8.2f -> %8.2f ms | "
+           "search %8.2f -> %8.2f ms | %.1f slot writes/insert\n", t,
+           dense_insert, gapped_insert, dense_delete, gapped_delete,
+           dense_search, gapped_search, moves);
+    free(keys);
+    free(order);
+}
+
+static void run_gapped_benchmarks(int argc, char *argv[]) {
+    printf("\n===== GAPPED LEAF BENCHMARK (dense -> gapped) =====\n");
+    int n = argc > 2 ? atoi(argv[2]) : 1000000;
+    int degrees[] = {50, 100, 500};
+    for (int i = 0; i < 3; i++) {
+        benchmark_gapped(n, degrees[i]);
+    }
+}
+
+/*
+ * benchmark_bstar - 50/50 splits vs. the B* policy
+ *
+ * Same random keys for both; fill is keys / (nodes * (2t-1)).
+ */
+static void benchmark_bstar(int n, int t) {
+    int *keys = malloc(n * sizeof(int));
+    for (int i = 0; i < n; i++) {
+        keys[i] = i;  /* Distinct: a set tree's validation rejects duplicates */
+    }
+    shuffle(keys, n);
+
+    double insert_ms[2], search_ms[2];
+    BTreeStats stats[2];
+    for (int mode = 0; mode <= 1; mode++) {
+        BTree *tree = mode ? btree_create_bstar(t) : btree_create(t);
+
+        double start = get_time_ns();
+        for (int i = 0; i < n; i++) {
+            btree_insert(tree, keys[i]);
+        }
+        insert_ms[mode] = (get_time_ns() - start) / 1e6;
+
+        volatile long hits = 0;
+        start = get_time_ns();
+        for (int i = 0; i < n; i++) {
+            hits += btree_search(tree->root, keys[i], NULL) != NULL;
+        }
+        search_ms[mode] = (get_time_ns() - start) / 1e6;
+        btree_validate_stats(tree, &stats[mode]);
+        btree_destroy(tree);
+    }
+
+    printf("  t=%4d: fill %5.1f%% -> %5.1f%% | height %d -> %d | nodes %ld -> "
+           "%ld | insert %8.2f -> %8.2f ms | search %8.2f -> %8.2f ms\n", t,
+           stats[0].fill * 100.0, stats[1].fill * 100.0,
+           stats[0].height, stats[1].height, stats[0].nodes, stats[1].nodes,
+           insert_ms[0], insert_ms[1], search_ms[0], search_ms[1]);
+    free(keys);
+}
+
+static void run_bstar_benchmarks(int argc, char *argv[]) {
+    printf("\n===== B* INSERT POLICY BENCHMARK (50/50 split -> B*) =====\n");
+    int n = argc > 2 ? atoi(argv[2]) : 2000000;
+    int degrees[] = {3, 8, 16, 50, 100};
+    for (int i = 0; i < 5; i++) {
+        benchmark_bstar(n, degrees[i]);
+    }
+}
+
+/*
+ * benchmark_aggregate - Summary maintenance cost and range query speedup
+ *
+ * Writes: the same shuffled keys into a plain and an aggregate tree.
+ * Queries: btree_range_aggregate on the plain tree walks every key in
+ * the range; on the aggregate tree it walks two root-to-leaf paths.
+ */
+static void benchmark_aggregate(int n, int t) {
+    int *keys = malloc(n * sizeof(int));
+    for (int i = 0; i < n; i++) {
+        keys[i] = i;
+    }
+    shuffle(keys, n);
+
+    BTree *trees[2] = { btree_create(t), btree_create_aggregate(t) };
+    double insert_ms[2], delete_ms[2];
+    for (int mode = 0; mode <= 1; mode++) {
+        double start = get_time_ns();
+        for (int i = 0; i < n; i++) {
+            btree_insert(trees[mode], keys[i]);
+        }
+        insert_ms[mode] = (get_time_ns() - start) / 1e6;
+    }
+    printf("  t=%d, n=%d: insert %8.2f -> %8.2f ms (%+.0f%%)\n", t, n,
+           insert_ms[0], insert_ms[1],
+           (insert_ms[1] / insert_ms[0] - 1.0) * 100.0);
+
+    int widths[] = {100, 10000, n / 2};
+    for (int w = 0; w < 3; w++) {
+        int queries = widths[w] >= 10000 ? 200 : 20000;
+        double query_ms[2];
+        volatile long long sink = 0;
+        for (int mode = 0; mode <= 1; mode++) {
+            srand(42);
+            double start = get_time_ns();
+            for (int q = 0; q < queries; q++) {
+                int lo = rand() % (n - widths[w] + 1);
+                sink += btree_range_aggregate(trees[mode], lo, lo + widths[w] - 1).sum;
+            }
+            query_ms[mode] = (get_time_ns() - start) / 1e6;
+        }
+        printf("    range %8d keys: scan %9.3f us -> aggregate %7.3f us (%.1fx)\n",
+               widths[w], query_ms[0] * 1e3 / queries,
+               query_ms[1] * 1e3 / queries, query_ms[0] / query_ms[1]);
+    }
+
+    for (int mode = 0; mode <= 1; mode++) {
+        double start = get_time_ns();
+        for (int i = 0; i < n; i++) {
+            btree_delete(trees[mode], keys[i]);
+        }
+        delete_ms[mode] = (get_time_ns() - start) / 1e6;
+        btree_destroy(trees[mode]);
+    }
+    printf("    delete %8.2f -> %8.2f ms (%+.0f%%)\n", delete_ms[0], delete_ms[1],
+           (delete_ms[1] / delete_ms[0] - 1.0) * 100.0);
+    free(keys);
+}
+
+static void run_aggregate_benchmarks(int argc, char *argv[]) {
+    printf("\n===== AGGREGATE BENCHMARK (plain -> aggregate tree) =====\n");
+    int n = argc > 2 ? atoi(argv[2]) : 1000000;
+    benchmark_aggregate(n, 16);
+    benchmark_aggregate(n, 64);
+}
+
+/*
+ * lookup_ns - Average latency of n random lookups of present keys
+ */
+static double lookup_ns(BTree *tree, const int *keys, int n) {
+    volatile int found = 0;
+    double start = get_time_ns();
+    for (int i = 0; i < n; i++) {
+        found += btree_search(tree->root, keys[(i * 7919L) % n], NULL) != NULL;
+    }
+    return (get_time_ns() - start) / n;
+}
+
+/*
+ * benchmark_relayout - Churned tree vs. relaid-out vs. fresh bulk build
+ *
+ * Churn: after n random inserts, n rounds of deleting a live key and
+ * inserting a new one, so nodes are allocated all over the heap.
+ */
+static void benchmark_relayout(int n, int t) {
+    int *keys = malloc(n * sizeof(int));
+    for (int i = 0; i < n; i++) {
+        keys[i] = i * 2;
+    }
+    shuffle(keys, n);
+
+    BTree *tree = btree_create(t);
+    for (int i = 0; i < n; i++) {
+        btree_insert(tree, keys[i]);
+    }
+    for (int i = 0; i < n; i++) {
+        int victim = rand() % n;
+        btree_delete(tree, keys[victim]);
+        keys[victim] = 2 * n + 2 * i + 1;  /* Fresh odd key */
+        btree_insert(tree, keys[victim]);
+    }
+
+    BTree *fresh = btree_build_parallel(t, keys, n, 1);
+    printf("  n=%d (t=%d)\n", n, t);
+    printf("    churned (malloc):   %7.1f ns/lookup\n", lookup_ns(tree, keys, n));
+
+    BTreeLayout orders[] = {BTREE_LAYOUT_BFS, BTREE_LAYOUT_VEB};
+    for (int o = 0; o < 2; o++) {
+        double start = get_time_ns();
+        int rc = btree_relayout(tree, orders[o]);
+        double ms = (get_time_ns() - start) / 1e6;
+        printf("    relayout %-3s:       %7.1f ns/lookup  (relayout %.1f ms%s)\n",
+               orders[o] == BTREE_LAYOUT_BFS ? "BFS" : "vEB",
+               lookup_ns(tree, keys, n), ms, rc == 0 ? "" : ", FAILED");
+    }
+    printf("    fresh bulk build:   %7.1f ns/lookup\n", lookup_ns(fresh, keys, n));
+
+    btree_destroy(tree);
+    btree_destroy(fresh);
+    free(keys);
+}
+
+static void run_relayout_benchmarks(int argc, char *argv[]) {
+    printf("\n===== RELAYOUT BENCHMARK (churned -> relaid out -> fresh) =====\n");
+    int n = argc > 2 ? atoi(argv[2]) : 2000000;
+    benchmark_relayout(n, 4);
+    benchmark_relayout(n, 32);
+}
+
+typedef struct {
+    BTreeForest *forest;
+    const int *keys;    /* Key universe to draw from */
+    int universe;
+    int hot;            /* Keys [0, hot) get 90% of ops; 0 = uniform */
+    long ops;
+    unsigned int seed;
+} ForestLoad;
+
+/* forest_load - Batches of 1024 ops: 80% search, 10% insert, 10% delete */
+static void *forest_load(void *arg) {
+    ForestLoad *load = (ForestLoad *)arg;
+    BTreeForestOp batch[1024];
+    for (long done = 0; done < load->ops; done += 1024) {
+        for (int i = 0; i < 1024; i++) {
+            int r = rand_r(&load->seed);
+            int slot = load->hot && r % 10 != 0 ? rand_r(&load->seed) % load->hot
+                                                : rand_r(&load->seed) % load->universe;
+            int kind = r % 10 < 8 ? BTREE_FOREST_SEARCH
+                     : r % 10 == 8 ? BTREE_FOREST_INSERT : BTREE_FOREST_DELETE;
+            batch[i] = (BTreeForestOp){ load->keys[slot], (BTreeForestOpKind)kind, false };
+        }
+        btree_forest_execute(load->forest, batch, 1024);
+    }
+    return NULL;
+}
+
+/* run_forest_load - Mops/s of @clients threads driving @forest */
+static double run_forest_load(BTreeForest *forest, const int *keys, int universe,
+                              int hot, int clients, long ops) {
+    pthread_t threads[16];
+    ForestLoad loads[16];
+    double start = get_time_ns();
+    for (int c = 0; c < clients; c++) {
+        loads[c] = (ForestLoad){ forest, keys, universe, hot, ops / clients, 17u * c + 1 };
+        pthread_create(&threads[c], NULL, forest_load, &loads[c]);
+    }
+    for (int c = 0; c < clients; c++) pthread_join(threads[c], NULL);
+    return ops / ((get_time_ns() - start) / 1e3);
+}
+
+/*
+ * benchmark_forest - Throughput against shard count, then skew
+ *
+ * Keys are 0, 2, 4, ... (2n); half are preloaded. The baseline is one
+ * tree driven directly by one thread with the same op mix.
+ */
+static void benchmark_forest(int n, int t) {
+    int universe = 2 * n;
+    int *keys = malloc(universe * sizeof(int));
+    for (int i = 0; i < universe; i++) keys[i] = 2 * i;
+    long ops = 4L * n;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    printf("  %d preloaded keys, %ld ops per run, %ld online CPUs\n", n, ops, cpus);
+
+    BTree *single = btree_create(t);
+    for (int i = 0; i < universe; i += 2) btree_insert(single, keys[i]);
+    unsigned int seed = 1;
+    double start = get_time_ns();
+    for (long i = 0; i < ops; i++) {
+        int r = rand_r(&seed);
+        int key = keys[rand_r(&seed) % universe];
+        bool present = btree_search(single->root, key, NULL) != NULL;
+        if (r % 10 == 8 && !present) btree_insert(single, key);
+        if (r % 10 == 9 && present) btree_delete(single, key);
+    }
+    printf("    single tree, 1 thread:          %6.2f Mops/s\n",
+           ops / ((get_time_ns() - start) / 1e3));
+    btree_destroy(single);
+
+    int shard_counts[] = {1, 2, 4, 8};
+    for (int i = 0; i < 4; i++) {
+        int shards = shard_counts[i];
+        BTreeForest *forest = btree_forest_create(shards, t, 0, 2 * universe);
+        BTreeForestOp *fill = malloc(n * sizeof(BTreeForestOp));
+        for (int k = 0; k < n; k++) {
+            fill[k] = (BTreeForestOp){ keys[2 * k], BTREE_FOREST_INSERT, false };
+        }
+        btree_forest_execute(forest, fill, n);
+        free(fill);
+        int clients = shards < 2 ? 2 : shards;
+        printf("    forest P=%d, %d clients, uniform: %6.2f Mops/s\n", shards, clients,
+               run_forest_load(forest, keys, universe, 0, clients, ops));
+        btree_forest_destroy(forest);
+    }
+
+    /* 90% of ops on the lowest 5% of keys, all inside shard 0 of 4 */
+    BTreeForest *forest = btree_forest_create(4, t, 0, 2 * universe);
+    BTreeForestOp *fill = malloc(n * sizeof(BTreeForestOp));
+    for (int k = 0; k < n; k++) {
+        fill[k] = (BTreeForestOp){ keys[2 * k], BTREE_FOREST_INSERT, false };
+    }
+    btree_forest_execute(forest, fill, n);
+    free(fill);
+
+    BTreeForestStats stats;
+    int hot = universe / 20;
+    double mops = run_forest_load(forest, keys, universe, hot, 4, ops);
+    btree_forest_stats(forest, &stats);
+    printf("    skewed, P=4:                    %6.2f Mops/s  imbalance %.2f\n",
+           mops, stats.imbalance);
+    int splits = 0;
+    while (btree_forest_rebalance(forest, 1.5) == 1) {
+        splits++;
+        run_forest_load(forest, keys, universe, hot, 4, ops / 8);
+    }
+    mops = run_forest_load(forest, keys, universe, hot, 4, ops);
+    btree_forest_stats(forest, &stats);
+    printf("    skewed, after %d splits (P=%-2d): %6.2f Mops/s  imbalance %.2f\n",
+           splits, stats.shards, mops, stats.imbalance);
+    btree_forest_destroy(forest);
+    free(keys);
+}
+
+static void run_forest_benchmarks(int argc, char *argv[]) {
+    printf("\n===== FOREST BENCHMARK (range-partitioned, thread per shard) =====\n");
+    int n = argc > 2 ? atoi(argv[2]) : 1000000;
+    benchmark_forest(n, 16);
+}
+
+/*
+ * run_tune - Calibration tool: sweep t, print the table, save the choice
+ *
+ * Usage: --tune [search|mixed|insert] [n]
+ */
+static void run_tune(int argc, char *argv[]) {
+    BTreeWorkload workload = BTREE_WORKLOAD_MIXED;
+    if (argc > 2) {
+        if (strcmp(argv[2], "search") == 0) workload = BTREE_WORKLOAD_SEARCH;
+        else if (strcmp(argv[2], "insert") == 0) workload = BTREE_WORKLOAD_INSERT;
+    }
+    int n = argc > 3 ? atoi(argv[3]) : BTREE_TUNE_DEFAULT_KEYS;
+
+    printf("\n===== AUTO-TUNING (%s workload, n=%d) =====\n",
+           btree_workload_name(workload), n);
+    BTreeTuning tuning;
+    if (btree_tune(workload, n, &tuning) != 0) {
+        printf("Tuning failed\n");
+        return;
+    }
+    printf("  cache: L1d %ld KiB, L2 %ld KiB, line %ld B\n",
+           tuning.l1d / 1024, tuning.l2 / 1024, tuning.line);
+    for (int i = 0; i < tuning.candidates; i++) {
+        int t = tuning.cand_t[i];
+        printf("  t=%5d  node keys %6zu B  %8.2f Mops/s%s\n", t,
+               (2 * t - 1) * sizeof(int), tuning.cand_ops[i] / 1e6,
+               t == tuning.t ? "  <- chosen" : "");
+    }
+    printf("  expected throughput at t=%d: %.2f Mops/s\n",
+           tuning.t, tuning.ops_per_sec / 1e6);
+    if (btree_tuning_save(&tuning, NULL) == 0) {
+        printf("  saved to %s\n", btree_tuning_path());
+    } else {
+        printf("  could not save to %s\n", btree_tuning_path());
+    }
+}
+
+static void run_benchmarks(void) {
+    printf("\n===== PERFORMANCE BENCHMARKS =====\n");
+    printf("(Running %d iterations per benchmark, showing mean ± stddev)\n",
+           BENCH_ITERATIONS);
+
+    int sizes[] = {1000, 10000, 100000};
+    int degrees[] = {2, 10, 50, 100};
+
+    printf("\n--- Varying Size (t=50) ---\n");
+    for (int i = 0; i < 3; i++) {
         benchmark_insert(sizes[i], 50);
         benchmark_search(sizes[i], 50);
         benchmark_delete(sizes[i], 50);
@@ -593,6 +2539,46 @@ static void run_tests(void) {
     test_large_sequential();
     test_large_random();
 
+    /* Persistence tests */
+    test_save_load();
+    test_save_load_modes();
+
+    /* Parallel validation tests */
+    test_validate_parallel();
+
+    /* Bulk build tests */
+    test_build_parallel();
+
+    /* Arena tests */
+    test_arena();
+
+    /* Multimap tests */
+    test_multimap();
+
+    /* String key tests */
+    test_string_keys();
+
+    /* Fence index tests */
+    test_fenced();
+
+    /* Gapped leaf tests */
+    test_gapped();
+
+    /* B* insert policy tests */
+    test_bstar();
+
+    /* Aggregate tests */
+    test_aggregate();
+
+    /* Relayout tests */
+    test_relayout();
+
+    /* Forest tests */
+    test_forest();
+
+    /* Auto-tuning tests */
+    test_tuning();
+
     printf("\n===== TEST SUMMARY =====\n");
     printf("Passed: %d\n", tests_passed);
     printf("Failed: %d\n", tests_failed);
@@ -603,6 +2589,32 @@ int main(int argc, char *argv[]) {
 
     if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
         run_benchmarks();
+    } else if (argc > 1 && strcmp(argv[1], "--bench-persist") == 0) {
+        run_persist_benchmarks(argc, argv);
+    } else if (argc > 1 && strcmp(argv[1], "--bench-validate") == 0) {
+        run_validate_benchmarks(argc, argv);
+    } else if (argc > 1 && strcmp(argv[1], "--bench-build") == 0) {
+        run_build_benchmarks(argc, argv);
+    } else if (argc > 1 && strcmp(argv[1], "--bench-arena") == 0) {
+        run_arena_benchmarks(argc, argv);
+    } else if (argc > 1 && strcmp(argv[1], "--bench-multimap") == 0) {
+        run_multimap_benchmarks(argc, argv);
+    } else if (argc > 1 && strcmp(argv[1], "--bench-string") == 0) {
+        run_string_benchmarks(argc, argv);
+    } else if (argc > 1 && strcmp(argv[1], "--bench-fence") == 0) {
+        run_fence_benchmarks(argc, argv);
+    } else if (argc > 1 && strcmp(argv[1], "--bench-gapped") == 0) {
+        run_gapped_benchmarks(argc, argv);
+    } else if (argc > 1 && strcmp(argv[1], "--bench-bstar") == 0) {
+        run_bstar_benchmarks(argc, argv);
+    } else if (argc > 1 && strcmp(argv[1], "--bench-aggregate") == 0) {
+        run_aggregate_benchmarks(argc, argv);
+    } else if (argc > 1 && strcmp(argv[1], "--bench-relayout") == 0) {
+        run_relayout_benchmarks(argc, argv);
+    } else if (argc > 1 && strcmp(argv[1], "--bench-forest") == 0) {
+        run_forest_benchmarks(argc, argv);
+    } else if (argc > 1 && strcmp(argv[1], "--tune") == 0) {
+        run_tune(argc, argv);
     } else if (argc > 1 && strcmp(argv[1], "--all") == 0) {
         run_tests();
         run_benchmarks();
@@ -0,0 +1,241 @@
+/* ============================================================
+ * Coroutine-interleaved B-Tree lookups (C++20)
+ * ============================================================
+ * A lookup in a tree larger than the caches stalls on every hop:
+ *
+ *   node header -> keys[] -> children[i] -> next node header ...
+ *
+ * Each arrow is a dependent load, so one lookup has at most one miss
+ * in flight. Here a lookup is a coroutine that issues a prefetch for
+ * the next load and suspends (co_await prefetch(p)). A scheduler
+ * keeps K such lookups per thread and resumes them round-robin; by
+ * the time it comes back to one, its line has (ideally) arrived, and
+ * the misses of K lookups overlap.
+ *
+ * - Workers, not one frame per key: K coroutines each pull the next
+ *   key index from a shared counter until the batch is exhausted, so
+ *   a batch allocates K frames however many keys it holds.
+ * - The in-node search is the same linear scan btree_search uses, so
+ *   throughput differences come from the interleaving alone.
+ * - Read-only: the tree must not be modified during a batch.
+ *
+ * [x] btree::Tree         - owning RAII wrapper over the C engine
+ * [x] Tree::contains      - scalar lookup (btree_search)
+ * [x] Tree::contains_batch - K interleaved lookups per call
+ * ============================================================ */
+
+#ifndef BTREE_CORO_HPP
+#define BTREE_CORO_HPP
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "../b-tree-c/b-tree.h"
+
+namespace btree {
+
+constexpr int kMaxGroup = 64;       /* Upper bound on lookups in flight */
+constexpr std::size_t kLine = 64;   /* Bytes per prefetched cache line */
+
+/* ================================================================
+ * COROUTINE PLUMBING
+ * ================================================================ */
+
+/*
+ * Prefetch - Awaitable that starts loading @addr and always suspends
+ *
+ * The scheduler, not the awaiter, decides what runs next.
+ */
+struct Prefetch {
+    const void *addr;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<>) const noexcept {
+        __builtin_prefetch(addr);
+    }
+    void await_resume() const noexcept {}
+};
+
+/*
+ * Worker - Handle to a lookup coroutine, resumed by the scheduler
+ *
+ * Starts suspended and stays suspended at the end, so done() can be
+ * polled and the frame is released only by the destructor.
+ */
+class Worker {
+public:
+    struct promise_type {
+        Worker get_return_object() {
+            return Worker(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    Worker() = default;
+    explicit Worker(std::coroutine_handle<promise_type> h) : handle_(h) {}
+    Worker(Worker &&other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    Worker &operator=(Worker &&other) noexcept {
+        if (this != &other) {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    Worker(const Worker &) = delete;
+    Worker &operator=(const Worker &) = delete;
+    ~Worker() {
+        if (handle_) handle_.destroy();
+    }
+
+    bool done() const { return handle_.done(); }
+    void resume() { handle_.resume(); }
+
+private:
+    std::coroutine_handle<promise_type> handle_;
+};
+
+/* Shared state of one batch: workers claim keys by bumping next */
+struct Batch {
+    const BTreeNode *root;
+    std::span<const int> keys;
+    std::span<bool> found;
+    std::size_t next = 0;
+    long hits = 0;
+};
+
+/*
+ * lookup_worker - Answer keys from @batch until none are left
+ *
+ * Three suspension points per level, one per dependent load:
+ * the node header, its keys, and the child pointer it descends through.
+ */
+inline Worker lookup_worker(Batch &batch) {
+    for (std::size_t k; (k = batch.next++) < batch.keys.size();) {
+        int key = batch.keys[k];
+        const BTreeNode *node = batch.root;
+        bool hit = false;
+
+        co_await Prefetch{node};
+        for (;;) {
+            const int *keys = node->keys;
+            int n = node->n;
+            for (std::size_t off = 0; off < n * sizeof(int); off += kLine) {
+                __builtin_prefetch(reinterpret_cast<const char *>(keys) + off);
+            }
+            co_await Prefetch{keys};
+
+            int i = 0;
+            while (i < n && keys[i] < key) {
+                i++;
+            }
+            if (i < n && keys[i] == key) {
+                hit = true;
+                break;
+            }
+            if (node->is_leaf) break;
+
+            co_await Prefetch{&node->children[i]};
+            node = node->children[i];
+            co_await Prefetch{node};
+        }
+
+        batch.found[k] = hit;
+        batch.hits += hit;
+    }
+}
+
+/*
+ * search_interleaved - Look up @keys with @group lookups in flight
+ *
+ * @found: receives one flag per key (same length as @keys)
+ *
+ * Returns: number of keys found
+ */
+inline long search_interleaved(const BTree *tree, std::span<const int> keys,
+                               std::span<bool> found, int group) {
+    if (found.size() < keys.size()) {
+        throw std::invalid_argument("found is shorter than keys");
+    }
+    if (group < 1 || group > kMaxGroup) {
+        throw std::invalid_argument("group must be in [1, kMaxGroup]");
+    }
+
+    Batch batch{tree->root, keys, found};
+    Worker workers[kMaxGroup];
+    for (int w = 0; w < group; w++) {
+        workers[w] = lookup_worker(batch);
+    }
+
+    /* Round-robin until every worker has run out of keys */
+    for (int live = group; live > 0;) {
+        live = 0;
+        for (int w = 0; w < group; w++) {
+            if (workers[w].done()) continue;
+            workers[w].resume();
+            live += !workers[w].done();
+        }
+    }
+    return batch.hits;
+}
+
+/* ================================================================
+ * TREE WRAPPER
+ * ================================================================ */
+
+/*
+ * Tree - Owns a BTree; the C API stays reachable through get()
+ *
+ * Construction throws std::bad_alloc if the engine returns NULL.
+ */
+class Tree {
+public:
+    explicit Tree(int t) : Tree(btree_create(t)) {}
+
+    /* Adopt a tree built by the C API (e.g. btree_build_parallel) */
+    explicit Tree(BTree *tree) : tree_(tree) {
+        if (!tree_) throw std::bad_alloc();
+    }
+
+    Tree(Tree &&other) noexcept : tree_(std::exchange(other.tree_, nullptr)) {}
+    Tree &operator=(Tree &&other) noexcept {
+        if (this != &other) {
+            if (tree_) btree_destroy(tree_);
+            tree_ = std::exchange(other.tree_, nullptr);
+        }
+        return *this;
+    }
+    Tree(const Tree &) = delete;
+    Tree &operator=(const Tree &) = delete;
+    ~Tree() {
+        if (tree_) btree_destroy(tree_);
+    }
+
+    void insert(int key) { btree_insert(tree_, key); }
+    void erase(int key) { btree_delete(tree_, key); }
+
+    bool contains(int key) const {
+        return btree_search(tree_->root, key, nullptr) != nullptr;
+    }
+
+    long contains_batch(std::span<const int> keys, std::span<bool> found,
+                        int group = 8) const {
+        return search_interleaved(tree_, keys, found, group);
+    }
+
+    BTree *get() const { return tree_; }
+
+private:
+    BTree *tree_;
+};
+
+} /* namespace btree */
+
+#endif /* BTREE_CORO_HPP */
@@ -0,0 +1,1001 @@
+/*
+ * LSM-Tree Implementation
+ *
+ * This file implements the memtable, run files, merging reads and the
+ * background flush/compaction thread. See lsm_tree.h for the design.
+ */
+
+#include "lsm_tree.h"
+#include "../splay-tree-c/splay_tree.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define RUN_MAGIC   0x524D534Cu  /* "LSMR" little-endian */
+#define RUN_VERSION 1u
+#define L0_MAX      64           /* Hard cap; see background_main */
+
+/* ================================================================
+ * DATA STRUCTURES (private)
+ * ================================================================ */
+
+typedef struct {
+    int32_t key;
+    int32_t tomb;   /* 1 = delete marker */
+} Entry;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;
+    uint32_t blocks;
+} RunHeader;
+
+/* An immutable sorted run file; shared by reference count */
+typedef struct Run {
+    int fd;
+    char *path;
+    long count;
+    int blocks;
+    int *fences;     /* First key of each block: the sparse index */
+    int min_key, max_key;
+    int refs;        /* Guarded by LSMTree.lock */
+} Run;
+
+/* Two splay trees: live keys and tombstones; a key is in at most one */
+typedef struct {
+    struct Node *puts;
+    struct Node *dels;
+    size_t size;
+} Memtable;
+
+struct LSMTree {
+    char *dir;
+    LSMOptions opts;
+
+    Memtable *mem;   /* Foreground thread only */
+    Memtable *imm;   /* Being flushed; read-only, swapped under lock */
+
+    Run *l0[L0_MAX]; /* Newest first */
+    int l0_count;
+    Run *levels[LSM_MAX_LEVELS];  /* levels[1..]; [0] unused */
+    long next_run_id;
+
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t work;   /* Background thread waits here */
+    pthread_cond_t done;   /* Foreground waits for flush / idle */
+    bool stop;
+    bool idle;
+    bool failed;           /* A flush could not be written */
+
+    /* Foreground counters */
+    long puts, gets, blocks_read, runs_probed, stalls;
+    /* Background counters (under lock) */
+    long flush_bytes, compact_bytes, flushes, compactions;
+};
+
+/* ================================================================
+ * MEMTABLE
+ *
+ * The active memtable is splayed freely by the foreground thread. The
+ * immutable one may be walked by the background thread at the same
+ * time, so it is only ever searched without splaying.
+ * ================================================================ */
+
+static Memtable *mem_create(void) {
+    return (Memtable *)calloc(1, sizeof(Memtable));
+}
+
+static void mem_free(Memtable *mem) {
+    if (!mem) return;
+    freeTree(mem->puts);
+    freeTree(mem->dels);
+    free(mem);
+}
+
+/* mem_has - Splaying membership test (active memtable only) */
+static bool mem_has(struct Node **root, int key) {
+    if (!*root) return false;
+    *root = splay_search(*root, key);
+    return (*root)->key == key;
+}
+
+/* bst_has - Plain BST lookup that leaves the tree untouched */
+static bool bst_has(const struct Node *node, int key) {
+    while (node) {
+        if (key == node->key) return true;
+        node = key < node->key ? node->left : node->right;
+    }
+    return false;
+}
+
+/*
+ * mem_apply - Record key as live (@tomb false) or deleted (@tomb true)
+ *
+ * Returns: 0 on success, -1 on allocation failure
+ */
+static int mem_apply(Memtable *mem, int key, bool tomb) {
+    struct Node **add = tomb ? &mem->dels : &mem->puts;
+    struct Node **drop = tomb ? &mem->puts : &mem->dels;
+
+    if (mem_has(add, key)) return 0;
+    if (mem_has(drop, key)) {
+        *drop = splay_delete(*drop, key);
+    } else {
+        mem->size++;
+    }
+    *add = splay_insert(*add, key);
+    return (*add && (*add)->key == key) ? 0 : -1;
+}
+
+/*
+ * tree_keys - Keys of a splay tree within [lo, hi], in order
+ *
+ * Iterative, since splay trees can be very deep (e.g. after
+ * ascending inserts). Returns: malloc'd array (also when no key is in
+ * range, then *n is 0), or NULL on allocation failure.
+ */
+static int *tree_keys(const struct Node *root, int lo, int hi, size_t *n) {
+    size_t cap = 64, sp = 0, count = 0, out_cap = 64;
+    const struct Node **stack = malloc(cap * sizeof(*stack));
+    int *out = malloc(out_cap * sizeof(int));
+    *n = 0;
+    if (!stack || !out) goto fail;
+
+    const struct Node *cur = root;
+    while (cur || sp > 0) {
+        while (cur) {
+            if (cur->key < lo) {
+                cur = cur->right;
+                continue;
+            }
+            if (sp == cap) {
+                const struct Node **grown = realloc(stack, 2 * cap * sizeof(*stack));
+                if (!grown) goto fail;
+                stack = grown;
+                cap *= 2;
+            }
+            stack[sp++] = cur;
+            cur = cur->left;
+        }
+        cur = stack[--sp];
+        if (cur->key > hi) break;
+        if (count == out_cap) {
+            int *grown = realloc(out, 2 * out_cap * sizeof(int));
+            if (!grown) goto fail;
+            out = grown;
+            out_cap *= 2;
+        }
+        out[count++] = cur->key;
+        cur = cur->right;
+    }
+    free(stack);
+    *n = count;
+    return out;
+
+fail:
+    free(stack);
+    free(out);
+    return NULL;
+}
+
+/*
+ * mem_entries - Memtable contents within [lo, hi] as sorted entries
+ *
+ * @out: receives a malloc'd array, or NULL when there are no entries
+ * @n: receives its length
+ *
+ * Returns: 0 on success (including an empty range), -1 on allocation
+ *          failure
+ */
+static int mem_entries(const Memtable *mem, int lo, int hi, Entry **out, size_t *n) {
+    size_t np = 0, nd = 0;
+    int *puts = tree_keys(mem->puts, lo, hi, &np);
+    int *dels = tree_keys(mem->dels, lo, hi, &nd);
+    Entry *e = (puts && dels && np + nd > 0) ? malloc((np + nd) * sizeof(Entry)) : NULL;
+    int rc = (!puts || !dels || (np + nd > 0 && !e)) ? -1 : 0;
+
+    size_t i = 0, j = 0, k = 0;
+    while (e && (i < np || j < nd)) {
+        if (j == nd || (i < np && puts[i] < dels[j])) {
+            e[k++] = (Entry){ puts[i++], 0 };
+        } else {
+            e[k++] = (Entry){ dels[j++], 1 };
+        }
+    }
+    free(puts);
+    free(dels);
+    *out = e;
+    *n = k;
+    return rc;
+}
+
+/* ================================================================
+ * RUN FILES
+ *
+ *   [RunHeader][block 0][block 1]...[block B-1][fence 0 .. fence B-1]
+ *
+ * Each block holds LSM_BLOCK_ENTRIES entries (the last may be short).
+ * ================================================================ */
+
+static int write_all(int fd, const void *buf, size_t len) {
+    const char *p = (const char *)buf;
+    while (len > 0) {
+        ssize_t w = write(fd, p, len);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += w;
+        len -= (size_t)w;
+    }
+    return 0;
+}
+
+static int read_at(int fd, void *buf, size_t len, off_t off) {
+    char *p = (char *)buf;
+    while (len > 0) {
+        ssize_t r = pread(fd, p, len, off);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return -1;
+        p += r;
+        len -= (size_t)r;
+        off += r;
+    }
+    return 0;
+}
+
+typedef struct {
+    Run *run;
+    Entry block[LSM_BLOCK_ENTRIES];
+    int in_block;
+    int fence_cap;
+    bool failed;
+} RunWriter;
+
+static bool run_writer_open(LSMTree *lsm, RunWriter *w, long id) {
+    memset(w, 0, sizeof(*w));
+    w->run = (Run *)calloc(1, sizeof(Run));
+    if (!w->run) return false;
+
+    size_t len = strlen(lsm->dir) + 32;
+    w->run->path = malloc(len);
+    if (w->run->path) snprintf(w->run->path, len, "%s/run-%06ld.sst", lsm->dir, id);
+    w->run->fd = w->run->path ? open(w->run->path, O_RDWR | O_CREAT | O_TRUNC, 0644)
+                              : -1;
+    if (w->run->fd < 0 || lseek(w->run->fd, sizeof(RunHeader), SEEK_SET) < 0) {
+        if (w->run->fd >= 0) {
+            close(w->run->fd);
+            unlink(w->run->path);
+        }
+        free(w->run->path);
+        free(w->run);
+        return false;
+    }
+    w->run->refs = 1;
+    return true;
+}
+
+static void run_writer_add(RunWriter *w, Entry e) {
+    Run *run = w->run;
+    if (w->failed) return;
+
+    if (w->in_block == 0) {
+        if (run->blocks == w->fence_cap) {
+            int cap = w->fence_cap ? 2 * w->fence_cap : 16;
+            int *grown = realloc(run->fences, cap * sizeof(int));
+            if (!grown) {
+                w->failed = true;
+                return;
+            }
+            run->fences = grown;
+            w->fence_cap = cap;
+        }
+        run->fences[run->blocks++] = e.key;
+    }
+    if (run->count == 0) run->min_key = e.key;
+    run->max_key = e.key;
+    run->count++;
+
+    w->block[w->in_block++] = e;
+    if (w->in_block == LSM_BLOCK_ENTRIES) {
+        if (write_all(run->fd, w->block, sizeof(w->block)) != 0) w->failed = true;
+        w->in_block = 0;
+    }
+}
+
+static void run_discard(Run *run) {
+    close(run->fd);
+    unlink(run->path);
+    free(run->path);
+    free(run->fences);
+    free(run);
+}
+
+/*
+ * run_writer_finish - Write the tail, fences and header
+ *
+ * @bytes: receives the file size
+ *
+ * Returns: the new run (one reference), or NULL if it is empty or an
+ *          I/O error occurred (*failed is then set)
+ */
+static Run *run_writer_finish(RunWriter *w, long *bytes, bool *failed) {
+    Run *run = w->run;
+    *failed = w->failed;
+
+    if (!w->failed && w->in_block > 0 &&
+        write_all(run->fd, w->block, w->in_block * sizeof(Entry)) != 0) {
+        *failed = true;
+    }
+    if (!*failed && run->blocks > 0 &&
+        write_all(run->fd, run->fences, run->blocks * sizeof(int)) != 0) {
+        *failed = true;
+    }
+    RunHeader h = { RUN_MAGIC, RUN_VERSION, (uint32_t)run->count,
+                    (uint32_t)run->blocks };
+    if (!*failed && pwrite(run->fd, &h, sizeof(h), 0) != (ssize_t)sizeof(h)) {
+        *failed = true;
+    }
+
+    if (*failed || run->count == 0) {
+        run_discard(run);
+        return NULL;
+    }
+    *bytes = sizeof(RunHeader) + run->count * sizeof(Entry) +
+             run->blocks * sizeof(int);
+    return run;
+}
+
+/* run_read_block - Load block b; returns its entry count, -1 on error */
+static int run_read_block(const Run *run, int b, Entry *buf) {
+    long first = (long)b * LSM_BLOCK_ENTRIES;
+    int len = run->count - first < LSM_BLOCK_ENTRIES ? (int)(run->count - first)
+                                                      : LSM_BLOCK_ENTRIES;
+    off_t off = sizeof(RunHeader) + first * sizeof(Entry);
+    return read_at(run->fd, buf, len * sizeof(Entry), off) == 0 ? len : -1;
+}
+
+/* fence_block - Block that would hold key: last fence <= key (0 if none) */
+static int fence_block(const Run *run, int key) {
+    int lo = 0, hi = run->blocks;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (run->fences[mid] <= key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo > 0 ? lo - 1 : 0;
+}
+
+static int entry_lower_bound(const Entry *e, int n, int key) {
+    int lo = 0, hi = n;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (e[mid].key < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/* Caller holds lsm->lock */
+static void run_unref(Run *run) {
+    if (run && --run->refs == 0) run_discard(run);
+}
+
+/* ================================================================
+ * MERGING ITERATOR
+ *
+ * Sources are ordered newest first. For each key the newest source
+ * wins and the rest are skipped; tombstones are returned to the caller,
+ * which decides whether to drop them.
+ * ================================================================ */
+
+typedef struct {
+    /* Memtable source (run == NULL) */
+    const Entry *mem;
+    size_t mem_n;
+    /* Run source */
+    const Run *run;
+    Entry *block;
+    int block_idx, block_len;
+    /* Position */
+    size_t pos;
+    bool valid;
+    bool error;      /* A block read failed: the run is not exhausted */
+    Entry cur;
+} Source;
+
+static void source_load(Source *s) {
+    if (!s->run) {
+        s->valid = s->pos < s->mem_n;
+        if (s->valid) s->cur = s->mem[s->pos];
+        return;
+    }
+    while ((int)s->pos >= s->block_len) {
+        if (++s->block_idx >= s->run->blocks) {
+            s->valid = false;
+            return;
+        }
+        s->block_len = run_read_block(s->run, s->block_idx, s->block);
+        s->pos = 0;
+        if (s->block_len < 0) {
+            s->valid = false;
+            s->error = true;
+            return;
+        }
+    }
+    s->valid = true;
+    s->cur = s->block[s->pos];
+}
+
+static void source_init_mem(Source *s, const Entry *e, size_t n) {
+    memset(s, 0, sizeof(*s));
+    s->mem = e;
+    s->mem_n = n;
+    source_load(s);
+}
+
+/*
+ * source_init_run - Position a run source at the first key >= lo
+ *
+ * Returns: false on allocation or read failure
+ */
+static bool source_init_run(Source *s, const Run *run, int lo) {
+    memset(s, 0, sizeof(*s));
+    s->run = run;
+    s->block = malloc(LSM_BLOCK_ENTRIES * sizeof(Entry));
+    if (!s->block) return false;
+
+    s->block_idx = fence_block(run, lo);
+    s->block_len = run_read_block(run, s->block_idx, s->block);
+    if (s->block_len < 0) {
+        s->error = true;
+        return false;
+    }
+    s->pos = entry_lower_bound(s->block, s->block_len, lo);
+    source_load(s);
+    return !s->error;
+}
+
+static void source_advance(Source *s) {
+    s->pos++;
+    source_load(s);
+}
+
+/*
+ * merge_next - Next winning entry across sources
+ *
+ * Returns: 1 with *out set, 0 when every source is exhausted, -1 if a
+ *          run could not be read (its remaining keys are unknown)
+ */
+static int merge_next(Source *src, int n, Entry *out) {
+    int best = -1;
+    for (int i = 0; i < n; i++) {
+        if (src[i].error) return -1;
+        if (src[i].valid && (best < 0 || src[i].cur.key < src[best].cur.key)) {
+            best = i;  /* Ties keep the lower (newer) index */
+        }
+    }
+    if (best < 0) return 0;
+
+    *out = src[best].cur;
+    for (int i = 0; i < n; i++) {
+        if (src[i].valid && src[i].cur.key == out->key) source_advance(&src[i]);
+    }
+    return 1;
+}
+
+static void sources_free(Source *src, int n) {
+    for (int i = 0; i < n; i++) free(src[i].block);
+    free(src);
+}
+
+/* ================================================================
+ * FLUSH AND COMPACTION (background thread)
+ * ================================================================ */
+
+static long level_target(const LSMTree *lsm, int level) {
+    long target = (long)lsm->opts.memtable_keys * lsm->opts.l0_trigger;
+    for (int i = 1; i < level; i++) target *= lsm->opts.level_ratio;
+    return target;
+}
+
+/*
+ * flush_imm - Write the immutable memtable as the newest L0 run
+ *
+ * Called and returns with the lock held; drops it for the I/O.
+ */
+static void flush_imm(LSMTree *lsm) {
+    Memtable *imm = lsm->imm;
+    long id = lsm->next_run_id++;
+    pthread_mutex_unlock(&lsm->lock);
+
+    RunWriter *w = malloc(sizeof(RunWriter));
+    size_t n = 0;
+    Entry *entries = NULL;
+    bool failed = mem_entries(imm, INT_MIN, INT_MAX, &entries, &n) != 0 || !w;
+    Run *run = NULL;
+    long bytes = 0;
+
+    if (!failed && run_writer_open(lsm, w, id)) {
+        for (size_t i = 0; i < n; i++) run_writer_add(w, entries[i]);
+        run = run_writer_finish(w, &bytes, &failed);
+    } else {
+        failed = true;
+    }
+    free(entries);
+    free(w);
+
+    pthread_mutex_lock(&lsm->lock);
+    if (failed) {
+        /* Keep imm so no write is lost; writers see the error */
+        fprintf(stderr, "Error: memtable flush to %s failed\n", lsm->dir);
+        lsm->failed = true;
+        pthread_cond_broadcast(&lsm->done);
+        return;
+    }
+    if (run) {
+        memmove(&lsm->l0[1], &lsm->l0[0], lsm->l0_count * sizeof(Run *));
+        lsm->l0[0] = run;
+        lsm->l0_count++;
+        lsm->flush_bytes += bytes;
+    }
+    lsm->flushes++;
+    lsm->imm = NULL;
+    pthread_cond_broadcast(&lsm->done);
+
+    pthread_mutex_unlock(&lsm->lock);
+    mem_free(imm);
+    pthread_mutex_lock(&lsm->lock);
+}
+
+typedef struct {
+    int from;                    /* 0 for L0 -> L1, else Li -> Li+1 */
+    Run *inputs[L0_MAX + 1];     /* Newest first */
+    int n_inputs;
+    int l0_taken;                /* L0 runs consumed (the oldest ones) */
+} CompactionJob;
+
+/* pick_compaction - Choose the next merge, if any (lock held) */
+static bool pick_compaction(LSMTree *lsm, CompactionJob *job) {
+    memset(job, 0, sizeof(*job));
+
+    if (lsm->l0_count >= lsm->opts.l0_trigger) {
+        job->from = 0;
+        for (int i = 0; i < lsm->l0_count; i++) job->inputs[job->n_inputs++] = lsm->l0[i];
+        job->l0_taken = lsm->l0_count;
+        if (lsm->levels[1]) job->inputs[job->n_inputs++] = lsm->levels[1];
+        return true;
+    }
+    for (int level = 1; level + 1 < LSM_MAX_LEVELS; level++) {
+        Run *run = lsm->levels[level];
+        if (run && run->count > level_target(lsm, level)) {
+            job->from = level;
+            job->inputs[job->n_inputs++] = run;
+            if (lsm->levels[level + 1]) job->inputs[job->n_inputs++] = lsm->levels[level + 1];
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * run_compaction - Merge job inputs into one run at the next level
+ *
+ * Called and returns with the lock held; drops it for the merge.
+ * Tombstones are dropped when nothing older lies below the output.
+ */
+static void run_compaction(LSMTree *lsm, CompactionJob *job) {
+    int out_level = job->from + 1;
+    bool bottom = true;
+    for (int level = out_level + 1; level < LSM_MAX_LEVELS; level++) {
+        if (lsm->levels[level]) bottom = false;
+    }
+    for (int i = 0; i < job->n_inputs; i++) job->inputs[i]->refs++;
+    long id = lsm->next_run_id++;
+    pthread_mutex_unlock(&lsm->lock);
+
+    Source *src = calloc(job->n_inputs, sizeof(Source));
+    RunWriter *w = malloc(sizeof(RunWriter));
+    Run *out = NULL;
+    long bytes = 0;
+    bool failed = !src || !w;
+
+    for (int i = 0; !failed && i < job->n_inputs; i++) {
+        if (!source_init_run(&src[i], job->inputs[i], INT_MIN)) failed = true;
+    }
+    if (!failed && run_writer_open(lsm, w, id)) {
+        Entry e;
+        int more;
+        while ((more = merge_next(src, job->n_inputs, &e)) > 0) {
+            if (e.tomb && bottom) continue;
+            run_writer_add(w, e);
+        }
+        if (more < 0) w->failed = true;  /* Unreadable input: discard the output */
+        out = run_writer_finish(w, &bytes, &failed);
+    } else {
+        failed = true;
+    }
+    if (src) sources_free(src, job->n_inputs);
+    free(w);
+
+    pthread_mutex_lock(&lsm->lock);
+    for (int i = 0; i < job->n_inputs; i++) run_unref(job->inputs[i]);
+    if (failed) {
+        /* Inputs stay in place; nothing was lost */
+        fprintf(stderr, "Error: compaction in %s failed\n", lsm->dir);
+        lsm->failed = true;
+        return;
+    }
+
+    /* Install: newer L0 runs flushed meanwhile sit in front, untouched */
+    if (job->from == 0) {
+        for (int i = 0; i < job->l0_taken; i++) {
+            run_unref(lsm->l0[lsm->l0_count - 1 - i]);
+        }
+        lsm->l0_count -= job->l0_taken;
+    } else {
+        run_unref(lsm->levels[job->from]);
+        lsm->levels[job->from] = NULL;
+    }
+    run_unref(lsm->levels[out_level]);
+    lsm->levels[out_level] = out;
+    lsm->compact_bytes += bytes;
+    lsm->compactions++;
+    pthread_cond_broadcast(&lsm->done);
+}
+
+/*
+ * background_main - Flush and compaction loop
+ *
+ * Flushing comes first so writers stall as little as possible, unless
+ * L0 has reached twice its trigger: then compaction must catch up
+ * before more runs pile up (and L0_MAX bounds it regardless).
+ */
+static void *background_main(void *arg) {
+    LSMTree *lsm = (LSMTree *)arg;
+    CompactionJob *job = malloc(sizeof(CompactionJob));
+
+    pthread_mutex_lock(&lsm->lock);
+    while (!lsm->stop) {
+        bool l0_full = lsm->l0_count >= 2 * lsm->opts.l0_trigger ||
+                       lsm->l0_count >= L0_MAX;
+        if (!lsm->failed && lsm->imm && !l0_full) {
+            flush_imm(lsm);
+        } else if (!lsm->failed && job && pick_compaction(lsm, job)) {
+            run_compaction(lsm, job);
+        } else {
+            lsm->idle = true;
+            pthread_cond_broadcast(&lsm->done);
+            pthread_cond_wait(&lsm->work, &lsm->lock);
+        }
+    }
+    pthread_mutex_unlock(&lsm->lock);
+    free(job);
+    return NULL;
+}
+
+/* ================================================================
+ * PUBLIC: OPEN / CLOSE
+ * ================================================================ */
+
+/*
+ * lsm_open - Create an empty LSM-tree storing runs under @dir
+ *
+ * @dir: existing directory; run files are named run-NNNNNN.sst
+ * @opts: NULL for defaults (64K-key memtable, L0 trigger 4, ratio 10)
+ *
+ * Returns: new tree, or NULL on bad options / resource failure
+ */
+LSMTree *lsm_open(const char *dir, const LSMOptions *opts) {
+    LSMOptions defaults = { 65536, 4, 10 };
+    if (!opts) opts = &defaults;
+    if (!dir || opts->memtable_keys == 0 || opts->l0_trigger < 1 ||
+        2 * opts->l0_trigger > L0_MAX || opts->level_ratio < 2) {
+        fprintf(stderr, "Error: invalid LSM options\n");
+        return NULL;
+    }
+
+    LSMTree *lsm = (LSMTree *)calloc(1, sizeof(LSMTree));
+    if (!lsm) return NULL;
+    lsm->opts = *opts;
+    lsm->dir = strdup(dir);
+    lsm->mem = mem_create();
+    if (!lsm->dir || !lsm->mem) goto fail;
+
+    pthread_mutex_init(&lsm->lock, NULL);
+    pthread_cond_init(&lsm->work, NULL);
+    pthread_cond_init(&lsm->done, NULL);
+    lsm->idle = true;
+    if (pthread_create(&lsm->thread, NULL, background_main, lsm) != 0) {
+        pthread_mutex_destroy(&lsm->lock);
+        pthread_cond_destroy(&lsm->work);
+        pthread_cond_destroy(&lsm->done);
+        goto fail;
+    }
+    return lsm;
+
+fail:
+    mem_free(lsm->mem);
+    free(lsm->dir);
+    free(lsm);
+    return NULL;
+}
+
+/*
+ * lsm_close - Stop the background thread and remove all run files
+ *
+ * Unflushed writes are discarded (there is no WAL).
+ */
+void lsm_close(LSMTree *lsm) {
+    if (!lsm) return;
+
+    pthread_mutex_lock(&lsm->lock);
+    lsm->stop = true;
+    pthread_cond_signal(&lsm->work);
+    pthread_mutex_unlock(&lsm->lock);
+    pthread_join(lsm->thread, NULL);
+
+    for (int i = 0; i < lsm->l0_count; i++) run_unref(lsm->l0[i]);
+    for (int level = 1; level < LSM_MAX_LEVELS; level++) {
+        run_unref(lsm->levels[level]);
+    }
+    mem_free(lsm->mem);
+    mem_free(lsm->imm);
+    pthread_mutex_destroy(&lsm->lock);
+    pthread_cond_destroy(&lsm->work);
+    pthread_cond_destroy(&lsm->done);
+    free(lsm->dir);
+    free(lsm);
+}
+
+/* ================================================================
+ * WRITES
+ * ================================================================ */
+
+/*
+ * rotate - Hand the active memtable to the background thread
+ *
+ * Stalls while the previous one is still being flushed.
+ * Returns: 0 on success, -1 if flushing has failed
+ */
+static int rotate(LSMTree *lsm) {
+    Memtable *fresh = mem_create();
+    if (!fresh) return -1;
+
+    pthread_mutex_lock(&lsm->lock);
+    if (lsm->imm && !lsm->failed) lsm->stalls++;
+    while (lsm->imm && !lsm->failed) {
+        pthread_cond_wait(&lsm->done, &lsm->lock);
+    }
+    if (lsm->failed) {
+        pthread_mutex_unlock(&lsm->lock);
+        mem_free(fresh);
+        return -1;
+    }
+    lsm->imm = lsm->mem;
+    lsm->mem = fresh;
+    lsm->idle = false;
+    pthread_cond_signal(&lsm->work);
+    pthread_mutex_unlock(&lsm->lock);
+    return 0;
+}
+
+static int lsm_write(LSMTree *lsm, int key, bool tomb) {
+    if (!lsm) return -1;
+    lsm->puts++;
+    if (mem_apply(lsm->mem, key, tomb) != 0) return -1;
+    if (lsm->mem->size >= lsm->opts.memtable_keys) return rotate(lsm);
+    return 0;
+}
+
+/*
+ * lsm_put / lsm_delete - Insert or remove a key
+ *
+ * Returns: 0 on success, -1 on failure
+ */
+int lsm_put(LSMTree *lsm, int key) {
+    return lsm_write(lsm, key, false);
+}
+
+int lsm_delete(LSMTree *lsm, int key) {
+    return lsm_write(lsm, key, true);
+}
+
+/*
+ * lsm_flush - Flush the memtable and wait until it is on disk
+ *
+ * Returns: 0 on success, -1 if flushing failed
+ */
+int lsm_flush(LSMTree *lsm) {
+    if (!lsm) return -1;
+    if (lsm->mem->size > 0 && rotate(lsm) != 0) return -1;
+
+    pthread_mutex_lock(&lsm->lock);
+    while (lsm->imm && !lsm->failed) {
+        pthread_cond_wait(&lsm->done, &lsm->lock);
+    }
+    int rc = lsm->failed ? -1 : 0;
+    pthread_mutex_unlock(&lsm->lock);
+    return rc;
+}
+
+/*
+ * lsm_wait_idle - Wait until no flush or compaction is pending
+ */
+void lsm_wait_idle(LSMTree *lsm) {
+    if (!lsm) return;
+    pthread_mutex_lock(&lsm->lock);
+    while (!lsm->idle && !lsm->failed) {
+        pthread_cond_wait(&lsm->done, &lsm->lock);
+    }
+    pthread_mutex_unlock(&lsm->lock);
+}
+
+/* ================================================================
+ * READS
+ *
+ * Newest data wins: memtable, immutable memtable, L0 newest to
+ * oldest, then L1, L2, ... Runs are pinned by reference so that a
+ * concurrent compaction cannot delete them mid-read.
+ * ================================================================ */
+
+/* snapshot_runs - Pin every run in read order (lock held) */
+static int snapshot_runs(LSMTree *lsm, Run **out) {
+    int n = 0;
+    for (int i = 0; i < lsm->l0_count; i++) out[n++] = lsm->l0[i];
+    for (int level = 1; level < LSM_MAX_LEVELS; level++) {
+        if (lsm->levels[level]) out[n++] = lsm->levels[level];
+    }
+    for (int i = 0; i < n; i++) out[i]->refs++;
+    return n;
+}
+
+static void release_runs(LSMTree *lsm, Run **runs, int n) {
+    pthread_mutex_lock(&lsm->lock);
+    for (int i = 0; i < n; i++) run_unref(runs[i]);
+    pthread_mutex_unlock(&lsm->lock);
+}
+
+/*
+ * run_lookup - Probe one run
+ *
+ * Returns: 1 if key is live, 0 if deleted, -1 if the run has no entry
+ */
+static int run_lookup(LSMTree *lsm, const Run *run, int key, Entry *block) {
+    if (key < run->min_key || key > run->max_key) return -1;
+
+    lsm->runs_probed++;
+    int len = run_read_block(run, fence_block(run, key), block);
+    lsm->blocks_read++;
+    if (len <= 0) return -1;
+
+    int i = entry_lower_bound(block, len, key);
+    if (i < len && block[i].key == key) return block[i].tomb ? 0 : 1;
+    return -1;
+}
+
+/*
+ * lsm_get - Return true if key is present
+ */
+bool lsm_get(LSMTree *lsm, int key) {
+    if (!lsm) return false;
+    lsm->gets++;
+
+    if (mem_has(&lsm->mem->dels, key)) return false;
+    if (mem_has(&lsm->mem->puts, key)) return true;
+
+    Run *runs[L0_MAX + LSM_MAX_LEVELS];
+    pthread_mutex_lock(&lsm->lock);
+    if (lsm->imm && (bst_has(lsm->imm->dels, key) || bst_has(lsm->imm->puts, key))) {
+        bool live = bst_has(lsm->imm->puts, key);
+        pthread_mutex_unlock(&lsm->lock);
+        return live;
+    }
+    int n = snapshot_runs(lsm, runs);
+    pthread_mutex_unlock(&lsm->lock);
+
+    Entry *block = malloc(LSM_BLOCK_ENTRIES * sizeof(Entry));
+    int found = -1;
+    for (int i = 0; block && i < n && found < 0; i++) {
+        found = run_lookup(lsm, runs[i], key, block);
+    }
+    free(block);
+    release_runs(lsm, runs, n);
+    return found == 1;
+}
+
+/*
+ * lsm_range - Visit every live key in [lo, hi] in ascending order
+ *
+ * A failed block read ends the scan with -1; keys visited before it
+ * are correct but the range is incomplete.
+ *
+ * Returns: number of keys visited, or -1 on allocation or read failure
+ */
+long lsm_range(LSMTree *lsm, int lo, int hi,
+               void (*visit)(int key, void *ctx), void *ctx) {
+    if (!lsm || lo > hi) return 0;
+
+    size_t mem_n = 0, imm_n = 0;
+    Entry *mem_e = NULL, *imm_e = NULL;
+    bool ok = mem_entries(lsm->mem, lo, hi, &mem_e, &mem_n) == 0;
+    Run *runs[L0_MAX + LSM_MAX_LEVELS];
+
+    pthread_mutex_lock(&lsm->lock);
+    if (lsm->imm && mem_entries(lsm->imm, lo, hi, &imm_e, &imm_n) != 0) ok = false;
+    int n = snapshot_runs(lsm, runs);
+    pthread_mutex_unlock(&lsm->lock);
+
+    Source *src = calloc(n + 2, sizeof(Source));
+    long visited = -1;
+    if (src && ok) {
+        source_init_mem(&src[0], mem_e, mem_n);
+        source_init_mem(&src[1], imm_e, imm_n);
+        for (int i = 0; i < n; i++) {
+            if (!source_init_run(&src[2 + i], runs[i], lo)) ok = false;
+        }
+
+        Entry e;
+        int more = 0;
+        visited = 0;
+        while (ok && (more = merge_next(src, n + 2, &e)) > 0 && e.key <= hi) {
+            if (e.tomb) continue;
+            if (visit) visit(e.key, ctx);
+            visited++;
+        }
+        if (!ok || more < 0) visited = -1;
+    }
+    if (src) sources_free(src, n + 2);
+    free(mem_e);
+    free(imm_e);
+    release_runs(lsm, runs, n);
+    return visited;
+}
+
+/* ================================================================
+ * STATISTICS
+ * ================================================================ */
+
+void lsm_stats(LSMTree *lsm, LSMStats *stats) {
+    memset(stats, 0, sizeof(*stats));
+    if (!lsm) return;
+
+    stats->puts = lsm->puts;
+    stats->gets = lsm->gets;
+    stats->user_bytes = lsm->puts * (long)sizeof(Entry);
+    stats->blocks_read = lsm->blocks_read;
+    stats->runs_probed = lsm->runs_probed;
+    stats->stalls = lsm->stalls;
+
+    pthread_mutex_lock(&lsm->lock);
+    stats->flush_bytes = lsm->flush_bytes;
+    stats->compact_bytes = lsm->compact_bytes;
+    stats->flushes = lsm->flushes;
+    stats->compactions = lsm->compactions;
+    stats->l0_runs = lsm->l0_count;
+    for (int i = 0; i < lsm->l0_count; i++) stats->level_keys[0] += lsm->l0[i]->count;
+    for (int level = 1; level < LSM_MAX_LEVELS; level++) {
+        if (lsm->levels[level]) stats->level_keys[level] = lsm->levels[level]->count;
+    }
+    pthread_mutex_unlock(&lsm->lock);
+
+    if (stats->user_bytes > 0) {
+        stats->write_amp = (double)(stats->flush_bytes + stats->compact_bytes) /
+                           stats->user_bytes;
+    }
+    if (stats->gets > 0) stats->read_amp = (double)stats->blocks_read / stats->gets;
+}
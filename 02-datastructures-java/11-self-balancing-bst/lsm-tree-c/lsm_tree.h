@@ -0,0 +1,92 @@
+/* ============================================================
+ * LSM-Tree (Log-Structured Merge Tree) over int keys
+ * ============================================================
+ * Writes never update data in place:
+ *
+ *   put/delete -> memtable (splay trees from ../splay-tree-c)
+ *                    | full: becomes the immutable memtable
+ *                    v
+ *              background thread flushes it to an L0 run file
+ *                    |
+ *                    v
+ *   L0: run, run, run (newest first, key ranges overlap)
+ *   L1: one sorted run, ~ l0_trigger memtables
+ *   L2: one sorted run, level_ratio x L1 ...
+ *
+ * - Run file: header, sorted entries {key, tombstone} in 4 KiB blocks,
+ *   then one fence key per block. The fences are the sparse index
+ *   (like the internal level of a B-tree): a point read binary
+ *   searches them in memory and reads exactly one block.
+ * - Deletes write tombstones, which shadow older runs and are dropped
+ *   once compaction reaches the bottom level.
+ * - Leveled compaction on the background thread: l0_trigger L0 runs
+ *   are merged into L1; an oversized level Li is merged into Li+1.
+ *   A full immutable memtable stalls writers until it is flushed.
+ *
+ * Scope: a set of int keys, like the other trees in this directory.
+ * There is no WAL or manifest: run files live in the given directory
+ * only while the tree is open and are removed by lsm_close.
+ *
+ * Threading: every lsm_* call on one tree must come from a single
+ * thread. The active memtable and the foreground counters (puts,
+ * gets, blocks_read, ...) are not synchronized; only the handoff to
+ * the background thread is.
+ *
+ * Errors: a failed run read makes lsm_range return -1 and fails the
+ * compaction that hit it (after which lsm_flush, and any write that
+ * fills the memtable, return -1);
+ * lsm_get cannot report it and treats the run as holding no entry.
+ *
+ * [x] lsm_open / lsm_close
+ * [x] lsm_put / lsm_delete / lsm_get / lsm_range
+ * [x] lsm_flush / lsm_wait_idle / lsm_stats
+ * ============================================================ */
+
+#ifndef LSM_TREE_H
+#define LSM_TREE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define LSM_MAX_LEVELS 8          /* L1..L7; L0 is separate */
+#define LSM_BLOCK_ENTRIES 512     /* 8-byte entries per 4 KiB block */
+
+typedef struct LSMTree LSMTree;   /* Layout is private */
+
+typedef struct LSMOptions {
+    size_t memtable_keys;  /* Entries per memtable before it is flushed */
+    int l0_trigger;        /* L0 runs that trigger an L0 -> L1 merge */
+    int level_ratio;       /* Size ratio between adjacent levels */
+} LSMOptions;
+
+typedef struct LSMStats {
+    long puts;              /* lsm_put + lsm_delete calls */
+    long gets;              /* lsm_get calls */
+    long user_bytes;        /* 8 bytes per put/delete: the logical input */
+    long flush_bytes;       /* Run bytes written by memtable flushes */
+    long compact_bytes;     /* Run bytes written by compactions */
+    long blocks_read;       /* Blocks read by lsm_get */
+    long runs_probed;       /* Runs whose fences lsm_get searched */
+    long flushes;
+    long compactions;
+    long stalls;            /* Writes that waited for a flush */
+    int l0_runs;
+    long level_keys[LSM_MAX_LEVELS];  /* [0] counts all L0 entries */
+    double write_amp;       /* (flush + compact bytes) / user bytes */
+    double read_amp;        /* Blocks read per lsm_get */
+} LSMStats;
+
+LSMTree *lsm_open(const char *dir, const LSMOptions *opts);
+void lsm_close(LSMTree *lsm);
+
+int lsm_put(LSMTree *lsm, int key);
+int lsm_delete(LSMTree *lsm, int key);
+bool lsm_get(LSMTree *lsm, int key);
+long lsm_range(LSMTree *lsm, int lo, int hi,
+               void (*visit)(int key, void *ctx), void *ctx);
+
+int lsm_flush(LSMTree *lsm);
+void lsm_wait_idle(LSMTree *lsm);
+void lsm_stats(LSMTree *lsm, LSMStats *stats);
+
+#endif /* LSM_TREE_H */
@@ -0,0 +1,434 @@
+/*
+ * LSM-Tree tests and benchmarks
+ *
+ * Compile: gcc -O2 -pthread -o lsm_test main.c lsm_tree.c \
+ *          ../splay-tree-c/splay_tree.c ../b-tree-c/b-tree.c -lm
+ * Usage:   ./lsm_test [--bench [n]]
+ */
+
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "lsm_tree.h"
+#include "../b-tree-c/b-tree.h"
+
+/* ================================================================
+ * TEST UTILITIES
+ * ================================================================ */
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST(name) printf("\n[TEST] %s\n", name)
+#define ASSERT(cond, msg) do { \
+    if (cond) { \
+        tests_passed++; \
+        printf("  PASS: %s\n", msg); \
+    } else { \
+        tests_failed++; \
+        printf("  FAIL: %s\n", msg); \
+    } \
+} while(0)
+
+/* Shuffle array using Fisher-Yates algorithm */
+static void shuffle(int *arr, int n) {
+    for (int i = n - 1; i > 0; i--) {
+        int j = rand() % (i + 1);
+        int temp = arr[i];
+        arr[i] = arr[j];
+        arr[j] = temp;
+    }
+}
+
+/* make_dir - Fresh temporary directory for run files */
+static char *make_dir(void) {
+    char *dir = strdup("/tmp/lsm_test_XXXXXX");
+    if (dir && !mkdtemp(dir)) {
+        free(dir);
+        return NULL;
+    }
+    return dir;
+}
+
+/* count_files - Entries in dir other than . and .. */
+static int count_files(const char *dir) {
+    DIR *d = opendir(dir);
+    int n = 0;
+    if (!d) return -1;
+    for (struct dirent *e; (e = readdir(d)) != NULL;) {
+        if (strcmp(e->d_name, ".") != 0 && strcmp(e->d_name, "..") != 0) n++;
+    }
+    closedir(d);
+    return n;
+}
+
+/* truncate_runs - Cut every file in dir to len bytes (simulates bad reads) */
+static int truncate_runs(const char *dir, off_t len) {
+    DIR *d = opendir(dir);
+    int n = 0;
+    char path[512];
+    if (!d) return -1;
+    for (struct dirent *e; (e = readdir(d)) != NULL;) {
+        if (strcmp(e->d_name, ".") == 0 || strcmp(e->d_name, "..") == 0) continue;
+        snprintf(path, sizeof(path), "%s/%s", dir, e->d_name);
+        if (truncate(path, len) == 0) n++;
+    }
+    closedir(d);
+    return n;
+}
+
+static void remove_dir(char *dir) {
+    rmdir(dir);
+    free(dir);
+}
+
+typedef struct {
+    long count;
+    int last;
+    bool sorted;
+    const bool *expect;  /* Optional reference set */
+    bool matches;
+} RangeCheck;
+
+static void range_visit(int key, void *ctx) {
+    RangeCheck *rc = (RangeCheck *)ctx;
+    if (rc->count > 0 && key <= rc->last) rc->sorted = false;
+    if (rc->expect && !rc->expect[key]) rc->matches = false;
+    rc->last = key;
+    rc->count++;
+}
+
+/* ================================================================
+ * TESTS
+ * ================================================================ */
+
+static void test_memtable_only(void) {
+    TEST("Memtable Only");
+
+    char *dir = make_dir();
+    LSMOptions opts = { 1000, 4, 10 };
+    LSMTree *lsm = lsm_open(dir, &opts);
+    ASSERT(lsm != NULL, "lsm_open returns non-NULL");
+
+    for (int k = 0; k < 100; k++) lsm_put(lsm, k * 2);
+    bool ok = true;
+    for (int k = 0; k < 200; k++) {
+        if (lsm_get(lsm, k) != (k % 2 == 0)) ok = false;
+    }
+    ASSERT(ok, "even keys present, odd keys absent");
+
+    lsm_delete(lsm, 10);
+    ASSERT(!lsm_get(lsm, 10), "deleted key is absent");
+    lsm_put(lsm, 10);
+    ASSERT(lsm_get(lsm, 10), "re-inserted key is present");
+
+    LSMStats stats;
+    lsm_stats(lsm, &stats);
+    ASSERT(stats.flushes == 0 && count_files(dir) == 0, "nothing written to disk");
+
+    ASSERT(lsm_open(dir, &(LSMOptions){ 0, 4, 10 }) == NULL, "zero memtable rejected");
+    ASSERT(lsm_open(dir, &(LSMOptions){ 1000, 4, 1 }) == NULL, "ratio < 2 rejected");
+
+    lsm_close(lsm);
+    remove_dir(dir);
+}
+
+static void test_flush_and_get(void) {
+    TEST("Flush to Runs and Point Reads");
+
+    char *dir = make_dir();
+    LSMOptions opts = { 1000, 4, 10 };
+    LSMTree *lsm = lsm_open(dir, &opts);
+
+    for (int k = 0; k < 2500; k++) lsm_put(lsm, k);
+    lsm_flush(lsm);
+    lsm_wait_idle(lsm);
+
+    LSMStats stats;
+    lsm_stats(lsm, &stats);
+    ASSERT(stats.flushes == 3, "three memtables flushed");
+    ASSERT(stats.l0_runs == 3, "three L0 runs");
+    ASSERT(count_files(dir) == 3, "one file per run");
+
+    bool ok = true;
+    for (int k = 0; k < 2500; k++) {
+        if (!lsm_get(lsm, k)) ok = false;
+    }
+    ASSERT(ok, "every key found in runs");
+    ASSERT(!lsm_get(lsm, -1) && !lsm_get(lsm, 2500), "out-of-range keys absent");
+
+    lsm_stats(lsm, &stats);
+    ASSERT(stats.read_amp <= 1.0, "at most one block per point read");
+
+    lsm_close(lsm);
+    ASSERT(count_files(dir) == 0, "lsm_close removes run files");
+    remove_dir(dir);
+}
+
+static void test_tombstones(void) {
+    TEST("Tombstones Shadow Older Runs");
+
+    char *dir = make_dir();
+    LSMOptions opts = { 500, 8, 10 };
+    LSMTree *lsm = lsm_open(dir, &opts);
+
+    for (int k = 0; k < 500; k++) lsm_put(lsm, k);
+    lsm_flush(lsm);
+    for (int k = 0; k < 500; k += 2) lsm_delete(lsm, k);
+
+    bool ok = true;
+    for (int k = 0; k < 500; k++) {
+        if (lsm_get(lsm, k) != (k % 2 == 1)) ok = false;
+    }
+    ASSERT(ok, "memtable tombstones hide flushed keys");
+
+    lsm_flush(lsm);
+    lsm_wait_idle(lsm);
+    ok = true;
+    for (int k = 0; k < 500; k++) {
+        if (lsm_get(lsm, k) != (k % 2 == 1)) ok = false;
+    }
+    ASSERT(ok, "L0 tombstones hide keys in older L0 runs");
+
+    RangeCheck rc = { 0, 0, true, NULL, true };
+    long n = lsm_range(lsm, 0, 499, range_visit, &rc);
+    ASSERT(n == 250 && rc.count == 250, "range skips deleted keys");
+
+    lsm_close(lsm);
+    remove_dir(dir);
+}
+
+static void test_compaction(void) {
+    TEST("Compaction Against Reference Set");
+
+    enum { UNIVERSE = 20000, OPS = 200000 };
+    char *dir = make_dir();
+    LSMOptions opts = { 1000, 2, 4 };
+    LSMTree *lsm = lsm_open(dir, &opts);
+    bool *ref = calloc(UNIVERSE, sizeof(bool));
+
+    bool ok = true;
+    for (int i = 0; i < OPS; i++) {
+        int key = rand() % UNIVERSE;
+        if (rand() % 3 == 0) {
+            if (lsm_delete(lsm, key) != 0) ok = false;
+            ref[key] = false;
+        } else {
+            if (lsm_put(lsm, key) != 0) ok = false;
+            ref[key] = true;
+        }
+        /* Read while the background thread is busy */
+        if (i % 97 == 0) {
+            int probe = rand() % UNIVERSE;
+            if (lsm_get(lsm, probe) != ref[probe]) ok = false;
+        }
+    }
+    ASSERT(ok, "reads match reference during ingest");
+
+    lsm_flush(lsm);
+    lsm_wait_idle(lsm);
+    LSMStats stats;
+    lsm_stats(lsm, &stats);
+    ASSERT(stats.compactions > 0, "compactions ran");
+    ASSERT(stats.l0_runs < 2 * opts.l0_trigger, "L0 kept below its stop limit");
+    int deepest = 0;
+    for (int level = 1; level < LSM_MAX_LEVELS; level++) {
+        if (stats.level_keys[level] > 0) deepest = level;
+    }
+    ASSERT(deepest >= 2, "data reached L2 or deeper");
+    ASSERT(stats.write_amp > 1.0, "write amplification above 1");
+
+    ok = true;
+    long live = 0;
+    for (int k = 0; k < UNIVERSE; k++) {
+        if (lsm_get(lsm, k) != ref[k]) ok = false;
+        live += ref[k];
+    }
+    ASSERT(ok, "every key matches reference after compaction");
+
+    RangeCheck rc = { 0, 0, true, ref, true };
+    long n = lsm_range(lsm, 0, UNIVERSE - 1, range_visit, &rc);
+    ASSERT(n == live && rc.sorted && rc.matches, "full range matches reference");
+
+    long expect = 0;
+    for (int k = 5000; k <= 5999; k++) expect += ref[k];
+    rc = (RangeCheck){ 0, 0, true, ref, true };
+    n = lsm_range(lsm, 5000, 5999, range_visit, &rc);
+    ASSERT(n == expect && rc.sorted && rc.matches, "sub-range matches reference");
+    ASSERT(lsm_range(lsm, 10, 5, NULL, NULL) == 0, "empty range");
+
+    free(ref);
+    lsm_close(lsm);
+    ASSERT(count_files(dir) == 0, "all run files removed");
+    remove_dir(dir);
+}
+
+static void test_sequential_ingest(void) {
+    TEST("Sequential Ingest (deep splay paths)");
+
+    char *dir = make_dir();
+    LSMOptions opts = { 20000, 4, 10 };
+    LSMTree *lsm = lsm_open(dir, &opts);
+
+    for (int k = 0; k < 100000; k++) lsm_put(lsm, k);
+    lsm_wait_idle(lsm);
+
+    RangeCheck rc = { 0, 0, true, NULL, true };
+    long n = lsm_range(lsm, 0, 99999, range_visit, &rc);
+    ASSERT(n == 100000 && rc.sorted, "range returns all keys in order");
+    ASSERT(lsm_get(lsm, 0) && lsm_get(lsm, 99999), "first and last key present");
+
+    lsm_close(lsm);
+    remove_dir(dir);
+}
+
+static void test_read_errors(void) {
+    TEST("Failed Run Reads Are Reported");
+
+    char *dir = make_dir();
+    LSMOptions opts = { 1000, 2, 10 };
+    LSMTree *lsm = lsm_open(dir, &opts);
+
+    /* One run of two blocks */
+    for (int k = 0; k < 1000; k++) lsm_put(lsm, k);
+    lsm_wait_idle(lsm);
+    RangeCheck rc = { 0, 0, true, NULL, true };
+    ASSERT(lsm_range(lsm, 0, 999, range_visit, &rc) == 1000, "intact run is scanned");
+
+    /* Keep the 16-byte header and block 0; block 1 now reads short */
+    ASSERT(truncate_runs(dir, 16 + LSM_BLOCK_ENTRIES * 8) == 1, "run file truncated");
+    rc = (RangeCheck){ 0, 0, true, NULL, true };
+    ASSERT(lsm_range(lsm, 0, 999, range_visit, &rc) == -1,
+           "range over an unreadable block fails");
+    rc = (RangeCheck){ 0, 0, true, NULL, true };
+    ASSERT(lsm_range(lsm, 0, 99, range_visit, &rc) == 100,
+           "range within the readable block still succeeds");
+
+    /* A second run triggers an L0 -> L1 merge that must not drop keys */
+    for (int k = 1000; k < 2000; k++) lsm_put(lsm, k);
+    lsm_wait_idle(lsm);
+    LSMStats stats;
+    lsm_stats(lsm, &stats);
+    ASSERT(stats.compactions == 0 && lsm_flush(lsm) == -1,
+           "compaction over an unreadable run fails");
+
+    lsm_close(lsm);
+    remove_dir(dir);
+}
+
+static void run_tests(void) {
+    printf("===== LSM-TREE TEST SUITE =====\n");
+
+    test_memtable_only();
+    test_flush_and_get();
+    test_tombstones();
+    test_compaction();
+    test_sequential_ingest();
+    test_read_errors();
+
+    printf("\n===== TEST SUMMARY =====\n");
+    printf("Passed: %d\n", tests_passed);
+    printf("Failed: %d\n", tests_failed);
+}
+
+/* ================================================================
+ * BENCHMARK
+ * ================================================================ */
+
+static double get_time_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void count_visit(int key, void *ctx) {
+    (void)key;
+    (*(long *)ctx)++;
+}
+
+/*
+ * run_benchmark - Random-key ingest, point reads and scans
+ *
+ * The B-tree baseline is in memory, so the ingest comparison favours it;
+ * the LSM pays for sorting, file writes and compaction on top.
+ */
+static void run_benchmark(int argc, char *argv[]) {
+    int n = argc > 2 ? atoi(argv[2]) : 2000000;
+    printf("\n===== LSM-TREE BENCHMARK (n=%d random keys) =====\n", n);
+
+    int *keys = malloc(n * sizeof(int));
+    for (int i = 0; i < n; i++) keys[i] = i;
+    shuffle(keys, n);
+
+    double start = get_time_ns();
+    BTree *tree = btree_create(50);
+    for (int i = 0; i < n; i++) btree_insert(tree, keys[i]);
+    double btree_ms = (get_time_ns() - start) / 1e6;
+    printf("  btree_insert (t=50):   %9.2f ms  %6.2f Mops/s\n",
+           btree_ms, n / btree_ms / 1e3);
+    btree_destroy(tree);
+
+    char *dir = make_dir();
+    LSMTree *lsm = lsm_open(dir, NULL);
+    start = get_time_ns();
+    for (int i = 0; i < n; i++) lsm_put(lsm, keys[i]);
+    double put_ms = (get_time_ns() - start) / 1e6;
+    lsm_flush(lsm);
+    lsm_wait_idle(lsm);
+    double settle_ms = (get_time_ns() - start) / 1e6;
+    printf("  lsm_put:               %9.2f ms  %6.2f Mops/s  "
+           "(%.2f ms incl. final flush/compaction)\n",
+           put_ms, n / put_ms / 1e3, settle_ms);
+
+    int gets = n < 200000 ? n : 200000;
+    start = get_time_ns();
+    long found = 0;
+    for (int i = 0; i < gets; i++) found += lsm_get(lsm, rand() % (2 * n));
+    double get_ms = (get_time_ns() - start) / 1e6;
+    printf("  lsm_get (50%% hits):    %9.2f ms  %6.2f Mops/s  (%ld found)\n",
+           get_ms, gets / get_ms / 1e3, found);
+
+    int scans = 1000;
+    long scanned = 0;
+    start = get_time_ns();
+    for (int i = 0; i < scans; i++) {
+        int lo = rand() % n;
+        lsm_range(lsm, lo, lo + 999, count_visit, &scanned);
+    }
+    double scan_ms = (get_time_ns() - start) / 1e6;
+    printf("  lsm_range (1000 keys): %9.2f ms  %6.2f Mkeys/s\n",
+           scan_ms, scanned / scan_ms / 1e3);
+
+    LSMStats stats;
+    lsm_stats(lsm, &stats);
+    printf("  flushes=%ld compactions=%ld stalls=%ld\n",
+           stats.flushes, stats.compactions, stats.stalls);
+    printf("  levels: L0=%ld (%d runs)", stats.level_keys[0], stats.l0_runs);
+    for (int level = 1; level < LSM_MAX_LEVELS; level++) {
+        if (stats.level_keys[level]) printf(" L%d=%ld", level, stats.level_keys[level]);
+    }
+    printf("\n  write amplification: %.2f   read amplification: %.2f blocks/get "
+           "(%.2f runs probed/get)\n",
+           stats.write_amp, stats.read_amp,
+           stats.gets ? (double)stats.runs_probed / stats.gets : 0.0);
+
+    lsm_close(lsm);
+    remove_dir(dir);
+    free(keys);
+}
+
+int main(int argc, char *argv[]) {
+    srand((unsigned int)time(NULL));
+
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        run_benchmark(argc, argv);
+    } else {
+        run_tests();
+    }
+
+    return tests_failed > 0 ? 1 : 0;
+}